@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "market_data/market_data_consumer.h"
+
+/// Updates are published in batches of this many, waiting for the consumer to process each batch before sending the next one.
+static constexpr size_t batch_size = 64;
+static constexpr size_t num_updates = 20000;
+static constexpr size_t num_tickers = 8;
+
+/// Plays the market data publisher - sends incremental updates for num_tickers tickers round robin, sharded across the incremental channels.
+/// Every update carries the time it was published in priority_, to measure its latency through the consumer.
+struct BenchmarkPublisher {
+  BenchmarkPublisher(Common::Logger &logger, const std::vector<Exchange::IncrementalChannelCfg> &channels)
+      : channel_next_seq_num_(channels.size(), 1) {
+    sockets_.reserve(channels.size());
+    for (const auto &channel_cfg: channels) {
+      auto &socket = sockets_.emplace_back(logger);
+      ASSERT(socket.init(channel_cfg.ip_, "lo", channel_cfg.port_, /*is_listening*/ false) >= 0,
+             "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    }
+  }
+
+  ~BenchmarkPublisher() {
+    for (auto &socket: sockets_)
+      socket.leave("", 0);
+  }
+
+  /// Publish a batch of updates, each channel's share of it goes out in one datagram.
+  auto publishBatch() -> void {
+    const auto publish_time = Common::getCurrentNanos();
+    for (size_t i = 0; i < batch_size; ++i, ++next_order_id_) {
+      const auto ticker_id = static_cast<Common::TickerId>(next_order_id_ % num_tickers);
+      const auto channel = Exchange::tickerChannel(ticker_id, sockets_.size());
+      const Exchange::MDPMarketUpdate market_update{channel_next_seq_num_[channel]++, ticker_next_seq_num_[ticker_id]++,
+                                                    {Exchange::MarketUpdateType::ADD, next_order_id_, ticker_id, Common::Side::BUY, 100, 1,
+                                                     static_cast<Common::Priority>(publish_time)}};
+      sockets_[channel].send(&market_update, sizeof(market_update));
+    }
+
+    for (auto &socket: sockets_)
+      socket.sendAndRecv();
+  }
+
+  Common::OrderId next_order_id_ = 0;
+  size_t ticker_next_seq_num_[num_tickers] = {1, 1, 1, 1, 1, 1, 1, 1};
+  std::vector<size_t> channel_next_seq_num_;
+  std::vector<Common::McastSocket> sockets_;
+};
+
+/// Publish num_updates across num_channels channels to a consumer subscribed to the tickers provided, reporting how many updates it had to decode,
+/// how many it pushed to its queue and their latency from being published to being read off the queue.
+void benchmarkSubscription(size_t num_channels, const std::vector<Common::TickerId> &tickers, int port) {
+  std::vector<Exchange::IncrementalChannelCfg> channels;
+  for (size_t channel = 0; channel < num_channels; ++channel)
+    channels.push_back({"233.252.14." + std::to_string(10 + channel), port + 2 + static_cast<int>(channel), "", 0, false});
+
+  Common::Logger logger("");
+  auto publisher = new BenchmarkPublisher(logger, channels);
+
+  // Nothing listens on the gap fill port, no updates are dropped in this benchmark.
+  Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+  auto market_data_consumer = new Trading::MarketDataConsumer(0, &market_updates, "lo", "233.252.14.1", port, channels, tickers, "127.0.0.1", port + 1);
+  market_data_consumer->start();
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(1s); // let the consumer join the incremental channels.
+
+  auto subscribed = [&](Common::TickerId ticker_id) { return tickers.empty() || std::find(tickers.begin(), tickers.end(), ticker_id) != tickers.end(); };
+  std::vector<bool> joined(num_channels, tickers.empty());
+  for (const auto ticker_id: tickers)
+    joined[Exchange::tickerChannel(ticker_id, num_channels)] = true;
+
+  std::vector<Common::Nanos> latencies;
+  latencies.reserve(num_updates);
+  size_t num_decoded = 0, num_expected = 0;
+  while (publisher->next_order_id_ < num_updates) {
+    for (auto order_id = publisher->next_order_id_; order_id < publisher->next_order_id_ + batch_size; ++order_id) {
+      const auto ticker_id = static_cast<Common::TickerId>(order_id % num_tickers);
+      num_decoded += joined[Exchange::tickerChannel(ticker_id, num_channels)];
+      num_expected += subscribed(ticker_id);
+    }
+    publisher->publishBatch();
+
+    const auto deadline = Common::getCurrentNanos() + 10 * Common::NANOS_TO_SECS;
+    while (latencies.size() < num_expected && Common::getCurrentNanos() < deadline) {
+      if (market_updates.size()) {
+        latencies.push_back(Common::getCurrentNanos() - static_cast<Common::Nanos>(market_updates.getNextToRead()->priority_));
+        market_updates.updateReadIndex();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    ASSERT(latencies.size() == num_expected, "Consumer stuck at " + std::to_string(latencies.size()) + " of " + std::to_string(num_expected) + " updates.");
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  std::cout << "CHANNELS:" << num_channels << " TICKERS:" << std::setw(3) << (tickers.empty() ? std::string("all") : std::to_string(tickers.size()))
+            << " decoded:" << std::setw(6) << num_decoded << " queued:" << std::setw(6) << latencies.size()
+            << " LATENCY p50:" << latencies[latencies.size() / 2] / Common::NANOS_TO_MICROS << " us"
+            << " p99:" << latencies[latencies.size() * 99 / 100] / Common::NANOS_TO_MICROS << " us"
+            << " max:" << latencies.back() / Common::NANOS_TO_MICROS << " us." << std::endl;
+
+  delete market_data_consumer;
+  delete publisher;
+}
+
+int main(int, char **) {
+  // Every consumer used to decode and queue every ticker, a consumer trading a single ticker now only joins its channel and only queues its ticker.
+  benchmarkSubscription(1, {}, 20140);
+  int port = 20150;
+  for (const size_t num_channels: {1, 2, 4, 8}) {
+    benchmarkSubscription(num_channels, {0}, port);
+    port += 10;
+  }
+
+  exit(EXIT_SUCCESS);
+}
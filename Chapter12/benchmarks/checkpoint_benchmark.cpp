@@ -0,0 +1,177 @@
+#include "matcher/matching_engine.h"
+#include "journal/journal.h"
+#include "journal/checkpoint_writer.h"
+
+/// Number of resting orders in the books when the checkpoint is taken and number of client requests journaled after it.
+static constexpr size_t resting_count = 1000000;
+static constexpr size_t tail_count = 100000;
+
+/// Runs a thread which discards every market update, standing in for the market data publisher during recovery.
+struct MarketUpdateDrainer {
+  explicit MarketUpdateDrainer(Exchange::MEMarketUpdateLFQueue *market_updates)
+      : market_updates_(market_updates) {
+    thread_ = Common::createAndStartThread(-1, "MarketUpdateDrainer", [this]() { run(); });
+  }
+
+  auto run() noexcept -> void {
+    while (run_) {
+      while (market_updates_->size())
+        market_updates_->updateReadIndex();
+      std::this_thread::yield(); // give the core back to the matching engine when benchmarking on fewer cores than threads.
+    }
+  }
+
+  ~MarketUpdateDrainer() {
+    run_ = false;
+    thread_->join();
+    delete thread_;
+  }
+
+  Exchange::MEMarketUpdateLFQueue *market_updates_ = nullptr;
+  volatile bool run_ = true;
+  std::thread *thread_ = nullptr;
+};
+
+/// Process a client request through the matching engine and also journal it, the same way the FIFOSequencer would.
+void processAndJournal(Exchange::MatchingEngine *matching_engine, const Exchange::MEClientRequest &request, Exchange::JournalRecordLFQueue *journal_records,
+                       Exchange::ClientResponseLFQueue *client_responses, Exchange::MEMarketUpdateLFQueue *market_updates) {
+  while (journal_records->size() >= Exchange::ME_MAX_JOURNAL_RECORDS - 1)
+    std::this_thread::yield();
+  auto next_write = journal_records->getNextToWriteTo();
+  next_write->seq_num_ = matching_engine->lastSeqNum() + 1;
+  next_write->recv_time_ = Common::getCurrentNanos();
+  next_write->me_client_request_ = request;
+  journal_records->updateWriteIndex();
+
+  matching_engine->processClientRequest(&request);
+
+  while (client_responses->size())
+    client_responses->updateReadIndex();
+  while (market_updates->size())
+    market_updates->updateReadIndex();
+}
+
+/// Hash of every live order in every book, used to check that the recovered books are identical to the original ones.
+uint64_t booksHash(const Exchange::MatchingEngine *matching_engine) {
+  Exchange::Checkpoint checkpoint;
+  matching_engine->checkpoint(&checkpoint);
+  const auto hash = Common::fnv1a(checkpoint.books_.data(), checkpoint.books_.size() * sizeof(Exchange::CheckpointBookHeader));
+  return Common::fnv1a(checkpoint.orders_.data(), checkpoint.orders_.size() * sizeof(Exchange::CheckpointOrder), hash);
+}
+
+/// Time to rebuild a fresh matching engine from the provided checkpoint (if it exists) and journal.
+Common::Nanos benchmarkRecovery(const std::string &name, const Exchange::CheckpointCfg &checkpoint_cfg, const Exchange::JournalCfg &journal_cfg,
+                                uint64_t expected_hash) {
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "");
+
+  Common::Nanos elapsed = 0;
+  {
+    MarketUpdateDrainer drainer(&market_updates);
+
+    const auto start_time = Common::getCurrentNanos();
+    matching_engine->recover(checkpoint_cfg, journal_cfg);
+    elapsed = Common::getCurrentNanos() - start_time;
+  }
+
+  const auto hash = booksHash(matching_engine);
+  std::cout << name << " RESTART-TO-READY " << elapsed / NANOS_TO_MILLIS << " ms."
+            << " seq:" << matching_engine->lastSeqNum() << " books-hash:" << hash << (hash == expected_hash ? " MATCHES" : " DIFFERS") << std::endl;
+
+  delete matching_engine;
+
+  return (hash == expected_hash ? elapsed : 0);
+}
+
+int main(int argc, char **argv) {
+  srand(0);
+
+  const std::string dir = (argc > 1 ? argv[1] : ".");
+
+  Exchange::JournalCfg journal_cfg;
+  journal_cfg.dir_ = dir;
+  journal_cfg.prefix_ = "checkpoint_benchmark_journal_" + std::to_string(getpid());
+  journal_cfg.sync_mode_ = Exchange::JournalSyncMode::NONE;
+
+  Exchange::CheckpointCfg checkpoint_cfg;
+  checkpoint_cfg.dir_ = dir;
+  checkpoint_cfg.file_name_ = "checkpoint_benchmark_" + std::to_string(getpid()) + ".bin";
+
+  uint64_t expected_hash = 0;
+  {
+    Exchange::ClientRequestLFQueue client_requests(1);
+    Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+    Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+    Exchange::JournalRecordLFQueue journal_records(Exchange::ME_MAX_JOURNAL_RECORDS);
+
+    auto journal = new Exchange::Journal(&journal_records, journal_cfg);
+    journal->start();
+    auto checkpoint_writer = new Exchange::CheckpointWriter(checkpoint_cfg);
+    checkpoint_writer->start();
+    auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "");
+
+    // Passive orders only, bids at [1, 100] and asks at [101, 200], spread across every ticker and client.
+    std::array<Common::OrderId, ME_MAX_NUM_CLIENTS> next_order_id;
+    next_order_id.fill(1);
+    for (size_t i = 0; i < resting_count; ++i) {
+      const Common::ClientId client_id = i % ME_MAX_NUM_CLIENTS;
+      const Common::TickerId ticker_id = rand() % ME_MAX_TICKERS;
+      const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+      const Common::Price price = (side == Common::Side::BUY ? 100 - (rand() % 100) : 101 + (rand() % 100));
+      const Exchange::MEClientRequest request{Exchange::ClientRequestType::NEW, client_id, ticker_id, next_order_id[client_id]++, side, price,
+                                              static_cast<Common::Qty>(1 + rand() % 100)};
+      processAndJournal(matching_engine, request, &journal_records, &client_responses, &market_updates);
+    }
+
+    // Time the copy the matching engine thread pays for, the write to disk happens on the checkpoint writer thread.
+    auto checkpoint = checkpoint_writer->acquire();
+    const auto copy_start = Common::rdtsc();
+    matching_engine->checkpoint(checkpoint);
+    const auto copy_cycles = Common::rdtsc() - copy_start;
+
+    const auto write_start = Common::getCurrentNanos();
+    checkpoint_writer->publish();
+    while (!checkpoint_writer->numCheckpoints())
+      std::this_thread::yield();
+    std::cout << "CHECKPOINT orders:" << checkpoint->orders_.size() << " COPY " << copy_cycles << " CLOCK CYCLES."
+              << " WRITE " << (Common::getCurrentNanos() - write_start) / NANOS_TO_MILLIS << " ms." << std::endl;
+
+    // Journal tail after the checkpoint, aggressive orders on top of cancels of random resting orders.
+    for (size_t i = 0; i < tail_count; ++i) {
+      const Common::ClientId client_id = rand() % ME_MAX_NUM_CLIENTS;
+      const Common::TickerId ticker_id = rand() % ME_MAX_TICKERS;
+      if (i % 2) {
+        const Exchange::MEClientRequest request{Exchange::ClientRequestType::CANCEL, client_id, ticker_id,
+                                                static_cast<Common::OrderId>(1 + rand() % (next_order_id[client_id] - 1)), Side::INVALID, Price_INVALID, Qty_INVALID};
+        processAndJournal(matching_engine, request, &journal_records, &client_responses, &market_updates);
+      } else {
+        const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+        const Common::Price price = (side == Common::Side::BUY ? 101 : 100);
+        const Exchange::MEClientRequest request{Exchange::ClientRequestType::NEW, client_id, ticker_id, next_order_id[client_id]++, side, price,
+                                                static_cast<Common::Qty>(1 + rand() % 100)};
+        processAndJournal(matching_engine, request, &journal_records, &client_responses, &market_updates);
+      }
+    }
+
+    expected_hash = booksHash(matching_engine);
+    std::cout << "ORIGINAL seq:" << matching_engine->lastSeqNum() << " books-hash:" << expected_hash << std::endl;
+
+    journal->stop();
+    delete journal;
+    delete matching_engine;
+    delete checkpoint_writer;
+  }
+
+  const auto checkpoint_elapsed = benchmarkRecovery("CHECKPOINT+JOURNAL-TAIL", checkpoint_cfg, journal_cfg, expected_hash);
+
+  auto no_checkpoint_cfg = checkpoint_cfg;
+  no_checkpoint_cfg.file_name_ += ".missing";
+  const auto journal_elapsed = benchmarkRecovery("FULL-JOURNAL", no_checkpoint_cfg, journal_cfg, expected_hash);
+
+  unlink(Exchange::checkpointFileName(checkpoint_cfg).c_str());
+  for (size_t index = 0; unlink(Exchange::journalFileName(journal_cfg, index).c_str()) == 0; ++index);
+
+  exit(checkpoint_elapsed && journal_elapsed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,162 @@
+#include <iomanip>
+#include <map>
+
+#include "matcher/matching_engine.h"
+#include "market_data/market_data_publisher.h"
+
+static constexpr size_t num_requests = 100000;
+
+/// The books rebuilt from the published and the matching engine's updates are compared every this many requests.
+static constexpr size_t check_interval = 1024;
+
+/// Aggressive order flow on one ticker - a maker rests orders of 100 to 500 within 5 ticks of the mid price and cancels some of them, a taker sends
+/// orders of 10 to 60 crossing the spread by up to 3 ticks, each partially filling the orders at the top of the book, and what the taker's orders do
+/// not fill rests to be filled by the next orders on the other side.
+auto aggressiveFlow() {
+  srand(0);
+  std::vector<Exchange::MEClientRequest> requests;
+  requests.reserve(num_requests);
+
+  constexpr Common::ClientId maker = 0, taker = 1;
+  constexpr Common::Price mid_price = 100;
+  Common::OrderId next_order_id[2] = {1, 1};
+  while (requests.size() < num_requests) {
+    const auto side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+    const auto sign = (side == Common::Side::BUY ? 1 : -1);
+    const auto action = rand() % 10;
+    if (action < 5) {
+      requests.push_back({Exchange::ClientRequestType::NEW, maker, 0, next_order_id[maker]++, side, mid_price - sign * (1 + rand() % 5),
+                          static_cast<Common::Qty>(100 + rand() % 401)});
+    } else if (action < 9) {
+      requests.push_back({Exchange::ClientRequestType::NEW, taker, 0, next_order_id[taker]++, side, mid_price + sign * (rand() % 4),
+                          static_cast<Common::Qty>(10 + rand() % 51)});
+    } else { // may have been filled already, the cancel is then rejected.
+      requests.push_back({Exchange::ClientRequestType::CANCEL, maker, 0, static_cast<Common::OrderId>(1 + rand() % next_order_id[maker]), side,
+                          Common::Price_INVALID, Common::Qty_INVALID});
+    }
+  }
+
+  return requests;
+}
+
+/// Live orders by market order id, quantity by price and number of trades, built from a stream of incremental updates.
+/// The orders a TRADE fills are only modified or cancelled after it, so they still have to be in the book when the TRADE arrives.
+struct Book {
+  auto apply(const Exchange::MEMarketUpdate &market_update) {
+    switch (market_update.type_) {
+      case Exchange::MarketUpdateType::ADD:
+        ASSERT(orders_.insert({market_update.order_id_, {market_update.price_, market_update.qty_}}).second, "Duplicate " + market_update.toString());
+        price_qty_[market_update.price_] += market_update.qty_;
+        break;
+      case Exchange::MarketUpdateType::MODIFY:
+        ASSERT(orders_.count(market_update.order_id_), "Unknown " + market_update.toString());
+        price_qty_[orders_[market_update.order_id_].first] -= orders_[market_update.order_id_].second;
+        price_qty_[market_update.price_] += market_update.qty_;
+        orders_[market_update.order_id_] = {market_update.price_, market_update.qty_};
+        break;
+      case Exchange::MarketUpdateType::CANCEL:
+        ASSERT(orders_.count(market_update.order_id_), "Unknown " + market_update.toString());
+        price_qty_[orders_[market_update.order_id_].first] -= orders_[market_update.order_id_].second;
+        orders_.erase(market_update.order_id_);
+        break;
+      case Exchange::MarketUpdateType::TRADE:
+        ASSERT(price_qty_[market_update.price_] >= market_update.qty_, "Orders filled were removed before " + market_update.toString());
+        ++num_trades_;
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::map<Common::OrderId, std::pair<Common::Price, Common::Qty>> orders_;
+  std::map<Common::Price, Common::Qty> price_qty_;
+  size_t num_trades_ = 0;
+};
+
+/// Run the order flow through a matching engine burst_size requests at a time, the market updates of every burst are handed to the market data publisher
+/// as one batch. Reports the updates published against the ones produced by the matching engine, and checks that the book and trades rebuilt from the
+/// published updates match the ones from the matching engine's updates.
+void benchmarkCoalescing(const std::vector<Exchange::MEClientRequest> &requests, size_t burst_size, bool coalesce, int port) {
+  const std::string ip = "233.252.14.20";
+  Common::Logger logger("");
+
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue me_market_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &me_market_updates, "");
+
+  Exchange::CoalesceCfg coalesce_cfg;
+  coalesce_cfg.enabled_ = coalesce;
+  coalesce_cfg.max_batch_ = ME_MAX_MARKET_UPDATES;
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  auto market_data_publisher = new Exchange::MarketDataPublisher(&market_updates, "lo", "233.252.14.21", port + 1, {{ip, port, "", 0, false}}, port + 2, "", 0,
+                                                                 Common::EngineLimits(), Exchange::SnapshotCfg(), coalesce_cfg);
+
+  Book published_book;
+  size_t num_published = 0, num_seq_gaps = 0;
+  Common::McastSocket subscriber(logger);
+  subscriber.recv_callback_ = [&](auto socket) {
+    size_t i = 0;
+    for (; i + sizeof(Exchange::MDPMarketUpdate) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::MDPMarketUpdate)) {
+      const auto update = reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->inbound_data_.data() + i);
+      num_seq_gaps += (update->seq_num_ != num_published + 1);
+      num_published = update->seq_num_;
+      published_book.apply(update->me_market_update_);
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  };
+  ASSERT(subscriber.init(ip, "lo", port, /*is_listening*/ true) >= 0, "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+  ASSERT(subscriber.join(ip), "Join failed on:" + std::to_string(subscriber.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+  market_data_publisher->start();
+
+  Book me_book;
+  size_t num_me_updates = 0;
+  for (size_t i = 0; i < requests.size(); i += burst_size) {
+    for (auto j = i; j < std::min(i + burst_size, requests.size()); ++j)
+      matching_engine->processClientRequest(&requests[j]);
+    for (auto response = client_responses.getNextToRead(); response; response = client_responses.getNextToRead())
+      client_responses.updateReadIndex();
+
+    // Hand the burst's updates to the publisher all at once and wait for them to be published.
+    for (auto update = me_market_updates.getNextToRead(); update; update = me_market_updates.getNextToRead()) {
+      me_book.apply(*update);
+      *market_updates.getNextToWriteTo() = *update;
+      market_updates.updateWriteIndex();
+      me_market_updates.updateReadIndex();
+      ++num_me_updates;
+    }
+
+    const auto deadline = Common::getCurrentNanos() + Common::NANOS_TO_SECS;
+    while ((market_updates.size() || num_published < num_me_updates - market_data_publisher->numCoalesced()) && Common::getCurrentNanos() < deadline) {
+      if (!subscriber.sendAndRecv())
+        std::this_thread::yield();
+    }
+
+    if ((i / burst_size) % (check_interval / burst_size) == 0 || i + burst_size >= requests.size())
+      ASSERT(published_book.orders_ == me_book.orders_ && published_book.num_trades_ == me_book.num_trades_,
+             "Published book does not match the matching engine's after request:" + std::to_string(i + burst_size));
+  }
+
+  std::cout << "BURST:" << std::setw(3) << burst_size << " COALESCE:" << coalesce << " matching engine updates:" << num_me_updates
+            << " published:" << std::setw(6) << num_published << " saved:" << std::setw(6) << num_me_updates - num_published
+            << " (" << std::fixed << std::setprecision(1) << std::setw(4) << 100.0 * static_cast<double>(num_me_updates - num_published) / num_me_updates << "%)"
+            << " trades:" << published_book.num_trades_ << " seq gaps:" << num_seq_gaps << std::endl;
+
+  subscriber.leave(ip, port);
+  delete market_data_publisher;
+  delete matching_engine;
+}
+
+int main(int, char **) {
+  const auto requests = aggressiveFlow();
+
+  int port = 20210;
+  benchmarkCoalescing(requests, 16, false, port);
+  for (const size_t burst_size: {1, 4, 16, 64}) {
+    port += 3;
+    benchmarkCoalescing(requests, burst_size, true, port);
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,139 @@
+#include "market_data/gap_fill_server.h"
+#include "market_data/market_data_consumer.h"
+
+/// Updates are published in batches of this many, waiting for the consumers to process each batch, so that no updates are lost to full socket buffers.
+static constexpr size_t batch_size = 64;
+static constexpr size_t num_updates = 20000;
+static constexpr size_t num_tickers = 8;
+
+/// Plays the market data publisher - sends incremental updates on the A and B incremental multicast feeds and forwards them to a GapFillServer,
+/// dropping each one on each feed with the configured probability.
+struct BenchmarkPublisher {
+  BenchmarkPublisher(Common::Logger &logger, const std::string &incremental_ip, int incremental_port,
+                     const std::string &incremental_b_ip, int incremental_b_port, int gap_fill_port)
+      : gap_fill_updates_(Common::ME_MAX_MARKET_UPDATES), gap_fill_server_(&gap_fill_updates_, "lo", gap_fill_port, 1, Exchange::ME_GAP_FILL_HISTORY, ""),
+        incremental_socket_(logger), incremental_b_socket_(logger) {
+    ASSERT(incremental_socket_.init(incremental_ip, "lo", incremental_port, /*is_listening*/ false) >= 0,
+           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    ASSERT(incremental_b_socket_.init(incremental_b_ip, "lo", incremental_b_port, /*is_listening*/ false) >= 0,
+           "Unable to create incremental B mcast socket. error:" + std::string(std::strerror(errno)));
+    gap_fill_server_.start();
+  }
+
+  auto publish(double loss_a, double loss_b) -> void {
+    const auto ticker_id = static_cast<Common::TickerId>(next_seq_num_ % num_tickers);
+    const Exchange::MDPMarketUpdate market_update{next_seq_num_, ticker_next_seq_num_[ticker_id]++,
+                                                  {Exchange::MarketUpdateType::ADD, next_seq_num_, ticker_id, Common::Side::BUY, 100, 1, next_seq_num_}};
+    ++next_seq_num_;
+
+    auto next_write = gap_fill_updates_.getNextToWriteTo();
+    *next_write = market_update;
+    gap_fill_updates_.updateWriteIndex();
+
+    const auto drop_a = (rand() < loss_a * RAND_MAX), drop_b = (rand() < loss_b * RAND_MAX);
+    dropped_a_ += drop_a;
+    dropped_b_ += drop_b;
+    dropped_both_ += (drop_a && drop_b);
+    if (!drop_a) {
+      incremental_socket_.send(&market_update, sizeof(market_update));
+      incremental_socket_.sendAndRecv();
+    }
+    if (!drop_b) {
+      incremental_b_socket_.send(&market_update, sizeof(market_update));
+      incremental_b_socket_.sendAndRecv();
+    }
+  }
+
+  size_t next_seq_num_ = 1;
+  size_t ticker_next_seq_num_[num_tickers] = {1, 1, 1, 1, 1, 1, 1, 1};
+  size_t dropped_a_ = 0, dropped_b_ = 0, dropped_both_ = 0;
+
+  Exchange::MDPMarketUpdateLFQueue gap_fill_updates_;
+  Exchange::GapFillServer gap_fill_server_;
+  Common::McastSocket incremental_socket_, incremental_b_socket_;
+};
+
+/// A market data consumer and the number of updates read off its queue so far.
+struct BenchmarkConsumer {
+  BenchmarkConsumer(Common::ClientId client_id, const std::string &incremental_ip, int incremental_port,
+                    const std::string &incremental_b_ip, int incremental_b_port, int snapshot_port, int gap_fill_port)
+      : market_updates_(Common::ME_MAX_MARKET_UPDATES),
+        consumer_(new Trading::MarketDataConsumer(client_id, &market_updates_, "lo", "233.252.14.1", snapshot_port, {{incremental_ip, incremental_port, incremental_b_ip, incremental_b_port, false}},
+                                                  {}, "127.0.0.1", gap_fill_port, {}, {}, {}, recoveryCfg())) {
+    consumer_->start();
+  }
+
+  /// There is no snapshot stream, so every ticker needs a recovery buffer to queue up its updates while gap fills close its gaps.
+  static auto recoveryCfg() -> Trading::RecoveryCfg {
+    Trading::RecoveryCfg recovery_cfg;
+    recovery_cfg.num_buffers_ = num_tickers;
+    return recovery_cfg;
+  }
+
+  auto drain() {
+    while (market_updates_.size()) {
+      market_updates_.updateReadIndex();
+      ++received_;
+    }
+  }
+
+  Exchange::MEMarketUpdateLFQueue market_updates_;
+  Trading::MarketDataConsumer *consumer_ = nullptr;
+  size_t received_ = 0;
+};
+
+int main(int, char **) {
+  srand(0);
+
+  const std::string incremental_ip = "233.252.14.3", incremental_b_ip = "233.252.14.4";
+  const int snapshot_port = 20110, incremental_port = 20111, incremental_b_port = 20113, gap_fill_port = 20112;
+
+  Common::Logger logger("");
+  BenchmarkPublisher publisher(logger, incremental_ip, incremental_port, incremental_b_ip, incremental_b_port, gap_fill_port);
+
+  // Both consumers see the same losses on the A feed, only the first one arbitrates it against the B feed.
+  BenchmarkConsumer dual_feed(0, incremental_ip, incremental_port, incremental_b_ip, incremental_b_port, snapshot_port, gap_fill_port);
+  BenchmarkConsumer single_feed(1, incremental_ip, incremental_port, "", 0, snapshot_port, gap_fill_port);
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(1s); // let the consumers connect to the gap fill server and join the incremental feeds.
+
+  for (const auto &[loss_a, loss_b]: {std::pair{0.01, 0.0}, std::pair{0.05, 0.0}, std::pair{0.05, 0.05}}) {
+    const auto dropped_a = publisher.dropped_a_, dropped_b = publisher.dropped_b_, dropped_both = publisher.dropped_both_;
+    const auto dual_gaps = dual_feed.consumer_->numIncrementalGaps(), dual_recoveries = dual_feed.consumer_->numRecoveries();
+    const auto single_gaps = single_feed.consumer_->numIncrementalGaps(), single_recoveries = single_feed.consumer_->numRecoveries();
+
+    for (size_t sent = 0; sent < num_updates;) {
+      // The last update of every batch goes out on both feeds, so that the consumers notice every gap in the batch and have to process all of it.
+      for (size_t i = 0; i < batch_size; ++i, ++sent) {
+        if (i + 1 < batch_size)
+          publisher.publish(loss_a, loss_b);
+        else
+          publisher.publish(0, 0);
+      }
+      const auto last_seq_num = publisher.next_seq_num_ - 1;
+
+      const auto deadline = Common::getCurrentNanos() + 10 * Common::NANOS_TO_SECS;
+      while ((dual_feed.received_ < last_seq_num || single_feed.received_ < last_seq_num) && Common::getCurrentNanos() < deadline) {
+        dual_feed.drain();
+        single_feed.drain();
+        std::this_thread::yield();
+      }
+      ASSERT(dual_feed.received_ == last_seq_num && single_feed.received_ == last_seq_num,
+             "Consumers stuck at " + std::to_string(dual_feed.received_) + " / " + std::to_string(single_feed.received_) + " of " +
+             std::to_string(last_seq_num) + " updates.");
+    }
+
+    std::cout << "LOSS A:" << loss_a * 100 << "% B:" << loss_b * 100 << "% over " << num_updates << " updates"
+              << " dropped A:" << publisher.dropped_a_ - dropped_a << " B:" << publisher.dropped_b_ - dropped_b
+              << " both:" << publisher.dropped_both_ - dropped_both << "."
+              << " DUAL FEED gaps:" << dual_feed.consumer_->numIncrementalGaps() - dual_gaps
+              << " ticker recoveries:" << dual_feed.consumer_->numRecoveries() - dual_recoveries << "."
+              << " SINGLE FEED gaps:" << single_feed.consumer_->numIncrementalGaps() - single_gaps
+              << " ticker recoveries:" << single_feed.consumer_->numRecoveries() - single_recoveries << "." << std::endl;
+  }
+  std::cout << "DUAL FEED duplicates discarded:" << dual_feed.consumer_->numDuplicates() << std::endl;
+
+  // The process exits right after, the consumer and gap fill server threads are left running instead of waiting for them to stop.
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,110 @@
+#include <iomanip>
+
+#include "matcher/matching_engine.h"
+#include "order_server/client_wire.h"
+
+static constexpr size_t num_sweeps = 20000;
+
+/// Every sweep the maker rests this many orders of 10 to 50 on each of the price levels the taker's order sweeps through.
+static constexpr size_t orders_per_level = 5;
+static constexpr int max_levels = 10;
+
+/// Sweeps of the book - the maker client rests orders_per_level small orders on 1 to max_levels price levels on one side, then the taker client sends one
+/// large order crossing all of them, which fills every resting order and rests what is left over. The taker's leftover is cancelled before the next sweep.
+auto sweepFlow() {
+  srand(0);
+  std::vector<Exchange::MEClientRequest> requests;
+
+  constexpr Common::ClientId maker = 0, taker = 1;
+  constexpr Common::Price mid_price = 1000;
+  Common::OrderId next_order_id[2] = {1, 1};
+  for (size_t sweep = 0; sweep < num_sweeps; ++sweep) {
+    const auto side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+    const auto sign = (side == Common::Side::BUY ? 1 : -1);
+    const auto num_levels = 1 + rand() % max_levels;
+
+    Common::Qty total_qty = 0;
+    for (int level = 0; level < num_levels; ++level) {
+      for (size_t i = 0; i < orders_per_level; ++i) {
+        const auto qty = static_cast<Common::Qty>(10 + rand() % 41);
+        requests.push_back({Exchange::ClientRequestType::NEW, maker, 0, next_order_id[maker]++, side, mid_price - sign * (1 + level), qty});
+        total_qty += qty;
+      }
+    }
+
+    const auto taker_order_id = next_order_id[taker]++;
+    requests.push_back({Exchange::ClientRequestType::NEW, taker, 0, taker_order_id, (side == Common::Side::BUY ? Common::Side::SELL : Common::Side::BUY),
+                        mid_price - sign * num_levels, static_cast<Common::Qty>(total_qty + 100)});
+    requests.push_back({Exchange::ClientRequestType::CANCEL, taker, 0, taker_order_id, Common::Side::INVALID, Common::Price_INVALID, Common::Qty_INVALID});
+  }
+
+  return requests;
+}
+
+/// Client responses of one client as the order server would send them.
+struct ClientFills {
+  auto add(const Exchange::MEClientResponse &response) {
+    char encoded[Exchange::WIRE_MAX_RESPONSE_SIZE];
+    bytes_ += Exchange::encodeClientResponse(static_cast<uint32_t>(++num_responses_), response, encoded);
+    if (response.type_ == Exchange::ClientResponseType::FILLED) {
+      ++num_fills_;
+      exec_qty_ += response.exec_qty_;
+      notional_ += response.price_ * response.exec_qty_;
+    }
+  }
+
+  size_t num_responses_ = 0, num_fills_ = 0, bytes_ = 0;
+  Common::Qty exec_qty_ = 0;
+  int64_t notional_ = 0;
+};
+
+/// Run the sweeps through a matching engine reporting the taker's fills as per fill_reporting, the maker is always reported every fill.
+/// Reports the taker's fill messages and encoded response bytes per sweep and the matching engine's time per request.
+auto benchmarkFillReporting(const std::vector<Exchange::MEClientRequest> &requests, Exchange::FillReporting fill_reporting) {
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+
+  Exchange::FillReportCfg fill_report_cfg;
+  fill_report_cfg.client_reporting_ = {Exchange::FillReporting::INVALID, fill_reporting};
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, Common::EngineLimits(),
+                                                      fill_report_cfg);
+
+  ClientFills client_fills[2];
+  Common::Nanos match_time = 0;
+  for (const auto &request: requests) {
+    const auto start = Common::getCurrentNanos();
+    matching_engine->processClientRequest(&request);
+    match_time += Common::getCurrentNanos() - start;
+
+    for (auto response = client_responses.getNextToRead(); response; response = client_responses.getNextToRead()) {
+      client_fills[response->client_id_].add(*response);
+      client_responses.updateReadIndex();
+    }
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+  }
+
+  const auto &taker = client_fills[1];
+  std::cout << std::setw(15) << Exchange::fillReportingToString(fill_reporting)
+            << " taker fills per sweep:" << std::setw(5) << static_cast<double>(taker.num_fills_) / num_sweeps
+            << " response bytes per sweep:" << std::setw(6) << static_cast<double>(taker.bytes_) / num_sweeps
+            << " maker fills:" << client_fills[0].num_fills_
+            << " ns per request:" << std::setw(5) << static_cast<double>(match_time) / requests.size() << std::endl;
+
+  delete matching_engine;
+  return client_fills[1];
+}
+
+int main(int, char **) {
+  const auto requests = sweepFlow();
+  std::cout << std::fixed << std::setprecision(1);
+
+  const auto per_fill = benchmarkFillReporting(requests, Exchange::FillReporting::PER_FILL);
+  const auto per_price_level = benchmarkFillReporting(requests, Exchange::FillReporting::PER_PRICE_LEVEL);
+
+  // Consolidated fills are all at a single price, so they add up to the same quantity and notional exactly.
+  ASSERT(per_price_level.exec_qty_ == per_fill.exec_qty_ && per_price_level.notional_ == per_fill.notional_, "Price level fills do not add up to the fills.");
+
+  exit(EXIT_SUCCESS);
+}
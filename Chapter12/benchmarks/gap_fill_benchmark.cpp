@@ -0,0 +1,98 @@
+#include <algorithm>
+
+#include "market_data/gap_fill_server.h"
+#include "market_data/market_data_consumer.h"
+
+/// Every gap size is dropped this many times, each time measuring how long the market data consumer takes to recover the missing updates.
+static constexpr size_t num_iterations = 20;
+
+/// Plays the market data publisher - sends incremental updates on the incremental multicast stream and forwards them to a GapFillServer,
+/// except for the dropped ones which only reach the gap fill server.
+struct BenchmarkPublisher {
+  BenchmarkPublisher(Common::Logger &logger, const std::string &incremental_ip, int incremental_port, int gap_fill_port)
+      : gap_fill_updates_(Common::ME_MAX_MARKET_UPDATES), gap_fill_server_(&gap_fill_updates_, "lo", gap_fill_port, 1, Exchange::ME_GAP_FILL_HISTORY, ""),
+        incremental_socket_(logger) {
+    ASSERT(incremental_socket_.init(incremental_ip, "lo", incremental_port, /*is_listening*/ false) >= 0,
+           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    gap_fill_server_.start();
+  }
+
+  auto publish(bool drop) -> void {
+    const Exchange::MDPMarketUpdate market_update{next_seq_num_, next_seq_num_,
+                                                  {Exchange::MarketUpdateType::ADD, next_seq_num_, 0, Common::Side::BUY, 100, 1, next_seq_num_}};
+    ++next_seq_num_;
+
+    auto next_write = gap_fill_updates_.getNextToWriteTo();
+    *next_write = market_update;
+    gap_fill_updates_.updateWriteIndex();
+
+    if (!drop) {
+      incremental_socket_.send(&market_update, sizeof(market_update));
+      incremental_socket_.sendAndRecv();
+    }
+  }
+
+  size_t next_seq_num_ = 1;
+  Exchange::MDPMarketUpdateLFQueue gap_fill_updates_;
+  Exchange::GapFillServer gap_fill_server_;
+  Common::McastSocket incremental_socket_;
+};
+
+/// Read market updates off the consumer's queue until num_updates have been seen or the timeout, returns the number seen.
+auto drain(Exchange::MEMarketUpdateLFQueue &market_updates, size_t num_updates) {
+  const auto deadline = Common::getCurrentNanos() + 10 * Common::NANOS_TO_SECS;
+  size_t seen = 0;
+  while (seen < num_updates && Common::getCurrentNanos() < deadline) {
+    if (market_updates.size()) {
+      market_updates.updateReadIndex();
+      ++seen;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  return seen;
+}
+
+int main(int, char **) {
+  const std::string incremental_ip = "233.252.14.3";
+  const int snapshot_port = 20100, incremental_port = 20101, gap_fill_port = 20102;
+
+  Common::Logger logger("");
+  BenchmarkPublisher publisher(logger, incremental_ip, incremental_port, gap_fill_port);
+
+  Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+  auto market_data_consumer = new Trading::MarketDataConsumer(0, &market_updates, "lo", "233.252.14.1", snapshot_port, {{incremental_ip, incremental_port, "", 0, false}},
+                                                              {}, "127.0.0.1", gap_fill_port);
+  market_data_consumer->start();
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(1s); // let the consumer connect to the gap fill server and join the incremental stream.
+
+  for (const size_t gap: {1, 10, 1000}) {
+    std::vector<Common::Nanos> recovery_times;
+    for (size_t iteration = 0; iteration < num_iterations; ++iteration) {
+      // An update the consumer gets in order, then the dropped ones and the first one after the gap which makes the consumer notice it.
+      publisher.publish(false);
+      ASSERT(drain(market_updates, 1) == 1, "Consumer did not receive an incremental update.");
+
+      for (size_t i = 0; i < gap; ++i)
+        publisher.publish(true);
+
+      const auto start_time = Common::getCurrentNanos();
+      publisher.publish(false);
+      const auto recovered = drain(market_updates, gap + 1);
+      recovery_times.push_back(Common::getCurrentNanos() - start_time);
+      ASSERT(recovered == gap + 1, "Only recovered " + std::to_string(recovered) + " of " + std::to_string(gap + 1) + " updates.");
+    }
+    std::sort(recovery_times.begin(), recovery_times.end());
+
+    std::cout << "GAP:" << gap << " recovered over " << num_iterations << " drops in"
+              << " min:" << recovery_times.front() / Common::NANOS_TO_MICROS << " us"
+              << " p50:" << recovery_times[recovery_times.size() / 2] / Common::NANOS_TO_MICROS << " us"
+              << " max:" << recovery_times.back() / Common::NANOS_TO_MICROS << " us." << std::endl;
+  }
+
+  // The process exits right after, the consumer and gap fill server threads are left running instead of waiting for them to stop.
+  exit(EXIT_SUCCESS);
+}
@@ -3,10 +3,14 @@
 
 static constexpr size_t loop_count = 100000;
 
+/// Returns the clock cycles per operation and the number of branch misses in total over all the operations, if hardware counters are available.
 template<typename T>
-size_t benchmarkHashMap(T *order_book, const std::vector<Exchange::MEClientRequest>& client_requests) {
+size_t benchmarkHashMap(T *order_book, const std::vector<Exchange::MEClientRequest>& client_requests, uint64_t *branch_misses) {
   size_t total_rdtsc = 0;
 
+  Common::PerfEventCounter branch_miss_counter(PERF_COUNT_HW_BRANCH_MISSES);
+  branch_miss_counter.start();
+
   for (size_t i = 0; i < loop_count; ++i) {
     const auto& client_request = client_requests[i];
     switch (client_request.type_) {
@@ -30,17 +34,31 @@ size_t benchmarkHashMap(T *order_book, const std::vector<Exchange::MEClientReque
     }
   }
 
+  *branch_misses = branch_miss_counter.stop();
+  if (!branch_miss_counter.available())
+    *branch_misses = std::numeric_limits<uint64_t>::max();
+
   return (total_rdtsc / (loop_count * 2));
 }
 
+/// Print clock cycles and, if the hardware counter was available, branch misses per operation.
+void printResult(const std::string &name, size_t cycles, uint64_t branch_misses) {
+  std::cout << name << " " << cycles << " CLOCK CYCLES PER OPERATION. ";
+  if (branch_misses == std::numeric_limits<uint64_t>::max())
+    std::cout << "BRANCH-MISSES PER OPERATION n/a." << std::endl;
+  else
+    std::cout << static_cast<double>(branch_misses) / loop_count << " BRANCH-MISSES PER OPERATION." << std::endl;
+}
+
 int main(int, char **) {
   srand(0);
 
-  Common::Logger logger("hash_benchmark.log");
+  // Logging is disabled, otherwise formatting the log lines dominates the cost of the order book operations.
+  Common::Logger logger("");
   Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
   Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
   Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
-  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "");
 
   Common::OrderId order_id = 1000;
   std::vector<Exchange::MEClientRequest> client_requests_vec;
@@ -61,15 +79,18 @@ int main(int, char **) {
   }
 
   {
-    auto me_order_book = new Exchange::MEOrderBook(0, &logger, matching_engine);
-    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec);
-    std::cout << "ARRAY HASHMAP " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+    Exchange::MEOrderBookPools order_book_pools(Common::EngineLimits{});
+    auto me_order_book = new Exchange::MEOrderBook(0, &logger, matching_engine, &order_book_pools);
+    uint64_t branch_misses = 0;
+    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec, &branch_misses);
+    printResult("ARRAY HASHMAP", cycles, branch_misses);
   }
 
   {
-    auto me_order_book = new Exchange::UnorderedMapMEOrderBook(0, &logger, matching_engine);
-    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec);
-    std::cout << "UNORDERED-MAP HASHMAP " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+    auto me_order_book = new Exchange::UnorderedMapMEOrderBook(0, &logger, matching_engine, Common::EngineLimits());
+    uint64_t branch_misses = 0;
+    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec, &branch_misses);
+    printResult("UNORDERED-MAP HASHMAP", cycles, branch_misses);
   }
 
   exit(EXIT_SUCCESS);
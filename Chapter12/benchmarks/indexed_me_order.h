@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <sstream>
+#include "common/types.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Index of an order in an IndexedMEOrderPool, 32 bits halve the size of the FIFO links compared to pointers.
+  typedef uint32_t OrderIndex;
+  constexpr auto OrderIndex_INVALID = std::numeric_limits<OrderIndex>::max();
+
+  /// Fields of an order in the limit order book which the matching loop touches - remaining quantity, owner, FIFO links and priority.
+  /// The price is kept here too since cancel needs it to find the price level.
+  /// Exactly 32 bytes and aligned to 32 bytes, so two nodes share a cache line and a node never straddles two.
+  struct alignas(32) MEOrderHot {
+    Qty qty_ = Qty_INVALID;
+    ClientId client_id_ = ClientId_INVALID;
+
+    /// MEOrderHot also serves as a node in a doubly linked list of all orders at price level arranged in FIFO order.
+    OrderIndex prev_order_ = OrderIndex_INVALID;
+    OrderIndex next_order_ = OrderIndex_INVALID;
+
+    Priority priority_ = Priority_INVALID;
+    Price price_ = Price_INVALID;
+  };
+
+  static_assert(sizeof(MEOrderHot) == 32, "MEOrderHot is expected to be exactly half a cache line.");
+
+  /// Fields of an order in the limit order book which are only needed to build client responses and market updates.
+  struct MEOrderCold {
+    OrderId client_order_id_ = OrderId_INVALID;
+    OrderId market_order_id_ = OrderId_INVALID;
+  };
+
+  /// Pre-allocated order nodes stored as two parallel arrays indexed by OrderIndex, one of MEOrderHot and one of MEOrderCold.
+  /// Free nodes are chained through MEOrderHot::next_order_ so allocation and deallocation never search for a free node.
+  class IndexedMEOrderPool final {
+  public:
+    explicit IndexedMEOrderPool(size_t num_elems)
+        : hot_(num_elems), cold_(num_elems) {
+      ASSERT(num_elems < OrderIndex_INVALID, "IndexedMEOrderPool size:" + std::to_string(num_elems) + " does not fit in an OrderIndex.");
+      for (size_t i = 0; i < num_elems; ++i)
+        hot_[i].next_order_ = (i + 1 < num_elems ? i + 1 : OrderIndex_INVALID);
+      free_head_ = (num_elems ? 0 : OrderIndex_INVALID);
+    }
+
+    /// Take a node off the free list, the caller initializes its hot and cold fields.
+    auto allocate() noexcept {
+      ASSERT(free_head_ != OrderIndex_INVALID, "IndexedMEOrderPool out of space.");
+      const auto index = free_head_;
+      free_head_ = hot_[index].next_order_;
+      return index;
+    }
+
+    /// Return the node back to the pool by pushing it on the free list.
+    auto deallocate(OrderIndex index) noexcept {
+      hot_[index].qty_ = Qty_INVALID;
+      hot_[index].prev_order_ = OrderIndex_INVALID;
+      hot_[index].next_order_ = free_head_;
+      free_head_ = index;
+    }
+
+    auto hot(OrderIndex index) noexcept -> MEOrderHot & {
+      return hot_[index];
+    }
+
+    auto hot(OrderIndex index) const noexcept -> const MEOrderHot & {
+      return hot_[index];
+    }
+
+    auto cold(OrderIndex index) noexcept -> MEOrderCold & {
+      return cold_[index];
+    }
+
+    auto cold(OrderIndex index) const noexcept -> const MEOrderCold & {
+      return cold_[index];
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    IndexedMEOrderPool() = delete;
+
+    IndexedMEOrderPool(const IndexedMEOrderPool &) = delete;
+
+    IndexedMEOrderPool(const IndexedMEOrderPool &&) = delete;
+
+    IndexedMEOrderPool &operator=(const IndexedMEOrderPool &) = delete;
+
+    IndexedMEOrderPool &operator=(const IndexedMEOrderPool &&) = delete;
+
+  private:
+    std::vector<MEOrderHot> hot_;
+    std::vector<MEOrderCold> cold_;
+
+    OrderIndex free_head_ = OrderIndex_INVALID;
+  };
+
+  /// Used by the IndexedMEOrderBook to represent a price level in the limit order book.
+  /// Internally maintains a list of orders in an IndexedMEOrderPool arranged in FIFO order.
+  struct IndexedMEOrdersAtPrice {
+    Side side_ = Side::INVALID;
+    Price price_ = Price_INVALID;
+
+    OrderIndex first_order_ = OrderIndex_INVALID;
+
+    /// IndexedMEOrdersAtPrice also serves as a node in a doubly linked list of price levels arranged in order from most aggressive to least aggressive price.
+    IndexedMEOrdersAtPrice *prev_entry_ = nullptr;
+    IndexedMEOrdersAtPrice *next_entry_ = nullptr;
+
+    /// Only needed for use with MemPool.
+    IndexedMEOrdersAtPrice() = default;
+
+    IndexedMEOrdersAtPrice(Side side, Price price, OrderIndex first_order, IndexedMEOrdersAtPrice *prev_entry, IndexedMEOrdersAtPrice *next_entry)
+        : side_(side), price_(price), first_order_(first_order), prev_entry_(prev_entry), next_entry_(next_entry) {}
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "IndexedMEOrdersAtPrice["
+         << "side:" << sideToString(side_) << " "
+         << "price:" << priceToString(price_) << " "
+         << "first_order:" << first_order_ << " "
+         << "prev:" << priceToString(prev_entry_ ? prev_entry_->price_ : Price_INVALID) << " "
+         << "next:" << priceToString(next_entry_ ? next_entry_->price_ : Price_INVALID) << "]";
+
+      return ss.str();
+    }
+  };
+}
@@ -0,0 +1,220 @@
+#include "indexed_me_order_book.h"
+
+#include "matcher/matching_engine.h"
+
+namespace Exchange {
+  IndexedMEOrderBook::IndexedMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, const EngineLimits &limits)
+      : ticker_id_(ticker_id), max_order_ids_(limits.max_order_ids_), price_level_mask_(limits.max_price_levels_ - 1),
+        matching_engine_(matching_engine), cid_oid_to_order_(limits.max_num_clients_), orders_at_price_pool_(limits.max_price_levels_),
+        price_orders_at_price_(limits.max_price_levels_, nullptr), order_pool_(limits.max_order_ids_), logger_(logger) {
+    ASSERT(limits.isValid(), "Invalid " + limits.toString());
+  }
+
+  IndexedMEOrderBook::~IndexedMEOrderBook() {
+    if (logger_->enabled())
+      logger_->log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                   toString(false, true));
+
+    matching_engine_ = nullptr;
+    bids_by_price_ = asks_by_price_ = nullptr;
+  }
+
+  /// Match a new aggressive order with the provided parameters against the passive order at index in the orders_at_price level and generate client responses and market updates for the match.
+  /// It will update the passive order based on the match and possibly remove it if fully matched.
+  /// It will return remaining quantity on the aggressive order in the leaves_qty parameter.
+  auto IndexedMEOrderBook::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id,
+                                 IndexedMEOrdersAtPrice *orders_at_price, OrderIndex index, Qty *leaves_qty) noexcept {
+    auto &order = order_pool_.hot(index);
+    const auto &order_cold = order_pool_.cold(index);
+    const auto price = orders_at_price->price_;
+    const auto order_side = orders_at_price->side_;
+    const auto order_qty = order.qty_;
+    const auto fill_qty = std::min(*leaves_qty, order_qty);
+
+    *leaves_qty -= fill_qty;
+    order.qty_ -= fill_qty;
+
+    client_response_ = {ClientResponseType::FILLED, client_id, ticker_id, client_order_id,
+                        new_market_order_id, side, price, fill_qty, *leaves_qty};
+    matching_engine_->sendClientResponse(&client_response_);
+
+    client_response_ = {ClientResponseType::FILLED, order.client_id_, ticker_id, order_cold.client_order_id_,
+                        order_cold.market_order_id_, order_side, price, fill_qty, order.qty_};
+    matching_engine_->sendClientResponse(&client_response_);
+
+    market_update_ = {MarketUpdateType::TRADE, OrderId_INVALID, ticker_id, side, price, fill_qty, Priority_INVALID};
+    matching_engine_->sendMarketUpdate(&market_update_);
+
+    if (!order.qty_) {
+      market_update_ = {MarketUpdateType::CANCEL, order_cold.market_order_id_, ticker_id, order_side,
+                        price, order_qty, Priority_INVALID};
+      matching_engine_->sendMarketUpdate(&market_update_);
+
+      START_MEASURE(Exchange_IndexedMEOrderBook_removeOrder);
+      removeOrder(orders_at_price, index);
+      END_MEASURE(Exchange_IndexedMEOrderBook_removeOrder, (*logger_));
+    } else {
+      market_update_ = {MarketUpdateType::MODIFY, order_cold.market_order_id_, ticker_id, order_side,
+                        price, order.qty_, order.priority_};
+      matching_engine_->sendMarketUpdate(&market_update_);
+    }
+  }
+
+  /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
+  /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
+  auto IndexedMEOrderBook::checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty,
+                                         OrderId new_market_order_id) noexcept {
+    auto leaves_qty = qty;
+
+    if (side == Side::BUY) {
+      while (leaves_qty && asks_by_price_) {
+        if (LIKELY(price < asks_by_price_->price_)) {
+          break;
+        }
+
+        START_MEASURE(Exchange_IndexedMEOrderBook_match);
+        match(ticker_id, client_id, side, client_order_id, new_market_order_id, asks_by_price_, asks_by_price_->first_order_, &leaves_qty);
+        END_MEASURE(Exchange_IndexedMEOrderBook_match, (*logger_));
+      }
+    }
+    if (side == Side::SELL) {
+      while (leaves_qty && bids_by_price_) {
+        if (LIKELY(price > bids_by_price_->price_)) {
+          break;
+        }
+
+        START_MEASURE(Exchange_IndexedMEOrderBook_match);
+        match(ticker_id, client_id, side, client_order_id, new_market_order_id, bids_by_price_, bids_by_price_->first_order_, &leaves_qty);
+        END_MEASURE(Exchange_IndexedMEOrderBook_match, (*logger_));
+      }
+    }
+
+    return leaves_qty;
+  }
+
+  /// Create and add a new order in the order book with provided attributes.
+  /// It will check to see if this new order matches an existing passive order with opposite side, and perform the matching if that is the case.
+  auto IndexedMEOrderBook::add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void {
+    const auto new_market_order_id = generateNewMarketOrderId();
+    client_response_ = {ClientResponseType::ACCEPTED, client_id, ticker_id, client_order_id, new_market_order_id, side, price, 0, qty};
+    matching_engine_->sendClientResponse(&client_response_);
+
+    START_MEASURE(Exchange_IndexedMEOrderBook_checkForMatch);
+    const auto leaves_qty = checkForMatch(client_id, client_order_id, ticker_id, side, price, qty, new_market_order_id);
+    END_MEASURE(Exchange_IndexedMEOrderBook_checkForMatch, (*logger_));
+
+    if (LIKELY(leaves_qty)) {
+      const auto priority = getNextPriority(price);
+
+      const auto index = order_pool_.allocate();
+      order_pool_.hot(index) = {leaves_qty, client_id, OrderIndex_INVALID, OrderIndex_INVALID, priority, price};
+      order_pool_.cold(index) = {client_order_id, new_market_order_id};
+      START_MEASURE(Exchange_IndexedMEOrderBook_addOrder);
+      addOrder(index, side);
+      END_MEASURE(Exchange_IndexedMEOrderBook_addOrder, (*logger_));
+
+      market_update_ = {MarketUpdateType::ADD, new_market_order_id, ticker_id, side, price, leaves_qty, priority};
+      matching_engine_->sendMarketUpdate(&market_update_);
+    }
+  }
+
+  /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
+  auto IndexedMEOrderBook::cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void {
+    auto index = OrderIndex_INVALID;
+    if (LIKELY(client_id < cid_oid_to_order_.size())) {
+      const auto &oid_to_order = cid_oid_to_order_[client_id];
+      index = (order_id < oid_to_order.size() ? oid_to_order[order_id] : OrderIndex_INVALID);
+    }
+
+    if (UNLIKELY(index == OrderIndex_INVALID)) {
+      client_response_ = {ClientResponseType::CANCEL_REJECTED, client_id, ticker_id, order_id, OrderId_INVALID,
+                          Side::INVALID, Price_INVALID, Qty_INVALID, Qty_INVALID};
+    } else {
+      const auto &order = order_pool_.hot(index);
+      const auto &order_cold = order_pool_.cold(index);
+      const auto orders_at_price = getOrdersAtPrice(order.price_);
+      const auto side = orders_at_price->side_;
+
+      client_response_ = {ClientResponseType::CANCELED, client_id, ticker_id, order_id, order_cold.market_order_id_,
+                          side, order.price_, Qty_INVALID, order.qty_};
+      market_update_ = {MarketUpdateType::CANCEL, order_cold.market_order_id_, ticker_id, side, order.price_, 0, order.priority_};
+
+      START_MEASURE(Exchange_IndexedMEOrderBook_removeOrder);
+      removeOrder(orders_at_price, index);
+      END_MEASURE(Exchange_IndexedMEOrderBook_removeOrder, (*logger_));
+
+      matching_engine_->sendMarketUpdate(&market_update_);
+    }
+
+    matching_engine_->sendClientResponse(&client_response_);
+  }
+
+  auto IndexedMEOrderBook::toString(bool detailed, bool validity_check) const -> std::string {
+    std::stringstream ss;
+
+    auto printer = [&](std::stringstream &ss, IndexedMEOrdersAtPrice *itr, Side side, Price &last_price, bool sanity_check) {
+      char buf[4096];
+      Qty qty = 0;
+      size_t num_orders = 0;
+
+      for (auto o_itr = itr->first_order_;; o_itr = order_pool_.hot(o_itr).next_order_) {
+        qty += order_pool_.hot(o_itr).qty_;
+        ++num_orders;
+        if (order_pool_.hot(o_itr).next_order_ == itr->first_order_)
+          break;
+      }
+      sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
+              priceToString(itr->price_).c_str(), priceToString(itr->prev_entry_->price_).c_str(), priceToString(itr->next_entry_->price_).c_str(),
+              priceToString(itr->price_).c_str(), qtyToString(qty).c_str(), std::to_string(num_orders).c_str());
+      ss << buf;
+      for (auto o_itr = itr->first_order_;; o_itr = order_pool_.hot(o_itr).next_order_) {
+        const auto &order = order_pool_.hot(o_itr);
+        if (detailed) {
+          sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
+                  orderIdToString(order_pool_.cold(o_itr).market_order_id_).c_str(), qtyToString(order.qty_).c_str(),
+                  orderIdToString(order_pool_.cold(order.prev_order_).market_order_id_).c_str(),
+                  orderIdToString(order_pool_.cold(order.next_order_).market_order_id_).c_str());
+          ss << buf;
+        }
+        if (order.next_order_ == itr->first_order_)
+          break;
+      }
+
+      ss << std::endl;
+
+      if (sanity_check) {
+        if ((side == Side::SELL && last_price >= itr->price_) || (side == Side::BUY && last_price <= itr->price_)) {
+          FATAL("Bids/Asks not sorted by ascending/descending prices last:" + priceToString(last_price) + " itr:" + itr->toString());
+        }
+        last_price = itr->price_;
+      }
+    };
+
+    ss << "Ticker:" << tickerIdToString(ticker_id_) << std::endl;
+    {
+      auto ask_itr = asks_by_price_;
+      auto last_ask_price = std::numeric_limits<Price>::min();
+      for (size_t count = 0; ask_itr; ++count) {
+        ss << "ASKS L:" << count << " => ";
+        auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price_ ? nullptr : ask_itr->next_entry_);
+        printer(ss, ask_itr, Side::SELL, last_ask_price, validity_check);
+        ask_itr = next_ask_itr;
+      }
+    }
+
+    ss << std::endl << "                          X" << std::endl << std::endl;
+
+    {
+      auto bid_itr = bids_by_price_;
+      auto last_bid_price = std::numeric_limits<Price>::max();
+      for (size_t count = 0; bid_itr; ++count) {
+        ss << "BIDS L:" << count << " => ";
+        auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price_ ? nullptr : bid_itr->next_entry_);
+        printer(ss, bid_itr, Side::BUY, last_bid_price, validity_check);
+        bid_itr = next_bid_itr;
+      }
+    }
+
+    return ss.str();
+  }
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/mem_pool.h"
+#include "common/logging.h"
+#include "order_server/client_response.h"
+#include "market_data/market_update.h"
+
+#include "indexed_me_order.h"
+
+using namespace Common;
+
+namespace Exchange {
+  class MatchingEngine;
+
+  /// Alternative to MEOrderBook which splits every order into a 32 byte MEOrderHot node with 32-bit FIFO links and a parallel MEOrderCold record.
+  /// The matching loop walks the MEOrderHot array only and reads MEOrderCold once per passive order filled.
+  /// Not part of the exchange, it is only built into order_node_benchmark to compare against MEOrderBook.
+  class IndexedMEOrderBook final {
+  public:
+    IndexedMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, const EngineLimits &limits);
+
+    ~IndexedMEOrderBook();
+
+    /// Create and add a new order in the order book with provided attributes.
+    /// It will check to see if this new order matches an existing passive order with opposite side, and perform the matching if that is the case.
+    auto add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void;
+
+    /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
+    auto cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void;
+
+    auto toString(bool detailed, bool validity_check) const -> std::string;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    IndexedMEOrderBook() = delete;
+
+    IndexedMEOrderBook(const IndexedMEOrderBook &) = delete;
+
+    IndexedMEOrderBook(const IndexedMEOrderBook &&) = delete;
+
+    IndexedMEOrderBook &operator=(const IndexedMEOrderBook &) = delete;
+
+    IndexedMEOrderBook &operator=(const IndexedMEOrderBook &&) = delete;
+
+  private:
+    TickerId ticker_id_ = TickerId_INVALID;
+
+    /// Capacity of the per client order index hash map and mask to convert a price to an index into price_orders_at_price_.
+    const size_t max_order_ids_;
+    const Price price_level_mask_;
+
+    /// The parent matching engine instance, used to publish market data and client responses.
+    MatchingEngine *matching_engine_ = nullptr;
+
+    /// Hash map from ClientId -> OrderId -> OrderIndex, the OrderHashMap for a client grows with the order ids it uses.
+    std::vector<std::vector<OrderIndex>> cid_oid_to_order_;
+
+    /// Memory pool to manage IndexedMEOrdersAtPrice objects.
+    MemPool<IndexedMEOrdersAtPrice> orders_at_price_pool_;
+
+    /// Pointers to beginning / best prices / top of book of buy and sell price levels.
+    IndexedMEOrdersAtPrice *bids_by_price_ = nullptr;
+    IndexedMEOrdersAtPrice *asks_by_price_ = nullptr;
+
+    /// Hash map from Price -> IndexedMEOrdersAtPrice.
+    std::vector<IndexedMEOrdersAtPrice *> price_orders_at_price_;
+
+    /// Hot and cold order nodes.
+    IndexedMEOrderPool order_pool_;
+
+    /// These are used to publish client responses and market updates.
+    MEClientResponse client_response_;
+    MEMarketUpdate market_update_;
+
+    OrderId next_market_order_id_ = 1;
+
+    std::string time_str_;
+    Logger *logger_ = nullptr;
+
+  private:
+    auto generateNewMarketOrderId() noexcept -> OrderId {
+      return next_market_order_id_++;
+    }
+
+    auto priceToIndex(Price price) const noexcept {
+      return static_cast<size_t>(price & price_level_mask_);
+    }
+
+    /// Fetch and return the IndexedMEOrdersAtPrice corresponding to the provided price.
+    auto getOrdersAtPrice(Price price) const noexcept -> IndexedMEOrdersAtPrice * {
+      return price_orders_at_price_[priceToIndex(price)];
+    }
+
+    /// Add a new IndexedMEOrdersAtPrice at the correct price into the containers - the hash map and the doubly linked list of price levels.
+    auto addOrdersAtPrice(IndexedMEOrdersAtPrice *new_orders_at_price) noexcept {
+      price_orders_at_price_[priceToIndex(new_orders_at_price->price_)] = new_orders_at_price;
+
+      const auto best_orders_by_price = (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_);
+      if (UNLIKELY(!best_orders_by_price)) {
+        (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) = new_orders_at_price;
+        new_orders_at_price->prev_entry_ = new_orders_at_price->next_entry_ = new_orders_at_price;
+      } else {
+        auto target = best_orders_by_price;
+        bool add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                          (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
+        if (add_after) {
+          target = target->next_entry_;
+          add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                       (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
+        }
+        while (add_after && target != best_orders_by_price) {
+          add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                       (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
+          if (add_after)
+            target = target->next_entry_;
+        }
+
+        if (add_after) { // add new_orders_at_price after target.
+          if (target == best_orders_by_price) {
+            target = best_orders_by_price->prev_entry_;
+          }
+          new_orders_at_price->prev_entry_ = target;
+          target->next_entry_->prev_entry_ = new_orders_at_price;
+          new_orders_at_price->next_entry_ = target->next_entry_;
+          target->next_entry_ = new_orders_at_price;
+        } else { // add new_orders_at_price before target.
+          new_orders_at_price->prev_entry_ = target->prev_entry_;
+          new_orders_at_price->next_entry_ = target;
+          target->prev_entry_->next_entry_ = new_orders_at_price;
+          target->prev_entry_ = new_orders_at_price;
+
+          if ((new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ > best_orders_by_price->price_) ||
+              (new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ < best_orders_by_price->price_)) {
+            target->next_entry_ = (target->next_entry_ == best_orders_by_price ? new_orders_at_price : target->next_entry_);
+            (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) = new_orders_at_price;
+          }
+        }
+      }
+    }
+
+    /// Remove the IndexedMEOrdersAtPrice from the containers - the hash map and the doubly linked list of price levels.
+    auto removeOrdersAtPrice(IndexedMEOrdersAtPrice *orders_at_price) noexcept {
+      const auto side = orders_at_price->side_;
+      const auto best_orders_by_price = (side == Side::BUY ? bids_by_price_ : asks_by_price_);
+
+      if (UNLIKELY(orders_at_price->next_entry_ == orders_at_price)) { // empty side of book.
+        (side == Side::BUY ? bids_by_price_ : asks_by_price_) = nullptr;
+      } else {
+        orders_at_price->prev_entry_->next_entry_ = orders_at_price->next_entry_;
+        orders_at_price->next_entry_->prev_entry_ = orders_at_price->prev_entry_;
+
+        if (orders_at_price == best_orders_by_price) {
+          (side == Side::BUY ? bids_by_price_ : asks_by_price_) = orders_at_price->next_entry_;
+        }
+
+        orders_at_price->prev_entry_ = orders_at_price->next_entry_ = nullptr;
+      }
+
+      price_orders_at_price_[priceToIndex(orders_at_price->price_)] = nullptr;
+
+      orders_at_price_pool_.deallocate(orders_at_price);
+    }
+
+    auto getNextPriority(Price price) noexcept {
+      const auto orders_at_price = getOrdersAtPrice(price);
+      if (!orders_at_price)
+        return 1lu;
+
+      return order_pool_.hot(order_pool_.hot(orders_at_price->first_order_).prev_order_).priority_ + 1;
+    }
+
+    /// Match a new aggressive order with the provided parameters against the passive order at index in the orders_at_price level and generate client responses and market updates for the match.
+    /// It will update the passive order based on the match and possibly remove it if fully matched.
+    /// It will return remaining quantity on the aggressive order in the leaves_qty parameter.
+    auto match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id,
+               IndexedMEOrdersAtPrice *orders_at_price, OrderIndex index, Qty *leaves_qty) noexcept;
+
+    /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
+    /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
+    auto checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, OrderId new_market_order_id) noexcept;
+
+    /// Unlink the order at index from its price level, removing the price level if it becomes empty, and de-allocate it.
+    auto removeOrder(IndexedMEOrdersAtPrice *orders_at_price, OrderIndex index) noexcept {
+      auto &order = order_pool_.hot(index);
+
+      if (order.prev_order_ == index) { // only one element.
+        removeOrdersAtPrice(orders_at_price);
+      } else { // remove the link.
+        order_pool_.hot(order.prev_order_).next_order_ = order.next_order_;
+        order_pool_.hot(order.next_order_).prev_order_ = order.prev_order_;
+
+        if (orders_at_price->first_order_ == index) {
+          orders_at_price->first_order_ = order.next_order_;
+        }
+      }
+
+      cid_oid_to_order_[order.client_id_][order_pool_.cold(index).client_order_id_] = OrderIndex_INVALID;
+      order_pool_.deallocate(index);
+    }
+
+    /// Add the order at index at the end of the FIFO queue at the price level that this order belongs in.
+    auto addOrder(OrderIndex index, Side side) noexcept {
+      auto &order = order_pool_.hot(index);
+      const auto orders_at_price = getOrdersAtPrice(order.price_);
+
+      if (!orders_at_price) {
+        order.next_order_ = order.prev_order_ = index;
+
+        auto new_orders_at_price = orders_at_price_pool_.allocate(side, order.price_, index, nullptr, nullptr);
+        addOrdersAtPrice(new_orders_at_price);
+      } else {
+        const auto first_index = orders_at_price->first_order_;
+        auto &first_order = order_pool_.hot(first_index);
+
+        order_pool_.hot(first_order.prev_order_).next_order_ = index;
+        order.prev_order_ = first_order.prev_order_;
+        order.next_order_ = first_index;
+        first_order.prev_order_ = index;
+      }
+
+      const auto client_order_id = order_pool_.cold(index).client_order_id_;
+      auto &oid_to_order = cid_oid_to_order_.at(order.client_id_);
+      if (UNLIKELY(client_order_id >= oid_to_order.size())) {
+        ASSERT(client_order_id < max_order_ids_, "Order id beyond limits:" + std::to_string(client_order_id));
+        oid_to_order.resize(std::min(max_order_ids_, std::max<size_t>(client_order_id + 1, 2 * oid_to_order.size())), OrderIndex_INVALID);
+      }
+      oid_to_order[client_order_id] = index;
+    }
+  };
+}
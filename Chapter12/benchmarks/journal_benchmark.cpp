@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "matcher/matching_engine.h"
+#include "order_server/fifo_sequencer.h"
+#include "journal/journal.h"
+
+static constexpr size_t loop_count = 20000;
+static constexpr size_t batch_size = 16;
+
+/// Return the p-th percentile of the provided samples.
+size_t percentile(std::vector<size_t> samples, double p) {
+  std::sort(samples.begin(), samples.end());
+  return samples[static_cast<size_t>(p * (samples.size() - 1))];
+}
+
+/// Push the client requests through a FIFOSequencer (with or without a journal writer attached) into the matching engine.
+/// Measures the sequencing cost and the matching engine processing cost per client request.
+void benchmarkJournal(const std::string &name, Exchange::MatchingEngine *matching_engine, const std::vector<Exchange::MEClientRequest> &client_requests,
+                      Exchange::ClientRequestLFQueue *me_requests, Exchange::ClientResponseLFQueue *me_responses, Exchange::MEMarketUpdateLFQueue *me_updates,
+                      Common::Logger *logger, const Exchange::JournalCfg *journal_cfg) {
+  Exchange::JournalRecordLFQueue journal_records(Exchange::ME_MAX_JOURNAL_RECORDS);
+  Exchange::Journal *journal = nullptr;
+  if (journal_cfg) {
+    journal = new Exchange::Journal(&journal_records, *journal_cfg);
+    journal->start();
+  }
+
+  Exchange::FIFOSequencer fifo_sequencer(me_requests, (journal ? &journal_records : nullptr), logger);
+
+  std::vector<size_t> sequencer_cycles, me_cycles;
+  for (size_t i = 0; i < client_requests.size(); i += batch_size) {
+    for (size_t j = i; j < std::min(i + batch_size, client_requests.size()); ++j)
+      fifo_sequencer.addClientRequest(Common::getCurrentNanos(), client_requests[j]);
+
+    // Requests held back by a full journal queue stay pending in the sequencer until the journal writer catches up.
+    do {
+      const auto start = Common::rdtsc();
+      fifo_sequencer.sequenceAndPublish();
+      sequencer_cycles.push_back((Common::rdtsc() - start) / batch_size);
+
+      for (auto request = me_requests->getNextToRead(); request; request = me_requests->getNextToRead()) {
+        const auto me_start = Common::rdtsc();
+        matching_engine->processClientRequest(request);
+        me_cycles.push_back(Common::rdtsc() - me_start);
+        me_requests->updateReadIndex();
+      }
+    } while (fifo_sequencer.size());
+
+    // Nothing consumes responses and market updates in this benchmark, so discard them.
+    while (me_responses->size())
+      me_responses->updateReadIndex();
+    while (me_updates->size())
+      me_updates->updateReadIndex();
+  }
+
+  size_t num_records = 0, num_syncs = 0;
+  if (journal) {
+    journal->stop(); // drains the remaining records and syncs before returning.
+    num_records = journal->numRecords();
+    num_syncs = journal->numSyncs();
+    delete journal;
+  }
+
+  std::cout << name
+            << " SEQUENCER p50:" << percentile(sequencer_cycles, 0.5) << " p99:" << percentile(sequencer_cycles, 0.99)
+            << " MATCHING-ENGINE p50:" << percentile(me_cycles, 0.5) << " p99:" << percentile(me_cycles, 0.99)
+            << " CLOCK CYCLES PER REQUEST."
+            << " journaled:" << num_records << " syncs:" << num_syncs
+            << " journal queue high water mark:" << fifo_sequencer.journalHighWaterMark() << " stalls:" << fifo_sequencer.numStalls() << std::endl;
+}
+
+int main(int argc, char **argv) {
+  srand(0);
+
+  const std::string journal_dir = (argc > 1 ? argv[1] : ".");
+
+  // Logging is disabled, otherwise formatting the log lines dominates the matching engine latencies and hides what the journal adds.
+  Common::Logger logger("");
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "");
+
+  Common::OrderId order_id = 1000;
+  std::vector<Exchange::MEClientRequest> client_requests_vec;
+  Price base_price = (rand() % 100) + 100;
+  while (client_requests_vec.size() < loop_count) {
+    const Price price = base_price + (rand() % 10) + 1;
+    const Qty qty = 1 + (rand() % 100) + 1;
+    const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+
+    Exchange::MEClientRequest new_request{Exchange::ClientRequestType::NEW, 0, 0, order_id++, side, price, qty};
+    client_requests_vec.push_back(new_request);
+
+    const auto cxl_index = rand() % client_requests_vec.size();
+    auto cxl_request = client_requests_vec[cxl_index];
+    cxl_request.type_ = Exchange::ClientRequestType::CANCEL;
+
+    client_requests_vec.push_back(cxl_request);
+  }
+
+  benchmarkJournal("NO-JOURNAL", matching_engine, client_requests_vec, &client_requests, &client_responses, &market_updates, &logger, nullptr);
+
+  for (auto sync_mode: {Exchange::JournalSyncMode::NONE, Exchange::JournalSyncMode::MSYNC_ASYNC,
+                        Exchange::JournalSyncMode::MSYNC_SYNC, Exchange::JournalSyncMode::FDATASYNC}) {
+    Exchange::JournalCfg journal_cfg;
+    journal_cfg.dir_ = journal_dir;
+    journal_cfg.prefix_ = "journal_benchmark_" + Exchange::journalSyncModeToString(sync_mode);
+    journal_cfg.file_size_ = 16 * 1024 * 1024;
+    journal_cfg.sync_mode_ = sync_mode;
+
+    benchmarkJournal("JOURNAL-" + Exchange::journalSyncModeToString(sync_mode), matching_engine, client_requests_vec,
+                     &client_requests, &client_responses, &market_updates, &logger, &journal_cfg);
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,70 @@
+#include <fstream>
+#include <sys/wait.h>
+
+#include "matcher/matching_engine.h"
+#include "strategy/market_order_book.h"
+
+/// A deployment trading a single symbol for a handful of clients, with its capacities baked in as compile time constants.
+typedef Common::FixedEngineLimits<1, 16, 64 * 1024, 256, 64 * 1024, 64 * 1024> SmallEngineLimits;
+
+/// Resident set size of this process in bytes.
+size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0, resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+/// Create the lock free queues, the matching engine and a trade engine's worth of market order books sized from the provided limits.
+/// Reports the time taken and the resident memory they add to the process.
+void benchmarkLimits(const std::string &name, const Common::EngineLimits &limits) {
+  const auto rss_before = residentBytes();
+  const auto start_time = Common::getCurrentNanos();
+
+  auto client_requests = new Exchange::ClientRequestLFQueue(limits.max_client_updates_);
+  auto client_responses = new Exchange::ClientResponseLFQueue(limits.max_client_updates_);
+  auto market_updates = new Exchange::MEMarketUpdateLFQueue(limits.max_market_updates_);
+  auto matching_engine = new Exchange::MatchingEngine(client_requests, client_responses, market_updates, "", nullptr, limits);
+
+  Common::Logger logger("");
+  auto market_order_book_pools = new Trading::MarketOrderBookPools(limits);
+  std::vector<Trading::MarketOrderBook *> market_order_books;
+  for (size_t i = 0; i < limits.max_tickers_; ++i)
+    market_order_books.push_back(new Trading::MarketOrderBook(i, &logger, market_order_book_pools));
+
+  const auto elapsed = Common::getCurrentNanos() - start_time;
+  const auto rss_after = residentBytes();
+
+  std::cout << name << " " << limits.toString() << " STARTUP " << elapsed / NANOS_TO_MICROS << " us."
+            << " RESIDENT " << (rss_after - rss_before) / (1024 * 1024) << " MB." << std::endl;
+
+  for (auto market_order_book: market_order_books)
+    delete market_order_book;
+  delete market_order_book_pools;
+  delete matching_engine;
+  delete market_updates;
+  delete client_responses;
+  delete client_requests;
+}
+
+int main(int, char **) {
+  const std::vector<std::pair<std::string, Common::EngineLimits>> profiles = {{"SMALL", SmallEngineLimits::limits()},
+                                                                              {"LARGE", Common::DefaultEngineLimits::limits()}};
+
+  // Every profile runs in a fresh child process so that the resident memory of one does not hide that of the next.
+  for (const auto &[name, limits]: profiles) {
+    const auto pid = fork();
+    ASSERT(pid >= 0, "fork() failed error:" + std::string(std::strerror(errno)));
+    if (!pid) {
+      benchmarkLimits(name, limits);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+      exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -1,6 +1,8 @@
 #include "common/logging.h"
 #include "common/opt_logging.h"
 
+#include <algorithm>
+
 std::string random_string(size_t length) {
   auto randchar = []() -> char {
     const char charset[] =
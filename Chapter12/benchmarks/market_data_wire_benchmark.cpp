@@ -0,0 +1,207 @@
+#include <iomanip>
+#include <map>
+
+#include "common/time_utils.h"
+
+#include "exchange/market_data/market_data_wire.h"
+
+static constexpr size_t num_updates = 1000000;
+static constexpr size_t num_tickers = 8;
+
+/// Decoding is repeated this many times and the fastest pass reported.
+static constexpr size_t num_passes = 5;
+
+/// Incremental updates of one channel the way the matching engine produces them - orders added within 5 ticks of a slowly moving mid price with the
+/// priority of their price level's FIFO queue, cancelled, partially cancelled and filled by a TRADE followed by a MODIFY or CANCEL of the passive order.
+struct OrderFlow {
+  struct Order {
+    Common::OrderId order_id_;
+    Common::Side side_;
+    Common::Price price_;
+    Common::Qty qty_;
+    Common::Priority priority_;
+  };
+
+  /// Last priority given out and number of orders at every price level of a ticker.
+  struct Level {
+    Common::Priority last_priority_ = 0;
+    size_t num_orders_ = 0;
+  };
+
+  OrderFlow() {
+    srand(0);
+    for (Common::TickerId ticker_id = 0; ticker_id < num_tickers; ++ticker_id)
+      mid_price_[ticker_id] = static_cast<Common::Price>(1000 + 100 * ticker_id);
+    while (updates_.size() < num_updates)
+      next();
+  }
+
+  auto add(Exchange::MarketUpdateType type, Common::TickerId ticker_id, Common::OrderId order_id, Common::Side side, Common::Price price, Common::Qty qty,
+           Common::Priority priority) -> void {
+    updates_.push_back({updates_.size() + 1, ++ticker_seq_num_[ticker_id], {type, order_id, ticker_id, side, price, qty, priority}});
+  }
+
+  auto remove(Common::TickerId ticker_id, size_t index) -> void {
+    auto &orders = live_orders_[ticker_id];
+    auto &level = levels_[ticker_id][orders[index].price_];
+    if (!--level.num_orders_)
+      level.last_priority_ = 0;
+    orders[index] = orders.back();
+    orders.pop_back();
+  }
+
+  auto next() -> void {
+    const auto ticker_id = static_cast<Common::TickerId>(rand() % num_tickers);
+    auto &orders = live_orders_[ticker_id];
+    auto &mid_price = mid_price_[ticker_id];
+    if (rand() % 100 == 0)
+      mid_price += (rand() % 2 ? 1 : -1);
+    const auto action = (orders.size() < 20 ? 0 : rand() % 10);
+
+    if (action < 4) { // new order.
+      const auto side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+      const auto price = mid_price + (side == Common::Side::BUY ? -1 : 1) * (1 + rand() % 5);
+      auto &level = levels_[ticker_id][price];
+      ++level.num_orders_;
+      orders.push_back({++next_order_id_[ticker_id], side, price, static_cast<Common::Qty>(1 + rand() % 100), ++level.last_priority_});
+      const auto &order = orders.back();
+      add(Exchange::MarketUpdateType::ADD, ticker_id, order.order_id_, order.side_, order.price_, order.qty_, order.priority_);
+      return;
+    }
+
+    const auto index = static_cast<size_t>(rand()) % orders.size();
+    auto &order = orders[index];
+    if (action < 7) { // cancel.
+      add(Exchange::MarketUpdateType::CANCEL, ticker_id, order.order_id_, order.side_, order.price_, 0, order.priority_);
+      remove(ticker_id, index);
+    } else if (action < 8 && order.qty_ > 1) { // partial cancel.
+      order.qty_ = static_cast<Common::Qty>(1 + rand() % (order.qty_ - 1));
+      add(Exchange::MarketUpdateType::MODIFY, ticker_id, order.order_id_, order.side_, order.price_, order.qty_, order.priority_);
+    } else { // fill by an aggressive order on the other side.
+      const auto fill_qty = static_cast<Common::Qty>(1 + rand() % order.qty_);
+      add(Exchange::MarketUpdateType::TRADE, ticker_id, Common::OrderId_INVALID, (order.side_ == Common::Side::BUY ? Common::Side::SELL : Common::Side::BUY),
+          order.price_, fill_qty, Common::Priority_INVALID);
+      order.qty_ -= fill_qty;
+      if (order.qty_) {
+        add(Exchange::MarketUpdateType::MODIFY, ticker_id, order.order_id_, order.side_, order.price_, order.qty_, order.priority_);
+      } else {
+        add(Exchange::MarketUpdateType::CANCEL, ticker_id, order.order_id_, order.side_, order.price_, fill_qty, Common::Priority_INVALID);
+        remove(ticker_id, index);
+      }
+    }
+  }
+
+  std::vector<Exchange::MDPMarketUpdate> updates_;
+  std::vector<Order> live_orders_[num_tickers];
+  std::map<Common::Price, Level> levels_[num_tickers];
+  Common::Price mid_price_[num_tickers] = {};
+  Common::OrderId next_order_id_[num_tickers] = {};
+  size_t ticker_seq_num_[num_tickers] = {};
+};
+
+/// Stands in for the consumer processing a decoded update, so that decoding is not optimized away.
+struct Checksum {
+  auto operator()(const Exchange::MDPMarketUpdate &update) noexcept {
+    const auto &me_market_update = update.me_market_update_;
+    value_ += update.seq_num_ ^ update.ticker_seq_num_ ^ me_market_update.order_id_ ^ static_cast<uint64_t>(me_market_update.price_) ^
+              me_market_update.qty_ ^ me_market_update.priority_ ^ static_cast<uint64_t>(me_market_update.type_) ^ me_market_update.ticker_id_;
+  }
+
+  uint64_t value_ = 0;
+};
+
+/// Fastest of num_passes calls to decode, which returns the checksum of the updates it decoded.
+template<typename Decode>
+auto fastestPass(Decode &&decode, uint64_t &checksum) {
+  auto fastest = std::numeric_limits<Common::Nanos>::max();
+  for (size_t pass = 0; pass < num_passes; ++pass) {
+    const auto start = Common::getCurrentNanos();
+    checksum = decode();
+    fastest = std::min(fastest, Common::getCurrentNanos() - start);
+  }
+  return fastest;
+}
+
+/// Raw MDPMarketUpdate structs back to back, as the incremental channels send them without the compact encoding.
+auto benchmarkRaw(const OrderFlow &order_flow) {
+  std::vector<char> stream(order_flow.updates_.size() * sizeof(Exchange::MDPMarketUpdate));
+  memcpy(stream.data(), order_flow.updates_.data(), stream.size());
+
+  uint64_t checksum = 0;
+  const auto decode_time = fastestPass([&]() {
+    Checksum sink;
+    for (size_t i = 0; i + sizeof(Exchange::MDPMarketUpdate) <= stream.size(); i += sizeof(Exchange::MDPMarketUpdate))
+      sink(*reinterpret_cast<const Exchange::MDPMarketUpdate *>(stream.data() + i));
+    return sink.value_;
+  }, checksum);
+
+  std::cout << "RAW              bytes per update:" << std::setw(5) << static_cast<double>(stream.size()) / order_flow.updates_.size()
+            << " decode ns per update:" << std::setw(5) << static_cast<double>(decode_time) / order_flow.updates_.size() << std::endl;
+  return checksum;
+}
+
+/// Encode the updates in packets of at most batch_size updates, i.e. as if the market data publisher found batch_size updates queued up every time,
+/// then decode them and check that every update decodes back to exactly the update encoded.
+auto benchmarkCompact(const OrderFlow &order_flow, size_t batch_size) {
+  std::vector<char> stream;
+  stream.reserve(order_flow.updates_.size() * sizeof(Exchange::MDPMarketUpdate));
+  size_t num_packets = 0;
+
+  Exchange::MDPWireEncoder encoder(num_tickers);
+  auto send_packet = [&]() {
+    stream.insert(stream.end(), encoder.data(), encoder.data() + encoder.size());
+    encoder.clear();
+    ++num_packets;
+  };
+
+  const auto encode_start = Common::getCurrentNanos();
+  for (size_t i = 0; i < order_flow.updates_.size(); i += batch_size) {
+    for (auto j = i; j < std::min(i + batch_size, order_flow.updates_.size()); ++j) {
+      if (encoder.add(order_flow.updates_[j]))
+        send_packet();
+    }
+    if (!encoder.empty())
+      send_packet();
+  }
+  const auto encode_time = Common::getCurrentNanos() - encode_start;
+
+  // The decoder reads up to 7 bytes past the end of the last packet, the consumer's receive buffers always have room to spare.
+  const auto stream_len = stream.size();
+  stream.resize(stream_len + sizeof(uint64_t));
+
+  Exchange::MDPWireDecoder decoder(num_tickers);
+  uint64_t checksum = 0;
+  const auto decode_time = fastestPass([&]() {
+    Checksum sink;
+    for (size_t i = 0, packet_len = 0; (packet_len = Exchange::mdpWirePacketLength(stream.data() + i, stream_len - i)); i += packet_len)
+      decoder.decode(stream.data() + i, sink);
+    return sink.value_;
+  }, checksum);
+
+  size_t num_decoded = 0;
+  for (size_t i = 0, packet_len = 0; (packet_len = Exchange::mdpWirePacketLength(stream.data() + i, stream_len - i)); i += packet_len) {
+    decoder.decode(stream.data() + i, [&](const Exchange::MDPMarketUpdate &update) {
+      ASSERT(num_decoded < order_flow.updates_.size() && !memcmp(&update, &order_flow.updates_[num_decoded], sizeof(update)),
+             "Decoded " + update.toString() + " expected " + order_flow.updates_[num_decoded].toString());
+      ++num_decoded;
+    });
+  }
+  ASSERT(num_decoded == order_flow.updates_.size(), "Decoded " + std::to_string(num_decoded) + " of " + std::to_string(order_flow.updates_.size()) + " updates.");
+
+  std::cout << "COMPACT BATCH:" << std::setw(3) << batch_size << " bytes per update:" << std::setw(5) << static_cast<double>(stream_len) / order_flow.updates_.size()
+            << " decode ns per update:" << std::setw(5) << static_cast<double>(decode_time) / order_flow.updates_.size()
+            << " encode ns per update:" << std::setw(5) << static_cast<double>(encode_time) / order_flow.updates_.size()
+            << " packets:" << num_packets << std::endl;
+  return checksum;
+}
+
+int main(int, char **) {
+  const OrderFlow order_flow;
+  std::cout << std::fixed << std::setprecision(1);
+
+  const auto raw_checksum = benchmarkRaw(order_flow);
+  for (const size_t batch_size: {1, 16, 256})
+    ASSERT(benchmarkCompact(order_flow, batch_size) == raw_checksum, "Compact updates do not add up to the raw updates.");
+
+  exit(EXIT_SUCCESS);
+}
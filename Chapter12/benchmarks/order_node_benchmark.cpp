@@ -0,0 +1,134 @@
+#include "common/checksum.h"
+
+#include "matcher/matching_engine.h"
+
+#include "indexed_me_order_book.h"
+
+/// Number of resting orders in the deep book, spread over a few price levels so that every level holds a long FIFO queue.
+static constexpr size_t resting_count = 500000;
+static constexpr size_t num_levels = 16;
+static constexpr size_t num_clients = 16;
+
+/// Number of cancels and of aggressive orders measured on the deep book.
+static constexpr size_t cancel_count = 50000;
+static constexpr size_t aggressive_count = 20000;
+
+/// Hash and discard every client response and market update, returning the number of trades among the market updates.
+size_t drain(Exchange::ClientResponseLFQueue *client_responses, Exchange::MEMarketUpdateLFQueue *market_updates, uint64_t *hash) {
+  size_t num_trades = 0;
+  for (auto response = client_responses->getNextToRead(); response; response = client_responses->getNextToRead()) {
+    *hash = Common::fnv1a(response, sizeof(Exchange::MEClientResponse), *hash);
+    client_responses->updateReadIndex();
+  }
+  for (auto update = market_updates->getNextToRead(); update; update = market_updates->getNextToRead()) {
+    *hash = Common::fnv1a(update, sizeof(Exchange::MEMarketUpdate), *hash);
+    num_trades += (update->type_ == Exchange::MarketUpdateType::TRADE);
+    market_updates->updateReadIndex();
+  }
+  return num_trades;
+}
+
+/// Build a deep book of passive asks, then measure random cancels into it and aggressive buys sweeping through it.
+/// Returns a hash of every client response and market update, which has to be the same for every order book implementation.
+template<typename T>
+uint64_t benchmarkOrderBook(const std::string &name, T *order_book, const std::vector<Exchange::MEClientRequest> &resting,
+                            const std::vector<Exchange::MEClientRequest> &cancels, const std::vector<Exchange::MEClientRequest> &aggressive,
+                            Exchange::ClientResponseLFQueue *client_responses, Exchange::MEMarketUpdateLFQueue *market_updates) {
+  auto hash = Common::FNV1A_OFFSET_BASIS;
+  for (const auto &request: resting) {
+    order_book->add(request.client_id_, request.order_id_, request.ticker_id_, request.side_, request.price_, request.qty_);
+    drain(client_responses, market_updates, &hash);
+  }
+
+  Common::PerfEventCounter llc_misses(PERF_COUNT_HW_CACHE_MISSES);
+
+  uint64_t cancel_cycles = 0;
+  llc_misses.start();
+  for (const auto &request: cancels) {
+    const auto start = Common::rdtsc();
+    order_book->cancel(request.client_id_, request.order_id_, request.ticker_id_);
+    cancel_cycles += Common::rdtsc() - start;
+    drain(client_responses, market_updates, &hash);
+  }
+  const auto cancel_misses = llc_misses.stop();
+
+  uint64_t match_cycles = 0;
+  size_t num_matches = 0;
+  llc_misses.start();
+  for (const auto &request: aggressive) {
+    const auto start = Common::rdtsc();
+    order_book->add(request.client_id_, request.order_id_, request.ticker_id_, request.side_, request.price_, request.qty_);
+    match_cycles += Common::rdtsc() - start;
+    num_matches += drain(client_responses, market_updates, &hash);
+  }
+  const auto match_misses = llc_misses.stop();
+
+  std::cout << name << " CANCEL " << cancel_cycles / cancels.size() << " CLOCK CYCLES PER CANCEL";
+  if (llc_misses.available())
+    std::cout << " " << static_cast<double>(cancel_misses) / cancels.size() << " LLC-MISSES PER CANCEL";
+  std::cout << ". MATCH " << match_cycles / std::max<size_t>(num_matches, 1) << " CLOCK CYCLES PER MATCH";
+  if (llc_misses.available())
+    std::cout << " " << static_cast<double>(match_misses) / std::max<size_t>(num_matches, 1) << " LLC-MISSES PER MATCH";
+  std::cout << ". matches:" << num_matches << " hash:" << hash << (llc_misses.available() ? "" : " (LLC misses not available)") << std::endl;
+
+  return hash;
+}
+
+int main(int, char **) {
+  srand(0);
+
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 1;
+  limits.max_num_clients_ = num_clients;
+
+  // Passive asks in random order over num_levels price levels, so consecutive orders in a FIFO queue are far apart in the pools.
+  std::vector<Exchange::MEClientRequest> resting;
+  std::array<Common::OrderId, num_clients> next_order_id;
+  next_order_id.fill(1);
+  for (size_t i = 0; i < resting_count; ++i) {
+    const Common::ClientId client_id = rand() % num_clients;
+    resting.push_back({Exchange::ClientRequestType::NEW, client_id, 0, next_order_id[client_id]++, Common::Side::SELL,
+                       static_cast<Common::Price>(101 + rand() % num_levels), static_cast<Common::Qty>(1 + rand() % 100)});
+  }
+
+  std::vector<Exchange::MEClientRequest> cancels;
+  for (size_t i = 0; i < cancel_count; ++i) {
+    auto request = resting[rand() % resting.size()];
+    request.type_ = Exchange::ClientRequestType::CANCEL;
+    cancels.push_back(request);
+  }
+
+  // Aggressive buys through the best levels, each filling several passive orders.
+  std::vector<Exchange::MEClientRequest> aggressive;
+  for (size_t i = 0; i < aggressive_count; ++i) {
+    const Common::ClientId client_id = rand() % num_clients;
+    aggressive.push_back({Exchange::ClientRequestType::NEW, client_id, 0, next_order_id[client_id]++, Common::Side::BUY,
+                          static_cast<Common::Price>(100 + num_levels), static_cast<Common::Qty>(200 + rand() % 400)});
+  }
+
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(limits.max_client_updates_);
+  Exchange::MEMarketUpdateLFQueue market_updates(limits.max_market_updates_);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+  Common::Logger logger("");
+
+  uint64_t pointer_hash = 0, indexed_hash = 0;
+  {
+    Exchange::MEOrderBookPools order_book_pools(limits);
+    auto me_order_book = new Exchange::MEOrderBook(0, &logger, matching_engine, &order_book_pools);
+    pointer_hash = benchmarkOrderBook("POINTER-LINKED MEOrder", me_order_book, resting, cancels, aggressive, &client_responses, &market_updates);
+    delete me_order_book;
+  }
+
+  {
+    auto indexed_order_book = new Exchange::IndexedMEOrderBook(0, &logger, matching_engine, limits);
+    indexed_hash = benchmarkOrderBook("INDEX-LINKED HOT/COLD", indexed_order_book, resting, cancels, aggressive, &client_responses, &market_updates);
+    delete indexed_order_book;
+  }
+
+  delete matching_engine;
+
+  std::cout << "IDENTICAL-OUTPUT:" << (pointer_hash == indexed_hash ? "YES" : "NO") << std::endl;
+
+  exit(pointer_hash == indexed_hash ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,157 @@
+#include <iomanip>
+#include <map>
+
+#include "market_data/price_level_publisher.h"
+
+static constexpr size_t num_updates = 1000000;
+static constexpr size_t num_tickers = 8;
+
+/// Random order flow on num_tickers books - orders are added within 10 ticks of a fixed mid price, cancelled, partially cancelled and filled.
+struct OrderFlow {
+  struct Order {
+    Common::OrderId order_id_;
+    Common::Side side_;
+    Common::Price price_;
+    Common::Qty qty_;
+  };
+
+  OrderFlow() {
+    srand(0);
+    for (size_t i = 0; i < num_updates; ++i)
+      next();
+  }
+
+  auto add(Exchange::MarketUpdateType type, Common::TickerId ticker_id, const Order &order) -> void {
+    updates_.push_back({updates_.size() + 1, ++ticker_seq_num_[ticker_id],
+                        {type, order.order_id_, ticker_id, order.side_, order.price_, order.qty_, order.order_id_}});
+  }
+
+  auto next() -> void {
+    const auto ticker_id = static_cast<Common::TickerId>(rand() % num_tickers);
+    auto &orders = live_orders_[ticker_id];
+    const auto mid_price = static_cast<Common::Price>(100 + 10 * ticker_id);
+    const auto action = (orders.size() < 50 ? 0 : rand() % 10);
+
+    if (action < 4) { // new order.
+      const auto side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+      const auto price = mid_price + (side == Common::Side::BUY ? -1 : 1) * (1 + rand() % 10);
+      orders.push_back({next_order_id_[ticker_id]++, side, price, static_cast<Common::Qty>(1 + rand() % 100)});
+      add(Exchange::MarketUpdateType::ADD, ticker_id, orders.back());
+      return;
+    }
+
+    const auto index = static_cast<size_t>(rand()) % orders.size();
+    auto &order = orders[index];
+    if (action < 8 && order.qty_ > 1) { // partial cancel, or a fill on action 7.
+      const auto qty = static_cast<Common::Qty>(1 + rand() % (order.qty_ - 1));
+      if (action == 7)
+        add(Exchange::MarketUpdateType::TRADE, ticker_id, {Common::OrderId_INVALID, order.side_, order.price_, order.qty_ - qty});
+      order.qty_ = qty;
+      add(Exchange::MarketUpdateType::MODIFY, ticker_id, order);
+    } else {
+      add(Exchange::MarketUpdateType::CANCEL, ticker_id, order);
+      order = orders.back();
+      orders.pop_back();
+    }
+  }
+
+  /// The top levels of a ticker's book computed from its live orders.
+  auto topLevels(Common::TickerId ticker_id, Common::Side side) const {
+    std::map<Common::Price, Exchange::MDPPriceLevel> levels;
+    for (const auto &order: live_orders_[ticker_id]) {
+      if (order.side_ != side)
+        continue;
+      auto &level = levels[side == Common::Side::BUY ? -order.price_ : order.price_];
+      level.price_ = order.price_;
+      level.qty_ += order.qty_;
+      ++level.num_orders_;
+    }
+
+    std::vector<Exchange::MDPPriceLevel> top_levels(Exchange::MDP_PRICE_LEVELS);
+    auto itr = levels.begin();
+    for (size_t i = 0; i < Exchange::MDP_PRICE_LEVELS && itr != levels.end(); ++i, ++itr)
+      top_levels[i] = itr->second;
+    return top_levels;
+  }
+
+  std::vector<Exchange::MDPMarketUpdate> updates_;
+  std::vector<Order> live_orders_[num_tickers];
+  Common::OrderId next_order_id_[num_tickers] = {};
+  size_t ticker_seq_num_[num_tickers] = {};
+};
+
+/// Apply the order flow to a PriceLevelPublisher, publishing after every batch_size incremental updates, i.e. as if the publisher's thread found
+/// batch_size updates queued up every time. Reports the price level updates published against the incremental updates and the cost per incremental
+/// update, then checks the latest price level update received for every ticker against its live orders.
+void benchmarkPriceLevels(const OrderFlow &order_flow, size_t batch_size, int port) {
+  const std::string ip = "233.252.14.7";
+  Common::Logger logger("");
+
+  // Updates are applied directly instead of going through the queue from the market data publisher.
+  auto price_level_publisher = new Exchange::PriceLevelPublisher(nullptr, "lo", ip, port, Common::EngineLimits(), "");
+
+  Exchange::MDPPriceLevelUpdate latest[num_tickers];
+  size_t num_received = 0, num_seq_gaps = 0, next_seq_num = 1;
+  Common::McastSocket subscriber(logger);
+  subscriber.recv_callback_ = [&](auto socket) {
+    size_t i = 0;
+    for (; i + sizeof(Exchange::MDPPriceLevelUpdate) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::MDPPriceLevelUpdate)) {
+      const auto update = reinterpret_cast<const Exchange::MDPPriceLevelUpdate *>(socket->inbound_data_.data() + i);
+      num_seq_gaps += (update->seq_num_ != next_seq_num);
+      next_seq_num = update->seq_num_ + 1;
+      latest[update->ticker_id_] = *update;
+      ++num_received;
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  };
+  ASSERT(subscriber.init(ip, "lo", port, /*is_listening*/ true) >= 0, "Unable to create price level mcast socket. error:" + std::string(std::strerror(errno)));
+  ASSERT(subscriber.join(ip), "Join failed on:" + std::to_string(subscriber.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+
+  Common::Nanos apply_time = 0, publish_time = 0;
+  size_t num_published = 0;
+  for (size_t i = 0; i < order_flow.updates_.size(); i += batch_size) {
+    const auto start = Common::getCurrentNanos();
+    for (auto j = i; j < std::min(i + batch_size, order_flow.updates_.size()); ++j)
+      price_level_publisher->addUpdate(&order_flow.updates_[j]);
+    const auto applied = Common::getCurrentNanos();
+    num_published += price_level_publisher->publishLevels();
+    apply_time += applied - start;
+    publish_time += Common::getCurrentNanos() - applied;
+
+    // Loopback multicast is delivered asynchronously, wait for the batch so that it is not lost to the backlog overflowing on a busy core.
+    const auto deadline = Common::getCurrentNanos() + 100 * Common::NANOS_TO_MILLIS;
+    while (next_seq_num <= num_published && Common::getCurrentNanos() < deadline) {
+      if (!subscriber.sendAndRecv())
+        std::this_thread::yield();
+    }
+  }
+
+  for (Common::TickerId ticker_id = 0; ticker_id < num_tickers; ++ticker_id) {
+    const auto bids = order_flow.topLevels(ticker_id, Common::Side::BUY), asks = order_flow.topLevels(ticker_id, Common::Side::SELL);
+    ASSERT(!memcmp(latest[ticker_id].bids_, bids.data(), sizeof(latest[ticker_id].bids_)) &&
+           !memcmp(latest[ticker_id].asks_, asks.data(), sizeof(latest[ticker_id].asks_)), "Price levels do not match live orders for ticker:" +
+           std::to_string(ticker_id) + " " + latest[ticker_id].toString());
+  }
+
+  const auto order_bytes = order_flow.updates_.size() * sizeof(Exchange::MDPMarketUpdate);
+  const auto level_bytes = num_received * sizeof(Exchange::MDPPriceLevelUpdate);
+  std::cout << "BATCH:" << std::setw(4) << batch_size << " incremental updates:" << order_flow.updates_.size() << " (" << order_bytes / 1024 << " KB)"
+            << " price level updates published:" << std::setw(7) << num_published << " received:" << std::setw(7) << num_received
+            << " (" << std::setw(6) << level_bytes / 1024 << " KB) gaps:" << num_seq_gaps << std::fixed << std::setprecision(1)
+            << " ns per incremental update apply:" << static_cast<double>(apply_time) / order_flow.updates_.size()
+            << " publish:" << static_cast<double>(publish_time) / order_flow.updates_.size() << std::endl;
+
+  subscriber.leave(ip, port);
+  delete price_level_publisher;
+}
+
+int main(int, char **) {
+  const OrderFlow order_flow;
+
+  int port = 20200;
+  for (const size_t batch_size: {1, 16, 256})
+    benchmarkPriceLevels(order_flow, batch_size, port++);
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "market_data/market_data_consumer.h"
+
+/// Snapshot and incremental messages are sent in bursts of this many with a pause after each, so that the consumer keeps up and none are lost to full
+/// socket buffers.
+static constexpr size_t burst_size = 64;
+
+/// An incremental update for the recovering ticker is sent after every this many snapshot messages.
+static constexpr size_t snapshot_msgs_per_incremental = 10;
+
+/// Plays the market data publisher - sends incremental updates and snapshots of a single ticker, there is no gap fill server so a gap in a ticker's
+/// updates is recovered from a snapshot.
+struct BenchmarkPublisher {
+  BenchmarkPublisher(Common::Logger &logger, const std::string &snapshot_ip, int snapshot_port, const std::string &incremental_ip, int incremental_port)
+      : incremental_socket_(logger), snapshot_socket_(logger) {
+    ASSERT(incremental_socket_.init(incremental_ip, "lo", incremental_port, /*is_listening*/ false) >= 0,
+           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    ASSERT(snapshot_socket_.init(snapshot_ip, "lo", snapshot_port, /*is_listening*/ false) >= 0,
+           "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
+  }
+
+  auto send(Common::McastSocket &socket, const Exchange::MDPMarketUpdate &market_update) -> void {
+    socket.send(&market_update, sizeof(market_update));
+    socket.sendAndRecv();
+
+    using namespace std::literals::chrono_literals;
+    if (++num_sent_ % burst_size == 0)
+      std::this_thread::sleep_for(10ms);
+  }
+
+  auto sendIncremental(Common::TickerId ticker_id, size_t ticker_seq_num) -> void {
+    send(incremental_socket_, {next_seq_num_, ticker_seq_num, {Exchange::MarketUpdateType::ADD, next_seq_num_, ticker_id, Common::Side::BUY, 100, 1, 0}});
+    ++next_seq_num_;
+  }
+
+  size_t next_seq_num_ = 1;
+  size_t num_sent_ = 0;
+  Common::McastSocket incremental_socket_, snapshot_socket_;
+};
+
+/// Put a ticker in recovery by skipping its first update, then send a snapshot of num_orders orders consistent with that first update while incremental
+/// updates keep coming for it. Measures how long the consumer takes to synchronize after the end of the snapshot has been sent.
+void benchmarkRecovery(BenchmarkPublisher &publisher, Exchange::MEMarketUpdateLFQueue &market_updates, Common::TickerId ticker_id, size_t num_orders) {
+  size_t ticker_seq_num = 2;
+  publisher.sendIncremental(ticker_id, ticker_seq_num++);
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(100ms); // let the consumer join the snapshot stream.
+
+  const auto start_time = Common::getCurrentNanos();
+  size_t seq_num = 0;
+  auto send_snapshot = [&](Exchange::MarketUpdateType type, Common::OrderId order_id) {
+    publisher.send(publisher.snapshot_socket_, {seq_num++, 1, {type, order_id, ticker_id, Common::Side::SELL, 100, 1, order_id}});
+    if (seq_num % snapshot_msgs_per_incremental == 0)
+      publisher.sendIncremental(ticker_id, ticker_seq_num++);
+  };
+  send_snapshot(Exchange::MarketUpdateType::SNAPSHOT_START, 0);
+  send_snapshot(Exchange::MarketUpdateType::CLEAR, 0);
+  for (size_t i = 0; i < num_orders; ++i)
+    send_snapshot(Exchange::MarketUpdateType::ADD, i);
+  const auto end_time = Common::getCurrentNanos();
+  send_snapshot(Exchange::MarketUpdateType::SNAPSHOT_END, 0);
+
+  // CLEAR, the orders and every incremental update after the first one.
+  const auto num_updates = 1 + num_orders + (ticker_seq_num - 2);
+  const auto deadline = Common::getCurrentNanos() + 30 * Common::NANOS_TO_SECS;
+  size_t received = 0;
+  while (received < num_updates && Common::getCurrentNanos() < deadline) {
+    if (market_updates.size()) {
+      market_updates.updateReadIndex();
+      ++received;
+    }
+  }
+  const auto sync_time = Common::getCurrentNanos() - end_time;
+
+  std::cout << "SNAPSHOT ORDERS " << std::setw(7) << num_orders << " with " << std::setw(6) << ticker_seq_num - 3 << " queued incrementals"
+            << " sent in " << (end_time - start_time) / Common::NANOS_TO_MILLIS << " ms,";
+  if (received == num_updates)
+    std::cout << " synchronized " << sync_time / Common::NANOS_TO_MICROS << " us after SNAPSHOT_END was sent." << std::endl;
+  else
+    std::cout << " not synchronized after 30 s, received " << received << " of " << num_updates << " updates." << std::endl;
+}
+
+int main(int, char **) {
+  const std::string snapshot_ip = "233.252.14.1", incremental_ip = "233.252.14.3";
+  const int snapshot_port = 20120, incremental_port = 20121, gap_fill_port = 20122;
+
+  Common::Logger logger("");
+  BenchmarkPublisher publisher(logger, snapshot_ip, snapshot_port, incremental_ip, incremental_port);
+
+  // Nothing listens on the gap fill port, so tickers are recovered from snapshots.
+  Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+  auto market_data_consumer = new Trading::MarketDataConsumer(0, &market_updates, "lo", snapshot_ip, snapshot_port, {{incremental_ip, incremental_port, "", 0, false}},
+                                                              {}, "127.0.0.1", gap_fill_port);
+  market_data_consumer->start();
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(1s);
+
+  Common::TickerId ticker_id = 0;
+  for (const size_t num_orders: {1000, 10000, 50000})
+    benchmarkRecovery(publisher, market_updates, ticker_id++, num_orders);
+
+  // The process exits right after, the consumer thread is left running instead of waiting for it to stop.
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "market_data/gap_fill_server.h"
+#include "market_data/market_data_consumer.h"
+
+/// Updates are published in batches of this many, waiting for the consumer to process each batch before sending the next one.
+static constexpr size_t batch_size = 16;
+static constexpr size_t num_updates = 10000;
+static constexpr size_t num_tickers = 8;
+
+/// Probability of an update being sent late, after the next 1 to max_delay updates, within its batch.
+static constexpr double reorder_probability = 0.05;
+static constexpr size_t max_delay = 3;
+
+/// Plays the market data publisher - sends incremental updates on the incremental multicast stream and forwards them to a GapFillServer, injecting
+/// reordering on the multicast stream. Every update carries the time it was published in priority_, to measure its latency through the consumer.
+struct BenchmarkPublisher {
+  BenchmarkPublisher(Common::Logger &logger, const std::string &incremental_ip, int incremental_port, int gap_fill_port)
+      : gap_fill_updates_(Common::ME_MAX_MARKET_UPDATES), gap_fill_server_(&gap_fill_updates_, "lo", gap_fill_port, 1, Exchange::ME_GAP_FILL_HISTORY, ""),
+        incremental_socket_(logger) {
+    ASSERT(incremental_socket_.init(incremental_ip, "lo", incremental_port, /*is_listening*/ false) >= 0,
+           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    gap_fill_server_.start();
+  }
+
+  /// Publish a batch of updates, returns the number sent out of order.
+  auto publishBatch() -> size_t {
+    const auto publish_time = Common::getCurrentNanos();
+    std::vector<Exchange::MDPMarketUpdate> batch;
+    for (size_t i = 0; i < batch_size; ++i, ++next_seq_num_) {
+      const auto ticker_id = static_cast<Common::TickerId>(next_seq_num_ % num_tickers);
+      batch.push_back({next_seq_num_, ticker_next_seq_num_[ticker_id]++,
+                       {Exchange::MarketUpdateType::ADD, next_seq_num_, ticker_id, Common::Side::BUY, 100, 1, static_cast<Common::Priority>(publish_time)}});
+
+      auto next_write = gap_fill_updates_.getNextToWriteTo();
+      *next_write = batch.back();
+      gap_fill_updates_.updateWriteIndex();
+    }
+
+    // Move updates back by a few positions, the last update of the batch always goes out last so that the consumer sees the whole batch.
+    size_t num_reordered = 0;
+    for (size_t i = 0; i + 1 < batch_size; ++i) {
+      const auto delay = 1 + static_cast<size_t>(rand()) % max_delay;
+      if (rand() < reorder_probability * RAND_MAX && i + delay + 1 < batch_size) {
+        std::rotate(batch.begin() + i, batch.begin() + i + 1, batch.begin() + i + delay + 1);
+        ++num_reordered;
+      }
+    }
+
+    for (const auto &market_update: batch) {
+      incremental_socket_.send(&market_update, sizeof(market_update));
+      incremental_socket_.sendAndRecv();
+    }
+
+    return num_reordered;
+  }
+
+  size_t next_seq_num_ = 1;
+  size_t ticker_next_seq_num_[num_tickers] = {1, 1, 1, 1, 1, 1, 1, 1};
+
+  Exchange::MDPMarketUpdateLFQueue gap_fill_updates_;
+  Exchange::GapFillServer gap_fill_server_;
+  Common::McastSocket incremental_socket_;
+};
+
+/// Publish num_updates with reordering injected to a consumer with the provided reorder window, reporting how many gaps and recoveries the
+/// reordering caused and the latency of the updates from being published to being read off the consumer's queue.
+void benchmarkReorderWindow(const Trading::ReorderCfg &reorder_cfg, int port) {
+  srand(0);
+
+  const std::string incremental_ip = "233.252.14.3";
+  Common::Logger logger("");
+  auto publisher = new BenchmarkPublisher(logger, incremental_ip, port, port + 1);
+
+  Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+  auto market_data_consumer = new Trading::MarketDataConsumer(0, &market_updates, "lo", "233.252.14.1", port + 2, {{incremental_ip, port, "", 0, false}},
+                                                              {}, "127.0.0.1", port + 1, reorder_cfg);
+  market_data_consumer->start();
+
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(1s); // let the consumer connect to the gap fill server and join the incremental stream.
+
+  std::vector<Common::Nanos> latencies;
+  latencies.reserve(num_updates);
+  size_t num_reordered = 0;
+  while (latencies.size() < num_updates) {
+    num_reordered += publisher->publishBatch();
+
+    const auto deadline = Common::getCurrentNanos() + 10 * Common::NANOS_TO_SECS;
+    while (latencies.size() + 1 < publisher->next_seq_num_ && Common::getCurrentNanos() < deadline) {
+      if (market_updates.size()) {
+        latencies.push_back(Common::getCurrentNanos() - static_cast<Common::Nanos>(market_updates.getNextToRead()->priority_));
+        market_updates.updateReadIndex();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    ASSERT(latencies.size() + 1 == publisher->next_seq_num_, "Consumer stuck at " + std::to_string(latencies.size()) + " updates.");
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  std::cout << std::setw(36) << reorder_cfg.toString() << " reordered:" << num_reordered
+            << " gaps:" << market_data_consumer->numIncrementalGaps() << " ticker recoveries:" << market_data_consumer->numRecoveries()
+            << " LATENCY p50:" << latencies[latencies.size() / 2] / Common::NANOS_TO_MICROS << " us"
+            << " p99:" << latencies[latencies.size() * 99 / 100] / Common::NANOS_TO_MICROS << " us"
+            << " max:" << latencies.back() / Common::NANOS_TO_MICROS << " us." << std::endl;
+
+  market_data_consumer->stop();
+  publisher->gap_fill_server_.stop();
+}
+
+int main(int, char **) {
+  int port = 20130;
+  for (const auto &reorder_cfg: {Trading::ReorderCfg{0, 0}, Trading::ReorderCfg{}, Trading::ReorderCfg{32, 1000 * Common::NANOS_TO_MICROS}}) {
+    benchmarkReorderWindow(reorder_cfg, port);
+    port += 3;
+  }
+
+  // The process exits right after, the stopped threads are left to finish on their own.
+  exit(EXIT_SUCCESS);
+}
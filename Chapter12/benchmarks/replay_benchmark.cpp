@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <fstream>
+
+#include "matcher/matching_engine.h"
+#include "journal/journal_reader.h"
+
+/// Number of client requests in the synthetic flow generated when no input file is provided.
+static constexpr size_t synthetic_count = 1000000;
+static constexpr size_t synthetic_tickers = 4;
+static constexpr size_t synthetic_clients = 8;
+
+/// Request processing latencies are bucketed by powers of two clock cycles.
+static constexpr size_t num_buckets = 32;
+
+struct ReplayStats {
+  size_t num_requests_ = 0;
+  Common::Nanos elapsed_ = 0;
+
+  std::array<std::vector<uint64_t>, 2> cycles_; // indexed by NEW = 0, CANCEL = 1.
+
+  size_t num_responses_ = 0;
+  size_t num_updates_ = 0;
+  uint64_t responses_hash_ = Common::FNV1A_OFFSET_BASIS;
+  uint64_t updates_hash_ = Common::FNV1A_OFFSET_BASIS;
+};
+
+/// Generate a recorded client request file with add/cancel flow over several clients and tickers, with enough aggressive orders to trade.
+void generateSyntheticFlow(const std::string &file_name) {
+  srand(0);
+
+  std::vector<Exchange::MEClientRequest> requests;
+  std::array<Common::OrderId, synthetic_clients> next_order_id;
+  next_order_id.fill(1);
+  std::array<Common::Price, synthetic_tickers> base_price;
+  for (auto &price: base_price)
+    price = 100 + (rand() % 100);
+
+  while (requests.size() < synthetic_count) {
+    const Common::ClientId client_id = rand() % synthetic_clients;
+    const Common::TickerId ticker_id = rand() % synthetic_tickers;
+    const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+    // Mostly passive prices, with roughly one in eight orders crossing the spread.
+    const auto aggressive = (rand() % 8 == 0);
+    const auto offset = static_cast<Common::Price>(1 + rand() % 10);
+    const Common::Price price = (side == Common::Side::BUY ? base_price[ticker_id] - offset + (aggressive ? 12 : 0)
+                                                           : base_price[ticker_id] + offset - (aggressive ? 12 : 0));
+    const Common::Qty qty = 1 + (rand() % 100);
+
+    const Exchange::MEClientRequest new_request{Exchange::ClientRequestType::NEW, client_id, ticker_id, next_order_id[client_id]++, side, price, qty};
+    requests.push_back(new_request);
+
+    // Cancel a random earlier order, which may already have been filled or cancelled and will then be rejected.
+    auto cxl_request = requests[rand() % requests.size()];
+    if (cxl_request.type_ == Exchange::ClientRequestType::NEW) {
+      cxl_request.type_ = Exchange::ClientRequestType::CANCEL;
+      requests.push_back(cxl_request);
+    }
+  }
+
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  ASSERT(file.is_open(), "Unable to create synthetic flow file:" + file_name);
+  file.write(reinterpret_cast<const char *>(requests.data()), requests.size() * sizeof(Exchange::MEClientRequest));
+}
+
+/// Drive a fresh MatchingEngine with logging disabled through every request in the file, hashing every response and market update it produces.
+ReplayStats replay(const Exchange::JournalReader &reader) {
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "");
+
+  ReplayStats stats;
+  stats.num_requests_ = reader.numRequests();
+  for (auto &cycles: stats.cycles_)
+    cycles.reserve(reader.numRequests());
+
+  const auto start_time = Common::getCurrentNanos();
+  for (size_t i = 0; i < reader.numRequests(); ++i) {
+    const auto request = reader.request(i);
+
+    const auto start = Common::rdtsc();
+    matching_engine->processClientRequest(request);
+    const auto cycles = Common::rdtsc() - start;
+    stats.cycles_[request->type_ == Exchange::ClientRequestType::NEW ? 0 : 1].push_back(cycles);
+
+    for (auto response = client_responses.getNextToRead(); response; response = client_responses.getNextToRead()) {
+      stats.responses_hash_ = Common::fnv1a(response, sizeof(Exchange::MEClientResponse), stats.responses_hash_);
+      ++stats.num_responses_;
+      client_responses.updateReadIndex();
+    }
+    for (auto update = market_updates.getNextToRead(); update; update = market_updates.getNextToRead()) {
+      stats.updates_hash_ = Common::fnv1a(update, sizeof(Exchange::MEMarketUpdate), stats.updates_hash_);
+      ++stats.num_updates_;
+      market_updates.updateReadIndex();
+    }
+  }
+  stats.elapsed_ = Common::getCurrentNanos() - start_time;
+
+  delete matching_engine;
+
+  return stats;
+}
+
+void printHistogram(const std::string &name, std::vector<uint64_t> cycles) {
+  if (cycles.empty())
+    return;
+
+  std::sort(cycles.begin(), cycles.end());
+  std::cout << name << " count:" << cycles.size()
+            << " p50:" << cycles[cycles.size() / 2]
+            << " p99:" << cycles[static_cast<size_t>(0.99 * (cycles.size() - 1))]
+            << " max:" << cycles.back() << " CLOCK CYCLES." << std::endl;
+
+  std::array<size_t, num_buckets> buckets{};
+  for (const auto c: cycles)
+    ++buckets[std::min(num_buckets - 1, static_cast<size_t>(c ? 64 - __builtin_clzll(c) : 0))];
+
+  for (size_t i = 0; i < num_buckets; ++i) {
+    if (buckets[i])
+      std::cout << "  <" << std::setw(12) << (1ULL << i) << " " << std::setw(10) << buckets[i]
+                << " " << std::string(1 + (buckets[i] * 60) / cycles.size(), '#') << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string file_name = (argc > 1 ? argv[1] : "");
+  if (file_name.empty()) {
+    file_name = "replay_benchmark_requests.bin";
+    generateSyntheticFlow(file_name);
+  }
+
+  const Exchange::JournalReader reader(file_name);
+  std::cout << "Replaying " << reader.numRequests() << " client requests from " << (reader.isJournal() ? "journal" : "raw") << " file:" << file_name;
+  if (reader.numRequests())
+    std::cout << " seq:[" << reader.seqNum(0) << "," << reader.seqNum(reader.numRequests() - 1) << "]";
+  std::cout << std::endl;
+
+  // Replay twice through fresh matching engines, the output streams have to be identical for the replay to be deterministic.
+  const auto first = replay(reader);
+  const auto second = replay(reader);
+
+  for (const auto *stats: {&first, &second}) {
+    std::cout << "REPLAY " << stats->num_requests_ << " requests in " << stats->elapsed_ << " ns. "
+              << static_cast<uint64_t>(stats->num_requests_ * 1e9 / std::max<Common::Nanos>(stats->elapsed_, 1)) << " MSGS/SEC."
+              << " responses:" << stats->num_responses_ << " hash:" << stats->responses_hash_
+              << " market-updates:" << stats->num_updates_ << " hash:" << stats->updates_hash_ << std::endl;
+  }
+
+  printHistogram("NEW", first.cycles_[0]);
+  printHistogram("CANCEL", first.cycles_[1]);
+
+  const auto deterministic = (first.num_responses_ == second.num_responses_ && first.responses_hash_ == second.responses_hash_ &&
+                              first.num_updates_ == second.num_updates_ && first.updates_hash_ == second.updates_hash_);
+  std::cout << "DETERMINISTIC:" << (deterministic ? "YES" : "NO") << std::endl;
+
+  exit(deterministic ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <sys/wait.h>
+
+#include "matcher/matching_engine.h"
+#include "order_server/order_server.h"
+#include "order_server/client_wire.h"
+
+/// Every client keeps one request in flight, alternating between a new order and its cancel, and measures the round trip to each response.
+static constexpr Common::Nanos run_time = 3 * Common::NANOS_TO_SECS;
+
+/// Order gateway side of one client connection, sends sequenced client requests and reads back client responses.
+struct BenchmarkClient {
+  BenchmarkClient(Common::ClientId client_id, Common::Logger &logger, int port)
+      : client_id_(client_id), socket_(logger) {
+    socket_.connect("127.0.0.1", "lo", port, false);
+    socket_.recv_callback_ = [this](auto socket, auto) { recvCallback(socket); };
+  }
+
+  /// Send the next request, a new order if the previous one was cancelled, else the cancel for the live order.
+  auto sendNext() -> void {
+    const auto type = (order_live_ ? Exchange::ClientRequestType::CANCEL : Exchange::ClientRequestType::NEW);
+    const Exchange::MEClientRequest request{type, client_id_, 0, order_id_, Common::Side::BUY, 100, 1};
+
+    send_time_ = Common::getCurrentNanos();
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    socket_.send(encoded, Exchange::encodeClientRequest(next_seq_num_, request, encoded));
+    ++next_seq_num_;
+    in_flight_ = true;
+  }
+
+  auto recvCallback(Common::TCPSocket *socket) -> void {
+    const auto now = Common::getCurrentNanos();
+    size_t i = 0;
+    for (auto msg_len = Exchange::wireMessageLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Exchange::wireMessageLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      Exchange::MEClientResponse response;
+      Exchange::decodeClientResponse(socket->inbound_data_.data() + i, client_id_, response);
+      latencies_.push_back(now - send_time_);
+      order_live_ = (response.type_ == Exchange::ClientResponseType::ACCEPTED);
+      in_flight_ = false;
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  }
+
+  const Common::ClientId client_id_;
+  Common::TCPSocket socket_;
+  uint32_t next_seq_num_ = 1;
+
+  /// The order is always cancelled before the next new order, so one client order id is enough.
+  const Common::OrderId order_id_ = 1;
+  bool order_live_ = false;
+  bool in_flight_ = false;
+  Common::Nanos send_time_ = 0;
+
+  /// Round trips measured so far.
+  std::vector<Common::Nanos> latencies_;
+};
+
+/// Run an order server with num_io_threads session groups and a matching engine on loopback with num_clients closed loop clients,
+/// reporting the responses per second and the round trip percentiles across all clients.
+void benchmarkSessionGroups(size_t num_clients, size_t num_io_threads, int port) {
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 1;
+  limits.max_num_clients_ = num_clients;
+  limits.max_order_ids_ = 1024;
+
+  // Like the server and engine, the queues are never destroyed, the threads using them are left running when this returns.
+  auto &client_requests = *new Exchange::ClientRequestLFQueue(limits.max_client_updates_);
+  auto &client_responses = *new Exchange::ClientResponseLFQueue(limits.max_client_updates_);
+  auto &market_updates = *new Exchange::MEMarketUpdateLFQueue(limits.max_market_updates_);
+
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+  matching_engine->start();
+  auto order_server = new Exchange::OrderServer(&client_requests, &client_responses, "lo", port, nullptr, 1, limits, Exchange::ThrottleLimits{0, 0},
+                                                num_io_threads);
+  order_server->start();
+
+  Common::Logger logger("");
+  std::vector<BenchmarkClient *> clients;
+  for (Common::ClientId client_id = 0; client_id < num_clients; ++client_id)
+    clients.push_back(new BenchmarkClient(client_id, logger, port));
+
+  const auto start_time = Common::getCurrentNanos();
+  for (auto now = start_time; now < start_time + run_time; now = Common::getCurrentNanos()) {
+    for (auto client: clients) {
+      if (!client->in_flight_)
+        client->sendNext();
+      client->socket_.sendAndRecv();
+    }
+
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+
+    // Let the order server and matching engine threads run if they share a core with the clients.
+    std::this_thread::yield();
+  }
+
+  std::vector<Common::Nanos> latencies;
+  for (auto client: clients)
+    latencies.insert(latencies.end(), client->latencies_.begin(), client->latencies_.end());
+  std::sort(latencies.begin(), latencies.end());
+  ASSERT(!latencies.empty(), "No round trips measured for clients:" + std::to_string(num_clients) + " io-threads:" + std::to_string(num_io_threads));
+
+  std::cout << "CLIENTS:" << num_clients << " IO THREADS:" << num_io_threads
+            << " responses/sec:" << latencies.size() * Common::NANOS_TO_SECS / run_time
+            << " p50:" << latencies[latencies.size() / 2] / Common::NANOS_TO_MICROS
+            << " p99:" << latencies[latencies.size() * 99 / 100] / Common::NANOS_TO_MICROS
+            << " max:" << latencies.back() / Common::NANOS_TO_MICROS << " us" << std::endl;
+
+  // The process exits right after, the server and engine threads are left running instead of waiting for them to stop.
+}
+
+int main(int, char **) {
+  // Every configuration runs in a fresh child process with its own order server port and threads.
+  int port = 12350;
+  for (const size_t num_clients: {16, 64, 256}) {
+    for (const size_t num_io_threads: {1, 4}) {
+      const auto pid = fork();
+      ASSERT(pid >= 0, "fork() failed error:" + std::string(std::strerror(errno)));
+      if (!pid) {
+        benchmarkSessionGroups(num_clients, num_io_threads, port);
+        exit(EXIT_SUCCESS);
+      }
+
+      int status = 0;
+      waitpid(pid, &status, 0);
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        exit(EXIT_FAILURE);
+      ++port;
+    }
+  }
+
+  exit(EXIT_SUCCESS);
+}
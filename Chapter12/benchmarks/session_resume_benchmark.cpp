@@ -0,0 +1,190 @@
+#include <sys/wait.h>
+
+#include "matcher/matching_engine.h"
+#include "order_server/order_server.h"
+#include "order_server/client_wire.h"
+
+/// Every scenario sends this many new orders on a first connection and reads all the responses, then another client fills some of them while the first
+/// one is disconnected. The session is resumed on a second connection claiming to have missed the last gap responses, which measures how long the order
+/// server takes to replay them and checks that the fills are among them and that the session carries on.
+/// With several order server I/O threads the second connection may land on another session group, which has to take the session over.
+static constexpr size_t num_orders = 8000;
+static constexpr size_t send_window = 512;
+static constexpr Common::Qty num_fills = 10;
+
+/// Order gateway side of one client session, speaking the compact wire format over a TCPSocket which is reconnected between the two phases.
+struct BenchmarkSession {
+  BenchmarkSession(Common::ClientId client_id, Common::Logger &logger, int port)
+      : client_id_(client_id), port_(port), socket_(logger) {
+    socket_.recv_callback_ = [this](auto socket, auto) { recvCallback(socket); };
+  }
+
+  auto logon(uint32_t last_response_seq) -> void {
+    socket_.disconnect();
+    socket_.connect("127.0.0.1", "lo", port_, false);
+
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    socket_.send(encoded, Exchange::encodeLogon(client_id_, next_seq_num_, last_response_seq, encoded));
+    replay_from_ = 0;
+    replayed_ = mismatched_ = replayed_fills_ = 0;
+  }
+
+  auto send(const Exchange::MEClientRequest &request) -> void {
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    socket_.send(encoded, Exchange::encodeClientRequest(next_seq_num_++, request, encoded));
+  }
+
+  /// Responses on the first connection are recorded by sequence number, responses on the resumed connection are checked against them.
+  auto recvCallback(Common::TCPSocket *socket) -> void {
+    size_t i = 0;
+    for (auto msg_len = Exchange::wireMessageLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Exchange::wireMessageLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      if (Exchange::wireMessageType(socket->inbound_data_.data() + i) == Exchange::WireMsgType::LOGON_ACK) {
+        replay_from_ = Exchange::decodeSessionMessage<Exchange::WireLogonAck>(socket->inbound_data_.data() + i)->replay_from_seq_;
+        continue;
+      }
+
+      Exchange::MEClientResponse response;
+      const auto seq_num = Exchange::decodeClientResponse(socket->inbound_data_.data() + i, client_id_, response);
+      if (resumed_) {
+        ++replayed_;
+        if (seq_num < responses_.size() &&
+            (responses_[seq_num].client_order_id_ != response.client_order_id_ || responses_[seq_num].type_ != response.type_))
+          ++mismatched_;
+        last_replayed_seq_ = seq_num;
+        replayed_fills_ += (response.type_ == Exchange::ClientResponseType::FILLED);
+      } else {
+        responses_.resize(std::max<size_t>(responses_.size(), seq_num + 1));
+        responses_[seq_num] = response;
+        ++received_;
+      }
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  }
+
+  const Common::ClientId client_id_;
+  const int port_;
+  Common::TCPSocket socket_;
+  uint32_t next_seq_num_ = 1;
+
+  bool resumed_ = false;
+  size_t received_ = 0;
+  std::vector<Exchange::MEClientResponse> responses_;
+
+  uint32_t replay_from_ = 0;
+  uint32_t last_replayed_seq_ = 0;
+  size_t replayed_ = 0;
+  size_t mismatched_ = 0;
+  size_t replayed_fills_ = 0;
+};
+
+/// Drive the session until done() or the timeout, the order server and matching engine run on their own threads.
+template<typename Done>
+auto pump(BenchmarkSession &session, Exchange::MEMarketUpdateLFQueue &market_updates, Done &&done) {
+  const auto deadline = Common::getCurrentNanos() + 10 * Common::NANOS_TO_SECS;
+  while (!done() && Common::getCurrentNanos() < deadline) {
+    session.socket_.sendAndRecv();
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+    std::this_thread::yield();
+  }
+
+  return done();
+}
+
+/// Run the scenarios against an order server with num_io_threads session groups.
+void benchmarkSessionResume(size_t num_io_threads, int port) {
+  const std::vector<uint32_t> gaps{100, 1000, 4000, 6000};
+
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 1;
+  limits.max_num_clients_ = gaps.size() + 1;
+  limits.max_order_ids_ = 64 * 1024;
+
+  // Like the server and engine, the queues are never destroyed, the threads using them are left running when this returns.
+  auto &client_requests = *new Exchange::ClientRequestLFQueue(limits.max_client_updates_);
+  auto &client_responses = *new Exchange::ClientResponseLFQueue(limits.max_client_updates_);
+  auto &market_updates = *new Exchange::MEMarketUpdateLFQueue(limits.max_market_updates_);
+
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+  matching_engine->start();
+  auto order_server = new Exchange::OrderServer(&client_requests, &client_responses, "lo", port, nullptr, 1, limits, Exchange::ThrottleLimits{0, 0},
+                                                num_io_threads);
+  order_server->start();
+
+  Common::Logger logger("");
+  const auto taker_id = static_cast<Common::ClientId>(gaps.size());
+  BenchmarkSession taker(taker_id, logger, port);
+  taker.logon(0);
+  Common::OrderId taker_order_id = 1;
+
+  for (Common::ClientId client_id = 0; client_id < gaps.size(); ++client_id) {
+    const auto gap = gaps[client_id];
+    BenchmarkSession session(client_id, logger, port);
+
+    // First connection - send the new orders with a bounded number unanswered and read every response.
+    // Every client bids above the previous ones, so that the taker only fills this client's orders.
+    const auto price = static_cast<Common::Price>(100 + client_id);
+    session.logon(0);
+    size_t sent = 0;
+    const auto first_done = pump(session, market_updates, [&]() {
+      while (sent < num_orders && sent < session.received_ + send_window) {
+        session.send({Exchange::ClientRequestType::NEW, client_id, 0, sent + 1, Common::Side::BUY, price, 1});
+        ++sent;
+      }
+      return (session.received_ == num_orders);
+    });
+    ASSERT(first_done, "Only received " + std::to_string(session.received_) + " responses for ClientId:" + std::to_string(client_id));
+
+    // Fill some of the orders while the client is disconnected, their FILLED responses are only seen on the resumed session.
+    session.socket_.disconnect();
+    const auto taker_received = taker.received_;
+    taker.send({Exchange::ClientRequestType::NEW, taker_id, 0, taker_order_id++, Common::Side::SELL, price, num_fills});
+    ASSERT(pump(taker, market_updates, [&]() { return (taker.received_ >= taker_received + 1 + num_fills); }), "Taker not filled.");
+
+    // Second connection - claim the last gap responses were missed and time the replay.
+    session.resumed_ = true;
+    const auto last_seq = static_cast<uint32_t>(num_orders + num_fills);
+    const auto start_time = Common::getCurrentNanos();
+    session.logon(static_cast<uint32_t>(num_orders) - gap);
+    const auto resume_done = pump(session, market_updates, [&]() { return (session.replay_from_ && session.last_replayed_seq_ == last_seq); });
+    const auto resume_time = Common::getCurrentNanos() - start_time;
+    ASSERT(resume_done, "Replay incomplete for gap:" + std::to_string(gap) + " last replayed:" + std::to_string(session.last_replayed_seq_));
+
+    std::cout << "IO THREADS:" << num_io_threads << " GAP:" << gap << " responses resumed in " << resume_time / Common::NANOS_TO_MICROS << " us."
+              << " replayed:" << session.replayed_ << " from seq:" << session.replay_from_
+              << " lost:" << (session.replay_from_ - (num_orders - gap + 1)) << " mismatched:" << session.mismatched_
+              << " fills:" << session.replayed_fills_ << std::endl;
+    ASSERT(!session.mismatched_, "Replayed responses differ from the original ones.");
+    ASSERT(session.replayed_fills_ == num_fills, "Fills while disconnected were not replayed.");
+
+    // The resumed session carries on with the next sequence numbers in both directions.
+    session.send({Exchange::ClientRequestType::NEW, client_id, 0, num_orders + 1, Common::Side::BUY, price, 1});
+    ASSERT(pump(session, market_updates, [&]() { return (session.last_replayed_seq_ == last_seq + 1); }), "No response on the resumed session.");
+  }
+
+  std::cout << "IO THREADS:" << num_io_threads << " sessions moved between groups:" << order_server->numSessionMoves() << std::endl;
+}
+
+int main(int, char **) {
+  // Every configuration runs in a fresh child process with its own order server port and threads.
+  int port = 12362;
+  for (const size_t num_io_threads: {1, 4}) {
+    const auto pid = fork();
+    ASSERT(pid >= 0, "fork() failed error:" + std::string(std::strerror(errno)));
+    if (!pid) {
+      // The process exits right after, the server and engine threads are left running instead of waiting for them to stop.
+      benchmarkSessionResume(num_io_threads, port);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+      exit(EXIT_FAILURE);
+    ++port;
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "market_data/snapshot_synthesizer.h"
+
+/// Market order ids are drawn from this range, so that live orders are spread sparsely over the ids seen like they are after a trading session.
+static constexpr size_t max_order_ids = 4 * 1024 * 1024;
+
+/// Return the p-th percentile of the provided sorted samples.
+uint64_t percentile(const std::vector<uint64_t> &samples, double p) {
+  return samples[static_cast<size_t>(p * (samples.size() - 1))];
+}
+
+/// Build a snapshot of num_live_orders orders on one ticker from incremental ADDs, MODIFYs and CANCELs, reporting the cost of each incremental
+/// update, the time the synthesizer spends copying the live orders for a snapshot, the cost of the incremental updates it keeps applying
+/// while the snapshot sender streams the snapshot out on the loopback interface and the time that takes.
+void benchmarkSnapshot(size_t num_live_orders) {
+  srand(0);
+
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 1;
+  limits.max_order_ids_ = max_order_ids;
+
+  // Unpaced, so the send time is the cost of writing the snapshot to the socket.
+  Exchange::SnapshotCfg cfg;
+  cfg.msgs_per_sec_ = 0;
+
+  Exchange::MDPMarketUpdateLFQueue market_updates(1);
+  Exchange::SnapshotSynthesizer snapshot_synthesizer(&market_updates, "lo", "233.252.14.1", 20000, limits, cfg, "");
+  snapshot_synthesizer.snapshotSender().start();
+
+  // Every live order is added next to one which is cancelled straight away and modified once, all ids are strided over the whole id range.
+  const auto stride = max_order_ids / (2 * num_live_orders);
+  size_t seq_num = 0;
+  std::vector<uint64_t> cycles;
+  cycles.reserve(4 * num_live_orders);
+  auto update = [&](Exchange::MarketUpdateType type, Common::OrderId order_id, Common::Price price) {
+    ++seq_num; // a single ticker, so its ticker sequence numbers are the incremental ones.
+    const Exchange::MDPMarketUpdate market_update{seq_num, seq_num, {type, order_id, 0, Common::Side::BUY, price, 100, order_id}};
+    const auto start = Common::rdtsc();
+    snapshot_synthesizer.addToSnapshot(&market_update);
+    cycles.push_back(Common::rdtsc() - start);
+  };
+  for (size_t i = 0; i < num_live_orders; ++i) {
+    const Common::OrderId order_id = 2 * i * stride, cancelled_order_id = order_id + stride;
+    update(Exchange::MarketUpdateType::ADD, order_id, 100 - rand() % 50);
+    update(Exchange::MarketUpdateType::ADD, cancelled_order_id, 100 - rand() % 50);
+    update(Exchange::MarketUpdateType::MODIFY, order_id, 100 - rand() % 50);
+    update(Exchange::MarketUpdateType::CANCEL, cancelled_order_id, 0);
+  }
+  std::sort(cycles.begin(), cycles.end());
+  const auto build_p50 = percentile(cycles, 0.5), build_p99 = percentile(cycles, 0.99);
+
+  const auto start_time = Common::getCurrentNanos();
+  ASSERT(snapshot_synthesizer.takeSnapshot(start_time), "Snapshot not taken.");
+  const auto copy_time = Common::getCurrentNanos() - start_time;
+
+  // Keep modifying live orders while the snapshot sender thread is busy with the snapshot.
+  cycles.clear();
+  while (snapshot_synthesizer.snapshotSender().numSnapshots() == 0)
+    update(Exchange::MarketUpdateType::MODIFY, 2 * (rand() % num_live_orders) * stride, 100 - rand() % 50);
+  const auto send_time = Common::getCurrentNanos() - start_time;
+  std::sort(cycles.begin(), cycles.end());
+
+  // The orders went out in time priority within each price level.
+  const auto &sent = snapshot_synthesizer.snapshotSender().acquire()->updates_;
+  ASSERT(std::is_sorted(sent.begin() + 2, sent.end() - 1, [](const auto &lhs, const auto &rhs) {
+    return std::tie(lhs.me_market_update_.price_, lhs.me_market_update_.priority_) < std::tie(rhs.me_market_update_.price_, rhs.me_market_update_.priority_);
+  }), "Snapshot orders not in priority order.");
+
+  std::cout << "LIVE ORDERS " << std::setw(8) << num_live_orders << " BUILD UPDATE p50:" << build_p50 << " p99:" << build_p99 << " CLOCK CYCLES."
+            << " SNAPSHOT COPY " << copy_time / NANOS_TO_MICROS << " us SEND " << send_time / NANOS_TO_MICROS << " us."
+            << " UPDATES DURING SEND " << cycles.size() << " p50:" << percentile(cycles, 0.5) << " p99:" << percentile(cycles, 0.99) << " CLOCK CYCLES." << std::endl;
+}
+
+int main(int, char **) {
+  for (const size_t num_live_orders: {1000, 100000, 1000000})
+    benchmarkSnapshot(num_live_orders);
+
+  exit(EXIT_SUCCESS);
+}
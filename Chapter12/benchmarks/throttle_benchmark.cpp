@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <sys/wait.h>
+
+#include "matcher/matching_engine.h"
+#include "order_server/order_server.h"
+#include "order_server/client_wire.h"
+
+/// Client 0 floods the order server, the other clients send a new order every quiet_interval once their previous one has been answered
+/// and measure the round trip to its response.
+static constexpr size_t num_quiet_clients = 3;
+static constexpr Common::Nanos run_time = 3 * Common::NANOS_TO_SECS;
+static constexpr Common::Nanos quiet_interval = Common::NANOS_TO_MILLIS;
+
+/// The flooding client keeps at most this many requests unanswered, well below ME_MAX_PENDING_REQUESTS,
+/// so that an unthrottled flood cannot overflow the FIFO sequencer's batch on its own.
+static constexpr size_t flood_window = 512;
+static constexpr size_t flood_batch = 64;
+
+/// Order gateway side of one client connection, sends sequenced client requests and reads back client responses.
+struct BenchmarkClient {
+  BenchmarkClient(Common::ClientId client_id, Common::Logger &logger, int port)
+      : client_id_(client_id), socket_(logger) {
+    socket_.connect("127.0.0.1", "lo", port, false);
+    socket_.recv_callback_ = [this](auto socket, auto) { recvCallback(socket); };
+  }
+
+  auto send(const Exchange::MEClientRequest &request) -> void {
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    socket_.send(encoded, Exchange::encodeClientRequest(next_seq_num_, request, encoded));
+    ++next_seq_num_;
+    ++in_flight_;
+  }
+
+  /// Record the round trip of every ACCEPTED response to a new order sent by this client.
+  auto recvCallback(Common::TCPSocket *socket) -> void {
+    const auto now = Common::getCurrentNanos();
+    size_t i = 0;
+    for (auto msg_len = Exchange::wireMessageLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Exchange::wireMessageLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      Exchange::MEClientResponse response;
+      Exchange::decodeClientResponse(socket->inbound_data_.data() + i, client_id_, response);
+      --in_flight_;
+      if (response.type_ == Exchange::ClientResponseType::THROTTLED)
+        ++throttled_;
+      if (response.type_ == Exchange::ClientResponseType::ACCEPTED &&
+          response.client_order_id_ < send_times_.size())
+        latencies_.push_back(now - send_times_[response.client_order_id_]);
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  }
+
+  const Common::ClientId client_id_;
+  Common::TCPSocket socket_;
+  uint32_t next_seq_num_ = 1;
+  size_t in_flight_ = 0;
+  size_t throttled_ = 0;
+
+  /// Send time of every new order indexed by its client order id, and the round trips measured so far.
+  std::vector<Common::Nanos> send_times_;
+  std::vector<Common::Nanos> latencies_;
+};
+
+/// Run an order server and matching engine on loopback with one flooding client and num_quiet_clients well behaved clients,
+/// reporting the round trip percentiles of the well behaved clients.
+void benchmarkThrottle(const std::string &name, const Exchange::ThrottleLimits &throttle_limits, int port) {
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 1;
+  limits.max_num_clients_ = num_quiet_clients + 1;
+
+  // Like the server and engine, the queues are never destroyed, the threads using them are left running when this returns.
+  auto &client_requests = *new Exchange::ClientRequestLFQueue(limits.max_client_updates_);
+  auto &client_responses = *new Exchange::ClientResponseLFQueue(limits.max_client_updates_);
+  auto &market_updates = *new Exchange::MEMarketUpdateLFQueue(limits.max_market_updates_);
+
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+  matching_engine->start();
+  auto order_server = new Exchange::OrderServer(&client_requests, &client_responses, "lo", port, nullptr, 1, limits, throttle_limits);
+  order_server->start();
+
+  Common::Logger logger("");
+  std::vector<BenchmarkClient *> clients;
+  for (Common::ClientId client_id = 0; client_id <= num_quiet_clients; ++client_id)
+    clients.push_back(new BenchmarkClient(client_id, logger, port));
+  auto flooder = clients[0];
+
+  size_t flood_sent = 0;
+  Common::OrderId next_quiet_order_id = 1;
+  const auto start_time = Common::getCurrentNanos();
+  auto next_quiet_time = start_time;
+  for (auto now = start_time; now < start_time + run_time; now = Common::getCurrentNanos()) {
+    // Cancels for orders which do not exist, so the flood costs a round trip through the matching engine without building up any state.
+    for (size_t i = 0; i < flood_batch && flooder->in_flight_ < flood_window; ++i, ++flood_sent)
+      flooder->send({Exchange::ClientRequestType::CANCEL, flooder->client_id_, 0, flood_sent + 1, Common::Side::BUY, 100, 1});
+
+    if (now >= next_quiet_time && std::all_of(clients.begin() + 1, clients.end(), [](auto client) { return !client->in_flight_; })) {
+      for (size_t i = 1; i < clients.size(); ++i) {
+        clients[i]->send_times_.resize(next_quiet_order_id + 1, 0);
+        clients[i]->send_times_[next_quiet_order_id] = Common::getCurrentNanos();
+        clients[i]->send({Exchange::ClientRequestType::NEW, clients[i]->client_id_, 0, next_quiet_order_id, Common::Side::BUY, 100, 1});
+      }
+      ++next_quiet_order_id;
+      next_quiet_time = now + quiet_interval;
+    }
+
+    for (auto client: clients)
+      client->socket_.sendAndRecv();
+
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+
+    // Let the order server and matching engine threads run if they share a core with the clients.
+    std::this_thread::yield();
+  }
+
+  std::vector<Common::Nanos> latencies;
+  for (size_t i = 1; i < clients.size(); ++i)
+    latencies.insert(latencies.end(), clients[i]->latencies_.begin(), clients[i]->latencies_.end());
+  std::sort(latencies.begin(), latencies.end());
+  ASSERT(!latencies.empty(), "No round trips measured for " + name);
+
+  std::cout << name << " QUIET CLIENTS p50:" << latencies[latencies.size() / 2] / Common::NANOS_TO_MICROS
+            << " p99:" << latencies[latencies.size() * 99 / 100] / Common::NANOS_TO_MICROS
+            << " max:" << latencies.back() / Common::NANOS_TO_MICROS << " us over " << latencies.size() << " orders."
+            << " FLOOD sent:" << flood_sent << " throttled:" << flooder->throttled_
+            << " server-throttled:" << order_server->throttledCount(flooder->client_id_) << std::endl;
+
+  // The process exits right after, the server and engine threads are left running instead of waiting for them to stop.
+}
+
+int main(int, char **) {
+  const std::vector<std::pair<std::string, Exchange::ThrottleLimits>> scenarios{
+      {"UNTHROTTLED", Exchange::ThrottleLimits{0, 0}},
+      {"THROTTLED 20000 msgs/sec burst 100", Exchange::ThrottleLimits{20000, 100}}};
+
+  // Every scenario runs in a fresh child process with its own order server port and threads.
+  int port = 12346;
+  for (const auto &[name, throttle_limits]: scenarios) {
+    const auto pid = fork();
+    ASSERT(pid >= 0, "fork() failed error:" + std::string(std::strerror(errno)));
+    if (!pid) {
+      benchmarkThrottle(name, throttle_limits, port);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+      exit(EXIT_FAILURE);
+    ++port;
+  }
+
+  exit(EXIT_SUCCESS);
+}
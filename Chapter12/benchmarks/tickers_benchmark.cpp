@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <fstream>
+#include <sys/wait.h>
+
+#include "matcher/matching_engine.h"
+
+/// Number of client requests processed for each ticker count, half of them new orders and the other half cancels.
+static constexpr size_t request_count = 200000;
+static constexpr size_t num_clients = 16;
+
+/// Resident set size of this process in bytes.
+size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0, resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+/// Return the p-th percentile of the provided sorted samples.
+uint64_t percentile(const std::vector<uint64_t> &samples, double p) {
+  return samples[static_cast<size_t>(p * (samples.size() - 1))];
+}
+
+/// Drive a matching engine with logging disabled through passive order adds and cancels spread uniformly across num_tickers tickers,
+/// reporting startup time, per request latency and resident memory.
+void benchmarkTickers(size_t num_tickers) {
+  srand(0);
+
+  Common::EngineLimits limits;
+  limits.max_tickers_ = num_tickers;
+  limits.max_num_clients_ = num_clients;
+
+  std::vector<Exchange::MEClientRequest> requests;
+  requests.reserve(request_count);
+  std::array<Common::OrderId, num_clients> next_order_id;
+  next_order_id.fill(1);
+  while (requests.size() < request_count) {
+    const Common::ClientId client_id = rand() % num_clients;
+    const Common::TickerId ticker_id = rand() % num_tickers;
+    const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+    const Common::Price price = (side == Common::Side::BUY ? 100 - (rand() % 100) : 101 + (rand() % 100));
+    requests.push_back({Exchange::ClientRequestType::NEW, client_id, ticker_id, next_order_id[client_id]++, side, price,
+                        static_cast<Common::Qty>(1 + rand() % 100)});
+
+    auto cxl_request = requests[rand() % requests.size()];
+    cxl_request.type_ = Exchange::ClientRequestType::CANCEL;
+    requests.push_back(cxl_request);
+  }
+
+  const auto rss_before = residentBytes();
+  const auto start_time = Common::getCurrentNanos();
+
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(limits.max_client_updates_);
+  Exchange::MEMarketUpdateLFQueue market_updates(limits.max_market_updates_);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+
+  const auto startup = Common::getCurrentNanos() - start_time;
+
+  std::vector<uint64_t> cycles;
+  cycles.reserve(requests.size());
+  for (const auto &request: requests) {
+    const auto start = Common::rdtsc();
+    matching_engine->processClientRequest(&request);
+    cycles.push_back(Common::rdtsc() - start);
+
+    while (client_responses.size())
+      client_responses.updateReadIndex();
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+  }
+
+  const auto rss_after = residentBytes();
+  std::sort(cycles.begin(), cycles.end());
+
+  std::cout << "TICKERS " << std::setw(6) << num_tickers << " STARTUP " << startup / NANOS_TO_MICROS << " us."
+            << " p50:" << percentile(cycles, 0.5) << " p99:" << percentile(cycles, 0.99) << " CLOCK CYCLES PER REQUEST."
+            << " RESIDENT " << (rss_after - rss_before) / (1024 * 1024) << " MB." << std::endl;
+
+  delete matching_engine;
+}
+
+/// Client order ids are per client across all tickers, check that a new order reusing a live one on another ticker is rejected and leaves the
+/// live order cancelable, and that the id can be reused once that order is gone.
+void checkClientOrderIdReuse() {
+  Common::EngineLimits limits;
+  limits.max_tickers_ = 2;
+  limits.max_num_clients_ = num_clients;
+
+  Exchange::ClientRequestLFQueue client_requests(1);
+  Exchange::ClientResponseLFQueue client_responses(limits.max_client_updates_);
+  Exchange::MEMarketUpdateLFQueue market_updates(limits.max_market_updates_);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "", nullptr, limits);
+
+  auto expect = [&](Exchange::ClientRequestType type, Common::TickerId ticker_id, Exchange::ClientResponseType expected_type) {
+    const Exchange::MEClientRequest request{type, 0, ticker_id, 1, Common::Side::BUY, 100, 10};
+    matching_engine->processClientRequest(&request);
+    ASSERT(client_responses.size() == 1 && client_responses.getNextToRead()->type_ == expected_type,
+           "Expected " + Exchange::clientResponseTypeToString(expected_type) + " for " + request.toString());
+    client_responses.updateReadIndex();
+    while (market_updates.size())
+      market_updates.updateReadIndex();
+  };
+
+  expect(Exchange::ClientRequestType::NEW, 0, Exchange::ClientResponseType::ACCEPTED);
+  expect(Exchange::ClientRequestType::NEW, 1, Exchange::ClientResponseType::REJECTED);
+  expect(Exchange::ClientRequestType::CANCEL, 1, Exchange::ClientResponseType::CANCEL_REJECTED);
+  expect(Exchange::ClientRequestType::CANCEL, 0, Exchange::ClientResponseType::CANCELED);
+  expect(Exchange::ClientRequestType::NEW, 1, Exchange::ClientResponseType::ACCEPTED);
+  expect(Exchange::ClientRequestType::CANCEL, 1, Exchange::ClientResponseType::CANCELED);
+
+  std::cout << "CLIENT ORDER ID REUSED ACROSS TICKERS: OK." << std::endl;
+
+  delete matching_engine;
+}
+
+int main(int, char **) {
+  checkClientOrderIdReuse();
+
+  // Every ticker count runs in a fresh child process so that the resident memory of one does not hide that of the next.
+  for (const size_t num_tickers: {8, 100, 1000, 10000}) {
+    const auto pid = fork();
+    ASSERT(pid >= 0, "fork() failed error:" + std::string(std::strerror(errno)));
+    if (!pid) {
+      benchmarkTickers(num_tickers);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+      exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+}
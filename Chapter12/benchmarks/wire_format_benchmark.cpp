@@ -0,0 +1,168 @@
+#include <algorithm>
+
+#include "common/tcp_server.h"
+#include "exchange/order_server/client_wire.h"
+
+/// Number of request round trips measured per wire format, every round trip waits for the responses to the previous request.
+static constexpr size_t num_round_trips = 20000;
+
+/// The fixed width OMClientRequest / OMClientResponse encoding.
+struct LegacyFormat {
+  static constexpr auto name = "OMClientRequest/OMClientResponse";
+
+  static auto encodeRequest(uint32_t seq_num, const Exchange::MEClientRequest &request, char *buffer) noexcept -> size_t {
+    *reinterpret_cast<Exchange::OMClientRequest *>(buffer) = Exchange::OMClientRequest{seq_num, request};
+    return sizeof(Exchange::OMClientRequest);
+  }
+
+  static auto requestLength(const char *, size_t len) noexcept -> size_t {
+    return (len >= sizeof(Exchange::OMClientRequest) ? sizeof(Exchange::OMClientRequest) : 0);
+  }
+
+  static auto decodeRequest(const char *buffer, Exchange::MEClientRequest &request) noexcept -> uint32_t {
+    const auto msg = reinterpret_cast<const Exchange::OMClientRequest *>(buffer);
+    request = msg->me_client_request_;
+    return static_cast<uint32_t>(msg->seq_num_);
+  }
+
+  static auto encodeResponse(uint32_t seq_num, const Exchange::MEClientResponse &response, char *buffer) noexcept -> size_t {
+    *reinterpret_cast<Exchange::OMClientResponse *>(buffer) = Exchange::OMClientResponse{seq_num, response};
+    return sizeof(Exchange::OMClientResponse);
+  }
+
+  static auto responseLength(const char *, size_t len) noexcept -> size_t {
+    return (len >= sizeof(Exchange::OMClientResponse) ? sizeof(Exchange::OMClientResponse) : 0);
+  }
+
+  static auto decodeResponse(const char *buffer, Common::ClientId, Exchange::MEClientResponse &response) noexcept -> uint32_t {
+    const auto msg = reinterpret_cast<const Exchange::OMClientResponse *>(buffer);
+    response = msg->me_client_response_;
+    return static_cast<uint32_t>(msg->seq_num_);
+  }
+};
+
+/// The compact encoding in client_wire.h.
+struct CompactFormat {
+  static constexpr auto name = "compact wire format";
+
+  static auto encodeRequest(uint32_t seq_num, const Exchange::MEClientRequest &request, char *buffer) noexcept {
+    return Exchange::encodeClientRequest(seq_num, request, buffer);
+  }
+
+  static auto requestLength(const char *buffer, size_t len) noexcept {
+    return Exchange::wireMessageLength(buffer, len);
+  }
+
+  static auto decodeRequest(const char *buffer, Exchange::MEClientRequest &request) noexcept {
+    return Exchange::decodeClientRequest(buffer, request);
+  }
+
+  static auto encodeResponse(uint32_t seq_num, const Exchange::MEClientResponse &response, char *buffer) noexcept {
+    return Exchange::encodeClientResponse(seq_num, response, buffer);
+  }
+
+  static auto responseLength(const char *buffer, size_t len) noexcept {
+    return Exchange::wireMessageLength(buffer, len);
+  }
+
+  static auto decodeResponse(const char *buffer, Common::ClientId client_id, Exchange::MEClientResponse &response) noexcept {
+    return Exchange::decodeClientResponse(buffer, client_id, response);
+  }
+};
+
+/// Send alternating new orders and cancels from a client socket to a server socket on loopback, both driven from this thread.
+/// The server answers a new order with an ACCEPTED and a partial FILLED and a cancel with a CANCELED, like the matching engine would.
+/// Reports the encoded bytes per message in each direction and the round trip from sending a request to decoding its last response.
+template<typename Format>
+void benchmarkWireFormat(int port) {
+  Common::Logger logger("");
+  constexpr Common::ClientId client_id = 1;
+  constexpr size_t max_msg_size = std::max(sizeof(Exchange::OMClientResponse), Exchange::WIRE_MAX_RESPONSE_SIZE);
+
+  size_t request_bytes = 0, num_requests = 0, response_bytes = 0, num_responses = 0;
+  uint32_t server_seq_num = 1;
+
+  Common::TCPServer server(logger);
+  server.recv_callback_ = [&](auto socket, auto) {
+    size_t i = 0;
+    for (auto msg_len = Format::requestLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Format::requestLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      Exchange::MEClientRequest request;
+      Format::decodeRequest(socket->inbound_data_.data() + i, request);
+      request_bytes += msg_len;
+      ++num_requests;
+
+      std::vector<Exchange::MEClientResponse> responses;
+      if (request.type_ == Exchange::ClientRequestType::NEW) {
+        responses.push_back({Exchange::ClientResponseType::ACCEPTED, request.client_id_, request.ticker_id_, request.order_id_, num_requests, request.side_,
+                             request.price_, 0, request.qty_});
+        responses.push_back({Exchange::ClientResponseType::FILLED, request.client_id_, request.ticker_id_, request.order_id_, num_requests, request.side_,
+                             request.price_, 1, request.qty_ - 1});
+      } else {
+        responses.push_back({Exchange::ClientResponseType::CANCELED, request.client_id_, request.ticker_id_, request.order_id_, num_requests, request.side_,
+                             request.price_, Common::Qty_INVALID, request.qty_});
+      }
+
+      for (const auto &response: responses) {
+        char encoded[max_msg_size];
+        const auto len = Format::encodeResponse(server_seq_num++, response, encoded);
+        socket->send(encoded, len);
+        response_bytes += len;
+        ++num_responses;
+      }
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  };
+  server.recv_finished_callback_ = []() {};
+  server.listen("lo", port);
+
+  size_t pending_responses = 0;
+  Common::Nanos send_time = 0;
+  std::vector<Common::Nanos> latencies;
+  latencies.reserve(num_round_trips);
+
+  Common::TCPSocket client(logger);
+  client.recv_callback_ = [&](auto socket, auto) {
+    size_t i = 0;
+    for (auto msg_len = Format::responseLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Format::responseLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      Exchange::MEClientResponse response;
+      Format::decodeResponse(socket->inbound_data_.data() + i, client_id, response);
+      if (!--pending_responses)
+        latencies.push_back(Common::getCurrentNanos() - send_time);
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  };
+  ASSERT(client.connect("127.0.0.1", "lo", port, false) >= 0, "Unable to connect to port:" + std::to_string(port));
+
+  uint32_t client_seq_num = 1;
+  while (latencies.size() < num_round_trips) {
+    if (!pending_responses) {
+      const auto is_new = (client_seq_num % 2 == 1);
+      const Exchange::MEClientRequest request{(is_new ? Exchange::ClientRequestType::NEW : Exchange::ClientRequestType::CANCEL), client_id, 3,
+                                              client_seq_num / 2 + 1, Common::Side::BUY, 1000 + client_seq_num % 50, 10};
+      char encoded[max_msg_size];
+      send_time = Common::getCurrentNanos();
+      client.send(encoded, Format::encodeRequest(client_seq_num++, request, encoded));
+      pending_responses = (is_new ? 2 : 1);
+    }
+
+    client.sendAndRecv();
+    server.poll();
+    server.sendAndRecv();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << Format::name << " request bytes/msg:" << static_cast<double>(request_bytes) / num_requests
+            << " response bytes/msg:" << static_cast<double>(response_bytes) / num_responses
+            << " round trip p50:" << latencies[latencies.size() / 2] << " p99:" << latencies[latencies.size() * 99 / 100] << " ns" << std::endl;
+}
+
+int main(int, char **) {
+  benchmarkWireFormat<LegacyFormat>(12360);
+  benchmarkWireFormat<CompactFormat>(12361);
+
+  exit(EXIT_SUCCESS);
+}
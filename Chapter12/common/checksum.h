@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Common {
+  /// Seed and multiplier for the 64-bit FNV-1a hash.
+  constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+  constexpr uint64_t FNV1A_PRIME = 1099511628211ull;
+
+  /// Compute the 64-bit FNV-1a hash of len bytes starting at data.
+  /// Passing the result of a previous call as the seed allows hashing a stream of buffers incrementally.
+  inline auto fnv1a(const void *data, size_t len, uint64_t seed = FNV1A_OFFSET_BASIS) noexcept {
+    auto hash = seed;
+    const auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; ++i) {
+      hash ^= bytes[i];
+      hash *= FNV1A_PRIME;
+    }
+
+    return hash;
+  }
+}
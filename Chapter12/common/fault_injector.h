@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+#include "macros.h"
+#include "time_utils.h"
+
+namespace Common {
+  /// Network faults injected into what a socket reads, so that the recovery paths get exercised on loopback where nothing is ever lost.
+  /// Every datagram read off a McastSocket is dropped, duplicated, delayed by delay_time_ or reordered behind the next datagram with the probabilities
+  /// below. A TCPSocket reads a byte stream which cannot lose, duplicate or reorder bytes, so for it a drop closes the connection and a delay holds
+  /// back everything read until it expires, duplicate_ and reorder_ are ignored.
+  struct FaultCfg {
+    /// The faults only depend on the seed and the sequence of datagrams / reads, so a run can be repeated with the same faults.
+    uint64_t seed_ = 0;
+
+    double drop_ = 0;
+    double duplicate_ = 0;
+    double delay_ = 0;
+    double reorder_ = 0;
+
+    /// How long delayed datagrams are held back, and the longest a reordered datagram waits for the next one.
+    Nanos delay_time_ = NANOS_TO_MILLIS;
+
+    auto enabled() const noexcept {
+      return (drop_ > 0 || duplicate_ > 0 || delay_ > 0 || reorder_ > 0);
+    }
+
+    /// Read the cfg from the environment variables <prefix>SEED, <prefix>DROP, <prefix>DUPLICATE, <prefix>DELAY, <prefix>REORDER and
+    /// <prefix>DELAY_MICROS, the ones not set keep their defaults.
+    static auto fromEnv(const std::string &prefix) {
+      FaultCfg cfg;
+      auto env = [&prefix](const char *name) {
+        return std::getenv((prefix + name).c_str());
+      };
+
+      if (const auto value = env("SEED"))
+        cfg.seed_ = std::strtoull(value, nullptr, 10);
+      for (auto [name, probability]: {std::make_pair("DROP", &cfg.drop_), std::make_pair("DUPLICATE", &cfg.duplicate_),
+                                      std::make_pair("DELAY", &cfg.delay_), std::make_pair("REORDER", &cfg.reorder_)}) {
+        if (const auto value = env(name))
+          *probability = std::atof(value);
+      }
+      if (const auto value = env("DELAY_MICROS"))
+        cfg.delay_time_ = std::atoll(value) * NANOS_TO_MICROS;
+
+      return cfg;
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "FaultCfg{"
+         << "seed:" << seed_ << " "
+         << "drop:" << drop_ << " "
+         << "duplicate:" << duplicate_ << " "
+         << "delay:" << delay_ << " "
+         << "reorder:" << reorder_ << " "
+         << "delay-time:" << delay_time_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  enum class Fault : uint8_t {
+    NONE = 0,
+    DROP = 1,
+    DUPLICATE = 2,
+    DELAY = 3,
+    REORDER = 4
+  };
+
+  inline auto faultToString(Fault fault) -> std::string {
+    switch (fault) {
+      case Fault::NONE:
+        return "NONE";
+      case Fault::DROP:
+        return "DROP";
+      case Fault::DUPLICATE:
+        return "DUPLICATE";
+      case Fault::DELAY:
+        return "DELAY";
+      case Fault::REORDER:
+        return "REORDER";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Draws the faults of one socket from a FaultCfg and holds back the data delayed or reordered by them.
+  class FaultInjector final {
+  public:
+    /// stream tells apart the sockets sharing a FaultCfg, each gets its own sequence of faults which only depends on the seed and the stream.
+    FaultInjector(const FaultCfg &cfg, uint64_t stream)
+        : cfg_(cfg), state_(mix(cfg.seed_ ^ mix(stream))) {
+    }
+
+    auto cfg() const noexcept -> const FaultCfg & {
+      return cfg_;
+    }
+
+    /// Fault to inject into the next datagram / read.
+    auto next() noexcept {
+      const auto value = static_cast<double>(random() >> 11) * 0x1.0p-53;
+      auto fault = Fault::NONE;
+      if (value < cfg_.drop_)
+        fault = Fault::DROP;
+      else if (value < cfg_.drop_ + cfg_.duplicate_)
+        fault = Fault::DUPLICATE;
+      else if (value < cfg_.drop_ + cfg_.duplicate_ + cfg_.delay_)
+        fault = Fault::DELAY;
+      else if (value < cfg_.drop_ + cfg_.duplicate_ + cfg_.delay_ + cfg_.reorder_)
+        fault = Fault::REORDER;
+
+      ++num_faults_[static_cast<size_t>(fault)];
+      return fault;
+    }
+
+    /// Hold back the len bytes at data until due, or until the next datagram is delivered if after_next.
+    auto hold(const char *data, size_t len, Nanos due, bool after_next) -> void {
+      held_.push_back({due, after_next, std::vector<char>(data, data + len)});
+    }
+
+    auto empty() const noexcept {
+      return held_.empty();
+    }
+
+    /// Due time of the data held back last, data read while something is held back on a byte stream has to wait for it.
+    auto lastDue() const noexcept {
+      return held_.back().due_;
+    }
+
+    /// Hand the data held back which is due at now, and the datagrams waiting for the next one if a datagram was just delivered, to
+    /// deliver(data, len) in the order they were held back. deliver returns false if there is no room for the data, which then stays held back
+    /// together with everything held back after it until the next release.
+    template<typename Deliver>
+    auto release(Nanos now, bool delivered, Deliver &&deliver) -> void {
+      for (auto itr = held_.begin(); itr != held_.end();) {
+        if (itr->due_ <= now || (delivered && itr->after_next_)) {
+          if (!deliver(itr->data_.data(), itr->data_.size()))
+            return;
+          itr = held_.erase(itr);
+        } else {
+          ++itr;
+        }
+      }
+    }
+
+    /// Drop everything held back, e.g. when the connection it was read from is closed.
+    auto clear() noexcept {
+      held_.clear();
+    }
+
+    auto numFaults(Fault fault) const noexcept {
+      return num_faults_[static_cast<size_t>(fault)];
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "Faults{";
+      for (auto fault: {Fault::DROP, Fault::DUPLICATE, Fault::DELAY, Fault::REORDER})
+        ss << faultToString(fault) << ":" << numFaults(fault) << " ";
+      ss << "held:" << held_.size()
+         << "}";
+
+      return ss.str();
+    }
+
+  private:
+    const FaultCfg cfg_;
+
+    /// splitmix64 state, so that the faults drawn do not depend on the standard library's generators.
+    uint64_t state_;
+
+    /// Data held back by a DELAY or REORDER.
+    struct Held {
+      Nanos due_;
+      bool after_next_;
+      std::vector<char> data_;
+    };
+
+    std::deque<Held> held_;
+
+    size_t num_faults_[static_cast<size_t>(Fault::REORDER) + 1] = {};
+
+    auto random() noexcept -> uint64_t {
+      return mix(state_ += 0x9e3779b97f4a7c15ULL);
+    }
+
+    /// splitmix64 finalizer, also used to spread the seed and stream over the state so that the sockets' sequences are not shifted copies of each other.
+    static auto mix(uint64_t z) noexcept -> uint64_t {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+  };
+}
@@ -37,6 +37,10 @@ namespace Common {
       return num_elements_.load();
     }
 
+    auto capacity() const noexcept {
+      return store_.size();
+    }
+
     /// Deleted default, copy & move constructors and assignment-operators.
     LFQueue() = delete;
 
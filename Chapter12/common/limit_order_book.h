@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "macros.h"
+#include "types.h"
+#include "mem_pool.h"
+
+namespace Common {
+  /// Price level container which finds the price level for a price in an array indexed by the price modulo the number of price levels.
+  /// The number of price levels has to be a power of 2 so that the modulo is a mask.
+  template<typename OrdersAtPrice>
+  class ModuloPriceLevels final {
+  public:
+    explicit ModuloPriceLevels(size_t max_price_levels)
+        : price_level_mask_(max_price_levels - 1), price_orders_at_price_(max_price_levels, nullptr) {
+      ASSERT(max_price_levels && !(max_price_levels & (max_price_levels - 1)), "Price levels:" + std::to_string(max_price_levels) + " not a power of 2.");
+    }
+
+    /// Fetch and return the OrdersAtPrice corresponding to the provided price, nullptr if there is none.
+    auto get(Price price) const noexcept -> OrdersAtPrice * {
+      return price_orders_at_price_.at(priceToIndex(price));
+    }
+
+    auto set(Price price, OrdersAtPrice *orders_at_price) noexcept -> void {
+      price_orders_at_price_.at(priceToIndex(price)) = orders_at_price;
+    }
+
+    auto clear() noexcept -> void {
+      std::fill(price_orders_at_price_.begin(), price_orders_at_price_.end(), nullptr);
+    }
+
+  private:
+    auto priceToIndex(Price price) const noexcept {
+      return static_cast<size_t>(price & price_level_mask_);
+    }
+
+    const Price price_level_mask_;
+
+    /// Hash map from Price -> OrdersAtPrice.
+    std::vector<OrdersAtPrice *> price_orders_at_price_;
+  };
+
+  /// Price-time priority limit order book which maintains the price levels on both sides and the FIFO queue of orders at every price level.
+  /// It does not know about matching or market data, the exchange MEOrderBook and the trading MarketOrderBook are adapters around it.
+  /// Order - order node with side_, price_, priority_, prev_order_ and next_order_ members.
+  /// OrdersAtPrice - price level with side_, price_, first_order_, prev_entry_ and next_entry_ members and a constructor taking them in that order.
+  /// OrderIndex - order id lookup with insert(Order *) and erase(const Order *), the adapter owns the lookup side of it.
+  /// PriceLevels - Price -> OrdersAtPrice container with get(), set() and clear().
+  template<typename Order, typename OrdersAtPrice, typename OrderIndex, typename PriceLevels = ModuloPriceLevels<OrdersAtPrice>>
+  class LimitOrderBook final {
+  public:
+    /// The memory pools can be shared by many order books.
+    LimitOrderBook(MemPool<Order> *order_pool, MemPool<OrdersAtPrice> *orders_at_price_pool, OrderIndex &&order_index, size_t max_price_levels)
+        : order_pool_(order_pool), orders_at_price_pool_(orders_at_price_pool), order_index_(std::move(order_index)), price_levels_(max_price_levels) {
+    }
+
+    ~LimitOrderBook() {
+      order_pool_ = nullptr;
+      orders_at_price_pool_ = nullptr;
+      bids_by_price_ = asks_by_price_ = nullptr;
+    }
+
+    /// Best / top of book price level on the provided side, nullptr if that side is empty.
+    /// The price levels on a side form a circular doubly linked list from most aggressive to least aggressive price.
+    auto bestOrdersByPrice(Side side) const noexcept -> OrdersAtPrice * {
+      return (side == Side::BUY ? bids_by_price_ : asks_by_price_);
+    }
+
+    /// Fetch and return the OrdersAtPrice corresponding to the provided price.
+    auto getOrdersAtPrice(Price price) const noexcept -> OrdersAtPrice * {
+      return price_levels_.get(price);
+    }
+
+    /// Priority for a new order at the provided price, i.e. one more than the last order in the FIFO queue at that price.
+    auto getNextPriority(Price price) const noexcept -> Priority {
+      const auto orders_at_price = getOrdersAtPrice(price);
+      if (!orders_at_price)
+        return 1lu;
+
+      return orders_at_price->first_order_->prev_order_->priority_ + 1;
+    }
+
+    auto orderIndex() noexcept -> OrderIndex & {
+      return order_index_;
+    }
+
+    auto orderIndex() const noexcept -> const OrderIndex & {
+      return order_index_;
+    }
+
+    /// Add a single order at the end of the FIFO queue at the price level that this order belongs in and into the order index.
+    auto addOrder(Order *order) noexcept -> void {
+      const auto orders_at_price = getOrdersAtPrice(order->price_);
+
+      if (!orders_at_price) {
+        order->next_order_ = order->prev_order_ = order;
+
+        auto new_orders_at_price = orders_at_price_pool_->allocate(order->side_, order->price_, order, nullptr, nullptr);
+        addOrdersAtPrice(new_orders_at_price);
+      } else {
+        auto first_order = orders_at_price->first_order_;
+
+        first_order->prev_order_->next_order_ = order;
+        order->prev_order_ = first_order->prev_order_;
+        order->next_order_ = first_order;
+        first_order->prev_order_ = order;
+      }
+
+      order_index_.insert(order);
+    }
+
+    /// Remove the provided order from its price level and from the order index and de-allocate it.
+    auto removeOrder(Order *order) noexcept -> void {
+      auto orders_at_price = getOrdersAtPrice(order->price_);
+
+      if (order->prev_order_ == order) { // only one element.
+        removeOrdersAtPrice(orders_at_price);
+      } else { // remove the link.
+        const auto order_before = order->prev_order_;
+        const auto order_after = order->next_order_;
+        order_before->next_order_ = order_after;
+        order_after->prev_order_ = order_before;
+
+        if (orders_at_price->first_order_ == order) {
+          orders_at_price->first_order_ = order_after;
+        }
+
+        order->prev_order_ = order->next_order_ = nullptr;
+      }
+
+      order_index_.erase(order);
+      order_pool_->deallocate(order);
+    }
+
+    /// Remove and de-allocate every order and price level.
+    auto clear() noexcept -> void {
+      for (auto best_orders_by_price: {bids_by_price_, asks_by_price_}) {
+        auto orders_at_price = best_orders_by_price;
+        while (orders_at_price) {
+          for (auto order = orders_at_price->first_order_;;) {
+            const auto next_order = order->next_order_;
+            order_index_.erase(order);
+            order_pool_->deallocate(order);
+            if (next_order == orders_at_price->first_order_)
+              break;
+            order = next_order;
+          }
+
+          const auto next_orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+          orders_at_price_pool_->deallocate(orders_at_price);
+          orders_at_price = next_orders_at_price;
+        }
+      }
+
+      price_levels_.clear();
+      bids_by_price_ = asks_by_price_ = nullptr;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    LimitOrderBook() = delete;
+
+    LimitOrderBook(const LimitOrderBook &) = delete;
+
+    LimitOrderBook(const LimitOrderBook &&) = delete;
+
+    LimitOrderBook &operator=(const LimitOrderBook &) = delete;
+
+    LimitOrderBook &operator=(const LimitOrderBook &&) = delete;
+
+  private:
+    /// Memory pools to manage Order and OrdersAtPrice objects, not owned.
+    MemPool<Order> *order_pool_ = nullptr;
+    MemPool<OrdersAtPrice> *orders_at_price_pool_ = nullptr;
+
+    OrderIndex order_index_;
+
+    /// Pointers to beginning / best prices / top of book of buy and sell price levels.
+    OrdersAtPrice *bids_by_price_ = nullptr;
+    OrdersAtPrice *asks_by_price_ = nullptr;
+
+    PriceLevels price_levels_;
+
+  private:
+    auto bestOrdersByPriceRef(Side side) noexcept -> OrdersAtPrice *& {
+      return (side == Side::BUY ? bids_by_price_ : asks_by_price_);
+    }
+
+    /// Add a new OrdersAtPrice at the correct price into the containers - the price levels and the doubly linked list of price levels.
+    auto addOrdersAtPrice(OrdersAtPrice *new_orders_at_price) noexcept -> void {
+      price_levels_.set(new_orders_at_price->price_, new_orders_at_price);
+
+      const auto side = new_orders_at_price->side_;
+      auto &best_orders_by_price = bestOrdersByPriceRef(side);
+      if (UNLIKELY(!best_orders_by_price)) {
+        best_orders_by_price = new_orders_at_price;
+        new_orders_at_price->prev_entry_ = new_orders_at_price->next_entry_ = new_orders_at_price;
+      } else {
+        auto target = best_orders_by_price;
+        bool add_after = ((side == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                          (side == Side::BUY && new_orders_at_price->price_ < target->price_));
+        if (add_after) {
+          target = target->next_entry_;
+          add_after = ((side == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                       (side == Side::BUY && new_orders_at_price->price_ < target->price_));
+        }
+        while (add_after && target != best_orders_by_price) {
+          add_after = ((side == Side::SELL && new_orders_at_price->price_ > target->price_) ||
+                       (side == Side::BUY && new_orders_at_price->price_ < target->price_));
+          if (add_after)
+            target = target->next_entry_;
+        }
+
+        if (add_after) { // add new_orders_at_price after target.
+          if (target == best_orders_by_price) {
+            target = best_orders_by_price->prev_entry_;
+          }
+          new_orders_at_price->prev_entry_ = target;
+          target->next_entry_->prev_entry_ = new_orders_at_price;
+          new_orders_at_price->next_entry_ = target->next_entry_;
+          target->next_entry_ = new_orders_at_price;
+        } else { // add new_orders_at_price before target.
+          new_orders_at_price->prev_entry_ = target->prev_entry_;
+          new_orders_at_price->next_entry_ = target;
+          target->prev_entry_->next_entry_ = new_orders_at_price;
+          target->prev_entry_ = new_orders_at_price;
+
+          if ((side == Side::BUY && new_orders_at_price->price_ > best_orders_by_price->price_) ||
+              (side == Side::SELL && new_orders_at_price->price_ < best_orders_by_price->price_)) {
+            target->next_entry_ = (target->next_entry_ == best_orders_by_price ? new_orders_at_price : target->next_entry_);
+            best_orders_by_price = new_orders_at_price;
+          }
+        }
+      }
+    }
+
+    /// Remove the OrdersAtPrice from the containers - the price levels and the doubly linked list of price levels.
+    auto removeOrdersAtPrice(OrdersAtPrice *orders_at_price) noexcept -> void {
+      auto &best_orders_by_price = bestOrdersByPriceRef(orders_at_price->side_);
+
+      if (UNLIKELY(orders_at_price->next_entry_ == orders_at_price)) { // empty side of book.
+        best_orders_by_price = nullptr;
+      } else {
+        orders_at_price->prev_entry_->next_entry_ = orders_at_price->next_entry_;
+        orders_at_price->next_entry_->prev_entry_ = orders_at_price->prev_entry_;
+
+        if (orders_at_price == best_orders_by_price) {
+          best_orders_by_price = orders_at_price->next_entry_;
+        }
+
+        orders_at_price->prev_entry_ = orders_at_price->next_entry_ = nullptr;
+      }
+
+      price_levels_.set(orders_at_price->price_, nullptr);
+
+      orders_at_price_pool_->deallocate(orders_at_price);
+    }
+  };
+}
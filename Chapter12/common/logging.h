@@ -87,8 +87,12 @@ namespace Common {
       }
     }
 
+    /// An empty file_name creates a disabled Logger which opens no file, starts no thread and discards everything logged to it.
     explicit Logger(const std::string &file_name)
-        : file_name_(file_name), queue_(LOG_QUEUE_SIZE) {
+        : file_name_(file_name), enabled_(!file_name.empty()), queue_(enabled_ ? LOG_QUEUE_SIZE : 1) {
+      if (!enabled_)
+        return;
+
       file_.open(file_name);
       ASSERT(file_.is_open(), "Could not open log file:" + file_name);
       logger_thread_ = createAndStartThread(-1, "Common/Logger " + file_name_, [this]() { flushQueue(); });
@@ -96,6 +100,9 @@ namespace Common {
     }
 
     ~Logger() {
+      if (!enabled_)
+        return;
+
       std::string time_str;
       std::cerr << Common::getCurrentTimeStr(&time_str) << " Flushing and closing Logger for " << file_name_ << std::endl;
 
@@ -164,9 +171,16 @@ namespace Common {
       pushValue(value.c_str());
     }
 
+    auto enabled() const noexcept {
+      return enabled_;
+    }
+
     /// Parse the format string, substitute % with the variable number of arguments passed and write the string to the lock free queue.
     template<typename T, typename... A>
     auto log(const char *s, const T &value, A... args) noexcept {
+      if (UNLIKELY(!enabled_))
+        return;
+
       while (*s) {
         if (*s == '%') {
           if (UNLIKELY(*(s + 1) == '%')) { // to allow %% -> % escape character.
@@ -185,6 +199,9 @@ namespace Common {
     /// Overload for case where no substitution in the string is necessary.
     /// Note that this is overloading not specialization. gcc does not allow inline specializations.
     auto log(const char *s) noexcept {
+      if (UNLIKELY(!enabled_))
+        return;
+
       while (*s) {
         if (*s == '%') {
           if (UNLIKELY(*(s + 1) == '%')) { // to allow %% -> % escape character.
@@ -211,6 +228,7 @@ namespace Common {
   private:
     /// File to which the log entries will be written.
     const std::string file_name_;
+    const bool enabled_ = true;
     std::ofstream file_;
 
     /// Lock free queue of log elements from main logging thread to background formatting and disk writer thread.
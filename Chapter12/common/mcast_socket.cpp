@@ -23,7 +23,9 @@ namespace Common {
   /// Publish outgoing data and read incoming data.
   auto McastSocket::sendAndRecv() noexcept -> bool {
     // Read data and dispatch callbacks if data is available - non blocking.
-    const ssize_t n_rcv = recv(socket_fd_, inbound_data_.data() + next_rcv_valid_index_, McastBufferSize - next_rcv_valid_index_, MSG_DONTWAIT);
+    ssize_t n_rcv = recv(socket_fd_, inbound_data_.data() + next_rcv_valid_index_, McastBufferSize - next_rcv_valid_index_, MSG_DONTWAIT);
+    if (UNLIKELY(fault_injector_ != nullptr))
+      n_rcv = applyFaults(n_rcv);
     if (n_rcv > 0) {
       next_rcv_valid_index_ += n_rcv;
       logger_.log("%:% %() % read socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
@@ -48,4 +50,49 @@ namespace Common {
     next_send_valid_index_ += len;
     ASSERT(next_send_valid_index_ < McastBufferSize, "Mcast socket buffer filled up and sendAndRecv() not called.");
   }
+
+  /// Inject the faults drawn from cfg into the datagrams read from now on, stream picks this socket's sequence of faults.
+  auto McastSocket::injectFaults(const FaultCfg &cfg, uint64_t stream) -> void {
+    fault_injector_ = std::make_unique<FaultInjector>(cfg, stream);
+  }
+
+  /// Apply the next fault to the n_rcv bytes datagram just read to the end of inbound_data_ and append the datagrams held back which are due after it.
+  /// Returns the number of bytes left there for recv_callback_.
+  auto McastSocket::applyFaults(ssize_t n_rcv) noexcept -> ssize_t {
+    const auto data = inbound_data_.data() + next_rcv_valid_index_;
+    const auto now = getCurrentNanos();
+    auto len = static_cast<size_t>(std::max<ssize_t>(n_rcv, 0));
+    if (len) {
+      const auto &cfg = fault_injector_->cfg();
+      const auto fault = fault_injector_->next();
+      switch (fault) {
+        case Fault::DROP:
+          len = 0;
+          break;
+        case Fault::DUPLICATE:
+          if (next_rcv_valid_index_ + 2 * len <= McastBufferSize) {
+            memcpy(data + len, data, len);
+            len *= 2;
+          }
+          break;
+        case Fault::DELAY:
+        case Fault::REORDER: // delivered behind the next datagram, or once delay_time_ expires if none arrives by then.
+          fault_injector_->hold(data, len, now + cfg.delay_time_, (fault == Fault::REORDER));
+          len = 0;
+          break;
+        case Fault::NONE:
+          break;
+      }
+    }
+
+    fault_injector_->release(now, len > 0, [&](const char *held, size_t held_len) {
+      if (next_rcv_valid_index_ + len + held_len > McastBufferSize)
+        return false;
+      memcpy(data + len, held, held_len);
+      len += held_len;
+      return true;
+    });
+
+    return static_cast<ssize_t>(len);
+  }
 }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
 #include "socket_utils.h"
+#include "fault_injector.h"
 
 #include "logging.h"
 
@@ -33,6 +35,9 @@ namespace Common {
     /// Copy data to send buffers - does not send them out yet.
     auto send(const void *data, size_t len) noexcept -> void;
 
+    /// Inject the faults drawn from cfg into the datagrams read from now on, stream picks this socket's sequence of faults.
+    auto injectFaults(const FaultCfg &cfg, uint64_t stream) -> void;
+
     int socket_fd_ = -1;
 
     /// Send and receive buffers, typically only one or the other is needed, not both.
@@ -44,7 +49,15 @@ namespace Common {
     /// Function wrapper for the method to call when data is read.
     std::function<void(McastSocket *s)> recv_callback_ = nullptr;
 
+    /// Faults injected into the datagrams read, nullptr unless injectFaults() was called.
+    std::unique_ptr<FaultInjector> fault_injector_;
+
     std::string time_str_;
     Logger &logger_;
+
+  private:
+    /// Apply the next fault to the n_rcv bytes datagram just read to the end of inbound_data_ and append the datagrams held back which are due after it.
+    /// Returns the number of bytes left there for recv_callback_.
+    auto applyFaults(ssize_t n_rcv) noexcept -> ssize_t;
   };
 }
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
 namespace Common {
   /// Read from the TSC register and return a uint64_t value to represent elapsed CPU clock cycles.
   inline auto rdtsc() noexcept {
@@ -7,21 +13,84 @@ namespace Common {
     __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
     return ((uint64_t) hi << 32) | lo;
   }
+
+  /// Counts a hardware event, e.g. PERF_COUNT_HW_CACHE_MISSES or PERF_COUNT_HW_BRANCH_MISSES, for the calling thread in user space.
+  /// Hardware counters are often not available in virtual machines and containers, in which case available() is false and stop() returns 0.
+  class PerfEventCounter final {
+  public:
+    explicit PerfEventCounter(uint64_t hw_event) noexcept {
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = hw_event;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~PerfEventCounter() {
+      if (fd_ >= 0)
+        close(fd_);
+    }
+
+    auto available() const noexcept {
+      return fd_ >= 0;
+    }
+
+    /// Reset the count and start counting.
+    auto start() noexcept {
+      if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+
+    /// Stop counting and return the count since start().
+    auto stop() noexcept {
+      uint64_t count = 0;
+      if (fd_ >= 0) {
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != sizeof(count))
+          count = 0;
+      }
+      return count;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    PerfEventCounter() = delete;
+
+    PerfEventCounter(const PerfEventCounter &) = delete;
+
+    PerfEventCounter(const PerfEventCounter &&) = delete;
+
+    PerfEventCounter &operator=(const PerfEventCounter &) = delete;
+
+    PerfEventCounter &operator=(const PerfEventCounter &&) = delete;
+
+  private:
+    int fd_ = -1;
+  };
 }
 
 /// Start latency measurement using rdtsc(). Creates a variable called TAG in the local scope.
 #define START_MEASURE(TAG) const auto TAG = Common::rdtsc()
 
 /// End latency measurement using rdtsc(). Expects a variable called TAG to already exist in the local scope.
+/// Skipped entirely when LOGGER is disabled, so that formatting the timestamp is not paid for either.
 #define END_MEASURE(TAG, LOGGER)                                                              \
       do {                                                                                    \
-        const auto end = Common::rdtsc();                                                     \
-        LOGGER.log("% RDTSC "#TAG" %\n", Common::getCurrentTimeStr(&time_str_), (end - TAG)); \
+        if (LOGGER.enabled()) {                                                               \
+          const auto end = Common::rdtsc();                                                   \
+          LOGGER.log("% RDTSC "#TAG" %\n", Common::getCurrentTimeStr(&time_str_), (end - TAG)); \
+        }                                                                                     \
       } while(false)
 
 /// Log a current timestamp at the time this macro is invoked.
 #define TTT_MEASURE(TAG, LOGGER)                                                              \
       do {                                                                                    \
-        const auto TAG = Common::getCurrentNanos();                                           \
-        LOGGER.log("% TTT "#TAG" %\n", Common::getCurrentTimeStr(&time_str_), TAG);           \
+        if (LOGGER.enabled()) {                                                               \
+          const auto TAG = Common::getCurrentNanos();                                         \
+          LOGGER.log("% TTT "#TAG" %\n", Common::getCurrentTimeStr(&time_str_), TAG);         \
+        }                                                                                     \
       } while(false)
@@ -29,6 +29,9 @@ namespace Common {
     bool is_listening_ = false;
     bool needs_so_timestamp_ =  false;
 
+    /// Let several listening sockets bind the same port, the kernel spreads incoming connections across them.
+    bool reuse_port_ = false;
+
     auto toString() const {
       std::stringstream ss;
       ss << "SocketCfg[ip:" << ip_
@@ -37,6 +40,7 @@ namespace Common {
       << " is_udp:" << is_udp_
       << " is_listening:" << is_listening_
       << " needs_SO_timestamp:" << needs_so_timestamp_
+      << " reuse_port:" << reuse_port_
       << "]";
 
       return ss.str();
@@ -125,6 +129,10 @@ namespace Common {
         ASSERT(setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one)) == 0, "setsockopt() SO_REUSEADDR failed. errno:" + std::string(strerror(errno)));
       }
 
+      if (socket_cfg.is_listening_ && socket_cfg.reuse_port_) {
+        ASSERT(setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char *>(&one), sizeof(one)) == 0, "setsockopt() SO_REUSEPORT failed. errno:" + std::string(strerror(errno)));
+      }
+
       if (socket_cfg.is_listening_) {
         // bind to the specified port number.
         const sockaddr_in addr{AF_INET, htons(socket_cfg.port_), {htonl(INADDR_ANY)}, {}};
@@ -8,11 +8,11 @@ namespace Common {
   }
 
   /// Start listening for connections on the provided interface and port.
-  auto TCPServer::listen(const std::string &iface, int port) -> void {
+  auto TCPServer::listen(const std::string &iface, int port, bool reuse_port) -> void {
     epoll_fd_ = epoll_create(1);
     ASSERT(epoll_fd_ >= 0, "epoll_create() failed error:" + std::string(std::strerror(errno)));
 
-    ASSERT(listener_socket_.connect("", iface, port, true) >= 0,
+    ASSERT(listener_socket_.connect("", iface, port, true, reuse_port) >= 0,
            "Listener socket failed to connect. iface:" + iface + " port:" + std::to_string(port) + " error:" +
            std::string(std::strerror(errno)));
 
@@ -8,8 +8,8 @@ namespace Common {
         : listener_socket_(logger), logger_(logger) {
     }
 
-    /// Start listening for connections on the provided interface and port.
-    auto listen(const std::string &iface, int port) -> void;
+    /// Start listening for connections on the provided interface and port, reuse_port lets several TCPServer instances listen on the same port.
+    auto listen(const std::string &iface, int port, bool reuse_port = false) -> void;
 
     /// Check for new connections or dead connections and update containers that track the sockets.
     auto poll() noexcept -> void;
@@ -2,9 +2,9 @@
 
 namespace Common {
   /// Create TCPSocket with provided attributes to either listen-on / connect-to.
-  auto TCPSocket::connect(const std::string &ip, const std::string &iface, int port, bool is_listening) -> int {
+  auto TCPSocket::connect(const std::string &ip, const std::string &iface, int port, bool is_listening, bool reuse_port) -> int {
     // Note that needs_so_timestamp=true for FIFOSequencer.
-    const SocketCfg socket_cfg{ip, iface, port, false, is_listening, true};
+    const SocketCfg socket_cfg{ip, iface, port, false, is_listening, true, reuse_port};
     socket_fd_ = createSocket(logger_, socket_cfg);
 
     socket_attrib_.sin_addr.s_addr = INADDR_ANY;
@@ -22,14 +22,19 @@ namespace Common {
     iovec iov{inbound_data_.data() + next_rcv_valid_index_, TCPBufferSize - next_rcv_valid_index_};
     msghdr msg{&socket_attrib_, sizeof(socket_attrib_), &iov, 1, ctrl, sizeof(ctrl), 0};
 
-    // Non-blocking call to read available data.
-    const auto read_size = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
+    // Non-blocking call to read available data. With the receive buffer full, e.g. while the reader holds data back, it stays in the kernel,
+    // a zero length read would be taken for the peer closing the connection.
+    const auto n_read = (LIKELY(next_rcv_valid_index_ < TCPBufferSize) ? recvmsg(socket_fd_, &msg, MSG_DONTWAIT) : -1);
+    const auto read_errno = (LIKELY(next_rcv_valid_index_ < TCPBufferSize) ? errno : EAGAIN);
+    const auto read_size = (UNLIKELY(fault_injector_ != nullptr) ? applyFaults(n_read) : n_read);
+
     if (read_size > 0) {
       next_rcv_valid_index_ += read_size;
 
       Nanos kernel_time = 0;
       timeval time_kernel;
-      if (cmsg->cmsg_level == SOL_SOCKET &&
+      if (n_read > 0 && // data released by the fault injector alone comes without a timestamp.
+          cmsg->cmsg_level == SOL_SOCKET &&
           cmsg->cmsg_type == SCM_TIMESTAMP &&
           cmsg->cmsg_len == CMSG_LEN(sizeof(time_kernel))) {
         memcpy(&time_kernel, CMSG_DATA(cmsg), sizeof(time_kernel));
@@ -41,21 +46,95 @@ namespace Common {
       logger_.log("%:% %() % read socket:% len:% utime:% ktime:% diff:%\n", __FILE__, __LINE__, __FUNCTION__,
                   Common::getCurrentTimeStr(&time_str_), socket_fd_, next_rcv_valid_index_, user_time, kernel_time, (user_time - kernel_time));
       recv_callback_(this, kernel_time);
+    } else if (n_read == 0 || (n_read < 0 && read_errno != EAGAIN && read_errno != EWOULDBLOCK)) { // orderly shutdown by the peer or a connection error.
+      if (!disconnected_)
+        logger_.log("%:% %() % disconnected socket:% errno:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
+                    (n_read ? std::string(strerror(read_errno)) : "EOF"));
+      disconnected_ = true;
     }
 
     if (next_send_valid_index_ > 0) {
-      // Non-blocking call to send data.
+      // Non-blocking call to send data, whatever the kernel does not take, e.g. with its send buffer full, is sent on the next call.
       const auto n = ::send(socket_fd_, outbound_data_.data(), next_send_valid_index_, MSG_DONTWAIT | MSG_NOSIGNAL);
-      logger_.log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_, n);
+      logger_.log("%:% %() % send socket:% len:% sent:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
+                  next_send_valid_index_, n);
+      if (n > 0) {
+        memmove(outbound_data_.data(), outbound_data_.data() + n, next_send_valid_index_ - n);
+        next_send_valid_index_ -= n;
+      }
     }
-    next_send_valid_index_ = 0;
 
     return (read_size > 0);
   }
 
-  /// Write outgoing data to the send buffers.
+  /// Write outgoing data to the send buffers, the data sendAndRecv() could not send yet stays in front of it.
+  /// If the peer stopped reading and they are full the data is dropped and the connection is marked disconnected_.
   auto TCPSocket::send(const void *data, size_t len) noexcept -> void {
+    if (UNLIKELY(len > TCPBufferSize - next_send_valid_index_)) { // the peer stopped reading, the stream cannot carry on without this data.
+      if (!disconnected_)
+        logger_.log("%:% %() % send buffer full socket:% len:% pending:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    socket_fd_, len, next_send_valid_index_);
+      disconnected_ = true;
+      return;
+    }
+
     memcpy(outbound_data_.data() + next_send_valid_index_, data, len);
     next_send_valid_index_ += len;
   }
+
+  /// Close the connection and drop any buffered data, connect() can be called again afterwards.
+  auto TCPSocket::disconnect() noexcept -> void {
+    if (socket_fd_ >= 0)
+      close(socket_fd_);
+    socket_fd_ = -1;
+    next_send_valid_index_ = next_rcv_valid_index_ = 0;
+    disconnected_ = false;
+    if (fault_injector_)
+      fault_injector_->clear();
+  }
+
+  /// Inject the faults drawn from cfg into the data read from now on, across reconnects, stream picks this socket's sequence of faults.
+  auto TCPSocket::injectFaults(const FaultCfg &cfg, uint64_t stream) -> void {
+    fault_injector_ = std::make_unique<FaultInjector>(cfg, stream);
+  }
+
+  /// Apply the next fault to the read_size bytes just read to the end of inbound_data_ and append the data held back which is due after it.
+  /// Returns the number of bytes left there for recv_callback_.
+  auto TCPSocket::applyFaults(ssize_t read_size) noexcept -> ssize_t {
+    const auto data = inbound_data_.data() + next_rcv_valid_index_;
+    const auto now = getCurrentNanos();
+    auto len = static_cast<size_t>(std::max<ssize_t>(read_size, 0));
+    if (len && !fault_injector_->empty()) { // a byte stream stays in order, so it queues up behind the data held back.
+      fault_injector_->hold(data, len, fault_injector_->lastDue(), false);
+      len = 0;
+    } else if (len) {
+      switch (fault_injector_->next()) {
+        case Fault::DROP: // the connection breaks, losing what was read.
+          logger_.log("%:% %() % injected disconnect socket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_);
+          disconnected_ = true;
+          len = 0;
+          break;
+        case Fault::DELAY:
+          fault_injector_->hold(data, len, now + fault_injector_->cfg().delay_time_, false);
+          len = 0;
+          break;
+        case Fault::DUPLICATE:
+        case Fault::REORDER:
+        case Fault::NONE:
+          break;
+      }
+    }
+
+    if (!disconnected_) {
+      fault_injector_->release(now, false, [&](const char *held, size_t held_len) {
+        if (next_rcv_valid_index_ + len + held_len > TCPBufferSize)
+          return false;
+        memcpy(data + len, held, held_len);
+        len += held_len;
+        return true;
+      });
+    }
+
+    return static_cast<ssize_t>(len);
+  }
 }
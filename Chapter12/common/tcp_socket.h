@@ -1,30 +1,58 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
 #include "socket_utils.h"
+#include "fault_injector.h"
 #include "logging.h"
 
 namespace Common {
   /// Size of our send and receive buffers in bytes.
   constexpr size_t TCPBufferSize = 64 * 1024 * 1024;
 
+  /// Fixed size send or receive buffer which leaves its memory uninitialized, so that it is not zero-filled and only the pages a connection
+  /// actually uses become resident. Otherwise every connection commits 2 * TCPBufferSize bytes.
+  class TCPBuffer final {
+  public:
+    explicit TCPBuffer(size_t size)
+        : data_(std::make_unique_for_overwrite<char[]>(size)) {
+    }
+
+    auto data() noexcept {
+      return data_.get();
+    }
+
+    auto data() const noexcept -> const char * {
+      return data_.get();
+    }
+
+  private:
+    std::unique_ptr<char[]> data_;
+  };
+
   struct TCPSocket {
     explicit TCPSocket(Logger &logger)
-        : logger_(logger) {
-      outbound_data_.resize(TCPBufferSize);
-      inbound_data_.resize(TCPBufferSize);
+        : outbound_data_(TCPBufferSize), inbound_data_(TCPBufferSize), logger_(logger) {
     }
 
     /// Create TCPSocket with provided attributes to either listen-on / connect-to.
-    auto connect(const std::string &ip, const std::string &iface, int port, bool is_listening) -> int;
+    /// reuse_port lets several listening sockets share the port.
+    auto connect(const std::string &ip, const std::string &iface, int port, bool is_listening, bool reuse_port = false) -> int;
 
     /// Called to publish outgoing data from the buffers as well as check for and callback if data is available in the read buffers.
     auto sendAndRecv() noexcept -> bool;
 
-    /// Write outgoing data to the send buffers.
+    /// Write outgoing data to the send buffers, the data sendAndRecv() could not send yet stays in front of it.
+    /// If the peer stopped reading and they are full the data is dropped and the connection is marked disconnected_.
     auto send(const void *data, size_t len) noexcept -> void;
 
+    /// Close the connection and drop any buffered data, connect() can be called again afterwards.
+    auto disconnect() noexcept -> void;
+
+    /// Inject the faults drawn from cfg into the data read from now on, across reconnects, stream picks this socket's sequence of faults.
+    auto injectFaults(const FaultCfg &cfg, uint64_t stream) -> void;
+
     /// Deleted default, copy & move constructors and assignment-operators.
     TCPSocket() = delete;
 
@@ -40,18 +68,29 @@ namespace Common {
     int socket_fd_ = -1;
 
     /// Send and receive buffers and trackers for read/write indices.
-    std::vector<char> outbound_data_;
+    TCPBuffer outbound_data_;
     size_t next_send_valid_index_ = 0;
-    std::vector<char> inbound_data_;
+    TCPBuffer inbound_data_;
     size_t next_rcv_valid_index_ = 0;
 
+    /// Set once sendAndRecv() finds that the peer closed the connection or that it failed, or send() ran out of buffer, cleared by disconnect().
+    bool disconnected_ = false;
+
     /// Socket attributes.
     struct sockaddr_in socket_attrib_{};
 
     /// Function wrapper to callback when there is data to be processed.
     std::function<void(TCPSocket *s, Nanos rx_time)> recv_callback_ = nullptr;
 
+    /// Faults injected into the data read, nullptr unless injectFaults() was called.
+    std::unique_ptr<FaultInjector> fault_injector_;
+
     std::string time_str_;
     Logger &logger_;
+
+  private:
+    /// Apply the next fault to the read_size bytes just read to the end of inbound_data_ and append the data held back which is due after it.
+    /// Returns the number of bytes left there for recv_callback_.
+    auto applyFaults(ssize_t read_size) noexcept -> ssize_t;
   };
 }
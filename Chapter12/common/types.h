@@ -25,6 +25,61 @@ namespace Common {
   /// Maximum price level depth in the order books.
   constexpr size_t ME_MAX_PRICE_LEVELS = 256;
 
+  /// Capacities used to size the order books, memory pools, hash maps and lock free queues at runtime.
+  /// Defaults to the ME_MAX_* constants above, which remain the upper bound for the small per-ticker arrays in the trading components.
+  struct EngineLimits {
+    size_t max_tickers_ = ME_MAX_TICKERS;
+    size_t max_num_clients_ = ME_MAX_NUM_CLIENTS;
+
+    /// Bounds the order ids per client and also the number of live orders across all order books, which share their memory pools.
+    size_t max_order_ids_ = ME_MAX_ORDER_IDS;
+
+    size_t max_price_levels_ = ME_MAX_PRICE_LEVELS;
+    size_t max_client_updates_ = ME_MAX_CLIENT_UPDATES;
+    size_t max_market_updates_ = ME_MAX_MARKET_UPDATES;
+
+    /// Price levels are indexed by masking the price, so the number of price levels has to be a power of 2.
+    constexpr auto isValid() const noexcept {
+      return (max_tickers_ && max_num_clients_ && max_order_ids_ && max_client_updates_ && max_market_updates_ &&
+              max_price_levels_ && !(max_price_levels_ & (max_price_levels_ - 1)));
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "EngineLimits{"
+         << "tickers:" << max_tickers_ << " "
+         << "clients:" << max_num_clients_ << " "
+         << "order-ids:" << max_order_ids_ << " "
+         << "price-levels:" << max_price_levels_ << " "
+         << "client-updates:" << max_client_updates_ << " "
+         << "market-updates:" << max_market_updates_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Policy for deployments which want the capacities baked in as compile time constants, checked at compile time.
+  /// Components are sized from limits(), e.g. MatchingEngine(..., FixedEngineLimits<1, 16, 64 * 1024, 256, 64 * 1024, 64 * 1024>::limits()).
+  template<size_t MaxTickers, size_t MaxNumClients, size_t MaxOrderIds, size_t MaxPriceLevels, size_t MaxClientUpdates, size_t MaxMarketUpdates>
+  struct FixedEngineLimits {
+    static constexpr size_t max_tickers_ = MaxTickers;
+    static constexpr size_t max_num_clients_ = MaxNumClients;
+    static constexpr size_t max_order_ids_ = MaxOrderIds;
+    static constexpr size_t max_price_levels_ = MaxPriceLevels;
+    static constexpr size_t max_client_updates_ = MaxClientUpdates;
+    static constexpr size_t max_market_updates_ = MaxMarketUpdates;
+
+    static constexpr auto limits() noexcept {
+      return EngineLimits{MaxTickers, MaxNumClients, MaxOrderIds, MaxPriceLevels, MaxClientUpdates, MaxMarketUpdates};
+    }
+
+    static_assert(limits().isValid(), "Invalid engine limits, every capacity has to be non-zero and price levels a power of 2.");
+  };
+
+  /// The compile time equivalent of the default EngineLimits.
+  typedef FixedEngineLimits<ME_MAX_TICKERS, ME_MAX_NUM_CLIENTS, ME_MAX_ORDER_IDS, ME_MAX_PRICE_LEVELS, ME_MAX_CLIENT_UPDATES, ME_MAX_MARKET_UPDATES> DefaultEngineLimits;
+
   typedef uint64_t OrderId;
   constexpr auto OrderId_INVALID = std::numeric_limits<OrderId>::max();
 
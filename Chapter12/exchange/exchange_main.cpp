@@ -3,12 +3,16 @@
 #include "matcher/matching_engine.h"
 #include "market_data/market_data_publisher.h"
 #include "order_server/order_server.h"
+#include "journal/journal.h"
+#include "journal/checkpoint_writer.h"
 
 /// Main components, made global to be accessible from the signal handler.
 Common::Logger *logger = nullptr;
 Exchange::MatchingEngine *matching_engine = nullptr;
 Exchange::MarketDataPublisher *market_data_publisher = nullptr;
 Exchange::OrderServer *order_server = nullptr;
+Exchange::Journal *journal = nullptr;
+Exchange::CheckpointWriter *checkpoint_writer = nullptr;
 
 /// Shut down gracefully on external signals to this server.
 void signal_handler(int) {
@@ -23,6 +27,10 @@ void signal_handler(int) {
   market_data_publisher = nullptr;
   delete order_server;
   order_server = nullptr;
+  delete journal;
+  journal = nullptr;
+  delete checkpoint_writer;
+  checkpoint_writer = nullptr;
 
   std::this_thread::sleep_for(10s);
 
@@ -36,30 +44,78 @@ int main(int, char **) {
 
   const int sleep_time = 100 * 1000;
 
+  // Capacities of the lock free queues, order books, memory pools and per client state.
+  const Common::EngineLimits limits;
+
+  // Per client message rate limit enforced by the order server.
+  const Exchange::ThrottleLimits throttle_limits;
+
   // The lock free queues to facilitate communication between order server <-> matching engine and matching engine -> market data publisher.
-  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
-  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
-  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  Exchange::ClientRequestLFQueue client_requests(limits.max_client_updates_);
+  Exchange::ClientResponseLFQueue client_responses(limits.max_client_updates_);
+  Exchange::MEMarketUpdateLFQueue market_updates(limits.max_market_updates_);
+
+  // Sequenced client requests are also broadcast from the order server to the journal writer.
+  Exchange::JournalRecordLFQueue journal_records(Exchange::ME_MAX_JOURNAL_RECORDS);
 
   std::string time_str;
 
-  logger->log("%:% %() % Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates);
-  matching_engine->start();
+  const Exchange::JournalCfg journal_cfg;
+  const Exchange::CheckpointCfg checkpoint_cfg;
+
+  logger->log("%:% %() % Starting Checkpoint Writer %...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), checkpoint_cfg.toString());
+  checkpoint_writer = new Exchange::CheckpointWriter(checkpoint_cfg);
+  checkpoint_writer->start();
+
+  // Every fill of an aggressive order is reported to its client session unless the session is configured for consolidated fill reports in client_reporting_.
+  const Exchange::FillReportCfg fill_report_cfg;
+
+  logger->log("%:% %() % Creating Matching Engine %...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), fill_report_cfg.toString());
+  matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, "exchange_matching_engine.log", checkpoint_writer, limits,
+                                                 fill_report_cfg);
 
   const std::string mkt_pub_iface = "lo";
-  const std::string snap_pub_ip = "233.252.14.1", inc_pub_ip = "233.252.14.3";
-  const int snap_pub_port = 20000, inc_pub_port = 20001;
+  const std::string snap_pub_ip = "233.252.14.1", price_level_pub_ip = "233.252.14.7";
+  const int snap_pub_port = 20000, gap_fill_port = 20002, price_level_pub_port = 20006;
 
-  logger->log("%:% %() % Starting Market Data Publisher...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  market_data_publisher = new Exchange::MarketDataPublisher(&market_updates, mkt_pub_iface, snap_pub_ip, snap_pub_port, inc_pub_ip, inc_pub_port);
+  // Tickers are sharded across the incremental channels, each published on an A and a B feed in the compact encoding.
+  const std::vector<Exchange::IncrementalChannelCfg> inc_pub_channels = {{"233.252.14.3", 20001, "233.252.14.4", 20003, true},
+                                                                         {"233.252.14.5", 20004, "233.252.14.6", 20005, true}};
+
+  // Snapshot interval per ticker and the rate snapshot messages are paced at on the snapshot stream.
+  const Exchange::SnapshotCfg snapshot_cfg;
+
+  // Updates to the same order within a batch, e.g. the MODIFYs of a resting order filled by several aggressive orders in a row, are coalesced.
+  Exchange::CoalesceCfg coalesce_cfg;
+  coalesce_cfg.enabled_ = true;
+
+  logger->log("%:% %() % Starting Market Data Publisher % %...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), snapshot_cfg.toString(),
+              coalesce_cfg.toString());
+  market_data_publisher = new Exchange::MarketDataPublisher(&market_updates, mkt_pub_iface, snap_pub_ip, snap_pub_port, inc_pub_channels, gap_fill_port,
+                                                            price_level_pub_ip, price_level_pub_port, limits, snapshot_cfg, coalesce_cfg);
   market_data_publisher->start();
 
+  // The market data publisher has to be running already, it consumes the market updates for the orders restored during recovery.
+  const auto recovery_start = Common::getCurrentNanos();
+  logger->log("%:% %() % Recovering Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+  matching_engine->recover(checkpoint_cfg, journal_cfg);
+  logger->log("%:% %() % Recovered Matching Engine up to seq:% in % ns. Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__,
+              Common::getCurrentTimeStr(&time_str), matching_engine->lastSeqNum(), Common::getCurrentNanos() - recovery_start);
+  matching_engine->start();
+
+  logger->log("%:% %() % Starting Journal %...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), journal_cfg.toString());
+  journal = new Exchange::Journal(&journal_records, journal_cfg);
+  journal->start();
+
   const std::string order_gw_iface = "lo";
   const int order_gw_port = 12345;
 
-  logger->log("%:% %() % Starting Order Server...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  order_server = new Exchange::OrderServer(&client_requests, &client_responses, order_gw_iface, order_gw_port);
+  // Client sessions are spread across this many order server I/O threads, more than one adds a sequencer stage thread between them and the matching engine.
+  const size_t order_server_io_threads = 1;
+
+  logger->log("%:% %() % Starting Order Server %...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), throttle_limits.toString());
+  order_server = new Exchange::OrderServer(&client_requests, &client_responses, order_gw_iface, order_gw_port, &journal_records,
+                                           matching_engine->lastSeqNum() + 1, limits, throttle_limits, order_server_io_threads);
   order_server->start();
 
   while (true) {
@@ -0,0 +1,88 @@
+#include "checkpoint.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+
+#include "common/checksum.h"
+
+namespace Exchange {
+  /// Write the checkpoint to a temporary file, sync it and atomically rename it over file_name.
+  auto writeCheckpointFile(const std::string &file_name, const Checkpoint &checkpoint) -> void {
+    const auto tmp_file_name = file_name + ".tmp";
+    const auto fd = open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT(fd >= 0, "Unable to create checkpoint file:" + tmp_file_name + " error:" + std::string(std::strerror(errno)));
+
+    auto checksum = FNV1A_OFFSET_BASIS;
+    auto write_all = [&](const void *data, size_t len) {
+      checksum = fnv1a(data, len, checksum);
+      for (auto ptr = static_cast<const char *>(data); len;) {
+        const auto n = write(fd, ptr, len);
+        ASSERT(n > 0, "Unable to write checkpoint file:" + tmp_file_name + " error:" + std::string(std::strerror(errno)));
+        ptr += n;
+        len -= n;
+      }
+    };
+
+    const CheckpointFileHeader header{CHECKPOINT_MAGIC, CHECKPOINT_VERSION, static_cast<uint32_t>(checkpoint.books_.size()), checkpoint.last_seq_num_};
+    write_all(&header, sizeof(header));
+
+    size_t offset = 0;
+    for (const auto &book: checkpoint.books_) {
+      write_all(&book, sizeof(book));
+      write_all(checkpoint.orders_.data() + offset, book.num_orders_ * sizeof(CheckpointOrder));
+      offset += book.num_orders_;
+    }
+
+    const auto file_checksum = checksum;
+    write_all(&file_checksum, sizeof(file_checksum));
+
+    ASSERT(fsync(fd) == 0, "Unable to sync checkpoint file:" + tmp_file_name + " error:" + std::string(std::strerror(errno)));
+    close(fd);
+
+    ASSERT(rename(tmp_file_name.c_str(), file_name.c_str()) == 0,
+           "Unable to rename checkpoint file:" + tmp_file_name + " error:" + std::string(std::strerror(errno)));
+  }
+
+  /// Load the checkpoint from file_name, returns false if there is no such file.
+  auto loadCheckpointFile(const std::string &file_name, Checkpoint *checkpoint) -> bool {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+      return false;
+
+    std::vector<char> data(file.tellg());
+    file.seekg(0);
+    ASSERT(file.read(data.data(), data.size()).good(), "Unable to read checkpoint file:" + file_name);
+    ASSERT(data.size() >= sizeof(CheckpointFileHeader) + sizeof(uint64_t), "Checkpoint file:" + file_name + " is truncated.");
+
+    uint64_t file_checksum = 0;
+    const auto body_size = data.size() - sizeof(file_checksum);
+    memcpy(&file_checksum, data.data() + body_size, sizeof(file_checksum));
+    ASSERT(file_checksum == fnv1a(data.data(), body_size), "Checkpoint file:" + file_name + " failed checksum validation.");
+
+    CheckpointFileHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    ASSERT(header.magic_ == CHECKPOINT_MAGIC && header.version_ == CHECKPOINT_VERSION,
+           "Unsupported checkpoint file:" + file_name + " version:" + std::to_string(header.version_) +
+           " books:" + std::to_string(header.num_books_));
+
+    checkpoint->clear();
+    checkpoint->last_seq_num_ = header.last_seq_num_;
+    checkpoint->books_.resize(header.num_books_);
+
+    size_t offset = sizeof(header);
+    for (auto &book: checkpoint->books_) {
+      ASSERT(offset + sizeof(book) <= body_size, "Checkpoint file:" + file_name + " is truncated.");
+      memcpy(&book, data.data() + offset, sizeof(book));
+      offset += sizeof(book);
+
+      const auto orders_size = book.num_orders_ * sizeof(CheckpointOrder);
+      ASSERT(offset + orders_size <= body_size, "Checkpoint file:" + file_name + " is truncated.");
+      const auto orders = reinterpret_cast<const CheckpointOrder *>(data.data() + offset);
+      checkpoint->orders_.insert(checkpoint->orders_.end(), orders, orders + book.num_orders_);
+      offset += orders_size;
+    }
+
+    return true;
+  }
+}
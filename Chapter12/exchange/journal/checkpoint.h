@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <sstream>
+
+#include "common/types.h"
+#include "common/time_utils.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Identifies a checkpoint file and the layout of the records in it.
+  constexpr uint64_t CHECKPOINT_MAGIC = 0x54504b434b4f4f42; // "BOOKCKPT"
+  constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+  /// These structures are written to disk as is, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  /// Written once at the start of every checkpoint file.
+  /// It is followed by num_books_ CheckpointBookHeader records, each followed by its num_orders_ CheckpointOrder records,
+  /// and finally by a 64-bit FNV-1a checksum over everything preceding it.
+  struct CheckpointFileHeader {
+    uint64_t magic_ = CHECKPOINT_MAGIC;
+    uint32_t version_ = CHECKPOINT_VERSION;
+    uint32_t num_books_ = 0;
+
+    /// Sequence number of the last client request reflected in this checkpoint.
+    size_t last_seq_num_ = 0;
+  };
+
+  /// State of a single MEOrderBook other than its live orders.
+  struct CheckpointBookHeader {
+    TickerId ticker_id_ = TickerId_INVALID;
+    OrderId next_market_order_id_ = 1;
+    size_t num_orders_ = 0;
+  };
+
+  /// A single live order, orders are stored bids first and then asks, price levels from most to least aggressive and FIFO within a price level.
+  struct CheckpointOrder {
+    ClientId client_id_ = ClientId_INVALID;
+    OrderId client_order_id_ = OrderId_INVALID;
+    OrderId market_order_id_ = OrderId_INVALID;
+    Side side_ = Side::INVALID;
+    Price price_ = Price_INVALID;
+    Qty qty_ = Qty_INVALID;
+    Priority priority_ = Priority_INVALID;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// In memory copy of the state of every order book, as taken by the matching engine and written out by the CheckpointWriter.
+  struct Checkpoint {
+    size_t last_seq_num_ = 0;
+
+    std::vector<CheckpointBookHeader> books_;
+
+    /// Live orders of all the books back to back, in the order of books_.
+    std::vector<CheckpointOrder> orders_;
+
+    /// Keeps the capacity of orders_ so that taking the next checkpoint does not allocate.
+    auto clear() noexcept {
+      last_seq_num_ = 0;
+      books_.clear();
+      orders_.clear();
+    }
+  };
+
+  /// Configuration for periodic checkpoints of the matching engine order books.
+  struct CheckpointCfg {
+    /// The latest checkpoint is kept at <dir_>/<file_name_>, replaced atomically every time a new one is written.
+    std::string dir_ = ".";
+    std::string file_name_ = "exchange_checkpoint.bin";
+
+    /// Take a checkpoint once interval_requests_ client requests have been processed since the last one,
+    /// or when the matching engine is idle and interval_ has elapsed since the last one with at least one request processed.
+    size_t interval_requests_ = 1000000;
+    Nanos interval_ = 60 * NANOS_TO_SECS;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "CheckpointCfg{"
+         << "dir:" << dir_ << " "
+         << "file:" << file_name_ << " "
+         << "interval-requests:" << interval_requests_ << " "
+         << "interval:" << interval_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Full path of the checkpoint file.
+  inline auto checkpointFileName(const CheckpointCfg &cfg) {
+    return cfg.dir_ + "/" + cfg.file_name_;
+  }
+
+  /// Write the checkpoint to a temporary file, sync it and atomically rename it over file_name.
+  auto writeCheckpointFile(const std::string &file_name, const Checkpoint &checkpoint) -> void;
+
+  /// Load the checkpoint from file_name, returns false if there is no such file.
+  /// A checkpoint file which exists but is corrupt is a fatal error, silently starting with empty books would be worse.
+  auto loadCheckpointFile(const std::string &file_name, Checkpoint *checkpoint) -> bool;
+}
@@ -0,0 +1,57 @@
+#include "checkpoint_writer.h"
+
+namespace Exchange {
+  CheckpointWriter::CheckpointWriter(const CheckpointCfg &cfg)
+      : cfg_(cfg), logger_("exchange_checkpoint_writer.log") {
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), cfg_.toString());
+  }
+
+  CheckpointWriter::~CheckpointWriter() {
+    stop();
+  }
+
+  /// Start and stop the checkpoint writer thread.
+  auto CheckpointWriter::start() -> void {
+    run_ = true;
+    checkpoint_thread_ = Common::createAndStartThread(-1, "Exchange/CheckpointWriter", [this]() { run(); });
+    ASSERT(checkpoint_thread_ != nullptr, "Failed to start CheckpointWriter thread.");
+  }
+
+  /// Stopping waits for a checkpoint which has already been published to be written out.
+  auto CheckpointWriter::stop() -> void {
+    run_ = false;
+
+    if (checkpoint_thread_) {
+      checkpoint_thread_->join();
+      delete checkpoint_thread_;
+      checkpoint_thread_ = nullptr;
+    }
+  }
+
+  /// Main loop for this thread - writes out the checkpoint every time one is published.
+  auto CheckpointWriter::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+
+    using namespace std::literals::chrono_literals;
+    while (run_) {
+      if (pending_)
+        write();
+      else
+        std::this_thread::sleep_for(1ms); // checkpoints are minutes apart, no need to spin on a core for them.
+    }
+
+    if (pending_)
+      write();
+  }
+
+  auto CheckpointWriter::write() noexcept -> void {
+    const auto start_time = getCurrentNanos();
+    writeCheckpointFile(checkpointFileName(cfg_), checkpoint_);
+
+    logger_.log("%:% %() % Wrote checkpoint seq:% orders:% to:% in % ns.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                checkpoint_.last_seq_num_, checkpoint_.orders_.size(), checkpointFileName(cfg_), getCurrentNanos() - start_time);
+
+    ++num_checkpoints_;
+    pending_ = false;
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/logging.h"
+
+#include "journal/checkpoint.h"
+
+namespace Exchange {
+  /// Writes checkpoints taken by the matching engine to disk on its own thread, so that the matching engine only pays for copying the order books.
+  /// Holds a single Checkpoint buffer, the matching engine skips taking a new checkpoint while the previous one is still being written.
+  class CheckpointWriter {
+  public:
+    explicit CheckpointWriter(const CheckpointCfg &cfg);
+
+    ~CheckpointWriter();
+
+    /// Start and stop the checkpoint writer thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main loop for this thread - writes out the checkpoint every time one is published.
+    auto run() noexcept -> void;
+
+    auto cfg() const noexcept -> const CheckpointCfg & {
+      return cfg_;
+    }
+
+    /// Returns the checkpoint buffer for the matching engine to fill in, or nullptr if the previous checkpoint has not been written out yet.
+    auto acquire() noexcept -> Checkpoint * {
+      return (pending_ ? nullptr : &checkpoint_);
+    }
+
+    /// Hand the checkpoint buffer filled in after acquire() over to the writer thread.
+    auto publish() noexcept {
+      pending_ = true;
+    }
+
+    /// Number of checkpoints written to disk so far.
+    auto numCheckpoints() const noexcept {
+      return num_checkpoints_.load();
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    CheckpointWriter() = delete;
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+
+    CheckpointWriter(const CheckpointWriter &&) = delete;
+
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    CheckpointWriter &operator=(const CheckpointWriter &&) = delete;
+
+  private:
+    const CheckpointCfg cfg_;
+
+    volatile bool run_ = false;
+    std::thread *checkpoint_thread_ = nullptr;
+
+    /// Set by the matching engine when checkpoint_ is ready to be written and cleared by the writer thread once it has been.
+    std::atomic<bool> pending_ = {false};
+    Checkpoint checkpoint_;
+
+    std::atomic<size_t> num_checkpoints_ = {0};
+
+    std::string time_str_;
+    Logger logger_;
+
+  private:
+    auto write() noexcept -> void;
+  };
+}
@@ -0,0 +1,154 @@
+#include "journal.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace Exchange {
+  Journal::Journal(JournalRecordLFQueue *journal_records, const JournalCfg &cfg)
+      : journal_records_(journal_records), cfg_(cfg), logger_("exchange_journal.log") {
+    ASSERT(cfg_.file_size_ >= sizeof(JournalFileHeader) + sizeof(JournalRecord),
+           "Journal file size too small to hold a single record. " + cfg_.toString());
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), cfg_.toString());
+  }
+
+  Journal::~Journal() {
+    stop();
+
+    journal_records_ = nullptr;
+  }
+
+  /// Start and stop the journal writer thread.
+  auto Journal::start() -> void {
+    openNextFile();
+
+    run_ = true;
+    journal_thread_ = Common::createAndStartThread(-1, "Exchange/Journal", [this]() { run(); });
+    ASSERT(journal_thread_ != nullptr, "Failed to start Journal thread.");
+  }
+
+  /// Stopping waits for the journal writer thread to append and sync whatever is still in the lock free queue.
+  auto Journal::stop() -> void {
+    run_ = false;
+
+    if (journal_thread_) {
+      journal_thread_->join();
+      delete journal_thread_;
+      journal_thread_ = nullptr;
+    }
+  }
+
+  /// Main loop for this thread - appends every record available in the lock free queue and syncs them to disk in batches.
+  auto Journal::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+
+    auto drain = [this]() {
+      for (auto record = journal_records_->getNextToRead(); journal_records_->size() && record; record = journal_records_->getNextToRead()) {
+        append(record);
+        journal_records_->updateReadIndex();
+      }
+    };
+
+    while (run_) {
+      drain();
+
+      if (pending_sync_records_ &&
+          (pending_sync_records_ >= cfg_.sync_batch_size_ || getCurrentNanos() - last_sync_time_ >= cfg_.sync_interval_)) {
+        sync();
+      }
+    }
+
+    // Records published before stop() was called still need to make it to disk.
+    drain();
+    closeFile();
+
+    logger_.log("%:% %() % Journaled % records with % syncs.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                num_records_, num_syncs_);
+  }
+
+  /// Create, preallocate and memory map the next journal file.
+  auto Journal::openNextFile() -> void {
+    // Never overwrite journal files left behind by a previous run.
+    while (access(journalFileName(cfg_, file_index_).c_str(), F_OK) == 0)
+      ++file_index_;
+
+    const auto file_name = journalFileName(cfg_, file_index_);
+    fd_ = open(file_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    ASSERT(fd_ >= 0, "Unable to create journal file:" + file_name + " error:" + std::string(std::strerror(errno)));
+
+    const auto rc = posix_fallocate(fd_, 0, cfg_.file_size_);
+    ASSERT(rc == 0, "Unable to preallocate journal file:" + file_name + " error:" + std::string(std::strerror(rc)));
+
+    // MAP_POPULATE pre-faults the whole mapping so that appends do not take page faults.
+    data_ = static_cast<char *>(mmap(nullptr, cfg_.file_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0));
+    ASSERT(data_ != MAP_FAILED, "Unable to mmap journal file:" + file_name + " error:" + std::string(std::strerror(errno)));
+
+    const JournalFileHeader header{JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(JournalRecord)};
+    memcpy(data_, &header, sizeof(header));
+    write_offset_ = sizeof(header);
+    synced_offset_ = 0;
+    pending_sync_records_ = 0;
+
+    logger_.log("%:% %() % Opened journal file:% size:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                file_name, cfg_.file_size_);
+  }
+
+  /// Sync and unmap the current journal file.
+  auto Journal::closeFile() -> void {
+    if (!data_)
+      return;
+
+    if (pending_sync_records_)
+      sync();
+
+    munmap(data_, cfg_.file_size_);
+    data_ = nullptr;
+    close(fd_);
+    fd_ = -1;
+
+    logger_.log("%:% %() % Closed journal file:% used:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                journalFileName(cfg_, file_index_), write_offset_);
+  }
+
+  /// Copy a record into the mapping, rolling over to a new file if it does not fit in the current one.
+  auto Journal::append(const JournalRecord *record) noexcept -> void {
+    if (UNLIKELY(write_offset_ + sizeof(JournalRecord) > cfg_.file_size_)) {
+      closeFile();
+      openNextFile();
+    }
+
+    auto journal_record = reinterpret_cast<JournalRecord *>(data_ + write_offset_);
+    memcpy(journal_record, record, sizeof(JournalRecord));
+    journal_record->checksum_ = journal_record->computeChecksum();
+
+    write_offset_ += sizeof(JournalRecord);
+    ++pending_sync_records_;
+    ++num_records_;
+  }
+
+  /// Force written records to stable storage as per the configured JournalSyncMode.
+  auto Journal::sync() noexcept -> void {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    switch (cfg_.sync_mode_) {
+      case JournalSyncMode::NONE:
+        break;
+      case JournalSyncMode::MSYNC_ASYNC:
+      case JournalSyncMode::MSYNC_SYNC: {
+        // msync() needs a page aligned address, so start from the page containing the first unsynced byte.
+        const auto start = synced_offset_ & ~(page_size - 1);
+        msync(data_ + start, write_offset_ - start, (cfg_.sync_mode_ == JournalSyncMode::MSYNC_SYNC ? MS_SYNC : MS_ASYNC));
+      }
+        break;
+      case JournalSyncMode::FDATASYNC: {
+        fdatasync(fd_);
+      }
+        break;
+    }
+
+    synced_offset_ = write_offset_;
+    pending_sync_records_ = 0;
+    last_sync_time_ = getCurrentNanos();
+    ++num_syncs_;
+  }
+}
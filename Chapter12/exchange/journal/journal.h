@@ -0,0 +1,85 @@
+#pragma once
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/logging.h"
+
+#include "journal/journal_record.h"
+
+namespace Exchange {
+  /// Consumes sequenced client requests published by the FIFOSequencer and appends them to memory-mapped, preallocated journal files.
+  /// Runs on its own thread so that the order server and the matching engine never wait on disk I/O.
+  class Journal {
+  public:
+    Journal(JournalRecordLFQueue *journal_records, const JournalCfg &cfg);
+
+    ~Journal();
+
+    /// Start and stop the journal writer thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main loop for this thread - appends every record available in the lock free queue and syncs them to disk in batches.
+    auto run() noexcept -> void;
+
+    /// Number of records appended to the journal and number of sync calls made so far.
+    auto numRecords() const noexcept {
+      return num_records_;
+    }
+
+    auto numSyncs() const noexcept {
+      return num_syncs_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    Journal() = delete;
+
+    Journal(const Journal &) = delete;
+
+    Journal(const Journal &&) = delete;
+
+    Journal &operator=(const Journal &) = delete;
+
+    Journal &operator=(const Journal &&) = delete;
+
+  private:
+    /// Lock free queue of sequenced client requests written to by the FIFOSequencer.
+    JournalRecordLFQueue *journal_records_ = nullptr;
+
+    const JournalCfg cfg_;
+
+    volatile bool run_ = false;
+    std::thread *journal_thread_ = nullptr;
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Currently open journal file, its memory mapping and the offset at which the next record will be written.
+    size_t file_index_ = 0;
+    int fd_ = -1;
+    char *data_ = nullptr;
+    size_t write_offset_ = 0;
+
+    /// Range of the mapping written to since the last sync and bookkeeping for when the next sync is due.
+    size_t synced_offset_ = 0;
+    size_t pending_sync_records_ = 0;
+    Nanos last_sync_time_ = 0;
+
+    size_t num_records_ = 0;
+    size_t num_syncs_ = 0;
+
+  private:
+    /// Create, preallocate and memory map the next journal file.
+    auto openNextFile() -> void;
+
+    /// Sync and unmap the current journal file.
+    auto closeFile() -> void;
+
+    /// Copy a record into the mapping, rolling over to a new file if it does not fit in the current one.
+    auto append(const JournalRecord *record) noexcept -> void;
+
+    /// Force written records to stable storage as per the configured JournalSyncMode.
+    auto sync() noexcept -> void;
+  };
+}
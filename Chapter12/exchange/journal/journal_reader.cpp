@@ -0,0 +1,57 @@
+#include "journal_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Exchange {
+  JournalReader::JournalReader(const std::string &file_name)
+      : file_name_(file_name) {
+    fd_ = open(file_name_.c_str(), O_RDONLY);
+    ASSERT(fd_ >= 0, "Unable to open journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+
+    struct stat st;
+    ASSERT(fstat(fd_, &st) == 0, "Unable to stat journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+    file_size_ = st.st_size;
+    if (!file_size_)
+      return;
+
+    data_ = static_cast<char *>(mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd_, 0));
+    ASSERT(data_ != MAP_FAILED, "Unable to mmap journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+    madvise(data_, file_size_, MADV_SEQUENTIAL);
+
+    const auto header = reinterpret_cast<const JournalFileHeader *>(data_);
+    is_journal_ = (file_size_ >= sizeof(JournalFileHeader) && header->magic_ == JOURNAL_MAGIC);
+
+    if (is_journal_) {
+      ASSERT(header->version_ == JOURNAL_VERSION && header->record_size_ == sizeof(JournalRecord),
+             "Unsupported journal file:" + file_name_ + " version:" + std::to_string(header->version_) +
+             " record-size:" + std::to_string(header->record_size_));
+
+      records_ = reinterpret_cast<const JournalRecord *>(data_ + sizeof(JournalFileHeader));
+      const auto max_records = (file_size_ - sizeof(JournalFileHeader)) / sizeof(JournalRecord);
+      // Journal files are preallocated, so the first record which fails validation marks the end of the written data.
+      while (num_requests_ < max_records && records_[num_requests_].isValid())
+        ++num_requests_;
+    } else {
+      ASSERT(file_size_ % sizeof(MEClientRequest) == 0,
+             "Raw client request file:" + file_name_ + " size:" + std::to_string(file_size_) +
+             " is not a multiple of " + std::to_string(sizeof(MEClientRequest)));
+      requests_ = reinterpret_cast<const MEClientRequest *>(data_);
+      num_requests_ = file_size_ / sizeof(MEClientRequest);
+    }
+  }
+
+  JournalReader::~JournalReader() {
+    if (data_)
+      munmap(data_, file_size_);
+    data_ = nullptr;
+    records_ = nullptr;
+    requests_ = nullptr;
+
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = -1;
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "common/macros.h"
+
+#include "journal/journal_record.h"
+
+namespace Exchange {
+  /// Read-only, memory-mapped view over either a journal file written by the Journal or a raw recorded file of back to back MEClientRequest structures.
+  class JournalReader {
+  public:
+    explicit JournalReader(const std::string &file_name);
+
+    ~JournalReader();
+
+    /// True if the file has a journal header, false if it was treated as a raw MEClientRequest file.
+    auto isJournal() const noexcept {
+      return is_journal_;
+    }
+
+    /// Number of client requests available, for journal files this stops at the first unwritten or corrupt record.
+    auto numRequests() const noexcept {
+      return num_requests_;
+    }
+
+    auto request(size_t index) const noexcept -> const MEClientRequest * {
+      return (is_journal_ ? &records_[index].me_client_request_ : &requests_[index]);
+    }
+
+    /// Sequence number assigned by the FIFOSequencer, raw files are implicitly sequenced from 1.
+    auto seqNum(size_t index) const noexcept -> size_t {
+      return (is_journal_ ? records_[index].seq_num_ : index + 1);
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalReader() = delete;
+
+    JournalReader(const JournalReader &) = delete;
+
+    JournalReader(const JournalReader &&) = delete;
+
+    JournalReader &operator=(const JournalReader &) = delete;
+
+    JournalReader &operator=(const JournalReader &&) = delete;
+
+  private:
+    const std::string file_name_;
+
+    int fd_ = -1;
+    char *data_ = nullptr;
+    size_t file_size_ = 0;
+
+    bool is_journal_ = false;
+    const JournalRecord *records_ = nullptr;
+    const MEClientRequest *requests_ = nullptr;
+    size_t num_requests_ = 0;
+  };
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <sstream>
+#include <iomanip>
+
+#include "common/types.h"
+#include "common/lf_queue.h"
+#include "common/time_utils.h"
+#include "common/checksum.h"
+
+#include "order_server/client_request.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Identifies a journal file and the layout of the records in it.
+  constexpr uint64_t JOURNAL_MAGIC = 0x4c414e524a454d45; // "EMEJRNAL"
+  constexpr uint32_t JOURNAL_VERSION = 1;
+
+  /// Maximum number of sequenced client requests waiting to be written to the journal.
+  constexpr size_t ME_MAX_JOURNAL_RECORDS = 256 * 1024;
+
+  /// These structures are written to disk as is, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  /// Written once at the start of every journal file.
+  struct JournalFileHeader {
+    uint64_t magic_ = JOURNAL_MAGIC;
+    uint32_t version_ = JOURNAL_VERSION;
+    uint32_t record_size_ = 0;
+  };
+
+  /// A client request as sequenced by the FIFOSequencer, along with the software receive time and a checksum over both.
+  struct JournalRecord {
+    size_t seq_num_ = 0;
+    Nanos recv_time_ = 0;
+    MEClientRequest me_client_request_;
+    uint64_t checksum_ = 0;
+
+    /// Checksum covers every field preceding checksum_.
+    auto computeChecksum() const noexcept {
+      return fnv1a(this, offsetof(JournalRecord, checksum_));
+    }
+
+    auto isValid() const noexcept {
+      return (seq_num_ && checksum_ == computeChecksum());
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "JournalRecord"
+         << " ["
+         << "seq:" << seq_num_
+         << " rx:" << recv_time_
+         << " " << me_client_request_.toString()
+         << " checksum:" << checksum_
+         << "]";
+      return ss.str();
+    }
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// Lock free queue of sequenced client requests from the FIFOSequencer to the journal writer.
+  typedef LFQueue<JournalRecord> JournalRecordLFQueue;
+
+  /// When and how the journal writer forces written records to stable storage.
+  enum class JournalSyncMode : uint8_t {
+    NONE = 0,
+    MSYNC_ASYNC = 1,
+    MSYNC_SYNC = 2,
+    FDATASYNC = 3
+  };
+
+  inline std::string journalSyncModeToString(JournalSyncMode mode) {
+    switch (mode) {
+      case JournalSyncMode::NONE:
+        return "NONE";
+      case JournalSyncMode::MSYNC_ASYNC:
+        return "MSYNC_ASYNC";
+      case JournalSyncMode::MSYNC_SYNC:
+        return "MSYNC_SYNC";
+      case JournalSyncMode::FDATASYNC:
+        return "FDATASYNC";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Configuration for the journal writer.
+  struct JournalCfg {
+    /// Journal files are named <dir_>/<prefix_>_<index>.bin.
+    std::string dir_ = ".";
+    std::string prefix_ = "exchange_journal";
+
+    /// Size each journal file is preallocated to, a new file is started when a record does not fit.
+    size_t file_size_ = 256 * 1024 * 1024;
+
+    /// Sync written records once sync_batch_size_ records are pending or sync_interval_ has elapsed since the last sync.
+    JournalSyncMode sync_mode_ = JournalSyncMode::MSYNC_ASYNC;
+    size_t sync_batch_size_ = 1024;
+    Nanos sync_interval_ = NANOS_TO_MILLIS;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "JournalCfg{"
+         << "dir:" << dir_ << " "
+         << "prefix:" << prefix_ << " "
+         << "file-size:" << file_size_ << " "
+         << "sync-mode:" << journalSyncModeToString(sync_mode_) << " "
+         << "sync-batch:" << sync_batch_size_ << " "
+         << "sync-interval:" << sync_interval_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Full path of the journal file with the provided index.
+  inline auto journalFileName(const JournalCfg &cfg, size_t index) {
+    std::stringstream ss;
+    ss << cfg.dir_ << "/" << cfg.prefix_ << "_" << std::setw(6) << std::setfill('0') << index << ".bin";
+    return ss.str();
+  }
+}
@@ -0,0 +1,86 @@
+#include "gap_fill_server.h"
+
+namespace Exchange {
+  GapFillServer::GapFillServer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface, int port, size_t num_channels, size_t history_size,
+                               const std::string &log_file_name)
+      : market_updates_(market_updates), logger_(log_file_name), channels_(num_channels), tcp_server_(logger_) {
+    ASSERT(!channels_.empty(), "Gap fill server needs at least one incremental channel.");
+    ASSERT(history_size, "Gap fill history cannot be empty.");
+    for (auto &channel: channels_)
+      channel.updates_.resize(history_size);
+
+    tcp_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
+    tcp_server_.recv_finished_callback_ = []() {};
+    tcp_server_.listen(iface, port);
+  }
+
+  GapFillServer::~GapFillServer() {
+    stop();
+  }
+
+  /// Start and stop the gap fill server thread.
+  auto GapFillServer::start() -> void {
+    run_ = true;
+    ASSERT(Common::createAndStartThread(-1, "Exchange/GapFillServer", [this]() { run(); }) != nullptr, "Failed to start GapFillServer thread.");
+  }
+
+  auto GapFillServer::stop() -> void {
+    run_ = false;
+  }
+
+  /// Main method for this thread - records incremental updates from the market data publisher and serves gap fill requests.
+  auto GapFillServer::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
+    while (run_) {
+      drainUpdates();
+
+      tcp_server_.poll();
+      tcp_server_.sendAndRecv();
+    }
+  }
+
+  /// Move the incremental updates forwarded by the market data publisher so far into history_.
+  auto GapFillServer::drainUpdates() noexcept -> void {
+    for (auto market_update = market_updates_->getNextToRead(); market_updates_->size() && market_update; market_update = market_updates_->getNextToRead()) {
+      auto &channel = channels_[tickerChannel(market_update->me_market_update_.ticker_id_, channels_.size())];
+      ASSERT(market_update->seq_num_ == channel.next_seq_num_, "Expected incremental seq_nums to increase.");
+      channel.updates_[channel.next_seq_num_ % channel.updates_.size()] = *market_update;
+      ++channel.next_seq_num_;
+
+      market_updates_->updateReadIndex();
+    }
+  }
+
+  /// Serve the gap fill requests read from a consumer's socket.
+  auto GapFillServer::recvCallback(TCPSocket *socket, Nanos) noexcept -> void {
+    // A consumer can only ask for updates it has seen a later one of, which the market data publisher forwarded here before sending it out,
+    // so everything it can ask for is in the queue by now.
+    drainUpdates();
+
+    size_t i = 0;
+    for (; i + sizeof(MDPGapFillRequest) <= socket->next_rcv_valid_index_; i += sizeof(MDPGapFillRequest)) {
+      const auto request = reinterpret_cast<const MDPGapFillRequest *>(socket->inbound_data_.data() + i);
+
+      MDPGapFillResponse response{request->channel_, request->from_seq_num_, 0};
+      if (UNLIKELY(request->channel_ >= channels_.size())) {
+        logger_.log("%:% %() % socket:% % unknown channel %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                    request->toString(), response.toString());
+        socket->send(&response, sizeof(response));
+        continue;
+      }
+
+      const auto &channel = channels_[request->channel_];
+      if (request->from_seq_num_ >= channel.oldestSeqNum() && request->from_seq_num_ <= request->to_seq_num_ && request->to_seq_num_ < channel.next_seq_num_)
+        response.num_updates_ = request->to_seq_num_ - request->from_seq_num_ + 1;
+
+      logger_.log("%:% %() % socket:% % history:[%, %) %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                  request->toString(), channel.oldestSeqNum(), channel.next_seq_num_, response.toString());
+
+      socket->send(&response, sizeof(response));
+      for (auto seq_num = response.from_seq_num_; seq_num < response.from_seq_num_ + response.num_updates_; ++seq_num)
+        socket->send(&channel.updates_[seq_num % channel.updates_.size()], sizeof(MDPMarketUpdate));
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/thread_utils.h"
+#include "common/lf_queue.h"
+#include "common/macros.h"
+#include "common/tcp_server.h"
+#include "common/logging.h"
+
+#include "market_data/market_update.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Number of most recent incremental market updates kept by the gap fill server by default.
+  constexpr size_t ME_GAP_FILL_HISTORY = 64 * 1024;
+
+  /// Keeps a bounded history of the most recent incremental market updates of every incremental channel and retransmits ranges of them to market data
+  /// consumers over TCP, so a consumer which dropped a few packets does not have to wait for the next snapshot of the affected tickers.
+  class GapFillServer {
+  public:
+    GapFillServer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface, int port, size_t num_channels = 1,
+                  size_t history_size = ME_GAP_FILL_HISTORY, const std::string &log_file_name = "exchange_gap_fill_server.log");
+
+    ~GapFillServer();
+
+    /// Start and stop the gap fill server thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main method for this thread - records incremental updates from the market data publisher and serves gap fill requests.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    GapFillServer() = delete;
+
+    GapFillServer(const GapFillServer &) = delete;
+
+    GapFillServer(const GapFillServer &&) = delete;
+
+    GapFillServer &operator=(const GapFillServer &) = delete;
+
+    GapFillServer &operator=(const GapFillServer &&) = delete;
+
+  private:
+    /// Lock free queue containing incremental market data updates coming in from the market data publisher.
+    MDPMarketUpdateLFQueue *market_updates_ = nullptr;
+
+    volatile bool run_ = false;
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Ring of the most recent incremental updates of one channel indexed by seq_num_ % updates_.size(), holding seq_nums [oldestSeqNum(), next_seq_num_).
+    struct ChannelHistory {
+      std::vector<MDPMarketUpdate> updates_;
+      size_t next_seq_num_ = 1;
+
+      auto oldestSeqNum() const noexcept {
+        return (next_seq_num_ > updates_.size() ? next_seq_num_ - updates_.size() : 1);
+      }
+    };
+
+    /// History of every incremental channel, indexed by channel.
+    std::vector<ChannelHistory> channels_;
+
+    /// TCP server socket listening for and connected to market data consumers.
+    TCPServer tcp_server_;
+
+  private:
+    /// Move the incremental updates forwarded by the market data publisher so far into history_.
+    auto drainUpdates() noexcept -> void;
+
+    /// Serve the gap fill requests read from a consumer's socket.
+    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
+  };
+}
@@ -3,44 +3,167 @@
 namespace Exchange {
   MarketDataPublisher::MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
                                            const std::string &snapshot_ip, int snapshot_port,
-                                           const std::string &incremental_ip, int incremental_port)
-      : outgoing_md_updates_(market_updates), snapshot_md_updates_(ME_MAX_MARKET_UPDATES),
-        run_(false), logger_("exchange_market_data_publisher.log"), incremental_socket_(logger_) {
-    ASSERT(incremental_socket_.init(incremental_ip, iface, incremental_port, /*is_listening*/ false) >= 0,
-           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
-    snapshot_synthesizer_ = new SnapshotSynthesizer(&snapshot_md_updates_, iface, snapshot_ip, snapshot_port);
+                                           const std::vector<IncrementalChannelCfg> &incremental_channels, int gap_fill_port,
+                                           const std::string &price_level_ip, int price_level_port, const EngineLimits &limits,
+                                           const SnapshotCfg &snapshot_cfg, const CoalesceCfg &coalesce_cfg)
+      : ticker_next_seq_num_(limits.max_tickers_, 1), outgoing_md_updates_(market_updates), snapshot_md_updates_(limits.max_market_updates_),
+        gap_fill_md_updates_(limits.max_market_updates_), price_level_md_updates_(limits.max_market_updates_),
+        run_(false), logger_("exchange_market_data_publisher.log"), coalesce_cfg_(coalesce_cfg), max_order_ids_(limits.max_order_ids_),
+        batch_slots_(limits.max_tickers_) {
+    ASSERT(!incremental_channels.empty(), "Market data publisher needs at least one incremental channel.");
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), coalesce_cfg_.toString());
+    batch_.reserve(coalesce_cfg_.max_batch_);
+    for (auto &slots: batch_slots_)
+      slots.reserve(max_order_ids_);
+
+    incremental_channels_.reserve(incremental_channels.size());
+    for (const auto &channel_cfg: incremental_channels) {
+      logger_.log("%:% %() % channel:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), incremental_channels_.size(),
+                  channel_cfg.toString());
+
+      auto &channel = incremental_channels_.emplace_back(logger_, channel_cfg.compact_, limits.max_tickers_);
+      ASSERT(channel.socket_.init(channel_cfg.ip_, iface, channel_cfg.port_, /*is_listening*/ false) >= 0,
+             "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+      if (!channel_cfg.b_ip_.empty())
+        ASSERT(channel.b_socket_.init(channel_cfg.b_ip_, iface, channel_cfg.b_port_, /*is_listening*/ false) >= 0,
+               "Unable to create incremental B mcast socket. error:" + std::string(std::strerror(errno)));
+    }
+    snapshot_synthesizer_ = new SnapshotSynthesizer(&snapshot_md_updates_, iface, snapshot_ip, snapshot_port, limits, snapshot_cfg);
+    gap_fill_server_ = new GapFillServer(&gap_fill_md_updates_, iface, gap_fill_port, incremental_channels_.size());
+    if (!price_level_ip.empty())
+      price_level_publisher_ = new PriceLevelPublisher(&price_level_md_updates_, iface, price_level_ip, price_level_port, limits);
   }
 
-  /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+  /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on their ticker's incremental channel and forwards them to the snapshot synthesizer, the gap fill server and the price level publisher.
   auto MarketDataPublisher::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
-      for (auto market_update = outgoing_md_updates_->getNextToRead();
-           outgoing_md_updates_->size() && market_update; market_update = outgoing_md_updates_->getNextToRead()) {
-        TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, logger_);
+      if (coalesce_cfg_.enabled_) {
+        // Read a batch of updates, merging the updates to the same order, and publish what is left of them.
+        ++batch_num_;
+        size_t num_read = 0;
+        for (auto market_update = outgoing_md_updates_->getNextToRead();
+             num_read < coalesce_cfg_.max_batch_ && outgoing_md_updates_->size() && market_update; market_update = outgoing_md_updates_->getNextToRead()) {
+          TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, logger_);
 
-        logger_.log("%:% %() % Sending seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), next_inc_seq_num_,
-                    market_update->toString().c_str());
+          coalesceUpdate(*market_update);
+          outgoing_md_updates_->updateReadIndex();
+          ++num_read;
+        }
 
-        START_MEASURE(Exchange_McastSocket_send);
-        incremental_socket_.send(&next_inc_seq_num_, sizeof(next_inc_seq_num_));
-        incremental_socket_.send(market_update, sizeof(MEMarketUpdate));
-        END_MEASURE(Exchange_McastSocket_send, logger_);
+        for (const auto &market_update: batch_) {
+          if (market_update.type_ != MarketUpdateType::INVALID)
+            publishUpdate(&market_update);
+          TTT_MEASURE(T6_MarketDataPublisher_UDP_write, logger_);
+        }
+        batch_.clear();
+        batch_trades_end_ = 0;
+      } else {
+        for (auto market_update = outgoing_md_updates_->getNextToRead();
+             outgoing_md_updates_->size() && market_update; market_update = outgoing_md_updates_->getNextToRead()) {
+          TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, logger_);
+
+          publishUpdate(market_update);
+          outgoing_md_updates_->updateReadIndex();
+          TTT_MEASURE(T6_MarketDataPublisher_UDP_write, logger_);
+        }
+      }
 
-        outgoing_md_updates_->updateReadIndex();
-        TTT_MEASURE(T6_MarketDataPublisher_UDP_write, logger_);
+      // Publish to the multicast streams.
+      for (auto &channel: incremental_channels_) {
+        if (!channel.encoder_.empty())
+          sendPacket(channel);
+        channel.socket_.sendAndRecv();
+        if (channel.b_socket_.socket_fd_ >= 0)
+          channel.b_socket_.sendAndRecv();
+      }
+    }
+  }
 
-        // Forward this incremental market data update the snapshot synthesizer.
-        auto next_write = snapshot_md_updates_.getNextToWriteTo();
-        next_write->seq_num_ = next_inc_seq_num_;
-        next_write->me_market_update_ = *market_update;
-        snapshot_md_updates_.updateWriteIndex();
+  /// Publish a market update on its ticker's incremental channel and forward it to the snapshot synthesizer, the gap fill server and the price level publisher.
+  auto MarketDataPublisher::publishUpdate(const MEMarketUpdate *market_update) noexcept -> void {
+    auto &channel = incremental_channels_[tickerChannel(market_update->ticker_id_, incremental_channels_.size())];
+    auto &ticker_seq_num = ticker_next_seq_num_[market_update->ticker_id_];
+    logger_.log("%:% %() % Sending seq:% channel-seq:% ticker-seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                next_inc_seq_num_, channel.next_seq_num_, ticker_seq_num, market_update->toString().c_str());
 
-        ++next_inc_seq_num_;
+    START_MEASURE(Exchange_McastSocket_send);
+    if (channel.compact_) {
+      if (channel.encoder_.add({channel.next_seq_num_, ticker_seq_num, *market_update}))
+        sendPacket(channel);
+    } else {
+      channel.socket_.send(&channel.next_seq_num_, sizeof(channel.next_seq_num_));
+      channel.socket_.send(&ticker_seq_num, sizeof(ticker_seq_num));
+      channel.socket_.send(market_update, sizeof(MEMarketUpdate));
+      if (channel.b_socket_.socket_fd_ >= 0) {
+        channel.b_socket_.send(&channel.next_seq_num_, sizeof(channel.next_seq_num_));
+        channel.b_socket_.send(&ticker_seq_num, sizeof(ticker_seq_num));
+        channel.b_socket_.send(market_update, sizeof(MEMarketUpdate));
       }
+    }
+    END_MEASURE(Exchange_McastSocket_send, logger_);
 
-      // Publish to the multicast stream.
-      incremental_socket_.sendAndRecv();
+    // Forward this incremental market data update the snapshot synthesizer, the gap fill server and the price level publisher, before it goes out in sendAndRecv() in run().
+    // The snapshot synthesizer follows the updates of all the channels in the order they were published, the gap fill server retransmits them by channel.
+    *snapshot_md_updates_.getNextToWriteTo() = {next_inc_seq_num_, ticker_seq_num, *market_update};
+    snapshot_md_updates_.updateWriteIndex();
+    *gap_fill_md_updates_.getNextToWriteTo() = {channel.next_seq_num_, ticker_seq_num, *market_update};
+    gap_fill_md_updates_.updateWriteIndex();
+    if (price_level_publisher_) {
+      *price_level_md_updates_.getNextToWriteTo() = {next_inc_seq_num_, ticker_seq_num, *market_update};
+      price_level_md_updates_.updateWriteIndex();
     }
+
+    ++next_inc_seq_num_;
+    ++channel.next_seq_num_;
+    ++ticker_seq_num;
+  }
+
+  /// Add a market update to the batch being coalesced, merging it with the batch's last update to the same order if there is one.
+  /// A MODIFY or CANCEL merged into an earlier MODIFY is published in the position of the later update, so it still follows the TRADEs which led to it.
+  /// An ADD keeps its place in its price level's FIFO queue, so updates are only merged into it if no TRADE has been added to the batch since.
+  auto MarketDataPublisher::coalesceUpdate(const MEMarketUpdate &market_update) noexcept -> void {
+    const auto is_order_update = (market_update.type_ == MarketUpdateType::ADD || market_update.type_ == MarketUpdateType::MODIFY ||
+                                  market_update.type_ == MarketUpdateType::CANCEL);
+    if (!is_order_update || UNLIKELY(market_update.ticker_id_ >= batch_slots_.size() || market_update.order_id_ >= max_order_ids_)) {
+      if (market_update.type_ == MarketUpdateType::TRADE)
+        batch_trades_end_ = batch_.size() + 1;
+      batch_.push_back(market_update);
+      return;
+    }
+
+    auto &slots = batch_slots_[market_update.ticker_id_];
+    if (UNLIKELY(market_update.order_id_ >= slots.size()))
+      slots.resize(std::min(max_order_ids_, std::max<size_t>(market_update.order_id_ + 1, 2 * slots.size())));
+    auto &slot = slots[market_update.order_id_];
+    if (slot.batch_ != batch_num_ || market_update.type_ == MarketUpdateType::ADD ||
+        (batch_[slot.index_].type_ == MarketUpdateType::ADD && slot.index_ < batch_trades_end_)) {
+      slot = {batch_num_, batch_.size()};
+      batch_.push_back(market_update);
+      return;
+    }
+
+    auto &last_update = batch_[slot.index_];
+    ++num_coalesced_;
+    if (last_update.type_ != MarketUpdateType::ADD) { // MODIFY followed by a MODIFY or a CANCEL.
+      last_update.type_ = MarketUpdateType::INVALID;
+      slot.index_ = batch_.size();
+      batch_.push_back(market_update);
+    } else if (market_update.type_ == MarketUpdateType::MODIFY) {
+      last_update.price_ = market_update.price_;
+      last_update.qty_ = market_update.qty_;
+    } else { // ADD followed by a CANCEL, the order is never published.
+      last_update.type_ = MarketUpdateType::INVALID;
+      slot.batch_ = 0;
+      ++num_coalesced_;
+    }
+  }
+
+  /// Copy the packet encoded on a compact channel to the send buffers of its sockets and start the next one.
+  auto MarketDataPublisher::sendPacket(IncrementalChannel &channel) noexcept -> void {
+    channel.socket_.send(channel.encoder_.data(), channel.encoder_.size());
+    if (channel.b_socket_.socket_fd_ >= 0)
+      channel.b_socket_.send(channel.encoder_.data(), channel.encoder_.size());
+    channel.encoder_.clear();
   }
 }
@@ -3,13 +3,39 @@
 #include <functional>
 
 #include "market_data/snapshot_synthesizer.h"
+#include "market_data/gap_fill_server.h"
+#include "market_data/price_level_publisher.h"
+#include "market_data/market_data_wire.h"
 
 namespace Exchange {
+  /// Coalescing of the incremental updates to the same order within one batch of updates published together.
+  struct CoalesceCfg {
+    /// Later updates to an order are merged with its last update in the batch - an ADD takes the quantity of the MODIFYs following it and is dropped
+    /// together with a CANCEL following it as long as no TRADE came in between, a MODIFY is replaced by the MODIFY or CANCEL following it, which is
+    /// published in the later update's position. Updates never move ahead of a TRADE, which are always published.
+    bool enabled_ = false;
+
+    /// Most updates read from the matching engine and coalesced as one batch, bounds the delay coalescing adds to the first update of a batch.
+    size_t max_batch_ = 256;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "CoalesceCfg{"
+         << "enabled:" << enabled_ << " "
+         << "max-batch:" << max_batch_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
   class MarketDataPublisher {
   public:
     MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
                         const std::string &snapshot_ip, int snapshot_port,
-                        const std::string &incremental_ip, int incremental_port);
+                        const std::vector<IncrementalChannelCfg> &incremental_channels, int gap_fill_port,
+                        const std::string &price_level_ip, int price_level_port, const EngineLimits &limits = EngineLimits(),
+                        const SnapshotCfg &snapshot_cfg = SnapshotCfg(), const CoalesceCfg &coalesce_cfg = CoalesceCfg());
 
     ~MarketDataPublisher() {
       stop();
@@ -19,26 +45,43 @@ namespace Exchange {
 
       delete snapshot_synthesizer_;
       snapshot_synthesizer_ = nullptr;
+
+      delete gap_fill_server_;
+      gap_fill_server_ = nullptr;
+
+      delete price_level_publisher_;
+      price_level_publisher_ = nullptr;
     }
 
-    /// Start and stop the market data publisher main thread, as well as the internal snapshot synthesizer thread.
+    /// Start and stop the market data publisher main thread, as well as the internal snapshot synthesizer, gap fill server and price level publisher threads.
     auto start() {
       run_ = true;
 
       ASSERT(Common::createAndStartThread(-1, "Exchange/MarketDataPublisher", [this]() { run(); }) != nullptr, "Failed to start MarketData thread.");
 
       snapshot_synthesizer_->start();
+      gap_fill_server_->start();
+      if (price_level_publisher_)
+        price_level_publisher_->start();
     }
 
     auto stop() -> void {
       run_ = false;
 
       snapshot_synthesizer_->stop();
+      gap_fill_server_->stop();
+      if (price_level_publisher_)
+        price_level_publisher_->stop();
     }
 
-    /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+    /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on their ticker's incremental channel and forwards them to the snapshot synthesizer, the gap fill server and the price level publisher.
     auto run() noexcept -> void;
 
+    /// Number of updates from the matching engine which were not published because they were coalesced with another update to the same order.
+    auto numCoalesced() const noexcept {
+      return num_coalesced_.load();
+    }
+
     // Deleted default, copy & move constructors and assignment-operators.
     MarketDataPublisher() = delete;
 
@@ -51,24 +94,86 @@ namespace Exchange {
     MarketDataPublisher &operator=(const MarketDataPublisher &&) = delete;
 
   private:
-    /// Sequencer number tracker on the incremental market data stream.
+    /// Sequence number of the next incremental market update across all the channels, orders the updates forwarded to the snapshot synthesizer.
     size_t next_inc_seq_num_ = 1;
 
+    /// Hash map from TickerId -> sequence number of the next incremental market update for that ticker.
+    std::vector<size_t> ticker_next_seq_num_;
+
     /// Lock free queue from which we consume market data updates sent by the matching engine.
     MEMarketUpdateLFQueue *outgoing_md_updates_ = nullptr;
 
     /// Lock free queue on which we forward the incremental market data updates to send to the snapshot synthesizer.
     MDPMarketUpdateLFQueue snapshot_md_updates_;
 
+    /// Lock free queue on which we forward the incremental market data updates to the gap fill server.
+    MDPMarketUpdateLFQueue gap_fill_md_updates_;
+
+    /// Lock free queue on which we forward the incremental market data updates to the price level publisher, if there is one.
+    MDPMarketUpdateLFQueue price_level_md_updates_;
+
     volatile bool run_ = false;
 
     std::string time_str_;
     Logger logger_;
 
-    /// Multicast socket to represent the incremental market data stream.
-    Common::McastSocket incremental_socket_;
+    /// An incremental channel - its sequence number tracker and multicast sockets. The B feed carries an identical copy of the A feed on a separate group
+    /// for consumers to arbitrate between, the B socket is not initialized if no B feed group is configured.
+    struct IncrementalChannel {
+      IncrementalChannel(Logger &logger, bool compact, size_t max_tickers)
+          : compact_(compact), encoder_(max_tickers), socket_(logger), b_socket_(logger) {
+      }
+
+      size_t next_seq_num_ = 1;
+
+      /// Updates of a compact channel are encoded into packets by encoder_, which are copied to the sockets once full or at the end of each batch.
+      const bool compact_ = false;
+      MDPWireEncoder encoder_;
+
+      Common::McastSocket socket_, b_socket_;
+    };
+
+    /// Incremental channels indexed by tickerChannel().
+    std::vector<IncrementalChannel> incremental_channels_;
 
     /// Snapshot synthesizer which synthesizes and publishes limit order book snapshots on the snapshot multicast stream.
     SnapshotSynthesizer *snapshot_synthesizer_ = nullptr;
+
+    /// Gap fill server which retransmits recent incremental market data updates to consumers over TCP.
+    GapFillServer *gap_fill_server_ = nullptr;
+
+    /// Price level publisher which publishes the conflated market by price feed, only created if a price level multicast group is configured.
+    PriceLevelPublisher *price_level_publisher_ = nullptr;
+
+    const CoalesceCfg coalesce_cfg_;
+    const size_t max_order_ids_;
+
+    /// Updates read from the matching engine for the batch being coalesced, updates coalesced away entirely are left in place with type INVALID.
+    std::vector<MEMarketUpdate> batch_;
+    size_t batch_num_ = 0;
+
+    /// One past the index in batch_ of the last TRADE in the batch being coalesced, 0 if there is none.
+    size_t batch_trades_end_ = 0;
+
+    /// Index in batch_ of the last update to an order, valid only if batch_ is the number of the batch being coalesced.
+    struct BatchSlot {
+      size_t batch_ = 0;
+      size_t index_ = 0;
+    };
+
+    /// Hash map from TickerId -> market order id -> BatchSlot, grows with the market order ids seen for each ticker within the max_order_ids_ reserved.
+    std::vector<std::vector<BatchSlot>> batch_slots_;
+
+    std::atomic<size_t> num_coalesced_ = {0};
+
+  private:
+    /// Publish a market update on its ticker's incremental channel and forward it to the snapshot synthesizer, the gap fill server and the price level publisher.
+    auto publishUpdate(const MEMarketUpdate *market_update) noexcept -> void;
+
+    /// Add a market update to the batch being coalesced, merging it with the batch's last update to the same order if there is one.
+    auto coalesceUpdate(const MEMarketUpdate &market_update) noexcept -> void;
+
+    /// Copy the packet encoded on a compact channel to the send buffers of its sockets and start the next one.
+    auto sendPacket(IncrementalChannel &channel) noexcept -> void;
   };
 }
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "common/macros.h"
+
+#include "market_update.h"
+
+namespace Exchange {
+  /// Compact encoding of the incremental market updates, used on the incremental channels configured with IncrementalChannelCfg::compact_ instead of
+  /// raw MDPMarketUpdate structs.
+  /// Updates are sent in packets, a MDPWirePacketHeader carrying the seq_num_ of the first update followed by the updates, whose seq_num_ are implicit.
+  /// Every update is a byte holding its type and side followed by LEB128 varints:
+  /// - ticker_id_.
+  /// - ticker_seq_num_, only on the first update of a ticker in the packet, the following ones of the same ticker are one more than the previous one.
+  /// - order_id_ and price_, zigzag encoded difference to the previous update of the same ticker in the packet, or to 0 on the first one.
+  /// - qty_.
+  /// - priority_ + 1, so that Priority_INVALID is a single byte.
+  /// TRADE updates carry no order_id_ or priority_, they are always invalid.
+  /// Packets are self contained so that they can be decoded in any order off either feed, a lost packet only loses its own updates.
+  constexpr uint8_t MDP_WIRE_VERSION = 1;
+
+  /// Largest encoded update, the type and side byte and six varints of at most 10 bytes.
+  constexpr size_t MDP_WIRE_MAX_UPDATE_SIZE = 1 + 6 * 10;
+
+  /// Packets are closed once they reach this size, so that a packet fits an ethernet frame when sent on its own.
+  constexpr size_t MDP_WIRE_MAX_PACKET_SIZE = 1400;
+
+  /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  struct MDPWirePacketHeader {
+    uint8_t version_ = MDP_WIRE_VERSION;
+
+    /// Length of the whole packet including this header, lets a reader skip versions it does not understand.
+    uint16_t length_ = 0;
+    uint16_t num_updates_ = 0;
+
+    /// seq_num_ of the first update in the packet, the following ones are numbered on from it.
+    uint64_t seq_num_ = 0;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  inline auto zigzagEncode(int64_t value) noexcept -> uint64_t {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+
+  inline auto zigzagDecode(uint64_t value) noexcept -> int64_t {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  /// Encode value as a LEB128 varint into buffer, returns the number of bytes written.
+  inline auto encodeVarint(uint64_t value, char *buffer) noexcept -> size_t {
+    size_t len = 0;
+    for (; value >= 0x80; value >>= 7)
+      buffer[len++] = static_cast<char>(value | 0x80);
+    buffer[len++] = static_cast<char>(value);
+    return len;
+  }
+
+  /// Decode the LEB128 varint at buffer into value, returns its length. Varints of up to 8 bytes, i.e. values below 2^56, are decoded from a single
+  /// unaligned little endian load without branching on their length, so the 8 bytes at buffer have to be readable even if the varint is shorter.
+  inline auto decodeVarint(const char *buffer, uint64_t &value) noexcept -> size_t {
+    uint64_t word;
+    memcpy(&word, buffer, sizeof(word));
+
+    const auto stop_bits = ~word & 0x8080808080808080ULL;
+    if (UNLIKELY(!stop_bits)) {
+      value = 0;
+      size_t len = 0;
+      for (unsigned shift = 0; shift < 64; shift += 7) {
+        const auto byte = static_cast<uint8_t>(buffer[len++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+          break;
+      }
+      return len;
+    }
+
+    // Keep the bytes up to the first one without a continuation bit, drop the continuation bits and squeeze the 7 bit groups together.
+    value = word & (stop_bits ^ (stop_bits - 1)) & 0x7f7f7f7f7f7f7f7fULL;
+    value = ((value & 0x7f007f007f007f00ULL) >> 1) | (value & 0x007f007f007f007fULL);
+    value = ((value & 0x3fff00003fff0000ULL) >> 2) | (value & 0x00003fff00003fffULL);
+    value = ((value & 0x0fffffff00000000ULL) >> 4) | (value & 0x000000000fffffffULL);
+    return (static_cast<size_t>(std::countr_zero(stop_bits)) >> 3) + 1;
+  }
+
+  /// Length of the complete packet at the start of the len valid bytes in buffer, 0 if more bytes are needed.
+  /// A corrupt length shorter than the header is treated as a header only packet so that the reader always makes progress.
+  inline auto mdpWirePacketLength(const char *buffer, size_t len) noexcept -> size_t {
+    if (len < sizeof(MDPWirePacketHeader))
+      return 0;
+
+    const auto header = reinterpret_cast<const MDPWirePacketHeader *>(buffer);
+    const size_t packet_len = std::max<size_t>(header->length_, sizeof(MDPWirePacketHeader));
+    return (packet_len <= len ? packet_len : 0);
+  }
+
+  /// State of a ticker within the packet being encoded / decoded, only valid if packet_ is the number of that packet.
+  struct MDPWireTickerState {
+    size_t packet_ = 0;
+    size_t next_ticker_seq_num_ = 0;
+    OrderId order_id_ = 0;
+    Price price_ = 0;
+  };
+
+  /// Encodes the updates of one incremental channel into packets.
+  class MDPWireEncoder {
+  public:
+    /// Encodes the updates of TickerIds in [0, max_tickers), the matching engine never publishes others.
+    explicit MDPWireEncoder(size_t max_tickers)
+        : tickers_(max_tickers) {
+    }
+
+    /// Append the update to the packet being encoded, opening a new packet if needed. Returns true once the packet is full, it then has to be sent
+    /// and clear()ed before adding the next update.
+    auto add(const MDPMarketUpdate &update) noexcept -> bool {
+      auto header = reinterpret_cast<MDPWirePacketHeader *>(packet_);
+      if (!length_) {
+        *header = {MDP_WIRE_VERSION, 0, 0, update.seq_num_};
+        length_ = sizeof(MDPWirePacketHeader);
+      }
+
+      const auto &me_market_update = update.me_market_update_;
+      auto &ticker = tickers_[me_market_update.ticker_id_];
+      const auto first = (ticker.packet_ != packet_num_);
+      const auto is_trade = (me_market_update.type_ == MarketUpdateType::TRADE);
+      const auto order_id_base = (first ? 0 : ticker.order_id_);
+      const auto price_base = (first ? 0 : ticker.price_);
+
+      auto buffer = packet_ + length_;
+      *buffer++ = static_cast<char>(static_cast<uint8_t>(me_market_update.type_) | static_cast<uint8_t>(static_cast<int8_t>(me_market_update.side_) + 1) << 3);
+      buffer += encodeVarint(me_market_update.ticker_id_, buffer);
+      if (first)
+        buffer += encodeVarint(update.ticker_seq_num_, buffer);
+      if (!is_trade)
+        buffer += encodeVarint(zigzagEncode(static_cast<int64_t>(me_market_update.order_id_ - order_id_base)), buffer);
+      buffer += encodeVarint(zigzagEncode(static_cast<int64_t>(static_cast<uint64_t>(me_market_update.price_) - static_cast<uint64_t>(price_base))), buffer);
+      buffer += encodeVarint(me_market_update.qty_, buffer);
+      if (!is_trade)
+        buffer += encodeVarint(me_market_update.priority_ + 1, buffer);
+
+      ticker = {packet_num_, update.ticker_seq_num_ + 1, (is_trade ? order_id_base : me_market_update.order_id_), me_market_update.price_};
+
+      length_ = static_cast<size_t>(buffer - packet_);
+      header->length_ = static_cast<uint16_t>(length_);
+      ++header->num_updates_;
+      return (length_ >= MDP_WIRE_MAX_PACKET_SIZE);
+    }
+
+    /// The packet being encoded.
+    auto data() const noexcept {
+      return packet_;
+    }
+
+    auto size() const noexcept {
+      return length_;
+    }
+
+    auto empty() const noexcept {
+      return !length_;
+    }
+
+    /// Start a new packet with the next update added.
+    auto clear() noexcept {
+      length_ = 0;
+      ++packet_num_;
+    }
+
+  private:
+    char packet_[MDP_WIRE_MAX_PACKET_SIZE + MDP_WIRE_MAX_UPDATE_SIZE];
+    size_t length_ = 0;
+
+    /// Number of the packet being encoded and hash map from TickerId -> MDPWireTickerState.
+    size_t packet_num_ = 1;
+    std::vector<MDPWireTickerState> tickers_;
+  };
+
+  /// Decodes the packets of the incremental channels, a decoder can be shared between channels since packets are self contained.
+  class MDPWireDecoder {
+  public:
+    /// Decodes the updates of TickerIds in [0, max_tickers).
+    explicit MDPWireDecoder(size_t max_tickers)
+        : tickers_(max_tickers) {
+    }
+
+    /// Decode the complete packet at buffer, see mdpWirePacketLength(), calling on_update with every update in it. Packets of other versions are skipped.
+    /// The rest of the packet is skipped at an update of a TickerId beyond max_tickers, returning false.
+    /// Fields are read whether they are present or not, only advancing past the ones present, so the 7 bytes past the end of the packet have to be readable.
+    template<typename OnUpdate>
+    auto decode(const char *buffer, OnUpdate &&on_update) noexcept -> bool {
+      const auto header = reinterpret_cast<const MDPWirePacketHeader *>(buffer);
+      if (UNLIKELY(header->version_ != MDP_WIRE_VERSION))
+        return true;
+
+      ++packet_num_;
+      const auto end = buffer + header->length_;
+      auto next = buffer + sizeof(MDPWirePacketHeader);
+      MDPMarketUpdate update;
+      update.seq_num_ = header->seq_num_;
+      uint64_t value;
+      for (size_t i = 0; i < header->num_updates_ && next < end; ++i, ++update.seq_num_) {
+        auto &me_market_update = update.me_market_update_;
+        const auto type_side = static_cast<uint8_t>(*next++);
+        me_market_update.type_ = static_cast<MarketUpdateType>(type_side & 0x07);
+        me_market_update.side_ = static_cast<Side>(static_cast<int8_t>((type_side >> 3) & 0x03) - 1);
+        next += decodeVarint(next, value);
+        me_market_update.ticker_id_ = static_cast<TickerId>(value);
+
+        if (UNLIKELY(me_market_update.ticker_id_ >= tickers_.size())) // the fields following it can not be decoded without the ticker's state.
+          return false;
+        auto &ticker = tickers_[me_market_update.ticker_id_];
+        const auto first = (ticker.packet_ != packet_num_);
+        const auto is_trade = (me_market_update.type_ == MarketUpdateType::TRADE);
+        const auto order_id_base = (first ? 0 : ticker.order_id_);
+        const auto price_base = (first ? 0 : ticker.price_);
+
+        auto len = decodeVarint(next, value);
+        next += (first ? len : 0);
+        update.ticker_seq_num_ = (first ? value : ticker.next_ticker_seq_num_);
+
+        len = decodeVarint(next, value);
+        next += (is_trade ? 0 : len);
+        me_market_update.order_id_ = (is_trade ? OrderId_INVALID : order_id_base + static_cast<OrderId>(zigzagDecode(value)));
+
+        next += decodeVarint(next, value);
+        me_market_update.price_ = static_cast<Price>(static_cast<uint64_t>(price_base) + static_cast<uint64_t>(zigzagDecode(value)));
+
+        next += decodeVarint(next, value);
+        me_market_update.qty_ = static_cast<Qty>(value);
+
+        len = decodeVarint(next, value);
+        next += (is_trade ? 0 : len);
+        me_market_update.priority_ = (is_trade ? Priority_INVALID : value - 1);
+
+        ticker = {packet_num_, update.ticker_seq_num_ + 1, (is_trade ? order_id_base : me_market_update.order_id_), me_market_update.price_};
+
+        on_update(update);
+      }
+
+      return true;
+    }
+
+  private:
+    /// Number of the packet being decoded and hash map from TickerId -> MDPWireTickerState.
+    size_t packet_num_ = 0;
+    std::vector<MDPWireTickerState> tickers_;
+  };
+}
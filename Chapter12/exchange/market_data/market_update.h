@@ -73,8 +73,12 @@ namespace Exchange {
   };
 
   /// Market update structure published over the network by the market data publisher.
+  /// On the incremental stream seq_num_ counts every market update of the update's channel and ticker_seq_num_ only those of the update's ticker, so a consumer can tell which
+  /// instruments a gap affected. On the snapshot stream seq_num_ counts the messages of one ticker's snapshot from its SNAPSHOT_START and ticker_seq_num_
+  /// is the incremental ticker_seq_num_ that snapshot is consistent with.
   struct MDPMarketUpdate {
     size_t seq_num_ = 0;
+    size_t ticker_seq_num_ = 0;
     MEMarketUpdate me_market_update_;
 
     auto toString() const {
@@ -82,14 +86,120 @@ namespace Exchange {
       ss << "MDPMarketUpdate"
          << " ["
          << " seq:" << seq_num_
+         << " ticker-seq:" << ticker_seq_num_
          << " " << me_market_update_.toString()
          << "]";
       return ss.str();
     }
   };
 
+  /// Request sent over TCP by a market data consumer to the gap fill server, to retransmit the incremental updates with seq_num_ in [from_seq_num_, to_seq_num_]
+  /// on incremental channel channel_.
+  struct MDPGapFillRequest {
+    size_t channel_ = 0;
+    size_t from_seq_num_ = 0;
+    size_t to_seq_num_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "MDPGapFillRequest"
+         << " ["
+         << " channel:" << channel_
+         << " from:" << from_seq_num_
+         << " to:" << to_seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Response from the gap fill server to a MDPGapFillRequest, followed by num_updates_ MDPMarketUpdate messages starting at seq_num_ from_seq_num_.
+  /// num_updates_ is 0 if the requested range is not in the gap fill server's history, the consumer then has to recover from snapshots.
+  struct MDPGapFillResponse {
+    size_t channel_ = 0;
+    size_t from_seq_num_ = 0;
+    size_t num_updates_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "MDPGapFillResponse"
+         << " ["
+         << " channel:" << channel_
+         << " from:" << from_seq_num_
+         << " updates:" << num_updates_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Number of price levels of each side of the book carried by a MDPPriceLevelUpdate.
+  constexpr size_t MDP_PRICE_LEVELS = 5;
+
+  /// Aggregated quantity and number of orders at one price level, price_ is Price_INVALID past the last level of a side.
+  struct MDPPriceLevel {
+    Price price_ = Price_INVALID;
+    Qty qty_ = 0;
+    uint32_t num_orders_ = 0;
+  };
+
+  /// Market by price update published on the price level multicast stream - the top MDP_PRICE_LEVELS aggregated levels of each side of a ticker's book,
+  /// best first, as of the incremental update with ticker_seq_num_. Updates are conflated, at most one per ticker is published for each batch of
+  /// incremental updates and only if its top levels changed. Every update carries the complete top of the book, so a client only needs the latest one
+  /// of each ticker and a dropped update is made good by the next one. seq_num_ counts the updates on the price level stream.
+  struct MDPPriceLevelUpdate {
+    size_t seq_num_ = 0;
+    size_t ticker_seq_num_ = 0;
+    TickerId ticker_id_ = TickerId_INVALID;
+    MDPPriceLevel bids_[MDP_PRICE_LEVELS];
+    MDPPriceLevel asks_[MDP_PRICE_LEVELS];
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "MDPPriceLevelUpdate"
+         << " ["
+         << " seq:" << seq_num_
+         << " ticker-seq:" << ticker_seq_num_
+         << " ticker:" << tickerIdToString(ticker_id_)
+         << " bids:";
+      for (const auto &level: bids_)
+        ss << " " << qtyToString(level.qty_) << "@" << priceToString(level.price_) << "(" << level.num_orders_ << ")";
+      ss << " asks:";
+      for (const auto &level: asks_)
+        ss << " " << qtyToString(level.qty_) << "@" << priceToString(level.price_) << "(" << level.num_orders_ << ")";
+      ss << "]";
+      return ss.str();
+    }
+  };
+
 #pragma pack(pop) // Undo the packed binary structure directive moving forward.
 
+  /// Multicast groups of one incremental channel. Tickers are sharded across the incremental channels by tickerChannel() and every channel numbers its
+  /// updates in a seq_num_ sequence of its own, so a consumer only has to join the channels of the tickers it trades. The B feed is optional.
+  struct IncrementalChannelCfg {
+    std::string ip_;
+    int port_ = 0;
+    std::string b_ip_;
+    int b_port_ = 0;
+
+    /// Updates are sent in the compact encoding of market_data_wire.h instead of as raw MDPMarketUpdate structs, publisher and consumers have to agree.
+    bool compact_ = false;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "IncrementalChannelCfg{"
+         << "A:" << ip_ << ":" << port_ << " "
+         << "B:" << (b_ip_.empty() ? "none" : b_ip_ + ":" + std::to_string(b_port_)) << " "
+         << "encoding:" << (compact_ ? "compact" : "raw")
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Incremental channel the updates of this ticker are published on.
+  inline auto tickerChannel(TickerId ticker_id, size_t num_channels) noexcept -> size_t {
+    return ticker_id % num_channels;
+  }
+
   /// Lock free queues of matching engine market update messages and market data publisher market updates messages respectively.
   typedef Common::LFQueue<Exchange::MEMarketUpdate> MEMarketUpdateLFQueue;
   typedef Common::LFQueue<Exchange::MDPMarketUpdate> MDPMarketUpdateLFQueue;
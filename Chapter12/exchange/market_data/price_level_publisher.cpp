@@ -0,0 +1,156 @@
+#include "price_level_publisher.h"
+
+namespace Exchange {
+  PriceLevelPublisher::PriceLevelPublisher(MDPMarketUpdateLFQueue *market_updates, const std::string &iface, const std::string &ip, int port,
+                                           const EngineLimits &limits, const std::string &log_file_name)
+      : market_updates_(market_updates), logger_(log_file_name), socket_(logger_), max_order_ids_(limits.max_order_ids_), tickers_(limits.max_tickers_) {
+    ASSERT(socket_.init(ip, iface, port, /*is_listening*/ false) >= 0,
+           "Unable to create price level mcast socket. error:" + std::string(std::strerror(errno)));
+
+    for (TickerId ticker_id = 0; ticker_id < tickers_.size(); ++ticker_id) {
+      auto &ticker = tickers_[ticker_id];
+      ticker.bids_.reserve(limits.max_price_levels_);
+      ticker.asks_.reserve(limits.max_price_levels_);
+      ticker.orders_.reserve(max_order_ids_);
+      ticker.published_.ticker_id_ = ticker_id;
+    }
+    updated_tickers_.reserve(tickers_.size());
+  }
+
+  PriceLevelPublisher::~PriceLevelPublisher() {
+    stop();
+  }
+
+  /// Start and stop the price level publisher thread.
+  auto PriceLevelPublisher::start() -> void {
+    run_ = true;
+    ASSERT(Common::createAndStartThread(-1, "Exchange/PriceLevelPublisher", [this]() { run(); }) != nullptr,
+           "Failed to start PriceLevelPublisher thread.");
+  }
+
+  auto PriceLevelPublisher::stop() -> void {
+    run_ = false;
+  }
+
+  /// Main method for this thread - applies the incremental updates forwarded by the market data publisher and publishes the tickers changed by them.
+  /// Everything queued up since the last iteration is applied before publishing, so the busier the incremental stream the more updates are conflated.
+  auto PriceLevelPublisher::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
+    while (run_) {
+      for (auto market_update = market_updates_->getNextToRead(); market_updates_->size() && market_update; market_update = market_updates_->getNextToRead()) {
+        addUpdate(market_update);
+        market_updates_->updateReadIndex();
+      }
+
+      publishLevels();
+    }
+  }
+
+  /// Apply an incremental market update to the aggregated price levels of its ticker.
+  auto PriceLevelPublisher::addUpdate(const MDPMarketUpdate *market_update) noexcept -> void {
+    const auto &me_market_update = market_update->me_market_update_;
+    auto &ticker = tickers_.at(me_market_update.ticker_id_);
+    auto &orders = ticker.orders_;
+    switch (me_market_update.type_) {
+      case MarketUpdateType::ADD: {
+        if (UNLIKELY(me_market_update.order_id_ >= orders.size())) {
+          if (UNLIKELY(me_market_update.order_id_ >= max_order_ids_))
+            FATAL("Order id beyond limits:" + me_market_update.toString());
+          orders.resize(std::min(max_order_ids_, std::max<size_t>(me_market_update.order_id_ + 1, 2 * orders.size())));
+        }
+        orders[me_market_update.order_id_] = {me_market_update.price_, me_market_update.qty_, me_market_update.side_};
+        updateLevel(me_market_update.side_ == Side::BUY ? ticker.bids_ : ticker.asks_, me_market_update.side_, me_market_update.price_,
+                    me_market_update.qty_, 1);
+      }
+        break;
+      case MarketUpdateType::MODIFY:
+      case MarketUpdateType::CANCEL: {
+        if (UNLIKELY(me_market_update.order_id_ >= orders.size() || !orders[me_market_update.order_id_].qty_))
+          FATAL("Received:" + me_market_update.toString() + " but order does not exist.");
+        auto &order = orders[me_market_update.order_id_];
+        auto &levels = (order.side_ == Side::BUY ? ticker.bids_ : ticker.asks_);
+
+        if (me_market_update.type_ == MarketUpdateType::MODIFY && me_market_update.price_ == order.price_) {
+          updateLevel(levels, order.side_, order.price_, static_cast<int64_t>(me_market_update.qty_) - order.qty_, 0);
+          order.qty_ = me_market_update.qty_;
+        } else {
+          updateLevel(levels, order.side_, order.price_, -static_cast<int64_t>(order.qty_), -1);
+          order.qty_ = 0;
+          if (me_market_update.type_ == MarketUpdateType::MODIFY) {
+            order = {me_market_update.price_, me_market_update.qty_, order.side_};
+            updateLevel(levels, order.side_, order.price_, order.qty_, 1);
+          }
+        }
+      }
+        break;
+      case MarketUpdateType::TRADE: // the passive orders filled are modified or cancelled by the updates following the trade.
+      case MarketUpdateType::SNAPSHOT_START:
+      case MarketUpdateType::CLEAR:
+      case MarketUpdateType::SNAPSHOT_END:
+      case MarketUpdateType::INVALID:
+        return;
+    }
+
+    ticker.ticker_seq_num_ = market_update->ticker_seq_num_;
+    if (!ticker.updated_) {
+      ticker.updated_ = true;
+      updated_tickers_.push_back(me_market_update.ticker_id_);
+    }
+  }
+
+  /// Add qty and num_orders to the level at price, creating it if needed and removing it once it has no orders left.
+  auto PriceLevelPublisher::updateLevel(std::vector<MDPPriceLevel> &levels, Side side, Price price, int64_t qty, int32_t num_orders) noexcept -> void {
+    // Sorted worst to best - ascending bid prices and descending ask prices.
+    auto itr = std::lower_bound(levels.begin(), levels.end(), price, [side](const MDPPriceLevel &level, Price price) {
+      return (side == Side::BUY ? level.price_ < price : level.price_ > price);
+    });
+    if (itr == levels.end() || itr->price_ != price)
+      itr = levels.insert(itr, {price, 0, 0});
+
+    itr->qty_ = static_cast<Qty>(itr->qty_ + qty);
+    itr->num_orders_ = static_cast<uint32_t>(itr->num_orders_ + num_orders);
+    if (!itr->num_orders_)
+      levels.erase(itr);
+  }
+
+  /// Copy the top MDP_PRICE_LEVELS levels best first.
+  auto PriceLevelPublisher::topLevels(const std::vector<MDPPriceLevel> &levels, MDPPriceLevel *top_levels) noexcept -> void {
+    const auto num_levels = std::min(levels.size(), MDP_PRICE_LEVELS);
+    for (size_t i = 0; i < num_levels; ++i)
+      top_levels[i] = levels[levels.size() - 1 - i];
+    for (size_t i = num_levels; i < MDP_PRICE_LEVELS; ++i)
+      top_levels[i] = {};
+  }
+
+  /// Publish the top levels of the tickers updated since the last call, if they changed. Returns the number of price level updates published.
+  auto PriceLevelPublisher::publishLevels() noexcept -> size_t {
+    size_t num_published = 0;
+    for (const auto ticker_id: updated_tickers_) {
+      auto &ticker = tickers_[ticker_id];
+      ticker.updated_ = false;
+
+      MDPPriceLevelUpdate update;
+      topLevels(ticker.bids_, update.bids_);
+      topLevels(ticker.asks_, update.asks_);
+      if (!memcmp(update.bids_, ticker.published_.bids_, sizeof(update.bids_)) && !memcmp(update.asks_, ticker.published_.asks_, sizeof(update.asks_)))
+        continue;
+
+      update.seq_num_ = next_seq_num_++;
+      update.ticker_seq_num_ = ticker.ticker_seq_num_;
+      update.ticker_id_ = ticker_id;
+      ticker.published_ = update;
+
+      socket_.send(&update, sizeof(update));
+      ++num_published;
+    }
+    updated_tickers_.clear();
+
+    if (num_published) {
+      logger_.log("%:% %() % Publishing % price level updates up to seq:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                  num_published, next_seq_num_ - 1);
+      socket_.sendAndRecv();
+    }
+
+    return num_published;
+  }
+}
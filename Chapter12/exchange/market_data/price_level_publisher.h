@@ -0,0 +1,99 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/thread_utils.h"
+#include "common/lf_queue.h"
+#include "common/macros.h"
+#include "common/mcast_socket.h"
+#include "common/logging.h"
+
+#include "market_data/market_update.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Maintains the aggregated price levels of every ticker's book from the incremental market updates and publishes a conflated market by price feed
+  /// of their top MDP_PRICE_LEVELS levels, for clients which do not need the order by order feed and the full order book it takes to follow it.
+  class PriceLevelPublisher {
+  public:
+    PriceLevelPublisher(MDPMarketUpdateLFQueue *market_updates, const std::string &iface, const std::string &ip, int port, const EngineLimits &limits,
+                        const std::string &log_file_name = "exchange_price_level_publisher.log");
+
+    ~PriceLevelPublisher();
+
+    /// Start and stop the price level publisher thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Apply an incremental market update to the aggregated price levels of its ticker.
+    auto addUpdate(const MDPMarketUpdate *market_update) noexcept -> void;
+
+    /// Publish the top levels of the tickers updated since the last call, if they changed. Returns the number of price level updates published.
+    auto publishLevels() noexcept -> size_t;
+
+    /// Main method for this thread - applies the incremental updates forwarded by the market data publisher and publishes the tickers changed by them.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    PriceLevelPublisher() = delete;
+
+    PriceLevelPublisher(const PriceLevelPublisher &) = delete;
+
+    PriceLevelPublisher(const PriceLevelPublisher &&) = delete;
+
+    PriceLevelPublisher &operator=(const PriceLevelPublisher &) = delete;
+
+    PriceLevelPublisher &operator=(const PriceLevelPublisher &&) = delete;
+
+  private:
+    /// Lock free queue containing incremental market data updates coming in from the market data publisher.
+    MDPMarketUpdateLFQueue *market_updates_ = nullptr;
+
+    volatile bool run_ = false;
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Multicast socket for the price level stream.
+    Common::McastSocket socket_;
+    size_t next_seq_num_ = 1;
+
+    const size_t max_order_ids_;
+
+    /// Price, side and remaining quantity of a live order, needed to take it out of its level when it is modified or cancelled.
+    struct LiveOrder {
+      Price price_ = Price_INVALID;
+      Qty qty_ = 0;
+      Side side_ = Side::INVALID;
+    };
+
+    /// Aggregated book of one ticker. Levels are sorted worst to best, so the levels at the top of the book which change the most often are at the end of
+    /// the vectors where they are the cheapest to insert and erase.
+    struct TickerLevels {
+      std::vector<MDPPriceLevel> bids_, asks_;
+
+      /// Hash map from market order id -> LiveOrder, grows with the market order ids seen for this ticker within the max_order_ids_ reserved.
+      std::vector<LiveOrder> orders_;
+
+      size_t ticker_seq_num_ = 0;
+      bool updated_ = false;
+
+      /// Last price level update published for this ticker, to skip publishing when only levels below the top ones changed.
+      MDPPriceLevelUpdate published_;
+    };
+
+    /// Hash map from TickerId -> TickerLevels.
+    std::vector<TickerLevels> tickers_;
+
+    /// Tickers updated since the last publishLevels().
+    std::vector<TickerId> updated_tickers_;
+
+  private:
+    /// Add qty and num_orders to the level at price, creating it if needed and removing it once it has no orders left.
+    auto updateLevel(std::vector<MDPPriceLevel> &levels, Side side, Price price, int64_t qty, int32_t num_orders) noexcept -> void;
+
+    /// Copy the top MDP_PRICE_LEVELS levels best first.
+    static auto topLevels(const std::vector<MDPPriceLevel> &levels, MDPPriceLevel *top_levels) noexcept -> void;
+  };
+}
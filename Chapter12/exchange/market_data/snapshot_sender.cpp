@@ -0,0 +1,97 @@
+#include "snapshot_sender.h"
+
+namespace Exchange {
+  SnapshotSender::SnapshotSender(const std::string &iface, const std::string &snapshot_ip, int snapshot_port, const SnapshotCfg &cfg,
+                                 const std::string &log_file_name)
+      : msg_interval_(cfg.msgs_per_sec_ ? NANOS_TO_SECS / static_cast<Nanos>(cfg.msgs_per_sec_) : 0), logger_(log_file_name), snapshot_socket_(logger_) {
+    ASSERT(snapshot_socket_.init(snapshot_ip, iface, snapshot_port, /*is_listening*/ false) >= 0,
+           "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), cfg.toString());
+  }
+
+  SnapshotSender::~SnapshotSender() {
+    stop();
+  }
+
+  /// Start and stop the snapshot sender thread.
+  auto SnapshotSender::start() -> void {
+    run_ = true;
+    sender_thread_ = Common::createAndStartThread(-1, "Exchange/SnapshotSender", [this]() { run(); });
+    ASSERT(sender_thread_ != nullptr, "Failed to start SnapshotSender thread.");
+  }
+
+  /// Stopping abandons a snapshot which is still being sent out.
+  auto SnapshotSender::stop() -> void {
+    run_ = false;
+
+    if (sender_thread_) {
+      sender_thread_->join();
+      delete sender_thread_;
+      sender_thread_ = nullptr;
+    }
+  }
+
+  /// Main loop for this thread - sends out the snapshot every time one is published.
+  auto SnapshotSender::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+
+    using namespace std::literals::chrono_literals;
+    while (run_) {
+      if (pending_)
+        send();
+      else
+        std::this_thread::sleep_for(1ms); // snapshots are seconds apart, no need to spin on a core for them.
+    }
+  }
+
+  /// Sort the live orders of every ticker in the snapshot buffer by side, price and priority and renumber them.
+  /// The snapshot synthesizer copies them in the order it keeps them in, which is not time priority once an order has been cancelled,
+  /// and a downstream consumer queues the orders of a price level in the order they arrive in.
+  auto SnapshotSender::sortOrders() noexcept -> void {
+    auto &updates = snapshot_.updates_;
+    for (size_t i = 0; i < updates.size(); ++i) {
+      if (updates[i].me_market_update_.type_ != MarketUpdateType::CLEAR)
+        continue;
+
+      auto end = i + 1;
+      while (end < updates.size() && updates[end].me_market_update_.type_ != MarketUpdateType::SNAPSHOT_END)
+        ++end;
+
+      std::sort(updates.begin() + i + 1, updates.begin() + end, [](const MDPMarketUpdate &lhs, const MDPMarketUpdate &rhs) {
+        const auto &l = lhs.me_market_update_, &r = rhs.me_market_update_;
+        return std::tie(l.side_, l.price_, l.priority_) < std::tie(r.side_, r.price_, r.priority_);
+      });
+      for (auto j = i + 1; j < end; ++j)
+        updates[j].seq_num_ = updates[j - 1].seq_num_ + 1;
+
+      i = end;
+    }
+  }
+
+  /// Publish the snapshot of every ticker in the snapshot buffer on the snapshot multicast stream.
+  auto SnapshotSender::send() noexcept -> void {
+    const auto start_time = getCurrentNanos();
+    auto next_send_time = start_time;
+
+    sortOrders();
+
+    // Spread the messages out evenly at the configured rate.
+    for (const auto &market_update: snapshot_.updates_) {
+      if (!run_)
+        return;
+
+      next_send_time += msg_interval_;
+      while (getCurrentNanos() < next_send_time);
+
+      logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), market_update.toString());
+      snapshot_socket_.send(&market_update, sizeof(MDPMarketUpdate));
+      snapshot_socket_.sendAndRecv();
+    }
+
+    logger_.log("%:% %() % Published snapshot of % messages in % ns.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                snapshot_.updates_.size(), getCurrentNanos() - start_time);
+
+    ++num_snapshots_;
+    pending_ = false;
+  }
+}
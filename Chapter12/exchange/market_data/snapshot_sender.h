@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+
+#include "common/types.h"
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/mcast_socket.h"
+#include "common/logging.h"
+
+#include "market_data/market_update.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// How often each ticker is snapshotted and how fast snapshots are sent out on the snapshot multicast stream.
+  struct SnapshotCfg {
+    /// Interval between two snapshots of a ticker, unless ticker_intervals_ has a non-zero entry for that TickerId.
+    /// Every ticker is snapshotted on its own, so tickers can be given different intervals.
+    Nanos interval_ = 60 * NANOS_TO_SECS;
+    std::vector<Nanos> ticker_intervals_;
+
+    /// Rate at which snapshot messages are paced onto the snapshot multicast stream, 0 sends them as fast as possible.
+    size_t msgs_per_sec_ = 200000;
+
+    auto tickerInterval(TickerId ticker_id) const noexcept {
+      return (ticker_id < ticker_intervals_.size() && ticker_intervals_[ticker_id] ? ticker_intervals_[ticker_id] : interval_);
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "SnapshotCfg{"
+         << "interval:" << interval_ << " "
+         << "ticker-intervals:[";
+      for (size_t ticker_id = 0; ticker_id < ticker_intervals_.size(); ++ticker_id) {
+        if (ticker_intervals_[ticker_id])
+          ss << ticker_id << ":" << ticker_intervals_[ticker_id] << " ";
+      }
+      ss << "] "
+         << "msgs/sec:" << msgs_per_sec_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Copy of the snapshot limit order books taken by the snapshot synthesizer, ready to be sent out.
+  /// updates_ holds one SNAPSHOT_START, CLEAR, live orders, SNAPSHOT_END run for every ticker in the snapshot, each run is numbered from 0.
+  /// The live orders are in no particular order until the sender thread sorts them into time priority before sending them.
+  struct Snapshot {
+    std::vector<MDPMarketUpdate> updates_;
+  };
+
+  /// Sends snapshots taken by the snapshot synthesizer on the snapshot multicast stream on its own thread, paced at SnapshotCfg::msgs_per_sec_,
+  /// so that the snapshot synthesizer only pays for copying the live orders and keeps draining incremental updates while a snapshot goes out.
+  /// Holds a single Snapshot buffer, the snapshot synthesizer skips taking a new snapshot while the previous one is still being sent.
+  class SnapshotSender {
+  public:
+    SnapshotSender(const std::string &iface, const std::string &snapshot_ip, int snapshot_port, const SnapshotCfg &cfg, const std::string &log_file_name);
+
+    ~SnapshotSender();
+
+    /// Start and stop the snapshot sender thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main loop for this thread - sends out the snapshot every time one is published.
+    auto run() noexcept -> void;
+
+    /// Returns the snapshot buffer for the snapshot synthesizer to fill in, or nullptr if the previous snapshot has not been sent out yet.
+    auto acquire() noexcept -> Snapshot * {
+      return (pending_ ? nullptr : &snapshot_);
+    }
+
+    /// Hand the snapshot buffer filled in after acquire() over to the sender thread.
+    auto publish() noexcept {
+      pending_ = true;
+    }
+
+    /// Number of snapshots sent out so far.
+    auto numSnapshots() const noexcept {
+      return num_snapshots_.load();
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    SnapshotSender() = delete;
+
+    SnapshotSender(const SnapshotSender &) = delete;
+
+    SnapshotSender(const SnapshotSender &&) = delete;
+
+    SnapshotSender &operator=(const SnapshotSender &) = delete;
+
+    SnapshotSender &operator=(const SnapshotSender &&) = delete;
+
+  private:
+    /// Nanoseconds between two snapshot messages at SnapshotCfg::msgs_per_sec_, 0 if not paced.
+    const Nanos msg_interval_;
+
+    volatile bool run_ = false;
+    std::thread *sender_thread_ = nullptr;
+
+    /// Set by the snapshot synthesizer when snapshot_ is ready to be sent and cleared by the sender thread once it has been.
+    std::atomic<bool> pending_ = {false};
+    Snapshot snapshot_;
+
+    std::atomic<size_t> num_snapshots_ = {0};
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Multicast socket for the snapshot multicast stream.
+    McastSocket snapshot_socket_;
+
+  private:
+    auto sortOrders() noexcept -> void;
+
+    auto send() noexcept -> void;
+  };
+}
@@ -2,20 +2,26 @@
 
 namespace Exchange {
   SnapshotSynthesizer::SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
-                                           const std::string &snapshot_ip, int snapshot_port)
-      : snapshot_md_updates_(market_updates), logger_("exchange_snapshot_synthesizer.log"), snapshot_socket_(logger_), order_pool_(ME_MAX_ORDER_IDS) {
-    ASSERT(snapshot_socket_.init(snapshot_ip, iface, snapshot_port, /*is_listening*/ false) >= 0,
-           "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
-    for(auto& orders : ticker_orders_)
-      orders.fill(nullptr);
+                                           const std::string &snapshot_ip, int snapshot_port, const EngineLimits &limits, const SnapshotCfg &cfg,
+                                           const std::string &log_file_name)
+      : snapshot_md_updates_(market_updates), logger_(log_file_name), cfg_(cfg),
+        snapshot_sender_(iface, snapshot_ip, snapshot_port, cfg, log_file_name.empty() ? "" : "exchange_snapshot_sender.log"),
+        max_order_ids_(limits.max_order_ids_), ticker_orders_(limits.max_tickers_), ticker_order_slots_(limits.max_tickers_),
+        ticker_last_seq_num_(limits.max_tickers_, 0), ticker_next_snapshot_time_(limits.max_tickers_, 0) {
+    for (TickerId ticker_id = 0; ticker_id < limits.max_tickers_; ++ticker_id) {
+      ticker_orders_[ticker_id].reserve(max_order_ids_);
+      ticker_order_slots_[ticker_id].reserve(max_order_ids_);
+    }
   }
 
   SnapshotSynthesizer::~SnapshotSynthesizer() {
     stop();
   }
 
-  /// Start and stop the snapshot synthesizer thread.
+  /// Start and stop the snapshot synthesizer thread and the snapshot sender thread.
   void SnapshotSynthesizer::start() {
+    snapshot_sender_.start();
+
     run_ = true;
     ASSERT(Common::createAndStartThread(-1, "Exchange/SnapshotSynthesizer", [this]() { run(); }) != nullptr,
            "Failed to start SnapshotSynthesizer thread.");
@@ -23,37 +29,57 @@ namespace Exchange {
 
   void SnapshotSynthesizer::stop() {
     run_ = false;
+
+    snapshot_sender_.stop();
   }
 
   /// Process an incremental market update and update the limit order book snapshot.
-  auto SnapshotSynthesizer::addToSnapshot(const MDPMarketUpdate *market_update) {
+  auto SnapshotSynthesizer::addToSnapshot(const MDPMarketUpdate *market_update) -> void {
     const auto &me_market_update = market_update->me_market_update_;
-    auto *orders = &ticker_orders_.at(me_market_update.ticker_id_);
+    auto &orders = ticker_orders_.at(me_market_update.ticker_id_);
+    auto &order_slots = ticker_order_slots_.at(me_market_update.ticker_id_);
     switch (me_market_update.type_) {
       case MarketUpdateType::ADD: {
-        auto order = orders->at(me_market_update.order_id_);
-        ASSERT(order == nullptr, "Received:" + me_market_update.toString() + " but order already exists:" + (order ? order->toString() : ""));
-        orders->at(me_market_update.order_id_) = order_pool_.allocate(me_market_update);
+        if (UNLIKELY(order_slots.empty()))
+          live_tickers_.push_back(me_market_update.ticker_id_);
+
+        if (UNLIKELY(me_market_update.order_id_ >= order_slots.size())) {
+          if (UNLIKELY(me_market_update.order_id_ >= max_order_ids_))
+            FATAL("Order id beyond limits:" + me_market_update.toString());
+          order_slots.resize(std::min(max_order_ids_, std::max<size_t>(me_market_update.order_id_ + 1, 2 * order_slots.size())), OrderSlot_INVALID);
+        }
+        auto &slot = order_slots[me_market_update.order_id_];
+        if (UNLIKELY(slot != OrderSlot_INVALID))
+          FATAL("Received:" + me_market_update.toString() + " but order already exists:" + orders[slot].toString());
+
+        slot = orders.size();
+        orders.push_back(me_market_update);
       }
         break;
       case MarketUpdateType::MODIFY: {
-        auto order = orders->at(me_market_update.order_id_);
-        ASSERT(order != nullptr, "Received:" + me_market_update.toString() + " but order does not exist.");
-        ASSERT(order->order_id_ == me_market_update.order_id_, "Expecting existing order to match new one.");
-        ASSERT(order->side_ == me_market_update.side_, "Expecting existing order to match new one.");
-
-        order->qty_ = me_market_update.qty_;
-        order->price_ = me_market_update.price_;
+        const auto slot = (me_market_update.order_id_ < order_slots.size() ? order_slots[me_market_update.order_id_] : OrderSlot_INVALID);
+        if (UNLIKELY(slot == OrderSlot_INVALID))
+          FATAL("Received:" + me_market_update.toString() + " but order does not exist.");
+        auto &order = orders[slot];
+        ASSERT(order.side_ == me_market_update.side_, "Expecting existing order to match new one.");
+
+        order.qty_ = me_market_update.qty_;
+        order.price_ = me_market_update.price_;
       }
         break;
       case MarketUpdateType::CANCEL: {
-        auto order = orders->at(me_market_update.order_id_);
-        ASSERT(order != nullptr, "Received:" + me_market_update.toString() + " but order does not exist.");
-        ASSERT(order->order_id_ == me_market_update.order_id_, "Expecting existing order to match new one.");
-        ASSERT(order->side_ == me_market_update.side_, "Expecting existing order to match new one.");
-
-        order_pool_.deallocate(order);
-        orders->at(me_market_update.order_id_) = nullptr;
+        if (UNLIKELY(me_market_update.order_id_ >= order_slots.size() || order_slots[me_market_update.order_id_] == OrderSlot_INVALID))
+          FATAL("Received:" + me_market_update.toString() + " but order does not exist.");
+        auto &slot = order_slots[me_market_update.order_id_];
+        ASSERT(orders[slot].side_ == me_market_update.side_, "Expecting existing order to match new one.");
+
+        // Move the last live order into the freed slot so the live orders stay contiguous.
+        if (slot != orders.size() - 1) {
+          orders[slot] = orders.back();
+          order_slots[orders[slot].order_id_] = slot;
+        }
+        orders.pop_back();
+        slot = OrderSlot_INVALID;
       }
         break;
       case MarketUpdateType::SNAPSHOT_START:
@@ -66,48 +92,44 @@ namespace Exchange {
 
     ASSERT(market_update->seq_num_ == last_inc_seq_num_ + 1, "Expected incremental seq_nums to increase.");
     last_inc_seq_num_ = market_update->seq_num_;
+    ticker_last_seq_num_[me_market_update.ticker_id_] = market_update->ticker_seq_num_;
   }
 
-  /// Publish a full snapshot cycle on the snapshot multicast stream.
-  auto SnapshotSynthesizer::publishSnapshot() {
-    size_t snapshot_size = 0;
-
-    // The snapshot cycle starts with a SNAPSHOT_START message and order_id_ contains the last sequence number from the incremental market data stream used to build this snapshot.
-    const MDPMarketUpdate start_market_update{snapshot_size++, {MarketUpdateType::SNAPSHOT_START, last_inc_seq_num_}};
-    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), start_market_update.toString());
-    snapshot_socket_.send(&start_market_update, sizeof(MDPMarketUpdate));
-
-    // Publish order information for each order in the limit order book for each instrument.
-    for (size_t ticker_id = 0; ticker_id < ticker_orders_.size(); ++ticker_id) {
-      const auto &orders = ticker_orders_.at(ticker_id);
-
-      MEMarketUpdate me_market_update;
-      me_market_update.type_ = MarketUpdateType::CLEAR;
-      me_market_update.ticker_id_ = ticker_id;
-
-      // We start order information for each instrument by first publishing a CLEAR message so the downstream consumer can clear the order book.
-      const MDPMarketUpdate clear_market_update{snapshot_size++, me_market_update};
-      logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), clear_market_update.toString());
-      snapshot_socket_.send(&clear_market_update, sizeof(MDPMarketUpdate));
-
-      // Publish each order.
-      for (const auto order: orders) {
-        if (order) {
-          const MDPMarketUpdate market_update{snapshot_size++, *order};
-          logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), market_update.toString());
-          snapshot_socket_.send(&market_update, sizeof(MDPMarketUpdate));
-          snapshot_socket_.sendAndRecv();
-        }
-      }
+  /// Copy the live orders of every ticker due for a snapshot at time now and hand them to the snapshot sender.
+  /// Returns false without taking a snapshot if the previous one is still being sent out or no ticker is due.
+  auto SnapshotSynthesizer::takeSnapshot(Nanos now) -> bool {
+    auto snapshot = snapshot_sender_.acquire();
+    if (!snapshot)
+      return false;
+
+    // The snapshot buffer keeps its capacity from one snapshot to the next, so this is only a copy of the packed live orders once it has grown.
+    auto &updates = snapshot->updates_;
+    updates.clear();
+    for (const auto ticker_id: live_tickers_) {
+      if (now < ticker_next_snapshot_time_[ticker_id])
+        continue;
+      ticker_next_snapshot_time_[ticker_id] = now + cfg_.tickerInterval(ticker_id);
+
+      // Each ticker's snapshot is bracketed by SNAPSHOT_START and SNAPSHOT_END messages, order_id_ contains the last sequence number from the incremental
+      // market data stream and ticker_seq_num_ the last one for this ticker used to build it. The orders follow a CLEAR message so the downstream
+      // consumer can clear the order book.
+      const auto ticker_seq_num = ticker_last_seq_num_[ticker_id];
+      size_t snapshot_seq_num = 0;
+      updates.push_back({snapshot_seq_num++, ticker_seq_num, {MarketUpdateType::SNAPSHOT_START, last_inc_seq_num_, ticker_id}});
+      updates.push_back({snapshot_seq_num++, ticker_seq_num, {MarketUpdateType::CLEAR, OrderId_INVALID, ticker_id}});
+      for (const auto &order: ticker_orders_[ticker_id])
+        updates.push_back({snapshot_seq_num++, ticker_seq_num, order});
+      updates.push_back({snapshot_seq_num++, ticker_seq_num, {MarketUpdateType::SNAPSHOT_END, last_inc_seq_num_, ticker_id}});
     }
 
-    // The snapshot cycle ends with a SNAPSHOT_END message and order_id_ contains the last sequence number from the incremental market data stream used to build this snapshot.
-    const MDPMarketUpdate end_market_update{snapshot_size++, {MarketUpdateType::SNAPSHOT_END, last_inc_seq_num_}};
-    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), end_market_update.toString());
-    snapshot_socket_.send(&end_market_update, sizeof(MDPMarketUpdate));
-    snapshot_socket_.sendAndRecv();
+    if (updates.empty())
+      return false;
+
+    snapshot_sender_.publish();
 
-    logger_.log("%:% %() % Published snapshot of % orders.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), snapshot_size - 1);
+    logger_.log("%:% %() % Took snapshot of % messages at seq:% in % ns.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                updates.size(), last_inc_seq_num_, getCurrentNanos() - now);
+    return true;
   }
 
   /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
@@ -123,10 +145,7 @@ namespace Exchange {
         snapshot_md_updates_->updateReadIndex();
       }
 
-      if (getCurrentNanos() - last_snapshot_time_ > 60 * NANOS_TO_SECS) {
-        last_snapshot_time_ = getCurrentNanos();
-        publishSnapshot();
-      }
+      takeSnapshot(getCurrentNanos());
     }
   }
 }
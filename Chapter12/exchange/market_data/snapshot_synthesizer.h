@@ -4,11 +4,10 @@
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
-#include "common/mcast_socket.h"
-#include "common/mem_pool.h"
 #include "common/logging.h"
 
 #include "market_data/market_update.h"
+#include "market_data/snapshot_sender.h"
 #include "matcher/me_order.h"
 
 using namespace Common;
@@ -17,22 +16,28 @@ namespace Exchange {
   class SnapshotSynthesizer {
   public:
     SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
-                        const std::string &snapshot_ip, int snapshot_port);
+                        const std::string &snapshot_ip, int snapshot_port, const EngineLimits &limits, const SnapshotCfg &cfg = SnapshotCfg(),
+                        const std::string &log_file_name = "exchange_snapshot_synthesizer.log");
 
     ~SnapshotSynthesizer();
 
-    /// Start and stop the snapshot synthesizer thread.
+    /// Start and stop the snapshot synthesizer thread and the snapshot sender thread.
     auto start() -> void;
 
     auto stop() -> void;
 
     /// Process an incremental market update and update the limit order book snapshot.
-    auto addToSnapshot(const MDPMarketUpdate *market_update);
+    auto addToSnapshot(const MDPMarketUpdate *market_update) -> void;
 
-    /// Publish a full snapshot cycle on the snapshot multicast stream.
-    auto publishSnapshot();
+    /// Copy the live orders of every ticker due for a snapshot at time now and hand them to the snapshot sender.
+    /// Returns false without taking a snapshot if the previous one is still being sent out or no ticker is due.
+    auto takeSnapshot(Nanos now) -> bool;
 
-    /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
+    auto snapshotSender() noexcept -> SnapshotSender & {
+      return snapshot_sender_;
+    }
+
+    /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and takes snapshots periodically.
     auto run() -> void;
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -56,15 +61,32 @@ namespace Exchange {
 
     std::string time_str_;
 
-    /// Multicast socket for the snapshot multicast stream.
-    McastSocket snapshot_socket_;
+    const SnapshotCfg cfg_;
+
+    /// Sends the snapshots taken by this thread on the snapshot multicast stream.
+    SnapshotSender snapshot_sender_;
+
+    /// Marks a market order id which has no live order in ticker_order_slots_.
+    static constexpr size_t OrderSlot_INVALID = std::numeric_limits<size_t>::max();
 
     /// Hash map from TickerId -> Full limit order book snapshot containing information for every live order.
-    std::array<std::array<MEMarketUpdate *, ME_MAX_ORDER_IDS>, ME_MAX_TICKERS> ticker_orders_;
+    /// Live orders are kept densely packed, a cancelled order is replaced by the last one so a snapshot only visits live orders.
+    const size_t max_order_ids_;
+    std::vector<std::vector<MEMarketUpdate>> ticker_orders_;
+
+    /// Hash map from TickerId -> market order id -> index of the order in ticker_orders_, or OrderSlot_INVALID.
+    /// The index for a ticker grows with the market order ids seen for it, within the max_order_ids_ reserved for it upfront.
+    std::vector<std::vector<size_t>> ticker_order_slots_;
+
+    /// Tickers which have had at least one order, in the order they were first seen.
+    /// Only these are published in a snapshot, downstream consumers cannot have a book to clear for any other ticker.
+    std::vector<TickerId> live_tickers_;
     size_t last_inc_seq_num_ = 0;
-    Nanos last_snapshot_time_ = 0;
 
-    /// Memory pool to manage MEMarketUpdate messages for the orders in the snapshot limit order books.
-    MemPool<MEMarketUpdate> order_pool_;
+    /// Hash map from TickerId -> last incremental ticker_seq_num_ applied to the snapshot of that ticker.
+    std::vector<size_t> ticker_last_seq_num_;
+
+    /// Hash map from TickerId -> time the next snapshot of that ticker is due.
+    std::vector<Nanos> ticker_next_snapshot_time_;
   };
 }
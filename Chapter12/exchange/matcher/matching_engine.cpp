@@ -1,13 +1,16 @@
 #include "matching_engine.h"
 
+#include <unistd.h>
+
+#include "journal/journal_reader.h"
+
 namespace Exchange {
   MatchingEngine::MatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
-                                 MEMarketUpdateLFQueue *market_updates)
-      : incoming_requests_(client_requests), outgoing_ogw_responses_(client_responses), outgoing_md_updates_(market_updates),
-        logger_("exchange_matching_engine.log") {
-    for(size_t i = 0; i < ticker_order_book_.size(); ++i) {
-      ticker_order_book_[i] = new MEOrderBook(i, &logger_, this);
-    }
+                                 MEMarketUpdateLFQueue *market_updates, const std::string &log_file_name,
+                                 CheckpointWriter *checkpoint_writer, const EngineLimits &limits, const FillReportCfg &fill_report_cfg)
+      : order_book_pools_(limits), ticker_order_book_(limits.max_tickers_, nullptr), incoming_requests_(client_requests), outgoing_ogw_responses_(client_responses),
+        outgoing_md_updates_(market_updates), checkpoint_writer_(checkpoint_writer), fill_report_cfg_(fill_report_cfg), logger_(log_file_name) {
+    logger_.log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), limits.toString(), fill_report_cfg_.toString());
   }
 
   MatchingEngine::~MatchingEngine() {
@@ -19,6 +22,7 @@ namespace Exchange {
     incoming_requests_ = nullptr;
     outgoing_ogw_responses_ = nullptr;
     outgoing_md_updates_ = nullptr;
+    checkpoint_writer_ = nullptr;
 
     for(auto& order_book : ticker_order_book_) {
       delete order_book;
@@ -26,8 +30,21 @@ namespace Exchange {
     }
   }
 
+  /// Create the order book for a ticker seeing its first order, this only happens once per ticker.
+  auto MatchingEngine::createOrderBook(TickerId ticker_id) noexcept -> MEOrderBook * {
+    ASSERT(ticker_id < ticker_order_book_.size(), "Ticker:" + tickerIdToString(ticker_id) + " beyond max tickers:" +
+                                                  std::to_string(ticker_order_book_.size()));
+    auto order_book = new MEOrderBook(ticker_id, &logger_, this, &order_book_pools_);
+    ticker_order_book_[ticker_id] = order_book;
+
+    logger_.log("%:% %() % Created order book for ticker:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), ticker_id);
+
+    return order_book;
+  }
+
   /// Start and stop the matching engine main thread.
   auto MatchingEngine::start() -> void {
+    last_checkpoint_time_ = getCurrentNanos();
     run_ = true;
     ASSERT(Common::createAndStartThread(-1, "Exchange/MatchingEngine", [this]() { run(); }) != nullptr, "Failed to start MatchingEngine thread.");
   }
@@ -35,4 +52,79 @@ namespace Exchange {
   auto MatchingEngine::stop() -> void {
     run_ = false;
   }
+
+  /// Rebuild the order books from the latest checkpoint, if there is one, and then replay the journaled client requests sequenced after it.
+  auto MatchingEngine::recover(const CheckpointCfg &checkpoint_cfg, const JournalCfg &journal_cfg) -> void {
+    const auto start_time = getCurrentNanos();
+    recovering_ = true;
+
+    {
+      Checkpoint checkpoint;
+      if (loadCheckpointFile(checkpointFileName(checkpoint_cfg), &checkpoint)) {
+        size_t offset = 0;
+        ASSERT(checkpoint.books_.size() <= ticker_order_book_.size(), "Checkpoint has " + std::to_string(checkpoint.books_.size()) +
+                                                                      " books, more than the " + std::to_string(ticker_order_book_.size()) + " tickers configured.");
+        for (const auto &book: checkpoint.books_) {
+          auto order_book = ticker_order_book_.at(book.ticker_id_);
+          (order_book ? order_book : createOrderBook(book.ticker_id_))->restore(book, checkpoint.orders_.data() + offset);
+          offset += book.num_orders_;
+        }
+        last_seq_num_ = checkpoint.last_seq_num_;
+      }
+
+      logger_.log("%:% %() % Restored % orders up to seq:% from checkpoint:% in % ns.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), checkpoint.orders_.size(), last_seq_num_, checkpointFileName(checkpoint_cfg),
+                  getCurrentNanos() - start_time);
+    }
+
+    const auto checkpoint_seq_num = last_seq_num_;
+    for (size_t index = 0; access(journalFileName(journal_cfg, index).c_str(), F_OK) == 0; ++index) {
+      const JournalReader journal_reader(journalFileName(journal_cfg, index));
+      for (size_t i = 0; i < journal_reader.numRequests(); ++i) {
+        if (journal_reader.seqNum(i) <= last_seq_num_)
+          continue;
+
+        ASSERT(journal_reader.seqNum(i) == last_seq_num_ + 1, "Journal gap in:" + journalFileName(journal_cfg, index) +
+                                                               " expected seq:" + std::to_string(last_seq_num_ + 1) +
+                                                               " found:" + std::to_string(journal_reader.seqNum(i)));
+        processClientRequest(journal_reader.request(i));
+      }
+    }
+
+    recovering_ = false;
+    checkpoint_seq_num_ = last_seq_num_;
+
+    logger_.log("%:% %() % Recovered up to seq:% replaying % journaled requests. Total recovery time % ns.\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), last_seq_num_, last_seq_num_ - checkpoint_seq_num, getCurrentNanos() - start_time);
+  }
+
+  /// Copy the state of every order book into the provided checkpoint, tickers without an order book are left out.
+  auto MatchingEngine::checkpoint(Checkpoint *checkpoint) const noexcept -> void {
+    checkpoint->clear();
+    checkpoint->last_seq_num_ = last_seq_num_;
+    for (const auto order_book: ticker_order_book_) {
+      if (order_book) {
+        checkpoint->books_.emplace_back();
+        order_book->checkpoint(&checkpoint->books_.back(), &checkpoint->orders_);
+      }
+    }
+  }
+
+  /// Copy the order books into the checkpoint writer's buffer and hand it over, skipped if the previous checkpoint is still being written.
+  auto MatchingEngine::takeCheckpoint() noexcept -> void {
+    auto checkpoint_buffer = checkpoint_writer_->acquire();
+    if (!checkpoint_buffer)
+      return;
+
+    const auto start = Common::rdtsc();
+    checkpoint(checkpoint_buffer);
+    checkpoint_writer_->publish();
+    const auto cycles = Common::rdtsc() - start;
+
+    checkpoint_seq_num_ = last_seq_num_;
+    last_checkpoint_time_ = getCurrentNanos();
+
+    logger_.log("%:% %() % Took checkpoint seq:% orders:% in % cycles.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                checkpoint_seq_num_, checkpoint_buffer->orders_.size(), cycles);
+  }
 }
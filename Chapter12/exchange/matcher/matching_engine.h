@@ -7,15 +7,73 @@
 #include "order_server/client_request.h"
 #include "order_server/client_response.h"
 #include "market_data/market_update.h"
+#include "journal/journal_record.h"
+#include "journal/checkpoint_writer.h"
 
 #include "me_order_book.h"
 
 namespace Exchange {
+  /// How the fills of an aggressive order are reported to the client sending it, passive orders always get a FILLED per fill.
+  enum class FillReporting : uint8_t {
+    INVALID = 0,
+    /// A FILLED for every passive order matched.
+    PER_FILL = 1,
+    /// A FILLED for every price level matched, with the quantity filled at that price. Fills are not consolidated across price levels, a FILLED
+    /// carries a single price so the client could only be sent their average price and would not get the exact notional.
+    PER_PRICE_LEVEL = 2
+  };
+
+  inline auto fillReportingToString(FillReporting fill_reporting) -> std::string {
+    switch (fill_reporting) {
+      case FillReporting::PER_FILL:
+        return "PER_FILL";
+      case FillReporting::PER_PRICE_LEVEL:
+        return "PER_PRICE_LEVEL";
+      case FillReporting::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Fill reporting of the client sessions.
+  struct FillReportCfg {
+    /// Fill reporting of every client session, unless client_reporting_ has an entry other than INVALID for that ClientId.
+    FillReporting reporting_ = FillReporting::PER_FILL;
+    std::vector<FillReporting> client_reporting_;
+
+    auto clientReporting(ClientId client_id) const noexcept {
+      return (client_id < client_reporting_.size() && client_reporting_[client_id] != FillReporting::INVALID ? client_reporting_[client_id] : reporting_);
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "FillReportCfg{"
+         << "reporting:" << fillReportingToString(reporting_) << " "
+         << "client-reporting:[";
+      for (size_t client_id = 0; client_id < client_reporting_.size(); ++client_id) {
+        if (client_reporting_[client_id] != FillReporting::INVALID)
+          ss << client_id << ":" << fillReportingToString(client_reporting_[client_id]) << " ";
+      }
+      ss << "]"
+         << "}";
+
+      return ss.str();
+    }
+  };
+
   class MatchingEngine final {
   public:
+    /// An empty log_file_name disables logging in the matching engine and its order books.
+    /// Periodic checkpoints of the order books are handed to checkpoint_writer if one is provided.
+    /// The order book for a ticker is created the first time an order is added for it, up to limits.max_tickers_ tickers,
+    /// and all the order books draw their orders and price levels from the same pools sized as per limits.
     MatchingEngine(ClientRequestLFQueue *client_requests,
                    ClientResponseLFQueue *client_responses,
-                   MEMarketUpdateLFQueue *market_updates);
+                   MEMarketUpdateLFQueue *market_updates,
+                   const std::string &log_file_name = "exchange_matching_engine.log",
+                   CheckpointWriter *checkpoint_writer = nullptr,
+                   const EngineLimits &limits = EngineLimits(),
+                   const FillReportCfg &fill_report_cfg = FillReportCfg());
 
     ~MatchingEngine();
 
@@ -24,11 +82,37 @@ namespace Exchange {
 
     auto stop() -> void;
 
+    /// Rebuild the order books from the latest checkpoint, if there is one, and then replay the journaled client requests sequenced after it.
+    /// Client responses are not published while recovering, market updates are so that the market data publisher sees every live order.
+    /// Has to be called before start().
+    auto recover(const CheckpointCfg &checkpoint_cfg, const JournalCfg &journal_cfg) -> void;
+
+    /// Copy the state of every order book into the provided checkpoint, tickers without an order book are left out.
+    auto checkpoint(Checkpoint *checkpoint) const noexcept -> void;
+
+    /// How the fills of the client's aggressive orders are reported to it.
+    auto fillReporting(ClientId client_id) const noexcept {
+      return fill_report_cfg_.clientReporting(client_id);
+    }
+
+    /// Sequence number of the last client request processed, client requests are implicitly sequenced in the order they are processed.
+    auto lastSeqNum() const noexcept {
+      return last_seq_num_;
+    }
+
     /// Called to process a client request read from the lock free queue sent by the order server.
+    /// The order server drops client requests for TickerIds beyond limits.max_tickers_.
     auto processClientRequest(const MEClientRequest *client_request) noexcept {
+#if !defined(NDEBUG)
+      ASSERT(client_request->ticker_id_ < ticker_order_book_.size(), "Ticker:" + tickerIdToString(client_request->ticker_id_) + " beyond max tickers:" +
+                                                                     std::to_string(ticker_order_book_.size()));
+#endif
       auto order_book = ticker_order_book_[client_request->ticker_id_];
       switch (client_request->type_) {
         case ClientRequestType::NEW: {
+          if (UNLIKELY(!order_book))
+            order_book = createOrderBook(client_request->ticker_id_);
+
           START_MEASURE(Exchange_MEOrderBook_add);
           order_book->add(client_request->client_id_, client_request->order_id_, client_request->ticker_id_,
                            client_request->side_, client_request->price_, client_request->qty_);
@@ -38,7 +122,13 @@ namespace Exchange {
 
         case ClientRequestType::CANCEL: {
           START_MEASURE(Exchange_MEOrderBook_cancel);
-          order_book->cancel(client_request->client_id_, client_request->order_id_, client_request->ticker_id_);
+          if (LIKELY(order_book)) {
+            order_book->cancel(client_request->client_id_, client_request->order_id_, client_request->ticker_id_);
+          } else { // no order was ever added for this ticker so there is nothing to cancel.
+            client_response_ = {ClientResponseType::CANCEL_REJECTED, client_request->client_id_, client_request->ticker_id_, client_request->order_id_,
+                                OrderId_INVALID, Side::INVALID, Price_INVALID, Qty_INVALID, Qty_INVALID};
+            sendClientResponse(&client_response_);
+          }
           END_MEASURE(Exchange_MEOrderBook_cancel, logger_);
         }
           break;
@@ -48,11 +138,17 @@ namespace Exchange {
         }
           break;
       }
+
+      ++last_seq_num_;
     }
 
     /// Write client responses to the lock free queue for the order server to consume.
-    auto sendClientResponse(const MEClientResponse *client_response) noexcept {
-      logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), client_response->toString());
+    auto sendClientResponse(const MEClientResponse *client_response) noexcept -> void {
+      if (UNLIKELY(recovering_))
+        return;
+
+      if (logger_.enabled())
+        logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), client_response->toString());
       auto next_write = outgoing_ogw_responses_->getNextToWriteTo();
       *next_write = std::move(*client_response);
       outgoing_ogw_responses_->updateWriteIndex();
@@ -61,7 +157,14 @@ namespace Exchange {
 
     /// Write market data update to the lock free queue for the market data publisher to consume.
     auto sendMarketUpdate(const MEMarketUpdate *market_update) noexcept {
-      logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), market_update->toString());
+      // Recovery can publish far more market updates than fit in the lock free queue, so let the market data publisher catch up.
+      if (UNLIKELY(recovering_)) {
+        while (outgoing_md_updates_->size() >= outgoing_md_updates_->capacity() / 2)
+          std::this_thread::yield();
+      }
+
+      if (logger_.enabled())
+        logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), market_update->toString());
       auto next_write = outgoing_md_updates_->getNextToWriteTo();
       *next_write = *market_update;
       outgoing_md_updates_->updateWriteIndex();
@@ -76,12 +179,19 @@ namespace Exchange {
         if (LIKELY(me_client_request)) {
           TTT_MEASURE(T3_MatchingEngine_LFQueue_read, logger_);
 
-          logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                      me_client_request->toString());
+          if (logger_.enabled())
+            logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                        me_client_request->toString());
           START_MEASURE(Exchange_MatchingEngine_processClientRequest);
           processClientRequest(me_client_request);
           END_MEASURE(Exchange_MatchingEngine_processClientRequest, logger_);
           incoming_requests_->updateReadIndex();
+
+          if (checkpoint_writer_ && UNLIKELY(last_seq_num_ - checkpoint_seq_num_ >= checkpoint_writer_->cfg().interval_requests_))
+            takeCheckpoint();
+        } else if (checkpoint_writer_ && last_seq_num_ != checkpoint_seq_num_ &&
+                   getCurrentNanos() - last_checkpoint_time_ >= checkpoint_writer_->cfg().interval_) {
+          takeCheckpoint();
         }
       }
     }
@@ -98,7 +208,10 @@ namespace Exchange {
     MatchingEngine &operator=(const MatchingEngine &&) = delete;
 
   private:
-    /// Hash map container from TickerId -> MEOrderBook.
+    /// Order and price level memory pools shared by all the order books.
+    MEOrderBookPools order_book_pools_;
+
+    /// Hash map container from TickerId -> MEOrderBook, nullptr for tickers which have not had an order added yet.
     OrderBookHashMap ticker_order_book_;
 
     /// Lock free queues.
@@ -111,7 +224,28 @@ namespace Exchange {
 
     volatile bool run_ = false;
 
+    /// Sequence number of the last client request processed and whether those are being replayed from the journal.
+    size_t last_seq_num_ = 0;
+    bool recovering_ = false;
+
+    /// Checkpoints are copied on this thread and written to disk by the checkpoint writer, nullptr if checkpoints are disabled.
+    CheckpointWriter *checkpoint_writer_ = nullptr;
+    size_t checkpoint_seq_num_ = 0;
+    Nanos last_checkpoint_time_ = 0;
+
+    const FillReportCfg fill_report_cfg_;
+
+    /// Used to reject cancels for tickers which do not have an order book.
+    MEClientResponse client_response_;
+
     std::string time_str_;
     Logger logger_;
+
+  private:
+    /// Create the order book for a ticker seeing its first order, this only happens once per ticker.
+    auto createOrderBook(TickerId ticker_id) noexcept -> MEOrderBook *;
+
+    /// Copy the order books into the checkpoint writer's buffer and hand it over, skipped if the previous checkpoint is still being written.
+    auto takeCheckpoint() noexcept -> void;
   };
 }
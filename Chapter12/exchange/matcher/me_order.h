@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <vector>
 #include <sstream>
 #include "common/types.h"
 
@@ -34,10 +36,48 @@ namespace Exchange {
   };
 
   /// Hash map from OrderId -> MEOrder.
-  typedef std::array<MEOrder *, ME_MAX_ORDER_IDS> OrderHashMap;
+  typedef std::vector<MEOrder *> OrderHashMap;
 
   /// Hash map from ClientId -> OrderId -> MEOrder.
-  typedef std::array<OrderHashMap, ME_MAX_NUM_CLIENTS> ClientOrderHashMap;
+  typedef std::vector<OrderHashMap> ClientOrderHashMap;
+
+  /// Order id index of an MEOrderBook, a view of a ClientOrderHashMap which is shared by all the order books of a matching engine.
+  /// A client order id therefore identifies at most one live order of the client across all tickers, MEOrderBook::add() rejects a new order reusing a live one.
+  /// The OrderHashMap for a client grows with the order ids it uses within the capacity reserved upfront, so inserting never reallocates.
+  class ClientOrderIndex final {
+  public:
+    ClientOrderIndex(ClientOrderHashMap *cid_oid_to_order, size_t max_order_ids) noexcept
+        : cid_oid_to_order_(cid_oid_to_order), max_order_ids_(max_order_ids) {}
+
+    /// Return the live order with the provided client id and client order id, or nullptr if there is none.
+    auto find(ClientId client_id, OrderId client_order_id) const noexcept -> MEOrder * {
+      if (UNLIKELY(client_id >= cid_oid_to_order_->size()))
+        return nullptr;
+
+      const auto &oid_to_order = (*cid_oid_to_order_)[client_id];
+      return (client_order_id < oid_to_order.size() ? oid_to_order[client_order_id] : nullptr);
+    }
+
+    auto insert(MEOrder *order) noexcept -> void {
+      auto &oid_to_order = cid_oid_to_order_->at(order->client_id_);
+      if (UNLIKELY(order->client_order_id_ >= oid_to_order.size())) {
+        ASSERT(order->client_order_id_ < max_order_ids_, "Order id beyond limits:" + order->toString());
+        oid_to_order.resize(std::min(max_order_ids_, std::max<size_t>(order->client_order_id_ + 1, 2 * oid_to_order.size())), nullptr);
+      }
+      oid_to_order[order->client_order_id_] = order;
+    }
+
+    /// Only clears the slot if it still refers to this order, so that erasing an order never drops another live order from the index.
+    auto erase(const MEOrder *order) noexcept -> void {
+      auto &slot = cid_oid_to_order_->at(order->client_id_).at(order->client_order_id_);
+      if (LIKELY(slot == order))
+        slot = nullptr;
+    }
+
+  private:
+    ClientOrderHashMap *cid_oid_to_order_ = nullptr;
+    size_t max_order_ids_ = 0;
+  };
 
   /// Used by the matching engine to represent a price level in the limit order book.
   /// Internally maintains a list of MEOrder objects arranged in FIFO order.
@@ -45,7 +85,7 @@ namespace Exchange {
     Side side_ = Side::INVALID;
     Price price_ = Price_INVALID;
 
-    MEOrder *first_me_order_ = nullptr;
+    MEOrder *first_order_ = nullptr;
 
     /// MEOrdersAtPrice also serves as a node in a doubly linked list of price levels arranged in order from most aggressive to least aggressive price.
     MEOrdersAtPrice *prev_entry_ = nullptr;
@@ -54,22 +94,19 @@ namespace Exchange {
     /// Only needed for use with MemPool.
     MEOrdersAtPrice() = default;
 
-    MEOrdersAtPrice(Side side, Price price, MEOrder *first_me_order, MEOrdersAtPrice *prev_entry, MEOrdersAtPrice *next_entry)
-        : side_(side), price_(price), first_me_order_(first_me_order), prev_entry_(prev_entry), next_entry_(next_entry) {}
+    MEOrdersAtPrice(Side side, Price price, MEOrder *first_order, MEOrdersAtPrice *prev_entry, MEOrdersAtPrice *next_entry)
+        : side_(side), price_(price), first_order_(first_order), prev_entry_(prev_entry), next_entry_(next_entry) {}
 
     auto toString() const {
       std::stringstream ss;
       ss << "MEOrdersAtPrice["
          << "side:" << sideToString(side_) << " "
          << "price:" << priceToString(price_) << " "
-         << "first_me_order:" << (first_me_order_ ? first_me_order_->toString() : "null") << " "
+         << "first_order:" << (first_order_ ? first_order_->toString() : "null") << " "
          << "prev:" << priceToString(prev_entry_ ? prev_entry_->price_ : Price_INVALID) << " "
          << "next:" << priceToString(next_entry_ ? next_entry_->price_ : Price_INVALID) << "]";
 
       return ss.str();
     }
   };
-
-  /// Hash map from Price -> MEOrdersAtPrice.
-  typedef std::array<MEOrdersAtPrice *, ME_MAX_PRICE_LEVELS> OrdersAtPriceHashMap;
 }
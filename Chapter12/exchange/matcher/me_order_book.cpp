@@ -3,26 +3,37 @@
 #include "matcher/matching_engine.h"
 
 namespace Exchange {
-  MEOrderBook::MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine)
-      : ticker_id_(ticker_id), matching_engine_(matching_engine), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(ME_MAX_ORDER_IDS),
-        logger_(logger) {
+  /// Every live price level holds at least one live order, so there cannot be more live price levels than live orders.
+  MEOrderBookPools::MEOrderBookPools(const EngineLimits &limits)
+      : max_order_ids_(limits.max_order_ids_), max_price_levels_(limits.max_price_levels_), order_pool_(limits.max_order_ids_),
+        orders_at_price_pool_(std::min(limits.max_order_ids_, limits.max_tickers_ * limits.max_price_levels_)),
+        cid_oid_to_order_(limits.max_num_clients_) {
+    ASSERT(limits.isValid(), "Invalid " + limits.toString());
+    for (auto &oid_to_order: cid_oid_to_order_)
+      oid_to_order.reserve(max_order_ids_);
+  }
+
+  MEOrderBook::MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, MEOrderBookPools *pools)
+      : ticker_id_(ticker_id), matching_engine_(matching_engine), pools_(pools),
+        book_(&pools->order_pool_, &pools->orders_at_price_pool_, ClientOrderIndex(&pools->cid_oid_to_order_, pools->max_order_ids_),
+              pools->max_price_levels_), logger_(logger) {
   }
 
   MEOrderBook::~MEOrderBook() {
-    logger_->log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                toString(false, true));
+    if (logger_->enabled())
+      logger_->log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                   toString(false, true));
 
     matching_engine_ = nullptr;
-    bids_by_price_ = asks_by_price_ = nullptr;
-    for (auto &itr: cid_oid_to_order_) {
-      itr.fill(nullptr);
-    }
+    pools_ = nullptr;
   }
 
   /// Match a new aggressive order with the provided parameters against a passive order held in the bid_itr object and generate client responses and market updates for the match.
   /// It will update the passive order (bid_itr) based on the match and possibly remove it if fully matched.
   /// It will return remaining quantity on the aggressive order in the leaves_qty parameter.
-  auto MEOrderBook::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* itr, Qty* leaves_qty) noexcept {
+  /// The fill is reported to the aggressive order's client right away if aggressor_fills is nullptr, and added to aggressor_fills otherwise.
+  auto MEOrderBook::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* itr, Qty* leaves_qty,
+                          AggressorFills *aggressor_fills) noexcept {
     const auto order = itr;
     const auto order_qty = order->qty_;
     const auto fill_qty = std::min(*leaves_qty, order_qty);
@@ -30,9 +41,14 @@ namespace Exchange {
     *leaves_qty -= fill_qty;
     order->qty_ -= fill_qty;
 
-    client_response_ = {ClientResponseType::FILLED, client_id, ticker_id, client_order_id,
-                        new_market_order_id, side, itr->price_, fill_qty, *leaves_qty};
-    matching_engine_->sendClientResponse(&client_response_);
+    if (LIKELY(!aggressor_fills)) {
+      client_response_ = {ClientResponseType::FILLED, client_id, ticker_id, client_order_id,
+                          new_market_order_id, side, itr->price_, fill_qty, *leaves_qty};
+      matching_engine_->sendClientResponse(&client_response_);
+    } else {
+      aggressor_fills->price_ = itr->price_;
+      aggressor_fills->qty_ += fill_qty;
+    }
 
     client_response_ = {ClientResponseType::FILLED, order->client_id_, ticker_id, order->client_order_id_,
                         order->market_order_id_, order->side_, itr->price_, fill_qty, order->qty_};
@@ -47,7 +63,7 @@ namespace Exchange {
       matching_engine_->sendMarketUpdate(&market_update_);
 
       START_MEASURE(Exchange_MEOrderBook_removeOrder);
-      removeOrder(order);
+      book_.removeOrder(order);
       END_MEASURE(Exchange_MEOrderBook_removeOrder, (*logger_));
     } else {
       market_update_ = {MarketUpdateType::MODIFY, order->market_order_id_, ticker_id, order->side_,
@@ -58,40 +74,54 @@ namespace Exchange {
 
   /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
   /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
+  /// Unless the client is reported every fill, the fills of the new order are reported once it moves on to the next price level or once it is done matching.
   auto MEOrderBook::checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id) noexcept {
     auto leaves_qty = qty;
+    const auto fill_reporting = matching_engine_->fillReporting(client_id);
+    AggressorFills aggressor_fills;
+    const auto aggressor_fills_ptr = (LIKELY(fill_reporting == FillReporting::PER_FILL) ? nullptr : &aggressor_fills);
+
+    const auto passive_side = (side == Side::BUY ? Side::SELL : Side::BUY);
+    while (leaves_qty && book_.bestOrdersByPrice(passive_side)) {
+      const auto passive_itr = book_.bestOrdersByPrice(passive_side)->first_order_;
+      if (LIKELY((side == Side::BUY && price < passive_itr->price_) || (side == Side::SELL && price > passive_itr->price_))) {
+        break;
+      }
 
-    if (side == Side::BUY) {
-      while (leaves_qty && asks_by_price_) {
-        const auto ask_itr = asks_by_price_->first_me_order_;
-        if (LIKELY(price < ask_itr->price_)) {
-          break;
-        }
+      if (aggressor_fills.qty_ && passive_itr->price_ != aggressor_fills.price_)
+        reportAggressorFills(ticker_id, client_id, side, client_order_id, new_market_order_id, leaves_qty, &aggressor_fills);
 
-        START_MEASURE(Exchange_MEOrderBook_match);
-        match(ticker_id, client_id, side, client_order_id, new_market_order_id, ask_itr, &leaves_qty);
-        END_MEASURE(Exchange_MEOrderBook_match, (*logger_));
-      }
+      START_MEASURE(Exchange_MEOrderBook_match);
+      match(ticker_id, client_id, side, client_order_id, new_market_order_id, passive_itr, &leaves_qty, aggressor_fills_ptr);
+      END_MEASURE(Exchange_MEOrderBook_match, (*logger_));
     }
-    if (side == Side::SELL) {
-      while (leaves_qty && bids_by_price_) {
-        const auto bid_itr = bids_by_price_->first_me_order_;
-        if (LIKELY(price > bid_itr->price_)) {
-          break;
-        }
 
-        START_MEASURE(Exchange_MEOrderBook_match);
-        match(ticker_id, client_id, side, client_order_id, new_market_order_id, bid_itr, &leaves_qty);
-        END_MEASURE(Exchange_MEOrderBook_match, (*logger_));
-      }
-    }
+    if (aggressor_fills.qty_)
+      reportAggressorFills(ticker_id, client_id, side, client_order_id, new_market_order_id, leaves_qty, &aggressor_fills);
 
     return leaves_qty;
   }
 
+  /// Report the fills accumulated in aggressor_fills, all at the same price, to the aggressive order's client as one FILLED and reset it.
+  auto MEOrderBook::reportAggressorFills(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, Qty leaves_qty,
+                                         AggressorFills *aggressor_fills) noexcept -> void {
+    client_response_ = {ClientResponseType::FILLED, client_id, ticker_id, client_order_id,
+                        new_market_order_id, side, aggressor_fills->price_, aggressor_fills->qty_, leaves_qty};
+    matching_engine_->sendClientResponse(&client_response_);
+
+    *aggressor_fills = AggressorFills();
+  }
+
   /// Create and add a new order in the order book with provided attributes.
   /// It will check to see if this new order matches an existing passive order with opposite side, and perform the matching if that is the case.
+  /// A new order reusing the client order id of a live order of the client, on any ticker, is rejected.
   auto MEOrderBook::add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void {
+    if (UNLIKELY(book_.orderIndex().find(client_id, client_order_id))) {
+      client_response_ = {ClientResponseType::REJECTED, client_id, ticker_id, client_order_id, OrderId_INVALID, side, price, Qty_INVALID, Qty_INVALID};
+      matching_engine_->sendClientResponse(&client_response_);
+      return;
+    }
+
     const auto new_market_order_id = generateNewMarketOrderId();
     client_response_ = {ClientResponseType::ACCEPTED, client_id, ticker_id, client_order_id, new_market_order_id, side, price, 0, qty};
     matching_engine_->sendClientResponse(&client_response_);
@@ -101,12 +131,12 @@ namespace Exchange {
     END_MEASURE(Exchange_MEOrderBook_checkForMatch, (*logger_));
 
     if (LIKELY(leaves_qty)) {
-      const auto priority = getNextPriority(price);
+      const auto priority = book_.getNextPriority(price);
 
-      auto order = order_pool_.allocate(ticker_id, client_id, client_order_id, new_market_order_id, side, price, leaves_qty, priority, nullptr,
+      auto order = pools_->order_pool_.allocate(ticker_id, client_id, client_order_id, new_market_order_id, side, price, leaves_qty, priority, nullptr,
                                         nullptr);
       START_MEASURE(Exchange_MEOrderBook_addOrder);
-      addOrder(order);
+      book_.addOrder(order);
       END_MEASURE(Exchange_MEOrderBook_addOrder, (*logger_));
 
       market_update_ = {MarketUpdateType::ADD, new_market_order_id, ticker_id, side, price, leaves_qty, priority};
@@ -116,13 +146,9 @@ namespace Exchange {
 
   /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
   auto MEOrderBook::cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void {
-    auto is_cancelable = (client_id < cid_oid_to_order_.size());
-    MEOrder *exchange_order = nullptr;
-    if (LIKELY(is_cancelable)) {
-      auto &co_itr = cid_oid_to_order_.at(client_id);
-      exchange_order = co_itr.at(order_id);
-      is_cancelable = (exchange_order != nullptr);
-    }
+    const auto exchange_order = book_.orderIndex().find(client_id, order_id);
+    // The ClientId -> OrderId -> MEOrder hash map is shared by all the order books, so the order has to be on this ticker.
+    const auto is_cancelable = (exchange_order != nullptr && exchange_order->ticker_id_ == ticker_id_);
 
     if (UNLIKELY(!is_cancelable)) {
       client_response_ = {ClientResponseType::CANCEL_REJECTED, client_id, ticker_id, order_id, OrderId_INVALID,
@@ -134,7 +160,7 @@ namespace Exchange {
                         exchange_order->priority_};
 
       START_MEASURE(Exchange_MEOrderBook_removeOrder);
-      removeOrder(exchange_order);
+      book_.removeOrder(exchange_order);
       END_MEASURE(Exchange_MEOrderBook_removeOrder, (*logger_));
 
       matching_engine_->sendMarketUpdate(&market_update_);
@@ -143,6 +169,46 @@ namespace Exchange {
     matching_engine_->sendClientResponse(&client_response_);
   }
 
+  /// Append every live order to orders in priority order and fill in the rest of the book state into book.
+  auto MEOrderBook::checkpoint(CheckpointBookHeader *book, std::vector<CheckpointOrder> *orders) const noexcept -> void {
+    const auto start_size = orders->size();
+
+    for (auto best_orders_by_price: {book_.bestOrdersByPrice(Side::BUY), book_.bestOrdersByPrice(Side::SELL)}) {
+      auto orders_at_price = best_orders_by_price;
+      while (orders_at_price) {
+        for (auto order = orders_at_price->first_order_;; order = order->next_order_) {
+          orders->push_back({order->client_id_, order->client_order_id_, order->market_order_id_, order->side_,
+                             order->price_, order->qty_, order->priority_});
+          if (order->next_order_ == orders_at_price->first_order_)
+            break;
+        }
+
+        orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+      }
+    }
+
+    *book = {ticker_id_, next_market_order_id_, orders->size() - start_size};
+  }
+
+  /// Rebuild an empty order book from the state written by checkpoint(), publishing an ADD market update for every restored order.
+  auto MEOrderBook::restore(const CheckpointBookHeader &book, const CheckpointOrder *orders) noexcept -> void {
+    ASSERT(book.ticker_id_ == ticker_id_, "Checkpoint for ticker:" + tickerIdToString(book.ticker_id_) + " restored into book:" + tickerIdToString(ticker_id_));
+    ASSERT(!book_.bestOrdersByPrice(Side::BUY) && !book_.bestOrdersByPrice(Side::SELL), "Checkpoint restored into non-empty book:" + tickerIdToString(ticker_id_));
+
+    for (size_t i = 0; i < book.num_orders_; ++i) {
+      const auto &checkpoint_order = orders[i];
+      // Orders are stored in priority order, so appending each one to its price level rebuilds the same FIFO queues.
+      auto order = pools_->order_pool_.allocate(ticker_id_, checkpoint_order.client_id_, checkpoint_order.client_order_id_, checkpoint_order.market_order_id_,
+                                        checkpoint_order.side_, checkpoint_order.price_, checkpoint_order.qty_, checkpoint_order.priority_, nullptr, nullptr);
+      book_.addOrder(order);
+
+      market_update_ = {MarketUpdateType::ADD, order->market_order_id_, ticker_id_, order->side_, order->price_, order->qty_, order->priority_};
+      matching_engine_->sendMarketUpdate(&market_update_);
+    }
+
+    next_market_order_id_ = book.next_market_order_id_;
+  }
+
   auto MEOrderBook::toString(bool detailed, bool validity_check) const -> std::string {
     std::stringstream ss;
     std::string time_str;
@@ -152,17 +218,17 @@ namespace Exchange {
       Qty qty = 0;
       size_t num_orders = 0;
 
-      for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         qty += o_itr->qty_;
         ++num_orders;
-        if (o_itr->next_order_ == itr->first_me_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
       sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
               priceToString(itr->price_).c_str(), priceToString(itr->prev_entry_->price_).c_str(), priceToString(itr->next_entry_->price_).c_str(),
               priceToString(itr->price_).c_str(), qtyToString(qty).c_str(), std::to_string(num_orders).c_str());
       ss << buf;
-      for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         if (detailed) {
           sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
                   orderIdToString(o_itr->market_order_id_).c_str(), qtyToString(o_itr->qty_).c_str(),
@@ -170,7 +236,7 @@ namespace Exchange {
                   orderIdToString(o_itr->next_order_ ? o_itr->next_order_->market_order_id_ : OrderId_INVALID).c_str());
           ss << buf;
         }
-        if (o_itr->next_order_ == itr->first_me_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
 
@@ -186,11 +252,12 @@ namespace Exchange {
 
     ss << "Ticker:" << tickerIdToString(ticker_id_) << std::endl;
     {
-      auto ask_itr = asks_by_price_;
+      const auto asks_by_price = book_.bestOrdersByPrice(Side::SELL);
+      auto ask_itr = asks_by_price;
       auto last_ask_price = std::numeric_limits<Price>::min();
       for (size_t count = 0; ask_itr; ++count) {
         ss << "ASKS L:" << count << " => ";
-        auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price_ ? nullptr : ask_itr->next_entry_);
+        auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price ? nullptr : ask_itr->next_entry_);
         printer(ss, ask_itr, Side::SELL, last_ask_price, validity_check);
         ask_itr = next_ask_itr;
       }
@@ -199,11 +266,12 @@ namespace Exchange {
     ss << std::endl << "                          X" << std::endl << std::endl;
 
     {
-      auto bid_itr = bids_by_price_;
+      const auto bids_by_price = book_.bestOrdersByPrice(Side::BUY);
+      auto bid_itr = bids_by_price;
       auto last_bid_price = std::numeric_limits<Price>::max();
       for (size_t count = 0; bid_itr; ++count) {
         ss << "BIDS L:" << count << " => ";
-        auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price_ ? nullptr : bid_itr->next_entry_);
+        auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price ? nullptr : bid_itr->next_entry_);
         printer(ss, bid_itr, Side::BUY, last_bid_price, validity_check);
         bid_itr = next_bid_itr;
       }
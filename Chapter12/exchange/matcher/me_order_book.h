@@ -2,9 +2,11 @@
 
 #include "common/types.h"
 #include "common/mem_pool.h"
+#include "common/limit_order_book.h"
 #include "common/logging.h"
 #include "order_server/client_response.h"
 #include "market_data/market_update.h"
+#include "journal/checkpoint.h"
 
 #include "me_order.h"
 
@@ -13,9 +15,43 @@ using namespace Common;
 namespace Exchange {
   class MatchingEngine;
 
+  /// Memory shared by all the MEOrderBook instances of a matching engine, so that it is bounded by the number of live orders instead of the number of tickers.
+  struct MEOrderBookPools {
+    explicit MEOrderBookPools(const EngineLimits &limits);
+
+    /// Capacity of the per client OrderHashMap and number of price levels in each order book.
+    const size_t max_order_ids_;
+    const size_t max_price_levels_;
+
+    /// Memory pool to manage MEOrder objects.
+    MemPool<MEOrder> order_pool_;
+
+    /// Memory pool to manage MEOrdersAtPrice objects.
+    MemPool<MEOrdersAtPrice> orders_at_price_pool_;
+
+    /// Hash map from ClientId -> OrderId -> MEOrder across every order book, client order ids are unique per client and not per client and ticker.
+    /// The OrderHashMap for a client reserves max_order_ids_ upfront and grows with the order ids it uses within that capacity,
+    /// so that only address space is taken for the order ids not seen and memory is never reallocated while matching.
+    ClientOrderHashMap cid_oid_to_order_;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MEOrderBookPools() = delete;
+
+    MEOrderBookPools(const MEOrderBookPools &) = delete;
+
+    MEOrderBookPools(const MEOrderBookPools &&) = delete;
+
+    MEOrderBookPools &operator=(const MEOrderBookPools &) = delete;
+
+    MEOrderBookPools &operator=(const MEOrderBookPools &&) = delete;
+  };
+
+  /// Price level and FIFO queue maintenance shared with Trading::MarketOrderBook, MEOrderBook adds matching and publishing on top of it.
+  typedef LimitOrderBook<MEOrder, MEOrdersAtPrice, ClientOrderIndex> MELimitOrderBook;
+
   class MEOrderBook final {
   public:
-    explicit MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine);
+    MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, MEOrderBookPools *pools);
 
     ~MEOrderBook();
 
@@ -26,6 +62,12 @@ namespace Exchange {
     /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
     auto cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void;
 
+    /// Append every live order to orders in priority order and fill in the rest of the book state into book.
+    auto checkpoint(CheckpointBookHeader *book, std::vector<CheckpointOrder> *orders) const noexcept -> void;
+
+    /// Rebuild an empty order book from the state written by checkpoint(), publishing an ADD market update for every restored order.
+    auto restore(const CheckpointBookHeader &book, const CheckpointOrder *orders) noexcept -> void;
+
     auto toString(bool detailed, bool validity_check) const -> std::string;
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -45,21 +87,11 @@ namespace Exchange {
     /// The parent matching engine instance, used to publish market data and client responses.
     MatchingEngine *matching_engine_ = nullptr;
 
-    /// Hash map from ClientId -> OrderId -> MEOrder.
-    ClientOrderHashMap cid_oid_to_order_;
-
-    /// Memory pool to manage MEOrdersAtPrice objects.
-    MemPool<MEOrdersAtPrice> orders_at_price_pool_;
+    /// Order and price level memory pools and the ClientId -> OrderId -> MEOrder hash map, shared with the other order books.
+    MEOrderBookPools *pools_ = nullptr;
 
-    /// Pointers to beginning / best prices / top of book of buy and sell price levels.
-    MEOrdersAtPrice *bids_by_price_ = nullptr;
-    MEOrdersAtPrice *asks_by_price_ = nullptr;
-
-    /// Hash map from Price -> MEOrdersAtPrice.
-    OrdersAtPriceHashMap price_orders_at_price_;
-
-    /// Memory pool to manage MEOrder objects.
-    MemPool<MEOrder> order_pool_;
+    /// Price levels and FIFO queues of orders on both sides.
+    MELimitOrderBook book_;
 
     /// These are used to publish client responses and market updates.
     MEClientResponse client_response_;
@@ -67,6 +99,13 @@ namespace Exchange {
 
     OrderId next_market_order_id_ = 1;
 
+    /// Fills of the aggressive order at the price level being matched which have not been reported to its client yet, used unless the client is
+    /// reported every fill.
+    struct AggressorFills {
+      Price price_ = Price_INVALID;
+      Qty qty_ = 0;
+    };
+
     std::string time_str_;
     Logger *logger_ = nullptr;
 
@@ -75,147 +114,22 @@ namespace Exchange {
       return next_market_order_id_++;
     }
 
-    auto priceToIndex(Price price) const noexcept {
-      return (price % ME_MAX_PRICE_LEVELS);
-    }
-
-    /// Fetch and return the MEOrdersAtPrice corresponding to the provided price.
-    auto getOrdersAtPrice(Price price) const noexcept -> MEOrdersAtPrice * {
-      return price_orders_at_price_.at(priceToIndex(price));
-    }
-
-    /// Add a new MEOrdersAtPrice at the correct price into the containers - the hash map and the doubly linked list of price levels.
-    auto addOrdersAtPrice(MEOrdersAtPrice *new_orders_at_price) noexcept {
-      price_orders_at_price_.at(priceToIndex(new_orders_at_price->price_)) = new_orders_at_price;
-
-      const auto best_orders_by_price = (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_);
-      if (UNLIKELY(!best_orders_by_price)) {
-        (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) = new_orders_at_price;
-        new_orders_at_price->prev_entry_ = new_orders_at_price->next_entry_ = new_orders_at_price;
-      } else {
-        auto target = best_orders_by_price;
-        bool add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
-                          (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
-        if (add_after) {
-          target = target->next_entry_;
-          add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
-                       (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
-        }
-        while (add_after && target != best_orders_by_price) {
-          add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->price_) ||
-                       (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->price_));
-          if (add_after)
-            target = target->next_entry_;
-        }
-
-        if (add_after) { // add new_orders_at_price after target.
-          if (target == best_orders_by_price) {
-            target = best_orders_by_price->prev_entry_;
-          }
-          new_orders_at_price->prev_entry_ = target;
-          target->next_entry_->prev_entry_ = new_orders_at_price;
-          new_orders_at_price->next_entry_ = target->next_entry_;
-          target->next_entry_ = new_orders_at_price;
-        } else { // add new_orders_at_price before target.
-          new_orders_at_price->prev_entry_ = target->prev_entry_;
-          new_orders_at_price->next_entry_ = target;
-          target->prev_entry_->next_entry_ = new_orders_at_price;
-          target->prev_entry_ = new_orders_at_price;
-
-          if ((new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ > best_orders_by_price->price_) ||
-              (new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ < best_orders_by_price->price_)) {
-            target->next_entry_ = (target->next_entry_ == best_orders_by_price ? new_orders_at_price : target->next_entry_);
-            (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) = new_orders_at_price;
-          }
-        }
-      }
-    }
-
-    /// Remove the MEOrdersAtPrice from the containers - the hash map and the doubly linked list of price levels.
-    auto removeOrdersAtPrice(Side side, Price price) noexcept {
-      const auto best_orders_by_price = (side == Side::BUY ? bids_by_price_ : asks_by_price_);
-      auto orders_at_price = getOrdersAtPrice(price);
-
-      if (UNLIKELY(orders_at_price->next_entry_ == orders_at_price)) { // empty side of book.
-        (side == Side::BUY ? bids_by_price_ : asks_by_price_) = nullptr;
-      } else {
-        orders_at_price->prev_entry_->next_entry_ = orders_at_price->next_entry_;
-        orders_at_price->next_entry_->prev_entry_ = orders_at_price->prev_entry_;
-
-        if (orders_at_price == best_orders_by_price) {
-          (side == Side::BUY ? bids_by_price_ : asks_by_price_) = orders_at_price->next_entry_;
-        }
-
-        orders_at_price->prev_entry_ = orders_at_price->next_entry_ = nullptr;
-      }
-
-      price_orders_at_price_.at(priceToIndex(price)) = nullptr;
-
-      orders_at_price_pool_.deallocate(orders_at_price);
-    }
-
-    auto getNextPriority(Price price) noexcept {
-      const auto orders_at_price = getOrdersAtPrice(price);
-      if (!orders_at_price)
-        return 1lu;
-
-      return orders_at_price->first_me_order_->prev_order_->priority_ + 1;
-    }
-
     /// Match a new aggressive order with the provided parameters against a passive order held in the bid_itr object and generate client responses and market updates for the match.
     /// It will update the passive order (bid_itr) based on the match and possibly remove it if fully matched.
     /// It will return remaining quantity on the aggressive order in the leaves_qty parameter.
-    auto match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* bid_itr, Qty* leaves_qty) noexcept;
+    /// The fill is reported to the aggressive order's client right away if aggressor_fills is nullptr, and added to aggressor_fills otherwise.
+    auto match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* bid_itr, Qty* leaves_qty,
+               AggressorFills *aggressor_fills) noexcept;
+
+    /// Report the fills accumulated in aggressor_fills, all at the same price, to the aggressive order's client as one FILLED and reset it.
+    auto reportAggressorFills(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, Qty leaves_qty,
+                              AggressorFills *aggressor_fills) noexcept -> void;
 
     /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
     /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
     auto checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id) noexcept;
-
-    /// Remove and de-allocate provided order from the containers.
-    auto removeOrder(MEOrder *order) noexcept {
-      auto orders_at_price = getOrdersAtPrice(order->price_);
-
-      if (order->prev_order_ == order) { // only one element.
-        removeOrdersAtPrice(order->side_, order->price_);
-      } else { // remove the link.
-        const auto order_before = order->prev_order_;
-        const auto order_after = order->next_order_;
-        order_before->next_order_ = order_after;
-        order_after->prev_order_ = order_before;
-
-        if (orders_at_price->first_me_order_ == order) {
-          orders_at_price->first_me_order_ = order_after;
-        }
-
-        order->prev_order_ = order->next_order_ = nullptr;
-      }
-
-      cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = nullptr;
-      order_pool_.deallocate(order);
-    }
-
-    /// Add a single order at the end of the FIFO queue at the price level that this order belongs in.
-    auto addOrder(MEOrder *order) noexcept {
-      const auto orders_at_price = getOrdersAtPrice(order->price_);
-
-      if (!orders_at_price) {
-        order->next_order_ = order->prev_order_ = order;
-
-        auto new_orders_at_price = orders_at_price_pool_.allocate(order->side_, order->price_, order, nullptr, nullptr);
-        addOrdersAtPrice(new_orders_at_price);
-      } else {
-        auto first_order = (orders_at_price ? orders_at_price->first_me_order_ : nullptr);
-
-        first_order->prev_order_->next_order_ = order;
-        order->prev_order_ = first_order->prev_order_;
-        order->next_order_ = first_order;
-        first_order->prev_order_ = order;
-      }
-
-      cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = order;
-    }
   };
 
   /// A hash map from TickerId -> MEOrderBook.
-  typedef std::array<MEOrderBook *, ME_MAX_TICKERS> OrderBookHashMap;
+  typedef std::vector<MEOrderBook *> OrderBookHashMap;
 }
@@ -3,9 +3,9 @@
 #include "matcher/matching_engine.h"
 
 namespace Exchange {
-  UnorderedMapMEOrderBook::UnorderedMapMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine)
-      : ticker_id_(ticker_id), matching_engine_(matching_engine), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(ME_MAX_ORDER_IDS),
-        logger_(logger) {
+  UnorderedMapMEOrderBook::UnorderedMapMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, const EngineLimits &limits)
+      : ticker_id_(ticker_id), max_price_levels_(limits.max_price_levels_), matching_engine_(matching_engine),
+        orders_at_price_pool_(limits.max_price_levels_), order_pool_(limits.max_order_ids_), logger_(logger) {
   }
 
   UnorderedMapMEOrderBook::~UnorderedMapMEOrderBook() {
@@ -60,7 +60,7 @@ namespace Exchange {
 
     if (side == Side::BUY) {
       while (leaves_qty && asks_by_price_) {
-        const auto ask_itr = asks_by_price_->first_me_order_;
+        const auto ask_itr = asks_by_price_->first_order_;
         if (LIKELY(price < ask_itr->price_)) {
           break;
         }
@@ -72,7 +72,7 @@ namespace Exchange {
     }
     if (side == Side::SELL) {
       while (leaves_qty && bids_by_price_) {
-        const auto bid_itr = bids_by_price_->first_me_order_;
+        const auto bid_itr = bids_by_price_->first_order_;
         if (LIKELY(price > bid_itr->price_)) {
           break;
         }
@@ -149,17 +149,17 @@ namespace Exchange {
       Qty qty = 0;
       size_t num_orders = 0;
 
-      for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         qty += o_itr->qty_;
         ++num_orders;
-        if (o_itr->next_order_ == itr->first_me_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
       sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
               priceToString(itr->price_).c_str(), priceToString(itr->prev_entry_->price_).c_str(), priceToString(itr->next_entry_->price_).c_str(),
               priceToString(itr->price_).c_str(), qtyToString(qty).c_str(), std::to_string(num_orders).c_str());
       ss << buf;
-      for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         if (detailed) {
           sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
                   orderIdToString(o_itr->market_order_id_).c_str(), qtyToString(o_itr->qty_).c_str(),
@@ -167,7 +167,7 @@ namespace Exchange {
                   orderIdToString(o_itr->next_order_ ? o_itr->next_order_->market_order_id_ : OrderId_INVALID).c_str());
           ss << buf;
         }
-        if (o_itr->next_order_ == itr->first_me_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
 
@@ -17,7 +17,7 @@ namespace Exchange {
 
   class UnorderedMapMEOrderBook final {
   public:
-    explicit UnorderedMapMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine);
+    UnorderedMapMEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine, const EngineLimits &limits);
 
     ~UnorderedMapMEOrderBook();
 
@@ -44,6 +44,8 @@ namespace Exchange {
   private:
     TickerId ticker_id_ = TickerId_INVALID;
 
+    const size_t max_price_levels_;
+
     /// The parent matching engine instance, used to publish market data and client responses.
     MatchingEngine *matching_engine_ = nullptr;
 
@@ -78,7 +80,7 @@ namespace Exchange {
     }
 
     auto priceToIndex(Price price) const noexcept {
-      return (price % ME_MAX_PRICE_LEVELS);
+      return (price % static_cast<Price>(max_price_levels_));
     }
 
     /// Fetch and return the MEOrdersAtPrice corresponding to the provided price.
@@ -164,7 +166,7 @@ namespace Exchange {
       if (!orders_at_price)
         return 1lu;
 
-      return orders_at_price->first_me_order_->prev_order_->priority_ + 1;
+      return orders_at_price->first_order_->prev_order_->priority_ + 1;
     }
 
     /// Match a new aggressive order with the provided parameters against a passive order held in the bid_itr object and generate client responses and market updates for the match.
@@ -188,8 +190,8 @@ namespace Exchange {
         order_before->next_order_ = order_after;
         order_after->prev_order_ = order_before;
 
-        if (orders_at_price->first_me_order_ == order) {
-          orders_at_price->first_me_order_ = order_after;
+        if (orders_at_price->first_order_ == order) {
+          orders_at_price->first_order_ = order_after;
         }
 
         order->prev_order_ = order->next_order_ = nullptr;
@@ -209,7 +211,7 @@ namespace Exchange {
         auto new_orders_at_price = orders_at_price_pool_.allocate(order->side_, order->price_, order, nullptr, nullptr);
         addOrdersAtPrice(new_orders_at_price);
       } else {
-        auto first_order = (orders_at_price ? orders_at_price->first_me_order_ : nullptr);
+        auto first_order = (orders_at_price ? orders_at_price->first_order_ : nullptr);
 
         first_order->prev_order_->next_order_ = order;
         order->prev_order_ = first_order->prev_order_;
@@ -12,7 +12,11 @@ namespace Exchange {
   enum class ClientRequestType : uint8_t {
     INVALID = 0,
     NEW = 1,
-    CANCEL = 2
+    CANCEL = 2,
+    /// Internal to the order server, never sequenced - from a session group to the sequencer stage, asking for the client's session after a LOGON.
+    SESSION_MOVE = 3,
+    /// Internal to the order server, never sequenced - from a session group to the sequencer stage, the client's session was handed over.
+    SESSION_RELEASED = 4
   };
 
   inline std::string clientRequestTypeToString(ClientRequestType type) {
@@ -21,6 +25,10 @@ namespace Exchange {
         return "NEW";
       case ClientRequestType::CANCEL:
         return "CANCEL";
+      case ClientRequestType::SESSION_MOVE:
+        return "SESSION_MOVE";
+      case ClientRequestType::SESSION_RELEASED:
+        return "SESSION_RELEASED";
       case ClientRequestType::INVALID:
         return "INVALID";
     }
@@ -57,7 +65,7 @@ namespace Exchange {
     }
   };
 
-  /// Client request structure published over the network by the order gateway client.
+  /// Fixed width client request encoding previously published over the network by the order gateway client, superseded by client_wire.h.
   struct OMClientRequest {
     size_t seq_num_ = 0;
     MEClientRequest me_client_request_;
@@ -14,7 +14,15 @@ namespace Exchange {
     ACCEPTED = 1,
     CANCELED = 2,
     FILLED = 3,
-    CANCEL_REJECTED = 4
+    CANCEL_REJECTED = 4,
+    /// Request rejected by the order server for exceeding the client's message rate, it never reached the matching engine.
+    THROTTLED = 5,
+    /// Internal to the order server, never sent to the client - from the sequencer stage to the session group owning the client's session, hand it over.
+    SESSION_MOVED = 6,
+    /// Internal to the order server, never sent to the client - from the sequencer stage to a session group, take over the client's session.
+    SESSION_TAKEOVER = 7,
+    /// New order rejected by the matching engine because a live order of the client already uses its client order id.
+    REJECTED = 8
   };
 
   inline std::string clientResponseTypeToString(ClientResponseType type) {
@@ -27,6 +35,14 @@ namespace Exchange {
         return "FILLED";
       case ClientResponseType::CANCEL_REJECTED:
         return "CANCEL_REJECTED";
+      case ClientResponseType::THROTTLED:
+        return "THROTTLED";
+      case ClientResponseType::SESSION_MOVED:
+        return "SESSION_MOVED";
+      case ClientResponseType::SESSION_TAKEOVER:
+        return "SESSION_TAKEOVER";
+      case ClientResponseType::REJECTED:
+        return "REJECTED";
       case ClientResponseType::INVALID:
         return "INVALID";
     }
@@ -66,7 +82,7 @@ namespace Exchange {
     }
   };
 
-  /// Client response structure published over the network by the order server.
+  /// Fixed width client response encoding previously published over the network by the order server, superseded by client_wire.h.
   struct OMClientResponse {
     size_t seq_num_ = 0;
     MEClientResponse me_client_response_;
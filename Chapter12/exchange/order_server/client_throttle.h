@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+
+#include "common/macros.h"
+#include "common/time_utils.h"
+
+namespace Exchange {
+  /// Per ClientId message rate limit applied by the order server before requests reach the FIFO sequencer.
+  struct ThrottleLimits {
+    /// Sustained rate of client requests accepted per second, 0 disables throttling.
+    size_t msgs_per_sec_ = 100000;
+
+    /// Number of client requests which can be sent back to back after the client has been idle.
+    size_t burst_ = 1000;
+
+    auto enabled() const noexcept {
+      return (msgs_per_sec_ != 0);
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "ThrottleLimits{"
+         << "msgs/sec:" << msgs_per_sec_ << " "
+         << "burst:" << burst_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Token bucket which refills continuously at ThrottleLimits::msgs_per_sec_ up to ThrottleLimits::burst_ tokens.
+  /// Tokens are kept as nanoseconds of credit, every message costs the nanoseconds between two messages at the sustained rate,
+  /// so refilling is a subtraction of timestamps with no division on the critical path.
+  class TokenBucket final {
+  public:
+    explicit TokenBucket(const ThrottleLimits &limits) noexcept
+        : cost_(limits.enabled() ? NANOS_TO_SECS / static_cast<Nanos>(limits.msgs_per_sec_) : 0),
+          capacity_(cost_ * static_cast<Nanos>(std::max<size_t>(limits.burst_, 1))), credit_(capacity_) {
+    }
+
+    /// Refill for the time elapsed since the last message and take one token, returns false if the bucket is empty.
+    auto tryConsume(Nanos now) noexcept {
+      credit_ = std::min(capacity_, credit_ + std::max<Nanos>(now - last_time_, 0));
+      last_time_ = now;
+
+      if (UNLIKELY(credit_ < cost_))
+        return false;
+
+      credit_ -= cost_;
+      return true;
+    }
+
+  private:
+    Nanos cost_ = 0;
+    Nanos capacity_ = 0;
+    Nanos credit_ = 0;
+    Nanos last_time_ = 0;
+  };
+}
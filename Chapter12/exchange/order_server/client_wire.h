@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+
+#include "client_request.h"
+#include "client_response.h"
+
+namespace Exchange {
+  /// Compact order entry encoding spoken between the trading OrderGateway and the exchange OrderServer.
+  /// Every message starts with a WireHeader carrying the encoding version, message type and total length, followed by only the fields that message type needs.
+  /// Prices in this ecosystem are already integer ticks, so they go on the wire as 32-bit ticks, client order ids and session sequence numbers as 32 bits.
+  /// The fixed width OMClientRequest / OMClientResponse structures are the previous encoding.
+  constexpr uint8_t CLIENT_WIRE_VERSION = 1;
+
+  enum class WireMsgType : uint8_t {
+    INVALID = 0,
+    NEW_ORDER = 1,
+    CANCEL_ORDER = 2,
+    ACCEPTED = 3,
+    CANCELED = 4,
+    FILLED = 5,
+    CANCEL_REJECTED = 6,
+    THROTTLED = 7,
+    LOGON = 8,
+    LOGON_ACK = 9,
+    REJECTED = 10
+  };
+
+  /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  struct WireHeader {
+    uint8_t version_ = CLIENT_WIRE_VERSION;
+    WireMsgType type_ = WireMsgType::INVALID;
+
+    /// Length of the whole message including this header, lets a reader skip message types or versions it does not understand.
+    uint16_t length_ = 0;
+
+    uint32_t seq_num_ = 0;
+  };
+
+  /// Requests carry the ClientId since the order server learns which client a connection belongs to from them.
+  struct WireNewOrder {
+    WireHeader header_;
+    ClientId client_id_;
+    TickerId ticker_id_;
+    uint32_t order_id_;
+    Side side_;
+    int32_t price_;
+    Qty qty_;
+  };
+
+  /// The side is only needed to route a THROTTLED response back to the order at the client, the matching engine cancels by order id.
+  struct WireCancelOrder {
+    WireHeader header_;
+    ClientId client_id_;
+    TickerId ticker_id_;
+    uint32_t order_id_;
+    Side side_;
+  };
+
+  /// Responses omit the ClientId, a connection only ever carries the responses of the one client sending requests over it.
+  /// The market order id is only sent once, when the order is accepted.
+  struct WireAccepted {
+    WireHeader header_;
+    TickerId ticker_id_;
+    uint32_t client_order_id_;
+    OrderId market_order_id_;
+    Side side_;
+    int32_t price_;
+    Qty leaves_qty_;
+  };
+
+  struct WireFilled {
+    WireHeader header_;
+    TickerId ticker_id_;
+    uint32_t client_order_id_;
+    Side side_;
+    int32_t price_;
+    Qty exec_qty_;
+    Qty leaves_qty_;
+  };
+
+  /// CANCELED, THROTTLED and REJECTED.
+  struct WireOrderDone {
+    WireHeader header_;
+    TickerId ticker_id_;
+    uint32_t client_order_id_;
+    Side side_;
+  };
+
+  struct WireCancelRejected {
+    WireHeader header_;
+    TickerId ticker_id_;
+    uint32_t client_order_id_;
+  };
+
+  /// Sent by the order gateway first on every connection to start or resume its session, header sequence number unused.
+  /// last_response_seq_ is the sequence number of the last client response the gateway processed, the order server replays the ones after it.
+  struct WireLogon {
+    WireHeader header_;
+    ClientId client_id_;
+    uint32_t next_request_seq_;
+    uint32_t last_response_seq_;
+  };
+
+  /// Order server's reply to a LOGON, header sequence number unused. next_request_seq_ is the sequence number the order server expects on the next
+  /// client request, the client responses replayed after this start at replay_from_seq_, which is past last_response_seq_ + 1 if some are lost.
+  struct WireLogonAck {
+    WireHeader header_;
+    uint32_t next_request_seq_;
+    uint32_t replay_from_seq_;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// Maximum encoded size of any client request / client response, to size encode buffers.
+  constexpr size_t WIRE_MAX_REQUEST_SIZE = std::max({sizeof(WireNewOrder), sizeof(WireCancelOrder), sizeof(WireLogon)});
+  constexpr size_t WIRE_MAX_RESPONSE_SIZE = std::max({sizeof(WireAccepted), sizeof(WireFilled), sizeof(WireOrderDone), sizeof(WireCancelRejected),
+                                                      sizeof(WireLogonAck)});
+
+  /// Fill in the header for a message of type Msg, returns its encoded length.
+  template<typename Msg>
+  inline auto encodeHeader(Msg *msg, WireMsgType type, uint32_t seq_num) noexcept {
+    msg->header_ = WireHeader{CLIENT_WIRE_VERSION, type, static_cast<uint16_t>(sizeof(Msg)), seq_num};
+    return sizeof(Msg);
+  }
+
+  /// Encode the client request into buffer which has room for WIRE_MAX_REQUEST_SIZE bytes, returns the number of bytes written.
+  inline auto encodeClientRequest(uint32_t seq_num, const MEClientRequest &request, char *buffer) noexcept -> size_t {
+    if (UNLIKELY(request.order_id_ > std::numeric_limits<uint32_t>::max()))
+      FATAL("Client order id does not fit the wire format " + request.toString());
+
+    if (request.type_ == ClientRequestType::CANCEL) {
+      auto msg = reinterpret_cast<WireCancelOrder *>(buffer);
+      msg->client_id_ = request.client_id_;
+      msg->ticker_id_ = request.ticker_id_;
+      msg->order_id_ = static_cast<uint32_t>(request.order_id_);
+      msg->side_ = request.side_;
+      return encodeHeader(msg, WireMsgType::CANCEL_ORDER, seq_num);
+    }
+
+    if (UNLIKELY(request.price_ < std::numeric_limits<int32_t>::min() || request.price_ > std::numeric_limits<int32_t>::max()))
+      FATAL("Price does not fit the wire format " + request.toString());
+    auto msg = reinterpret_cast<WireNewOrder *>(buffer);
+    msg->client_id_ = request.client_id_;
+    msg->ticker_id_ = request.ticker_id_;
+    msg->order_id_ = static_cast<uint32_t>(request.order_id_);
+    msg->side_ = request.side_;
+    msg->price_ = static_cast<int32_t>(request.price_);
+    msg->qty_ = request.qty_;
+    return encodeHeader(msg, WireMsgType::NEW_ORDER, seq_num);
+  }
+
+  /// Encode the client response into buffer which has room for WIRE_MAX_RESPONSE_SIZE bytes, returns the number of bytes written.
+  inline auto encodeClientResponse(uint32_t seq_num, const MEClientResponse &response, char *buffer) noexcept -> size_t {
+    switch (response.type_) {
+      case ClientResponseType::ACCEPTED: {
+        auto msg = reinterpret_cast<WireAccepted *>(buffer);
+        msg->ticker_id_ = response.ticker_id_;
+        msg->client_order_id_ = static_cast<uint32_t>(response.client_order_id_);
+        msg->market_order_id_ = response.market_order_id_;
+        msg->side_ = response.side_;
+        msg->price_ = static_cast<int32_t>(response.price_);
+        msg->leaves_qty_ = response.leaves_qty_;
+        return encodeHeader(msg, WireMsgType::ACCEPTED, seq_num);
+      }
+      case ClientResponseType::FILLED: {
+        auto msg = reinterpret_cast<WireFilled *>(buffer);
+        msg->ticker_id_ = response.ticker_id_;
+        msg->client_order_id_ = static_cast<uint32_t>(response.client_order_id_);
+        msg->side_ = response.side_;
+        msg->price_ = static_cast<int32_t>(response.price_);
+        msg->exec_qty_ = response.exec_qty_;
+        msg->leaves_qty_ = response.leaves_qty_;
+        return encodeHeader(msg, WireMsgType::FILLED, seq_num);
+      }
+      case ClientResponseType::CANCELED:
+      case ClientResponseType::THROTTLED:
+      case ClientResponseType::REJECTED: {
+        auto msg = reinterpret_cast<WireOrderDone *>(buffer);
+        msg->ticker_id_ = response.ticker_id_;
+        msg->client_order_id_ = static_cast<uint32_t>(response.client_order_id_);
+        msg->side_ = response.side_;
+        const auto type = (response.type_ == ClientResponseType::CANCELED ? WireMsgType::CANCELED :
+                           (response.type_ == ClientResponseType::THROTTLED ? WireMsgType::THROTTLED : WireMsgType::REJECTED));
+        return encodeHeader(msg, type, seq_num);
+      }
+      case ClientResponseType::CANCEL_REJECTED: {
+        auto msg = reinterpret_cast<WireCancelRejected *>(buffer);
+        msg->ticker_id_ = response.ticker_id_;
+        msg->client_order_id_ = static_cast<uint32_t>(response.client_order_id_);
+        return encodeHeader(msg, WireMsgType::CANCEL_REJECTED, seq_num);
+      }
+      case ClientResponseType::SESSION_MOVED:
+      case ClientResponseType::SESSION_TAKEOVER:
+      case ClientResponseType::INVALID:
+        break;
+    }
+
+    // Header only, so that the sequence number is still consumed.
+    *reinterpret_cast<WireHeader *>(buffer) = WireHeader{CLIENT_WIRE_VERSION, WireMsgType::INVALID, sizeof(WireHeader), seq_num};
+    return sizeof(WireHeader);
+  }
+
+  inline auto encodeLogon(ClientId client_id, uint32_t next_request_seq, uint32_t last_response_seq, char *buffer) noexcept -> size_t {
+    auto msg = reinterpret_cast<WireLogon *>(buffer);
+    msg->client_id_ = client_id;
+    msg->next_request_seq_ = next_request_seq;
+    msg->last_response_seq_ = last_response_seq;
+    return encodeHeader(msg, WireMsgType::LOGON, 0);
+  }
+
+  inline auto encodeLogonAck(uint32_t next_request_seq, uint32_t replay_from_seq, char *buffer) noexcept -> size_t {
+    auto msg = reinterpret_cast<WireLogonAck *>(buffer);
+    msg->next_request_seq_ = next_request_seq;
+    msg->replay_from_seq_ = replay_from_seq;
+    return encodeHeader(msg, WireMsgType::LOGON_ACK, 0);
+  }
+
+  /// Type of the complete message at buffer, INVALID for other versions, so that session messages can be told apart before decoding.
+  inline auto wireMessageType(const char *buffer) noexcept {
+    const auto header = reinterpret_cast<const WireHeader *>(buffer);
+    return (header->version_ == CLIENT_WIRE_VERSION ? header->type_ : WireMsgType::INVALID);
+  }
+
+  /// Complete session message of type Msg at buffer in place, nullptr if it is too short for its type.
+  template<typename Msg>
+  inline auto decodeSessionMessage(const char *buffer) noexcept -> const Msg * {
+    const auto header = reinterpret_cast<const WireHeader *>(buffer);
+    return (header->length_ >= sizeof(Msg) ? reinterpret_cast<const Msg *>(buffer) : nullptr);
+  }
+
+  /// Length of the complete message at the start of the len valid bytes in buffer, 0 if more bytes are needed.
+  /// A corrupt length shorter than the header is treated as a header only message so that the reader always makes progress.
+  inline auto wireMessageLength(const char *buffer, size_t len) noexcept -> size_t {
+    if (len < sizeof(WireHeader))
+      return 0;
+
+    const auto header = reinterpret_cast<const WireHeader *>(buffer);
+    const size_t msg_len = std::max<size_t>(header->length_, sizeof(WireHeader));
+    return (msg_len <= len ? msg_len : 0);
+  }
+
+  /// Decode the complete client request message at buffer in place, see wireMessageLength().
+  /// Messages of other versions or types, or too short for their type, decode to a request of type INVALID.
+  inline auto decodeClientRequest(const char *buffer, MEClientRequest &request) noexcept -> uint32_t {
+    const auto header = reinterpret_cast<const WireHeader *>(buffer);
+    request = MEClientRequest();
+
+    if (LIKELY(header->version_ == CLIENT_WIRE_VERSION)) {
+      if (header->type_ == WireMsgType::NEW_ORDER && header->length_ >= sizeof(WireNewOrder)) {
+        const auto msg = reinterpret_cast<const WireNewOrder *>(buffer);
+        request = {ClientRequestType::NEW, msg->client_id_, msg->ticker_id_, msg->order_id_, msg->side_, msg->price_, msg->qty_};
+      } else if (header->type_ == WireMsgType::CANCEL_ORDER && header->length_ >= sizeof(WireCancelOrder)) {
+        const auto msg = reinterpret_cast<const WireCancelOrder *>(buffer);
+        request = {ClientRequestType::CANCEL, msg->client_id_, msg->ticker_id_, msg->order_id_, msg->side_, Price_INVALID, Qty_INVALID};
+      }
+    }
+
+    return header->seq_num_;
+  }
+
+  /// Decode the complete client response message at buffer in place for the client at the other end of the connection, see wireMessageLength().
+  /// Messages of other versions or types, or too short for their type, decode to a response of type INVALID.
+  inline auto decodeClientResponse(const char *buffer, ClientId client_id, MEClientResponse &response) noexcept -> uint32_t {
+    const auto header = reinterpret_cast<const WireHeader *>(buffer);
+    response = MEClientResponse();
+    response.client_id_ = client_id;
+
+    if (UNLIKELY(header->version_ != CLIENT_WIRE_VERSION))
+      return header->seq_num_;
+
+    switch (header->type_) {
+      case WireMsgType::ACCEPTED:
+        if (header->length_ >= sizeof(WireAccepted)) {
+          const auto msg = reinterpret_cast<const WireAccepted *>(buffer);
+          response = {ClientResponseType::ACCEPTED, client_id, msg->ticker_id_, msg->client_order_id_, msg->market_order_id_, msg->side_, msg->price_, 0,
+                      msg->leaves_qty_};
+        }
+        break;
+      case WireMsgType::FILLED:
+        if (header->length_ >= sizeof(WireFilled)) {
+          const auto msg = reinterpret_cast<const WireFilled *>(buffer);
+          response = {ClientResponseType::FILLED, client_id, msg->ticker_id_, msg->client_order_id_, OrderId_INVALID, msg->side_, msg->price_, msg->exec_qty_,
+                      msg->leaves_qty_};
+        }
+        break;
+      case WireMsgType::CANCELED:
+      case WireMsgType::THROTTLED:
+      case WireMsgType::REJECTED:
+        if (header->length_ >= sizeof(WireOrderDone)) {
+          const auto msg = reinterpret_cast<const WireOrderDone *>(buffer);
+          const auto type = (header->type_ == WireMsgType::CANCELED ? ClientResponseType::CANCELED :
+                             (header->type_ == WireMsgType::THROTTLED ? ClientResponseType::THROTTLED : ClientResponseType::REJECTED));
+          response = {type, client_id, msg->ticker_id_, msg->client_order_id_, OrderId_INVALID, msg->side_, Price_INVALID, Qty_INVALID, Qty_INVALID};
+        }
+        break;
+      case WireMsgType::CANCEL_REJECTED:
+        if (header->length_ >= sizeof(WireCancelRejected)) {
+          const auto msg = reinterpret_cast<const WireCancelRejected *>(buffer);
+          response = {ClientResponseType::CANCEL_REJECTED, client_id, msg->ticker_id_, msg->client_order_id_, OrderId_INVALID, Side::INVALID, Price_INVALID,
+                      Qty_INVALID, Qty_INVALID};
+        }
+        break;
+      default:
+        break;
+    }
+
+    return header->seq_num_;
+  }
+}
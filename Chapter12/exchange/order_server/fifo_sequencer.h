@@ -4,50 +4,124 @@
 #include "common/macros.h"
 
 #include "order_server/client_request.h"
+#include "journal/journal_record.h"
 
 namespace Exchange {
   /// Maximum number of unprocessed client request messages across all TCP connections in the order server / FIFO sequencer.
   constexpr size_t ME_MAX_PENDING_REQUESTS = 1024;
 
+  /// A structure that encapsulates the software receive time as well as the client request.
+  struct RecvTimeClientRequest {
+    Nanos recv_time_ = 0;
+    MEClientRequest request_;
+
+    auto operator<(const RecvTimeClientRequest &rhs) const {
+      return (recv_time_ < rhs.recv_time_);
+    }
+  };
+
+  /// Lock free queue of received client requests, from an order server I/O thread to the sequencer stage.
+  typedef Common::LFQueue<RecvTimeClientRequest> RecvTimeClientRequestLFQueue;
+
   class FIFOSequencer {
   public:
-    FIFOSequencer(ClientRequestLFQueue *client_requests, Logger *logger)
-        : incoming_requests_(client_requests), logger_(logger) {
+    /// next_seq_num continues the sequence after a restart, i.e. one past the last client request recovered by the matching engine.
+    FIFOSequencer(ClientRequestLFQueue *client_requests, JournalRecordLFQueue *journal_records, Logger *logger, size_t next_seq_num = 1)
+        : incoming_requests_(client_requests), journal_records_(journal_records), next_seq_num_(next_seq_num), logger_(logger) {
     }
 
     ~FIFOSequencer() {
     }
 
+    /// True if no more client requests can be queued up before the next call to sequenceAndPublish().
+    auto full() const noexcept {
+      return (pending_size_ >= pending_client_requests_.size());
+    }
+
+    /// Number of client requests queued up and not sequenced yet.
+    auto size() const noexcept {
+      return pending_size_;
+    }
+
     /// Queue up a client request, not processed immediately, processed when sequenceAndPublish() is called.
     auto addClientRequest(Nanos rx_time, const MEClientRequest &request) {
-      if (pending_size_ >= pending_client_requests_.size()) {
-        FATAL("Too many pending requests");
+      if (pending_size_ >= pending_client_requests_.size()) { // the caller is expected to check full() if it can hold requests back.
+        FATAL("Too many pending requests, matching engine queue:" + std::to_string(incoming_requests_->size()) +
+              " journal queue:" + std::to_string(journal_records_ ? journal_records_->size() : 0));
       }
       pending_client_requests_.at(pending_size_++) = std::move(RecvTimeClientRequest{rx_time, request});
     }
 
     /// Sort pending client requests in ascending receive time order and then write them to the lock free queue for the matching engine to consume from.
+    /// Each request is assigned the next sequence number and, if journaling is enabled, also broadcast to the journal writer.
+    /// A request is only sequenced once both queues have room for it, the LFQueue does not check for overflow and would silently overwrite records the
+    /// journal writer has not written yet. The requests left over stay pending in receive time order until the next call, and once they fill up the
+    /// pending queue full() stops more from being queued.
     auto sequenceAndPublish() {
       if (UNLIKELY(!pending_size_))
         return;
 
       logger_->log("%:% %() % Processing % requests.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), pending_size_);
 
-      std::sort(pending_client_requests_.begin(), pending_client_requests_.begin() + pending_size_);
+      std::stable_sort(pending_client_requests_.begin(), pending_client_requests_.begin() + pending_size_);
+
+      size_t i = 0;
+      for (; i < pending_size_; ++i) {
+        if (UNLIKELY(incoming_requests_->size() >= incoming_requests_->capacity() ||
+                     (journal_records_ && journal_records_->size() >= journal_records_->capacity())))
+          break;
 
-      for (size_t i = 0; i < pending_size_; ++i) {
         const auto &client_request = pending_client_requests_.at(i);
 
         logger_->log("%:% %() % Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                      client_request.recv_time_, client_request.request_.toString());
 
         auto next_write = incoming_requests_->getNextToWriteTo();
-        *next_write = std::move(client_request.request_);
+        *next_write = client_request.request_;
         incoming_requests_->updateWriteIndex();
         TTT_MEASURE(T2_OrderServer_LFQueue_write, (*logger_));
+
+        if (journal_records_) {
+          auto next_journal_write = journal_records_->getNextToWriteTo();
+          next_journal_write->seq_num_ = next_seq_num_;
+          next_journal_write->recv_time_ = client_request.recv_time_;
+          next_journal_write->me_client_request_ = client_request.request_;
+          journal_records_->updateWriteIndex();
+        }
+
+        ++next_seq_num_;
       }
 
-      pending_size_ = 0;
+      if (journal_records_ && UNLIKELY(journal_records_->size() > journal_high_water_mark_)) {
+        journal_high_water_mark_ = journal_records_->size();
+        if ((journal_high_water_mark_ & (journal_high_water_mark_ - 1)) == 0) // every power of 2.
+          logger_->log("%:% %() % Journal queue high water mark:% capacity:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                       journal_high_water_mark_.load(), journal_records_->capacity());
+      }
+
+      if (UNLIKELY(i < pending_size_)) {
+        if (!stalled_) {
+          ++num_stalls_;
+          logger_->log("%:% %() % Stalled with % requests pending, matching engine queue:%/% journal queue:%/% stalls:%\n", __FILE__, __LINE__, __FUNCTION__,
+                       Common::getCurrentTimeStr(&time_str_), pending_size_ - i, incoming_requests_->size(), incoming_requests_->capacity(),
+                       (journal_records_ ? journal_records_->size() : 0), (journal_records_ ? journal_records_->capacity() : 0), num_stalls_.load());
+        }
+        stalled_ = true;
+        std::move(pending_client_requests_.begin() + i, pending_client_requests_.begin() + pending_size_, pending_client_requests_.begin());
+      } else {
+        stalled_ = false;
+      }
+      pending_size_ -= i;
+    }
+
+    /// Highest number of records seen queued up for the journal writer.
+    auto journalHighWaterMark() const noexcept {
+      return journal_high_water_mark_.load();
+    }
+
+    /// Number of times sequencing stalled on a full matching engine or journal queue.
+    auto numStalls() const noexcept {
+      return num_stalls_.load();
     }
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -65,21 +139,22 @@ namespace Exchange {
     /// Lock free queue used to publish client requests to, so that the matching engine can consume them.
     ClientRequestLFQueue *incoming_requests_ = nullptr;
 
-    std::string time_str_;
-    Logger *logger_ = nullptr;
+    /// Lock free queue used to broadcast sequenced client requests to the journal writer, nullptr if journaling is disabled.
+    JournalRecordLFQueue *journal_records_ = nullptr;
 
-    /// A structure that encapsulates the software receive time as well as the client request.
-    struct RecvTimeClientRequest {
-      Nanos recv_time_ = 0;
-      MEClientRequest request_;
+    /// Sequence number assigned to the next client request published to the matching engine.
+    size_t next_seq_num_ = 1;
 
-      auto operator<(const RecvTimeClientRequest &rhs) const {
-        return (recv_time_ < rhs.recv_time_);
-      }
-    };
+    std::string time_str_;
+    Logger *logger_ = nullptr;
 
     /// Queue of pending client requests, not sorted.
     std::array<RecvTimeClientRequest, ME_MAX_PENDING_REQUESTS> pending_client_requests_;
     size_t pending_size_ = 0;
+
+    /// Backpressure from the matching engine and the journal writer.
+    std::atomic<size_t> journal_high_water_mark_ = 0;
+    std::atomic<size_t> num_stalls_ = 0;
+    bool stalled_ = false;
   };
 }
@@ -1,15 +1,30 @@
 #include "order_server.h"
 
 namespace Exchange {
-  OrderServer::OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port)
+  OrderServer::OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port,
+                           JournalRecordLFQueue *journal_records, size_t next_seq_num, const EngineLimits &limits,
+                           const ThrottleLimits &throttle_limits, size_t num_io_threads)
       : iface_(iface), port_(port), outgoing_responses_(client_responses), logger_("exchange_order_server.log"),
-        tcp_server_(logger_), fifo_sequencer_(client_requests, &logger_) {
-    cid_next_outgoing_seq_num_.fill(1);
-    cid_next_exp_seq_num_.fill(1);
-    cid_tcp_socket_.fill(nullptr);
+        cid_group_(limits.max_num_clients_, SessionGroup_INVALID), fifo_sequencer_(client_requests, journal_records, &logger_, next_seq_num) {
+    ASSERT(num_io_threads >= 1, "OrderServer needs at least one I/O thread.");
 
-    tcp_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
-    tcp_server_.recv_finished_callback_ = [this]() { recvFinishedCallback(); };
+    if (num_io_threads == 1) {
+      groups_.push_back(new OrderSessionGroup(&logger_, outgoing_responses_, &fifo_sequencer_, nullptr, nullptr, limits, throttle_limits));
+      return;
+    }
+
+    session_handoffs_.resize(limits.max_num_clients_);
+    cid_moving_.resize(limits.max_num_clients_, false);
+    cid_move_target_.resize(limits.max_num_clients_, SessionGroup_INVALID);
+    cid_held_responses_.resize(limits.max_num_clients_);
+
+    for (size_t i = 0; i < num_io_threads; ++i) {
+      group_loggers_.push_back(new Logger("exchange_order_server_io_" + std::to_string(i) + ".log"));
+      group_requests_.push_back(new RecvTimeClientRequestLFQueue(limits.max_client_updates_));
+      group_responses_.push_back(new ClientResponseLFQueue(limits.max_client_updates_));
+      groups_.push_back(new OrderSessionGroup(group_loggers_.back(), group_responses_.back(), nullptr, group_requests_.back(), &session_handoffs_, limits,
+                                              throttle_limits));
+    }
   }
 
   OrderServer::~OrderServer() {
@@ -17,17 +32,77 @@ namespace Exchange {
 
     using namespace std::literals::chrono_literals;
     std::this_thread::sleep_for(1s);
+
+    for (auto group: groups_)
+      delete group;
+    for (auto group_logger: group_loggers_)
+      delete group_logger;
+    for (auto group_requests: group_requests_)
+      delete group_requests;
+    for (auto group_responses: group_responses_)
+      delete group_responses;
   }
 
-  /// Start and stop the order server main thread.
+  /// Start and stop the order server threads.
   auto OrderServer::start() -> void {
     run_ = true;
-    tcp_server_.listen(iface_, port_);
 
-    ASSERT(Common::createAndStartThread(-1, "Exchange/OrderServer", [this]() { run(); }) != nullptr, "Failed to start OrderServer thread.");
+    const auto reuse_port = (groups_.size() > 1);
+    for (size_t i = 0; i < groups_.size(); ++i) {
+      auto group = groups_[i];
+      group->listen(iface_, port_, reuse_port);
+      ASSERT(Common::createAndStartThread(-1, "Exchange/OrderServer/IO/" + std::to_string(i), [group]() { group->run(); }) != nullptr,
+             "Failed to start OrderServer I/O thread.");
+    }
+
+    if (groups_.size() > 1) {
+      ASSERT(Common::createAndStartThread(-1, "Exchange/OrderServer", [this]() { run(); }) != nullptr, "Failed to start OrderServer thread.");
+    }
   }
 
   auto OrderServer::stop() -> void {
+    for (auto group: groups_)
+      group->stop();
+
     run_ = false;
   }
+
+  auto OrderServer::onSessionRequest(size_t group, const MEClientRequest &request) noexcept -> void {
+    const auto client_id = request.client_id_;
+    logger_.log("%:% %() % % ClientId:% group:% owner:% moving:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                clientRequestTypeToString(request.type_), client_id, group, cid_group_[client_id], static_cast<bool>(cid_moving_[client_id]));
+
+    if (request.type_ == ClientRequestType::SESSION_MOVE) {
+      cid_move_target_[client_id] = group;
+      if (cid_moving_[client_id]) // the latest LOGON's group takes the session over once it has been released.
+        return;
+
+      const auto owner = cid_group_[client_id];
+      if (owner == SessionGroup_INVALID || owner == group) {
+        cid_group_[client_id] = group;
+        sendToGroup(group, MEClientResponse{ClientResponseType::SESSION_TAKEOVER, client_id});
+      } else {
+        cid_moving_[client_id] = true;
+        sendToGroup(owner, MEClientResponse{ClientResponseType::SESSION_MOVED, client_id});
+      }
+      return;
+    }
+
+    // SESSION_RELEASED
+    ++num_session_moves_;
+    const auto target = cid_move_target_[client_id];
+    cid_moving_[client_id] = false;
+    cid_group_[client_id] = target;
+    sendToGroup(target, MEClientResponse{ClientResponseType::SESSION_TAKEOVER, client_id});
+    for (const auto &client_response: cid_held_responses_[client_id])
+      sendToGroup(target, client_response);
+    cid_held_responses_[client_id].clear();
+  }
+
+  auto OrderServer::sendToGroup(size_t group, const MEClientResponse &client_response) noexcept -> void {
+    auto group_responses = group_responses_[group];
+    auto next_write = group_responses->getNextToWriteTo();
+    *next_write = client_response;
+    group_responses->updateWriteIndex();
+  }
 }
@@ -9,97 +9,79 @@
 #include "order_server/client_request.h"
 #include "order_server/client_response.h"
 #include "order_server/fifo_sequencer.h"
+#include "order_server/client_throttle.h"
+#include "order_server/order_session_group.h"
 
 namespace Exchange {
   class OrderServer {
   public:
-    OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port);
+    OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port,
+                JournalRecordLFQueue *journal_records = nullptr, size_t next_seq_num = 1, const EngineLimits &limits = EngineLimits(),
+                const ThrottleLimits &throttle_limits = ThrottleLimits(), size_t num_io_threads = 1);
 
     ~OrderServer();
 
-    /// Start and stop the order server main thread.
+    /// Number of client requests rejected so far for exceeding the message rate of the provided client, across all session groups.
+    auto throttledCount(ClientId client_id) const noexcept {
+      size_t throttled_count = 0;
+      for (auto group: groups_)
+        throttled_count += group->throttledCount(client_id);
+
+      return throttled_count;
+    }
+
+    /// Number of client sessions handed over from one session group to another so far.
+    auto numSessionMoves() const noexcept {
+      return num_session_moves_.load();
+    }
+
+    /// Start and stop the order server threads.
     auto start() -> void;
 
     auto stop() -> void;
 
-    /// Main run loop for this thread - accepts new client connections, receives client requests from them and sends client responses to them.
+    /// Main run loop of the sequencer stage, only used with more than one session group - drains the client requests forwarded by every group
+    /// into the FIFO sequencer, sequences and publishes them to the matching engine, and routes client responses back to the group owning the ClientId.
     auto run() noexcept {
       logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
       while (run_) {
-        tcp_server_.poll();
+        for (size_t i = 0; i < groups_.size(); ++i) {
+          auto forwarded_requests = group_requests_[i];
+          for (auto request = forwarded_requests->getNextToRead(); forwarded_requests->size() && request && !fifo_sequencer_.full();
+               request = forwarded_requests->getNextToRead()) {
+            const auto client_id = request->request_.client_id_;
+            if (UNLIKELY(request->request_.type_ == ClientRequestType::SESSION_MOVE || request->request_.type_ == ClientRequestType::SESSION_RELEASED)) {
+              onSessionRequest(i, request->request_);
+              forwarded_requests->updateReadIndex();
+              continue;
+            }
+
+            if (UNLIKELY(cid_group_[client_id] == SessionGroup_INVALID)) // a session started without a LOGON.
+              cid_group_[client_id] = i;
+
+            START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
+            fifo_sequencer_.addClientRequest(request->recv_time_, request->request_);
+            END_MEASURE(Exchange_FIFOSequencer_addClientRequest, logger_);
+
+            forwarded_requests->updateReadIndex();
+          }
+        }
 
-        tcp_server_.sendAndRecv();
+        START_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
+        fifo_sequencer_.sequenceAndPublish();
+        END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish, logger_);
 
         for (auto client_response = outgoing_responses_->getNextToRead(); outgoing_responses_->size() && client_response; client_response = outgoing_responses_->getNextToRead()) {
-          TTT_MEASURE(T5t_OrderServer_LFQueue_read, logger_);
-
-          auto &next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_response->client_id_];
-          logger_.log("%:% %() % Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                      client_response->client_id_, next_outgoing_seq_num, client_response->toString());
-
-          ASSERT(cid_tcp_socket_[client_response->client_id_] != nullptr,
-                 "Dont have a TCPSocket for ClientId:" + std::to_string(client_response->client_id_));
-          START_MEASURE(Exchange_TCPSocket_send);
-          cid_tcp_socket_[client_response->client_id_]->send(&next_outgoing_seq_num, sizeof(next_outgoing_seq_num));
-          cid_tcp_socket_[client_response->client_id_]->send(client_response, sizeof(MEClientResponse));
-          END_MEASURE(Exchange_TCPSocket_send, logger_);
+          if (UNLIKELY(cid_moving_[client_response->client_id_])) // held back until the session has been handed over.
+            cid_held_responses_[client_response->client_id_].push_back(*client_response);
+          else
+            sendToGroup(cid_group_[client_response->client_id_], *client_response);
 
           outgoing_responses_->updateReadIndex();
-          TTT_MEASURE(T6t_OrderServer_TCP_write, logger_);
-
-          ++next_outgoing_seq_num;
-        }
-      }
-    }
-
-    /// Read client request from the TCP receive buffer, check for sequence gaps and forward it to the FIFO sequencer.
-    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept {
-      TTT_MEASURE(T1_OrderServer_TCP_read, logger_);
-      logger_.log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                  socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
-
-      if (socket->next_rcv_valid_index_ >= sizeof(OMClientRequest)) {
-        size_t i = 0;
-        for (; i + sizeof(OMClientRequest) <= socket->next_rcv_valid_index_; i += sizeof(OMClientRequest)) {
-          auto request = reinterpret_cast<const OMClientRequest *>(socket->inbound_data_.data() + i);
-          logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), request->toString());
-
-          if (UNLIKELY(cid_tcp_socket_[request->me_client_request_.client_id_] == nullptr)) { // first message from this ClientId.
-            cid_tcp_socket_[request->me_client_request_.client_id_] = socket;
-          }
-
-          if (cid_tcp_socket_[request->me_client_request_.client_id_] != socket) { // TODO - change this to send a reject back to the client.
-            logger_.log("%:% %() % Received ClientRequest from ClientId:% on different socket:% expected:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), request->me_client_request_.client_id_, socket->socket_fd_,
-                        cid_tcp_socket_[request->me_client_request_.client_id_]->socket_fd_);
-            continue;
-          }
-
-          auto &next_exp_seq_num = cid_next_exp_seq_num_[request->me_client_request_.client_id_];
-          if (request->seq_num_ != next_exp_seq_num) { // TODO - change this to send a reject back to the client.
-            logger_.log("%:% %() % Incorrect sequence number. ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), request->me_client_request_.client_id_, next_exp_seq_num, request->seq_num_);
-            continue;
-          }
-
-          ++next_exp_seq_num;
-
-          START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
-          fifo_sequencer_.addClientRequest(rx_time, request->me_client_request_);
-          END_MEASURE(Exchange_FIFOSequencer_addClientRequest, logger_);
         }
-        memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
-        socket->next_rcv_valid_index_ -= i;
       }
     }
 
-    /// End of reading incoming messages across all the TCP connections, sequence and publish the client requests to the matching engine.
-    auto recvFinishedCallback() noexcept {
-      START_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
-      fifo_sequencer_.sequenceAndPublish();
-      END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish, logger_);
-    }
-
     /// Deleted default, copy & move constructors and assignment-operators.
     OrderServer() = delete;
 
@@ -123,17 +105,33 @@ namespace Exchange {
     std::string time_str_;
     Logger logger_;
 
-    /// Hash map from ClientId -> the next sequence number to be sent on outgoing client responses.
-    std::array<size_t, ME_MAX_NUM_CLIENTS> cid_next_outgoing_seq_num_;
-
-    /// Hash map from ClientId -> the next sequence number expected on incoming client requests.
-    std::array<size_t, ME_MAX_NUM_CLIENTS> cid_next_exp_seq_num_;
-
-    /// Hash map from ClientId -> TCP socket / client connection.
-    std::array<Common::TCPSocket *, ME_MAX_NUM_CLIENTS> cid_tcp_socket_;
-
-    /// TCP server instance listening for new client connections.
-    Common::TCPServer tcp_server_;
+    /// Sessions are spread across the groups by the kernel, each group has its own I/O thread and listening socket on the same port.
+    /// With a single group the FIFO sequencer runs inline on its I/O thread and it uses the queues and logger of the order server itself,
+    /// else each group has its own logger, forwards client requests to the sequencer stage and receives client responses from it through its own queues.
+    std::vector<OrderSessionGroup *> groups_;
+    std::vector<Logger *> group_loggers_;
+    std::vector<RecvTimeClientRequestLFQueue *> group_requests_;
+    std::vector<ClientResponseLFQueue *> group_responses_;
+
+    /// Hash map from ClientId -> index of the session group owning its session, set when a group takes the session over or else from its first client request.
+    std::vector<size_t> cid_group_;
+
+    /// Session state handed over between the groups by ClientId, see SessionHandoff.
+    std::vector<SessionHandoff> session_handoffs_;
+
+    /// Hash maps from ClientId -> whether its session is being handed over, the group to hand it over to and the client responses held back meanwhile.
+    std::vector<bool> cid_moving_;
+    std::vector<size_t> cid_move_target_;
+    std::vector<std::vector<MEClientResponse>> cid_held_responses_;
+    std::atomic<size_t> num_session_moves_ = 0;
+
+    /// Move a session between groups - a SESSION_MOVE from the group a client sent a LOGON to has the owning group release the session with SESSION_MOVED,
+    /// and the SESSION_RELEASED it forwards once every client response routed to it was sent has the new group take the session over with SESSION_TAKEOVER.
+    /// Client responses for the client are held back in between, so that none reaches the old group after it handed over the ring and numbering.
+    auto onSessionRequest(size_t group, const MEClientRequest &request) noexcept -> void;
+
+    /// Write the client response to the lock free queue of the provided session group.
+    auto sendToGroup(size_t group, const MEClientResponse &client_response) noexcept -> void;
 
     /// FIFO sequencer responsible for making sure incoming client requests are processed in the order in which they were received.
     FIFOSequencer fifo_sequencer_;
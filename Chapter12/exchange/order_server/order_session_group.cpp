@@ -0,0 +1,222 @@
+#include "order_session_group.h"
+
+namespace Exchange {
+  OrderSessionGroup::OrderSessionGroup(Logger *logger, ClientResponseLFQueue *outgoing_responses, FIFOSequencer *fifo_sequencer,
+                                       RecvTimeClientRequestLFQueue *forwarded_requests, std::vector<SessionHandoff> *session_handoffs,
+                                       const EngineLimits &limits, const ThrottleLimits &throttle_limits)
+      : logger_(logger), outgoing_responses_(outgoing_responses), fifo_sequencer_(fifo_sequencer), forwarded_requests_(forwarded_requests),
+        session_handoffs_(session_handoffs), max_tickers_(limits.max_tickers_), cid_next_outgoing_seq_num_(limits.max_num_clients_, 1), cid_next_exp_seq_num_(limits.max_num_clients_, 1),
+        cid_tcp_socket_(limits.max_num_clients_, nullptr), cid_pending_logon_(limits.max_num_clients_), cid_released_(limits.max_num_clients_, false),
+        cid_sent_responses_(limits.max_num_clients_), throttle_limits_(throttle_limits),
+        cid_token_bucket_(limits.max_num_clients_, TokenBucket(throttle_limits)), cid_throttled_count_(limits.max_num_clients_, 0), tcp_server_(*logger) {
+    ASSERT((fifo_sequencer_ != nullptr) != (forwarded_requests_ != nullptr), "OrderSessionGroup needs exactly one of a FIFOSequencer or a forwarding queue.");
+
+    tcp_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
+    tcp_server_.recv_finished_callback_ = [this]() { recvFinishedCallback(); };
+  }
+
+  auto OrderSessionGroup::recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
+    TTT_MEASURE(T1_OrderServer_TCP_read, (*logger_));
+    logger_->log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
+
+    size_t i = 0;
+    for (auto msg_len = wireMessageLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = wireMessageLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      if (UNLIKELY(!canForward())) { // left in the buffer until the sequencer has room again, see retryStalledSockets().
+        if (std::find(stalled_sockets_.begin(), stalled_sockets_.end(), socket) == stalled_sockets_.end()) {
+          logger_->log("%:% %() % Holding back socket:% pending:% bytes\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                       socket->socket_fd_, socket->next_rcv_valid_index_ - i);
+          stalled_sockets_.push_back(socket);
+        }
+        break;
+      }
+
+      if (UNLIKELY(wireMessageType(socket->inbound_data_.data() + i) == WireMsgType::LOGON)) {
+        const auto logon = decodeSessionMessage<WireLogon>(socket->inbound_data_.data() + i);
+        if (logon && logon->client_id_ < cid_tcp_socket_.size())
+          onLogon(socket, *logon);
+        continue;
+      }
+
+      MEClientRequest request;
+      const auto seq_num = decodeClientRequest(socket->inbound_data_.data() + i, request);
+      logger_->log("%:% %() % Received seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), seq_num, request.toString());
+
+      if (UNLIKELY(request.type_ == ClientRequestType::INVALID || request.client_id_ >= cid_tcp_socket_.size() || request.ticker_id_ >= max_tickers_)) { // TODO - change this to send a reject back to the client.
+        logger_->log("%:% %() % Dropping undecodable or invalid ClientRequest on socket:%\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_), socket->socket_fd_);
+        continue;
+      }
+
+      if (UNLIKELY(cid_pending_logon_[request.client_id_].socket_ == socket)) // left in the buffer until the session has been taken over after the LOGON.
+        break;
+
+      if (UNLIKELY(cid_tcp_socket_[request.client_id_] == nullptr && !cid_released_[request.client_id_])) { // first message from this ClientId without a LOGON.
+        bindSession(request.client_id_, socket);
+      }
+
+      if (cid_tcp_socket_[request.client_id_] != socket) { // TODO - change this to send a reject back to the client.
+        logger_->log("%:% %() % Received ClientRequest from ClientId:% on different socket:% expected:%\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_), request.client_id_, socket->socket_fd_,
+                     (cid_tcp_socket_[request.client_id_] ? cid_tcp_socket_[request.client_id_]->socket_fd_ : -1));
+        continue;
+      }
+
+      auto &next_exp_seq_num = cid_next_exp_seq_num_[request.client_id_];
+      if (seq_num != next_exp_seq_num) { // TODO - change this to send a reject back to the client.
+        logger_->log("%:% %() % Incorrect sequence number. ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_), request.client_id_, next_exp_seq_num, seq_num);
+        continue;
+      }
+
+      ++next_exp_seq_num;
+
+      if (throttle_limits_.enabled() && UNLIKELY(!cid_token_bucket_[request.client_id_].tryConsume(rx_time))) {
+        sendThrottled(request);
+        continue;
+      }
+
+      if (fifo_sequencer_) {
+        START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
+        fifo_sequencer_->addClientRequest(rx_time, request);
+        END_MEASURE(Exchange_FIFOSequencer_addClientRequest, (*logger_));
+      } else {
+        auto next_write = forwarded_requests_->getNextToWriteTo();
+        *next_write = RecvTimeClientRequest{rx_time, request};
+        forwarded_requests_->updateWriteIndex();
+      }
+    }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
+  }
+
+  auto OrderSessionGroup::retryStalledSockets() noexcept -> void {
+    // Requests are taken from the sockets in the order they stalled, a socket which stalls again goes back to the end of the list.
+    auto num_stalled = stalled_sockets_.size();
+    while (num_stalled-- && canForward()) {
+      const auto socket = stalled_sockets_.front();
+      stalled_sockets_.erase(stalled_sockets_.begin());
+      recvCallback(socket, getCurrentNanos());
+    }
+
+    recvFinishedCallback();
+  }
+
+  auto OrderSessionGroup::sendThrottled(const MEClientRequest &request) noexcept -> void {
+    auto &throttled_count = cid_throttled_count_[request.client_id_];
+    ++throttled_count;
+    logger_->log("%:% %() % Throttled ClientId:% count:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 request.client_id_, throttled_count, request.toString());
+
+    // Client responses are sequenced when they are written to the socket, so this one takes its place among the matching engine's responses.
+    sendResponse({ClientResponseType::THROTTLED, request.client_id_, request.ticker_id_, request.order_id_, OrderId_INVALID, request.side_, request.price_,
+                  Qty_INVALID, request.qty_});
+  }
+
+  auto OrderSessionGroup::bindSession(ClientId client_id, TCPSocket *socket) noexcept -> void {
+    cid_tcp_socket_[client_id] = socket;
+    if (cid_sent_responses_[client_id].empty())
+      cid_sent_responses_[client_id].resize(ME_MAX_SENT_RESPONSES);
+  }
+
+  auto OrderSessionGroup::onLogon(TCPSocket *socket, const WireLogon &logon) noexcept -> void {
+    const auto client_id = logon.client_id_;
+    if (cid_tcp_socket_[client_id] == nullptr && session_handoffs_) { // another group may own the session, the sequencer stage knows which.
+      logger_->log("%:% %() % LOGON ClientId:% socket:% waiting for the session\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                   client_id, socket->socket_fd_);
+      cid_pending_logon_[client_id] = {socket, logon};
+      forwardSessionRequest(ClientRequestType::SESSION_MOVE, client_id);
+      return;
+    }
+
+    resumeSession(socket, logon, (cid_tcp_socket_[client_id] != nullptr));
+  }
+
+  auto OrderSessionGroup::resumeSession(TCPSocket *socket, const WireLogon &logon, bool known_session) noexcept -> void {
+    const auto client_id = logon.client_id_;
+    auto &next_exp_seq_num = cid_next_exp_seq_num_[client_id];
+    auto &next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_id];
+
+    if (!known_session) { // e.g. after an exchange restart, so continue with the client's numbering.
+      next_exp_seq_num = logon.next_request_seq_;
+      next_outgoing_seq_num = logon.last_response_seq_ + 1;
+    }
+    cid_released_[client_id] = false;
+    bindSession(client_id, socket);
+
+    // The ring holds the client responses in [next_outgoing_seq_num - ME_MAX_SENT_RESPONSES, next_outgoing_seq_num), anything older is lost.
+    const uint32_t oldest_seq_num = (next_outgoing_seq_num > ME_MAX_SENT_RESPONSES ? next_outgoing_seq_num - ME_MAX_SENT_RESPONSES : 1);
+    const auto replay_from_seq_num = std::clamp(logon.last_response_seq_ + 1, oldest_seq_num, next_outgoing_seq_num);
+    logger_->log("%:% %() % LOGON ClientId:% socket:% next-request:% last-response:% expected-request:% replaying:[%, %)\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_), client_id, socket->socket_fd_, logon.next_request_seq_, logon.last_response_seq_, next_exp_seq_num,
+                 replay_from_seq_num, next_outgoing_seq_num);
+
+    char encoded[WIRE_MAX_RESPONSE_SIZE];
+    socket->send(encoded, encodeLogonAck(next_exp_seq_num, replay_from_seq_num, encoded));
+
+    const auto &sent_responses = cid_sent_responses_[client_id];
+    for (auto seq_num = replay_from_seq_num; seq_num < next_outgoing_seq_num; ++seq_num)
+      socket->send(encoded, encodeClientResponse(seq_num, sent_responses[seq_num % ME_MAX_SENT_RESPONSES], encoded));
+  }
+
+  auto OrderSessionGroup::releaseSession(ClientId client_id) noexcept -> void {
+    // Every client response routed here before the SESSION_MOVED has been sent and kept in the ring, so the ring and numbering are complete.
+    auto &handoff = (*session_handoffs_)[client_id];
+    handoff.valid_ = true;
+    handoff.next_outgoing_seq_num_ = cid_next_outgoing_seq_num_[client_id];
+    handoff.next_exp_seq_num_ = cid_next_exp_seq_num_[client_id];
+    std::swap(handoff.sent_responses_, cid_sent_responses_[client_id]);
+
+    logger_->log("%:% %() % Handing over ClientId:% next-outgoing:% next-expected:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 client_id, handoff.next_outgoing_seq_num_, handoff.next_exp_seq_num_);
+    cid_tcp_socket_[client_id] = nullptr;
+    cid_released_[client_id] = true;
+    forwardSessionRequest(ClientRequestType::SESSION_RELEASED, client_id);
+  }
+
+  auto OrderSessionGroup::takeOverSession(ClientId client_id) noexcept -> void {
+    auto &pending_logon = cid_pending_logon_[client_id];
+    if (UNLIKELY(pending_logon.socket_ == nullptr)) { // a second LOGON already took the session over for the first SESSION_MOVE.
+      logger_->log("%:% %() % No LOGON waiting for ClientId:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), client_id);
+      return;
+    }
+
+    auto &handoff = (*session_handoffs_)[client_id];
+    const auto known_session = handoff.valid_;
+    if (known_session) {
+      cid_next_outgoing_seq_num_[client_id] = handoff.next_outgoing_seq_num_;
+      cid_next_exp_seq_num_[client_id] = handoff.next_exp_seq_num_;
+      std::swap(handoff.sent_responses_, cid_sent_responses_[client_id]);
+      handoff.valid_ = false;
+    }
+
+    logger_->log("%:% %() % Taking over ClientId:% socket:% handed-over:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 client_id, pending_logon.socket_->socket_fd_, known_session);
+    const auto socket = pending_logon.socket_;
+    resumeSession(socket, pending_logon.logon_, known_session);
+    pending_logon = {};
+
+    // Client requests which followed the LOGON were left in the receive buffer.
+    if (socket->next_rcv_valid_index_)
+      recvCallback(socket, getCurrentNanos());
+  }
+
+  auto OrderSessionGroup::forwardSessionRequest(ClientRequestType type, ClientId client_id) noexcept -> void {
+    // Callers check canForward() first.
+    auto next_write = forwarded_requests_->getNextToWriteTo();
+    *next_write = RecvTimeClientRequest{getCurrentNanos(), MEClientRequest{type, client_id, TickerId_INVALID, OrderId_INVALID, Side::INVALID, Price_INVALID,
+                                                                          Qty_INVALID}};
+    forwarded_requests_->updateWriteIndex();
+  }
+
+  auto OrderSessionGroup::sendResponse(const MEClientResponse &client_response) noexcept -> void {
+    auto &next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_response.client_id_];
+    cid_sent_responses_[client_response.client_id_][next_outgoing_seq_num % ME_MAX_SENT_RESPONSES] = client_response;
+
+    char encoded[WIRE_MAX_RESPONSE_SIZE];
+    cid_tcp_socket_[client_response.client_id_]->send(encoded, encodeClientResponse(next_outgoing_seq_num, client_response, encoded));
+
+    ++next_outgoing_seq_num;
+  }
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <limits>
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/tcp_server.h"
+
+#include "order_server/client_request.h"
+#include "order_server/client_response.h"
+#include "order_server/fifo_sequencer.h"
+#include "order_server/client_throttle.h"
+#include "order_server/client_wire.h"
+
+namespace Exchange {
+  /// Number of client responses kept per client for replay to a resumed session.
+  constexpr size_t ME_MAX_SENT_RESPONSES = 4 * 1024;
+
+  /// Index of no session group, for ClientIds no group has owned a session for yet.
+  constexpr size_t SessionGroup_INVALID = std::numeric_limits<size_t>::max();
+
+  /// Session state of a ClientId on its way from the session group which owned it to the one its client reconnected to.
+  /// Written by the group handing the session over before it forwards SESSION_RELEASED to the sequencer stage, and read by the group taking it over
+  /// after the SESSION_TAKEOVER the sequencer stage sends it in return, so the lock free queues in between order the accesses.
+  struct SessionHandoff {
+    /// Set while the session state below is in transit, a group taking over a session never handed over starts it with the client's numbering.
+    bool valid_ = false;
+
+    uint32_t next_outgoing_seq_num_ = 1;
+    uint32_t next_exp_seq_num_ = 1;
+    std::vector<MEClientResponse> sent_responses_;
+  };
+
+  /// A set of client sessions served by one I/O thread of the OrderServer - accepts connections on its own listening socket, receives,
+  /// validates and throttles client requests from them and sends client responses to them.
+  /// Validated client requests go straight into fifo_sequencer if one is provided, i.e. when this is the only group and sequencing runs on its thread,
+  /// else they are forwarded with their receive time through forwarded_requests to the OrderServer's sequencer stage. While neither has room, client requests
+  /// stay in the TCP receive buffers and then the kernel's, so a stalled matching engine or journal pushes back on the clients.
+  /// All the state of a ClientId's session lives in the group owning its connection. With several groups the kernel may put a reconnect on a different group,
+  /// so a LOGON on a group not owning the session asks the sequencer stage for it through SESSION_MOVE, which has the owning group hand it over with its
+  /// numbering and response ring through session_handoffs, see OrderServer::onSessionRequest().
+  class OrderSessionGroup final {
+  public:
+    OrderSessionGroup(Logger *logger, ClientResponseLFQueue *outgoing_responses, FIFOSequencer *fifo_sequencer,
+                      RecvTimeClientRequestLFQueue *forwarded_requests, std::vector<SessionHandoff> *session_handoffs, const EngineLimits &limits,
+                      const ThrottleLimits &throttle_limits);
+
+    /// Start listening, reuse_port has to be set if other groups listen on the same port.
+    auto listen(const std::string &iface, int port, bool reuse_port) -> void {
+      tcp_server_.listen(iface, port, reuse_port);
+    }
+
+    /// Number of client requests rejected so far for exceeding the message rate of the provided client.
+    auto throttledCount(ClientId client_id) const noexcept {
+      return cid_throttled_count_.at(client_id);
+    }
+
+    /// True if there is room to forward another client request for sequencing, else client requests are left in the TCP receive buffers.
+    auto canForward() const noexcept {
+      return (fifo_sequencer_ ? !fifo_sequencer_->full() : forwarded_requests_->size() < forwarded_requests_->capacity());
+    }
+
+    /// Main run loop for the I/O thread of this group - accepts new client connections, receives client requests from them and sends client responses to them.
+    auto run() noexcept {
+      logger_->log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+      while (run_) {
+        tcp_server_.poll();
+
+        tcp_server_.sendAndRecv();
+
+        if (UNLIKELY(!stalled_sockets_.empty() || (fifo_sequencer_ && fifo_sequencer_->size())))
+          retryStalledSockets();
+
+        for (auto client_response = outgoing_responses_->getNextToRead(); outgoing_responses_->size() && client_response; client_response = outgoing_responses_->getNextToRead()) {
+          TTT_MEASURE(T5t_OrderServer_LFQueue_read, (*logger_));
+
+          logger_->log("%:% %() % Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                       client_response->client_id_, cid_next_outgoing_seq_num_[client_response->client_id_], client_response->toString());
+
+          if (UNLIKELY(client_response->type_ == ClientResponseType::SESSION_MOVED)) {
+            if (UNLIKELY(!canForward())) // SESSION_RELEASED has to be forwarded, so leave it queued until there is room.
+              break;
+            releaseSession(client_response->client_id_);
+          } else if (UNLIKELY(client_response->type_ == ClientResponseType::SESSION_TAKEOVER)) {
+            takeOverSession(client_response->client_id_);
+          } else {
+            ASSERT(cid_tcp_socket_[client_response->client_id_] != nullptr,
+                   "Dont have a TCPSocket for ClientId:" + std::to_string(client_response->client_id_));
+            START_MEASURE(Exchange_TCPSocket_send);
+            sendResponse(*client_response);
+            END_MEASURE(Exchange_TCPSocket_send, (*logger_));
+          }
+
+          outgoing_responses_->updateReadIndex();
+          TTT_MEASURE(T6t_OrderServer_TCP_write, (*logger_));
+        }
+      }
+    }
+
+    auto stop() noexcept {
+      run_ = false;
+    }
+
+    /// Decode client requests in place from the TCP receive buffer, check for sequence gaps and the client's message rate and forward it for sequencing.
+    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
+
+    /// End of reading incoming messages across all the TCP connections of this group, sequence and publish the client requests to the matching engine
+    /// if sequencing runs on this thread.
+    auto recvFinishedCallback() noexcept {
+      if (fifo_sequencer_) {
+        START_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
+        fifo_sequencer_->sequenceAndPublish();
+        END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish, (*logger_));
+      }
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    OrderSessionGroup() = delete;
+
+    OrderSessionGroup(const OrderSessionGroup &) = delete;
+
+    OrderSessionGroup(const OrderSessionGroup &&) = delete;
+
+    OrderSessionGroup &operator=(const OrderSessionGroup &) = delete;
+
+    OrderSessionGroup &operator=(const OrderSessionGroup &&) = delete;
+
+  private:
+    volatile bool run_ = true;
+
+    std::string time_str_;
+    Logger *logger_ = nullptr;
+
+    /// Lock free queue of outgoing client responses for the clients of this group.
+    ClientResponseLFQueue *outgoing_responses_ = nullptr;
+
+    /// Exactly one of these is set, see the class comment.
+    FIFOSequencer *fifo_sequencer_ = nullptr;
+    RecvTimeClientRequestLFQueue *forwarded_requests_ = nullptr;
+
+    /// Session state handed over between the groups by ClientId, shared by all of them, nullptr if this is the only group.
+    std::vector<SessionHandoff> *session_handoffs_ = nullptr;
+
+    /// Client requests for TickerIds beyond this are dropped before they reach the matching engine, see EngineLimits::max_tickers_.
+    const size_t max_tickers_;
+
+    /// Hash map from ClientId -> the next sequence number to be sent on outgoing client responses.
+    std::vector<uint32_t> cid_next_outgoing_seq_num_;
+
+    /// Hash map from ClientId -> the next sequence number expected on incoming client requests.
+    std::vector<uint32_t> cid_next_exp_seq_num_;
+
+    /// Hash map from ClientId -> TCP socket / client connection, a LOGON on a new connection moves the session over to it.
+    std::vector<Common::TCPSocket *> cid_tcp_socket_;
+
+    /// Hash map from ClientId -> LOGON waiting for the session to be handed over to this group, and the connection it arrived on.
+    struct PendingLogon {
+      Common::TCPSocket *socket_ = nullptr;
+      WireLogon logon_ = {};
+    };
+
+    std::vector<PendingLogon> cid_pending_logon_;
+
+    /// Hash map from ClientId -> whether this group handed the client's session over, its old connection can not bind it again without a LOGON.
+    std::vector<bool> cid_released_;
+
+    /// Hash map from ClientId -> ring of the last ME_MAX_SENT_RESPONSES client responses sent, indexed by sequence number, replayed on LOGON.
+    /// Allocated when the client's session starts.
+    std::vector<std::vector<MEClientResponse>> cid_sent_responses_;
+
+    /// Message rate limit and hash maps from ClientId -> token bucket and ClientId -> number of client requests throttled.
+    const ThrottleLimits throttle_limits_;
+    std::vector<TokenBucket> cid_token_bucket_;
+    std::vector<size_t> cid_throttled_count_;
+
+    /// TCP server instance listening for new client connections.
+    Common::TCPServer tcp_server_;
+
+    /// Connections with client requests left in their receive buffer because there was no room to forward them, in the order they stalled.
+    std::vector<Common::TCPSocket *> stalled_sockets_;
+
+  private:
+    /// Bind the client's session to the provided connection.
+    auto bindSession(ClientId client_id, TCPSocket *socket) noexcept -> void;
+
+    /// Start or resume the client's session on the connection the LOGON arrived on, or ask for it if another group may own it.
+    auto onLogon(TCPSocket *socket, const WireLogon &logon) noexcept -> void;
+
+    /// Bind the client's session to the connection the LOGON arrived on, agree the sequence numbers and replay the client responses it missed.
+    /// A session unknown to this group continues with the client's numbering.
+    auto resumeSession(TCPSocket *socket, const WireLogon &logon, bool known_session) noexcept -> void;
+
+    /// Hand the client's session over to the group its client reconnected to, on SESSION_MOVED from the sequencer stage.
+    auto releaseSession(ClientId client_id) noexcept -> void;
+
+    /// Take over the client's session for the LOGON waiting for it, on SESSION_TAKEOVER from the sequencer stage.
+    auto takeOverSession(ClientId client_id) noexcept -> void;
+
+    /// Send a session request about the client to the sequencer stage.
+    auto forwardSessionRequest(ClientRequestType type, ClientId client_id) noexcept -> void;
+
+    /// Assign the next sequence number of the client to the client response, keep it for replay and send it to the client's connection.
+    auto sendResponse(const MEClientResponse &client_response) noexcept -> void;
+
+    /// Process the client requests left in the receive buffers of the stalled connections while there is room to forward them, and sequence whatever
+    /// is pending if sequencing runs on this thread. Their receive time is the time they are taken from the buffer.
+    auto retryStalledSockets() noexcept -> void;
+
+    /// Reject a client request which exceeded the client's message rate straight back over its TCP connection, it is never sequenced.
+    auto sendThrottled(const MEClientRequest &request) noexcept -> void;
+  };
+}
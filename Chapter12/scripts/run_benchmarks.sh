@@ -17,4 +17,84 @@ echo "--------------------------------------------------------------------------
 echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
 echo " Benchmark using std::arrays and std::unordered_maps as hash maps. "
 echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
-./cmake-build-release/hash_benchmark
\ No newline at end of file
+./cmake-build-release/hash_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark sequencing and matching engine latencies with and without the request journal. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/journal_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark deterministic replay of recorded client requests through the matching engine with logging disabled. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/replay_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark matching engine restart-to-ready time from a checkpoint plus journal tail versus the full journal. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/checkpoint_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark startup time and resident memory for small and large runtime engine limits. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/limits_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark matching engine latency and resident memory as the number of tickers grows to 10,000. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/tickers_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark cancel and match costs on a deep book with pointer-linked versus index-linked hot/cold order nodes. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/order_node_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark round trip latency of well behaved clients while one client floods the order server, with and without throttling. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/throttle_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark order server throughput and round trip latency for 16 to 256 clients with one and with four session group I/O threads. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/session_groups_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark bytes per message and loopback round trip latency of the fixed width and the compact order entry wire formats. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/wire_format_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark resuming an order entry session with the order server replaying the missed client responses from memory. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/session_resume_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark building market data snapshots in the snapshot synthesizer and streaming them out on the snapshot sender thread. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/snapshot_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark recovering dropped incremental market data updates from the gap fill server. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/gap_fill_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark gaps and recoveries of market data consumers arbitrating the A and B incremental feeds with losses on them. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/feed_arbitration_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark market data consumers synchronizing a ticker from a snapshot while incremental updates for it are queued up. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/recovery_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark gaps, recoveries and latency of market data consumers with different reorder windows on a reordering incremental stream. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/reorder_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark updates decoded, queued and their latency for a market data consumer trading one ticker with tickers sharded across incremental channels. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/channel_sharding_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark the conflated market by price feed published against the order by order incremental updates it is built from. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/price_level_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark wire bytes and decode time per incremental update for the compact market data encoding against raw MDPMarketUpdate structs. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/market_data_wire_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark the incremental updates saved by coalescing updates to the same order within a publish batch under aggressive order flow. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/coalesce_benchmark
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark the client responses to an aggressive order sweeping the book with per fill and per price level fill reporting. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/fill_report_benchmark
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# Run the exchange and NUM_CLIENTS trading clients with network faults injected into what the clients read, then report how each of them recovered.
+# ./scripts/run_fault_injection.sh [NUM_CLIENTS] [RUN_SECS]
+#
+# The faults are read by trading_main from MD_FAULT_* for the market data sockets and OGW_FAULT_* for the order gateway's TCP connection, see
+# Common::FaultCfg. A datagram is only lost, and recovered from the snapshot, when it is dropped from both the A and B feeds of its channel, hence the
+# high default drop probability. The defaults below can be overridden, and a run is repeated with the same faults by keeping the seeds, e.g.
+# MD_FAULT_SEED=7 MD_FAULT_DROP=0.05 OGW_FAULT_DROP=0 ./scripts/run_fault_injection.sh 4 120
+
+NUM_CLIENTS=${1:-2}
+RUN_SECS=${2:-60}
+
+export MD_FAULT_SEED=${MD_FAULT_SEED:-1}
+export MD_FAULT_DROP=${MD_FAULT_DROP:-0.1}
+export MD_FAULT_DUPLICATE=${MD_FAULT_DUPLICATE:-0.01}
+export MD_FAULT_DELAY=${MD_FAULT_DELAY:-0.01}
+export MD_FAULT_REORDER=${MD_FAULT_REORDER:-0.01}
+export MD_FAULT_DELAY_MICROS=${MD_FAULT_DELAY_MICROS:-1000}
+
+export OGW_FAULT_SEED=${OGW_FAULT_SEED:-1}
+export OGW_FAULT_DROP=${OGW_FAULT_DROP:-0.001}
+export OGW_FAULT_DELAY=${OGW_FAULT_DELAY:-0.01}
+export OGW_FAULT_DELAY_MICROS=${OGW_FAULT_DELAY_MICROS:-1000}
+
+date
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Starting Exchange..."
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/exchange_main 2>&1 &
+sleep 10
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Starting ${NUM_CLIENTS} clients for ${RUN_SECS}s with faults:"
+env | grep -E "^(MD|OGW)_FAULT_" | sort
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+for CLIENT_ID in $(seq 1 "${NUM_CLIENTS}"); do
+  ./cmake-build-release/trading_main "${CLIENT_ID}" RANDOM 2>&1 &
+done
+
+sleep "${RUN_SECS}"
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Stopping clients and Exchange..."
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+pkill -9 trading_main
+pkill -2 exchange
+
+sleep 10
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Recovery per client - the last market data Stats line and the order gateway's injected disconnects and logons."
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+for CLIENT_ID in $(seq 1 "${NUM_CLIENTS}"); do
+  STATS=$(grep " Stats " "trading_market_data_consumer_${CLIENT_ID}.log" | tail -1 | sed 's/.* Stats //')
+  DISCONNECTS=$(grep -c "injected disconnect" "trading_order_gateway_${CLIENT_ID}.log")
+  LOGONS=$(grep -c "Received LOGON_ACK" "trading_order_gateway_${CLIENT_ID}.log")
+  echo "CLIENT:${CLIENT_ID} ${STATS:-no stats logged}"
+  echo "CLIENT:${CLIENT_ID} order gateway injected-disconnects:${DISCONNECTS} logons:${LOGONS}"
+done
+
+wait
+date
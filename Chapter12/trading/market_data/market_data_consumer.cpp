@@ -4,38 +4,236 @@ namespace Trading {
   MarketDataConsumer::MarketDataConsumer(Common::ClientId client_id, Exchange::MEMarketUpdateLFQueue *market_updates,
                                          const std::string &iface,
                                          const std::string &snapshot_ip, int snapshot_port,
-                                         const std::string &incremental_ip, int incremental_port)
-      : incoming_md_updates_(market_updates), run_(false),
+                                         const std::vector<Exchange::IncrementalChannelCfg> &incremental_channels,
+                                         const std::vector<Common::TickerId> &tickers,
+                                         const std::string &gap_fill_ip, int gap_fill_port, const ReorderCfg &reorder_cfg,
+                                         const Common::FaultCfg &fault_cfg, const Common::EngineLimits &limits,
+                                         const RecoveryCfg &recovery_cfg)
+      : reorder_cfg_(reorder_cfg), incoming_md_updates_(market_updates), run_(false),
         logger_("trading_market_data_consumer_" + std::to_string(client_id) + ".log"),
-        incremental_mcast_socket_(logger_), snapshot_mcast_socket_(logger_),
-        iface_(iface), snapshot_ip_(snapshot_ip), snapshot_port_(snapshot_port) {
-    auto recv_callback = [this](auto socket) {
-      recvCallback(socket);
-    };
+        wire_decoder_(limits.max_tickers_), snapshot_mcast_socket_(logger_), gap_fill_socket_(logger_),
+        iface_(iface), snapshot_ip_(snapshot_ip), snapshot_port_(snapshot_port), ticker_sync_(limits.max_tickers_),
+        incremental_pool_(recovery_cfg.num_buffers_, recovery_cfg.window_) {
+    ASSERT(!incremental_channels.empty(), "Market data consumer needs at least one incremental channel.");
+    ASSERT(recovery_cfg.window_, "Invalid " + recovery_cfg.toString());
+    logger_.log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), limits.toString(),
+                recovery_cfg.toString());
+
+    // Join only the channels the subscribed tickers are published on, or all of them if subscribed to every ticker.
+    std::vector<bool> join_channel(incremental_channels.size(), tickers.empty());
+    for (const auto ticker_id: tickers) {
+      ASSERT(ticker_id < limits.max_tickers_, "Subscribed to ticker:" + std::to_string(ticker_id) + " beyond " + limits.toString());
+      if (ticker_id >= subscribed_tickers_.size())
+        subscribed_tickers_.resize(ticker_id + 1, false);
+      subscribed_tickers_[ticker_id] = true;
+      join_channel[Exchange::tickerChannel(ticker_id, incremental_channels.size())] = true;
+    }
+
+    incremental_channels_.reserve(incremental_channels.size());
+    for (size_t channel_id = 0; channel_id < incremental_channels.size(); ++channel_id) {
+      if (!join_channel[channel_id])
+        continue;
+
+      const auto &channel_cfg = incremental_channels[channel_id];
+      logger_.log("%:% %() % Joining channel:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), channel_id,
+                  channel_cfg.toString());
+
+      auto &channel = incremental_channels_.emplace_back(channel_id, channel_cfg.compact_, logger_);
+      ASSERT(channel.socket_.init(channel_cfg.ip_, iface, channel_cfg.port_, /*is_listening*/ true) >= 0,
+             "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+
+      ASSERT(channel.socket_.join(channel_cfg.ip_),
+             "Join failed on:" + std::to_string(channel.socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+
+      if (!channel_cfg.b_ip_.empty()) {
+        channel.num_feeds_ = 2;
+        ASSERT(channel.b_socket_.init(channel_cfg.b_ip_, iface, channel_cfg.b_port_, /*is_listening*/ true) >= 0,
+               "Unable to create incremental B mcast socket. error:" + std::string(std::strerror(errno)));
+
+        ASSERT(channel.b_socket_.join(channel_cfg.b_ip_),
+               "Join failed on:" + std::to_string(channel.b_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+      }
+    }
+
+    // The channels do not move anymore, so the callbacks can refer to them.
+    for (auto &channel: incremental_channels_) {
+      channel.socket_.recv_callback_ = [this, &channel](auto socket) { recvCallback(socket, &channel, false); };
+      channel.b_socket_.recv_callback_ = [this, &channel](auto socket) { recvCallback(socket, &channel, true); };
+    }
 
-    incremental_mcast_socket_.recv_callback_ = recv_callback;
-    ASSERT(incremental_mcast_socket_.init(incremental_ip, iface, incremental_port, /*is_listening*/ true) >= 0,
-           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+    snapshot_mcast_socket_.recv_callback_ = [this](auto socket) { recvCallback(socket, nullptr, false); };
 
-    ASSERT(incremental_mcast_socket_.join(incremental_ip),
-           "Join failed on:" + std::to_string(incremental_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+    // Every socket draws its own faults, so that the A and B feeds of a channel do not lose the same datagrams.
+    if (fault_cfg.enabled()) {
+      logger_.log("%:% %() % Injecting %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), fault_cfg.toString());
+      for (auto &channel: incremental_channels_) {
+        channel.socket_.injectFaults(fault_cfg, 2 * channel.channel_id_);
+        channel.b_socket_.injectFaults(fault_cfg, 2 * channel.channel_id_ + 1);
+      }
+      snapshot_mcast_socket_.injectFaults(fault_cfg, 2 * incremental_channels.size());
+    }
+    logger_.log("%:% %() % % tickers:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), reorder_cfg_.toString(),
+                (tickers.empty() ? std::string("all") : std::to_string(tickers.size())));
 
-    snapshot_mcast_socket_.recv_callback_ = recv_callback;
+    // The connection completes in the background, if the gap fill server cannot be reached the socket ends up disconnected_ and gaps are recovered from snapshots.
+    gap_fill_socket_.recv_callback_ = [this](auto socket, auto) { gapFillCallback(socket); };
+    gap_fill_socket_.connect(gap_fill_ip, iface, gap_fill_port, false);
   }
 
   /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the recvCallback() and checkSnapshotSync() methods.
   auto MarketDataConsumer::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
-      incremental_mcast_socket_.sendAndRecv();
+      for (auto &channel: incremental_channels_) {
+        auto feeds_idle = !channel.socket_.sendAndRecv();
+        if (channel.num_feeds_ > 1)
+          feeds_idle &= !channel.b_socket_.sendAndRecv();
+
+        if (UNLIKELY(channel.num_pending_ && feeds_idle))
+          checkReorderWindow(channel, true);
+      }
       snapshot_mcast_socket_.sendAndRecv();
+
+      if (!gap_fill_socket_.disconnected_) {
+        gap_fill_socket_.sendAndRecv();
+
+        // The response being read can not be resynchronized with, so a gap fill server which stopped answering is treated like a lost connection.
+        if (UNLIKELY(num_gap_fills_pending_ && Common::getCurrentNanos() - gap_fill_time_ > MD_GAP_FILL_TIMEOUT)) {
+          logger_.log("%:% %() % Gap fill timed out, % updates remaining.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                      gap_fill_updates_remaining_);
+          gap_fill_socket_.disconnect();
+          gap_fill_socket_.disconnected_ = true;
+        }
+
+        if (UNLIKELY(gap_fill_socket_.disconnected_)) {
+          logger_.log("%:% %() % Gap fill server disconnected, % gap fills pending.\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), num_gap_fills_pending_);
+          gap_fill_updates_remaining_ = 0;
+          while (num_gap_fills_pending_)
+            gapFillDone();
+        }
+      }
+
+      logStats();
+    }
+  }
+
+  /// Log the recovery counters, the backlog of the lock free queue to the trade engine and the faults injected if they changed since last time.
+  auto MarketDataConsumer::logStats() noexcept -> void {
+    max_queue_backlog_ = std::max(max_queue_backlog_, incoming_md_updates_->size());
+    const auto now = Common::getCurrentNanos();
+    if (LIKELY(now - last_stats_time_ < MD_STATS_INTERVAL))
+      return;
+    last_stats_time_ = now;
+
+    const auto num_in_recovery = std::count_if(ticker_sync_.begin(), ticker_sync_.end(), [](const auto &ticker) { return ticker.in_recovery_; });
+
+    std::stringstream ss;
+    ss << "gaps:" << num_inc_gaps_ << " duplicates:" << num_duplicates_ << " recoveries:" << num_recoveries_ << " in-recovery:" << num_in_recovery
+       << " recovery-time:" << recovery_time_ << " max-recovery-backlog:" << max_recovery_backlog_ << " snapshot-only-recoveries:" << num_snapshot_only_recoveries_
+       << " invalid-tickers:" << num_invalid_tickers_ << " max-queue-backlog:" << max_queue_backlog_;
+    for (const auto &channel: incremental_channels_) {
+      if (channel.socket_.fault_injector_)
+        ss << " channel:" << channel.channel_id_ << " A:" << channel.socket_.fault_injector_->toString();
+      if (channel.b_socket_.fault_injector_)
+        ss << " B:" << channel.b_socket_.fault_injector_->toString();
+    }
+
+    auto stats = ss.str();
+    if (stats != last_stats_) {
+      logger_.log("%:% %() % Stats %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), stats);
+      last_stats_ = std::move(stats);
+    }
+  }
+
+  /// Ask the gap fill server to retransmit the updates of this channel with seq_num_ in [from_seq_num, to_seq_num], if it is reachable and the gap is small enough.
+  auto MarketDataConsumer::requestGapFill(size_t channel_id, size_t from_seq_num, size_t to_seq_num) -> void {
+    if (gap_fill_socket_.disconnected_ || to_seq_num - from_seq_num + 1 > MD_MAX_GAP_FILL) {
+      logger_.log("%:% %() % Not requesting gap fill channel:% [%, %] disconnected:%\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), channel_id, from_seq_num, to_seq_num, gap_fill_socket_.disconnected_);
+      return;
+    }
+
+    const Exchange::MDPGapFillRequest request{channel_id, from_seq_num, to_seq_num};
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), request.toString());
+    gap_fill_socket_.send(&request, sizeof(request));
+    if (!num_gap_fills_pending_)
+      gap_fill_time_ = Common::getCurrentNanos();
+    ++num_gap_fills_pending_;
+  }
+
+  /// Process the gap fill responses and the retransmitted incremental updates following them.
+  auto MarketDataConsumer::gapFillCallback(TCPSocket *socket) noexcept -> void {
+    gap_fill_time_ = Common::getCurrentNanos();
+
+    size_t i = 0;
+    while (true) {
+      if (!gap_fill_updates_remaining_) {
+        if (i + sizeof(Exchange::MDPGapFillResponse) > socket->next_rcv_valid_index_)
+          break;
+
+        const auto response = reinterpret_cast<const Exchange::MDPGapFillResponse *>(socket->inbound_data_.data() + i);
+        i += sizeof(Exchange::MDPGapFillResponse);
+        logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), response->toString());
+
+        gap_fill_updates_remaining_ = response->num_updates_;
+        if (!gap_fill_updates_remaining_) // the range was not in the gap fill server's history.
+          gapFillDone();
+        continue;
+      }
+
+      if (i + sizeof(Exchange::MDPMarketUpdate) > socket->next_rcv_valid_index_)
+        break;
+
+      onIncrementalUpdate(reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->inbound_data_.data() + i));
+      i += sizeof(Exchange::MDPMarketUpdate);
+
+      if (!--gap_fill_updates_remaining_)
+        gapFillDone();
     }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
   }
 
-  /// Start the process of snapshot synchronization by subscribing to the snapshot multicast stream.
-  auto MarketDataConsumer::startSnapshotSync() -> void {
-    snapshot_queued_msgs_.clear();
-    incremental_queued_msgs_.clear();
+  /// A gap fill completed or failed, tickers whose gaps are still open once no more gap fills are pending are recovered from snapshots.
+  auto MarketDataConsumer::gapFillDone() -> void {
+    --num_gap_fills_pending_;
+
+    for (Common::TickerId ticker_id = 0; ticker_id < ticker_sync_.size(); ++ticker_id) {
+      auto &ticker = ticker_sync_[ticker_id];
+      if (ticker.in_recovery_)
+        checkIncrementalSync(ticker_id);
+      if (ticker.in_recovery_ && !ticker.snapshot_sync_ && !num_gap_fills_pending_)
+        startSnapshotSync(ticker_id);
+    }
+  }
+
+  /// Start recovering this ticker, from the pending gap fills if there are any else from the snapshot multicast stream.
+  auto MarketDataConsumer::startRecovery(Common::TickerId ticker_id) -> void {
+    auto &ticker = ticker_sync_[ticker_id];
+    ticker.in_recovery_ = true;
+    ticker.recovery_start_ = Common::getCurrentNanos();
+    ++num_recoveries_;
+    ticker.snapshot_msgs_.reset();
+    ticker.recovery_seen_end_ = ticker.next_exp_seq_num_;
+    ticker.incremental_msgs_ = incremental_pool_.acquire(ticker.next_exp_seq_num_);
+    if (UNLIKELY(!ticker.incremental_msgs_)) { // gap fills and snapshots older than the updates seen need the updates queued up.
+      ++num_snapshot_only_recoveries_;
+      logger_.log("%:% %() % No incremental recovery buffer free for ticker:%, recovering from snapshots only.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), ticker_id);
+      startSnapshotSync(ticker_id);
+      return;
+    }
+
+    if (!num_gap_fills_pending_)
+      startSnapshotSync(ticker_id);
+  }
+
+  /// Start the process of snapshot synchronization for this ticker, subscribing to the snapshot multicast stream if no other ticker is synchronizing.
+  auto MarketDataConsumer::startSnapshotSync(Common::TickerId ticker_id) -> void {
+    ticker_sync_[ticker_id].snapshot_sync_ = true;
+    if (num_snapshot_syncs_++)
+      return;
 
     ASSERT(snapshot_mcast_socket_.init(snapshot_ip_, iface_, snapshot_port_, /*is_listening*/ true) >= 0,
            "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
@@ -43,141 +241,164 @@ namespace Trading {
            "Join failed on:" + std::to_string(snapshot_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
   }
 
-  /// Check if a recovery / synchronization is possible from the queued up market data updates from the snapshot and incremental market data streams.
-  auto MarketDataConsumer::checkSnapshotSync() -> void {
-    if (snapshot_queued_msgs_.empty()) {
-      return;
+  /// The ticker is in sync again and expects next_exp_seq_num next, leave the snapshot multicast stream if no other ticker is synchronizing.
+  auto MarketDataConsumer::finishRecovery(Common::TickerId ticker_id, size_t next_exp_seq_num) -> void {
+    auto &ticker = ticker_sync_[ticker_id];
+    recovery_time_ += Common::getCurrentNanos() - ticker.recovery_start_;
+
+    ticker.snapshot_msgs_.reset();
+    const auto incremental_msgs = ticker.incremental_msgs_;
+    ticker.incremental_msgs_ = nullptr;
+    ticker.next_exp_seq_num_ = next_exp_seq_num;
+    ticker.in_recovery_ = false;
+
+    if (ticker.snapshot_sync_) {
+      ticker.snapshot_sync_ = false;
+      if (!--num_snapshot_syncs_)
+        snapshot_mcast_socket_.leave(snapshot_ip_, snapshot_port_);
     }
 
-    const auto &first_snapshot_msg = snapshot_queued_msgs_.begin()->second;
-    if (first_snapshot_msg.type_ != Exchange::MarketUpdateType::SNAPSHOT_START) {
-      logger_.log("%:% %() % Returning because have not seen a SNAPSHOT_START yet.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+    if (!incremental_msgs)
       return;
-    }
 
-    std::vector<Exchange::MEMarketUpdate> final_events;
+    max_recovery_backlog_ = std::max(max_recovery_backlog_.load(), incremental_msgs->end() - incremental_msgs->begin());
+    incremental_pool_.release(incremental_msgs);
 
-    auto have_complete_snapshot = true;
-    size_t next_snapshot_seq = 0;
-    for (auto &snapshot_itr: snapshot_queued_msgs_) {
-      logger_.log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), snapshot_itr.first, snapshot_itr.second.toString());
-      if (snapshot_itr.first != next_snapshot_seq) {
-        have_complete_snapshot = false;
-        logger_.log("%:% %() % Detected gap in snapshot stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), next_snapshot_seq, snapshot_itr.first, snapshot_itr.second.toString());
+    // Hand the buffer over to a ticker recovering without one, it queues up the incremental updates from the last one it has seen on.
+    for (auto &other: ticker_sync_) {
+      if (other.in_recovery_ && !other.incremental_msgs_) {
+        other.incremental_msgs_ = incremental_pool_.acquire(other.recovery_seen_end_);
         break;
       }
-
-      if (snapshot_itr.second.type_ != Exchange::MarketUpdateType::SNAPSHOT_START &&
-          snapshot_itr.second.type_ != Exchange::MarketUpdateType::SNAPSHOT_END)
-        final_events.push_back(snapshot_itr.second);
-
-      ++next_snapshot_seq;
     }
+  }
 
-    if (!have_complete_snapshot) {
-      logger_.log("%:% %() % Returning because found gaps in snapshot stream.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+  /// Check if this ticker's queued incremental updates follow on from the last one processed without gaps, i.e. the gap fills closed its gap.
+  auto MarketDataConsumer::checkIncrementalSync(Common::TickerId ticker_id) -> void {
+    auto &ticker = ticker_sync_[ticker_id];
+    if (!ticker.incremental_msgs_)
       return;
-    }
 
-    const auto &last_snapshot_msg = snapshot_queued_msgs_.rbegin()->second;
-    if (last_snapshot_msg.type_ != Exchange::MarketUpdateType::SNAPSHOT_END) {
-      logger_.log("%:% %() % Returning because have not seen a SNAPSHOT_END yet.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+    const auto &incremental_msgs = *ticker.incremental_msgs_;
+    if (incremental_msgs.empty() || incremental_msgs.begin() != ticker.next_exp_seq_num_ || incremental_msgs.next() != incremental_msgs.end())
       return;
+
+    for (auto seq_num = incremental_msgs.begin(); seq_num < incremental_msgs.end(); ++seq_num) {
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = incremental_msgs.at(seq_num);
+      incoming_md_updates_->updateWriteIndex();
     }
 
-    auto have_complete_incremental = true;
-    size_t num_incrementals = 0;
-    next_exp_inc_seq_num_ = last_snapshot_msg.order_id_ + 1;
-    for (auto inc_itr = incremental_queued_msgs_.begin(); inc_itr != incremental_queued_msgs_.end(); ++inc_itr) {
-      logger_.log("%:% %() % Checking next_exp:% vs. seq:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), next_exp_inc_seq_num_, inc_itr->first, inc_itr->second.toString());
+    logger_.log("%:% %() % Recovered ticker:% from % gap filled and queued incremental updates.\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), ticker_id, incremental_msgs.end() - incremental_msgs.begin());
 
-      if (inc_itr->first < next_exp_inc_seq_num_)
-        continue;
+    finishRecovery(ticker_id, incremental_msgs.end());
+  }
 
-      if (inc_itr->first != next_exp_inc_seq_num_) {
-        logger_.log("%:% %() % Detected gap in incremental stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), next_exp_inc_seq_num_, inc_itr->first, inc_itr->second.toString());
-        have_complete_incremental = false;
-        break;
+  /// Check if a recovery / synchronization of this ticker is possible from its complete snapshot and the incremental updates queued up after it.
+  auto MarketDataConsumer::checkSnapshotSync(Common::TickerId ticker_id) -> void {
+    auto &ticker = ticker_sync_[ticker_id];
+    auto &snapshot_msgs = ticker.snapshot_msgs_;
+
+    // The snapshot is consistent with this ticker's incremental updates up to tickerSeqNum(), the queued ones after it have to follow without gaps.
+    // Without queued incremental updates it has to be at least as recent as the last update seen, the incremental stream carries on from it.
+    const auto next_exp_seq_num = snapshot_msgs.tickerSeqNum() + 1;
+    if (UNLIKELY(!ticker.incremental_msgs_)) {
+      if (next_exp_seq_num < ticker.recovery_seen_end_) {
+        logger_.log("%:% %() % Returning because snapshot for ticker:% ticker-seq:% is older than the updates seen:%.\n", __FILE__, __LINE__,
+                    __FUNCTION__, Common::getCurrentTimeStr(&time_str_), ticker_id, snapshot_msgs.tickerSeqNum(), ticker.recovery_seen_end_);
+        snapshot_msgs.reset();
+        return;
       }
 
-      logger_.log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), inc_itr->first, inc_itr->second.toString());
+      for (const auto &market_update: snapshot_msgs.updates()) {
+        auto next_write = incoming_md_updates_->getNextToWriteTo();
+        *next_write = market_update;
+        incoming_md_updates_->updateWriteIndex();
+      }
 
-      if (inc_itr->second.type_ != Exchange::MarketUpdateType::SNAPSHOT_START &&
-          inc_itr->second.type_ != Exchange::MarketUpdateType::SNAPSHOT_END)
-        final_events.push_back(inc_itr->second);
+      logger_.log("%:% %() % Recovered ticker:% from % snapshot orders only.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), ticker_id, snapshot_msgs.updates().size() - 1);
 
-      ++next_exp_inc_seq_num_;
-      ++num_incrementals;
+      finishRecovery(ticker_id, next_exp_seq_num);
+      return;
     }
 
-    if (!have_complete_incremental) {
-      logger_.log("%:% %() % Returning because have gaps in queued incrementals.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+    const auto &incremental_msgs = *ticker.incremental_msgs_;
+    if (next_exp_seq_num < incremental_msgs.begin() || !incremental_msgs.contiguousFrom(next_exp_seq_num)) {
+      logger_.log("%:% %() % Returning because have gaps in queued incrementals for ticker:% snapshot ticker-seq:% queued:[%, %) watermark:%.\n",
+                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), ticker_id, snapshot_msgs.tickerSeqNum(),
+                  incremental_msgs.begin(), incremental_msgs.end(), incremental_msgs.next());
+      snapshot_msgs.reset();
       return;
     }
 
-    for (const auto &itr: final_events) {
+    for (const auto &market_update: snapshot_msgs.updates()) {
       auto next_write = incoming_md_updates_->getNextToWriteTo();
-      *next_write = itr;
+      *next_write = market_update;
       incoming_md_updates_->updateWriteIndex();
     }
 
-    logger_.log("%:% %() % Recovered % snapshot and % incremental orders.\n", __FILE__, __LINE__, __FUNCTION__,
-                Common::getCurrentTimeStr(&time_str_), snapshot_queued_msgs_.size() - 2, num_incrementals);
+    const auto end_seq_num = std::max(incremental_msgs.end(), next_exp_seq_num);
+    for (auto seq_num = next_exp_seq_num; seq_num < end_seq_num; ++seq_num) {
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = incremental_msgs.at(seq_num);
+      incoming_md_updates_->updateWriteIndex();
+    }
 
-    snapshot_queued_msgs_.clear();
-    incremental_queued_msgs_.clear();
-    in_recovery_ = false;
+    logger_.log("%:% %() % Recovered ticker:% from % snapshot and % incremental orders.\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), ticker_id, snapshot_msgs.updates().size() - 1, end_seq_num - next_exp_seq_num);
 
-    snapshot_mcast_socket_.leave(snapshot_ip_, snapshot_port_);;
+    finishRecovery(ticker_id, end_seq_num);
   }
 
-  /// Queue up a message in the *_queued_msgs_ containers, first parameter specifies if this update came from the snapshot or the incremental streams.
+  /// Queue up a message in the ticker's recovery buffers, first parameter specifies if this update came from the snapshot or the incremental streams.
   auto MarketDataConsumer::queueMessage(bool is_snapshot, const Exchange::MDPMarketUpdate *request) {
+    const auto ticker_id = request->me_market_update_.ticker_id_;
+    auto &ticker = ticker_sync_[ticker_id];
+    logger_.log("%:% %() % ticker:% queued snapshot:% seen:% buffered:% % => %\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), ticker_id, ticker.snapshot_msgs_.updates().size(), ticker.recovery_seen_end_,
+                (ticker.incremental_msgs_ ? ticker.incremental_msgs_->end() - ticker.incremental_msgs_->begin() : 0), request->seq_num_,
+                request->toString());
+
     if (is_snapshot) {
-      if (snapshot_queued_msgs_.find(request->seq_num_) != snapshot_queued_msgs_.end()) {
-        logger_.log("%:% %() % Packet drops on snapshot socket. Received for a 2nd time:%\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), request->toString());
-        snapshot_queued_msgs_.clear();
-      }
-      snapshot_queued_msgs_[request->seq_num_] = request->me_market_update_;
+      if (!ticker.snapshot_msgs_.add(*request))
+        logger_.log("%:% %() % Packet drops on snapshot socket, discarded partial snapshot for ticker:% at:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), ticker_id, request->toString());
+      if (ticker.snapshot_msgs_.complete())
+        checkSnapshotSync(ticker_id);
     } else {
-      incremental_queued_msgs_[request->seq_num_] = request->me_market_update_;
+      ticker.recovery_seen_end_ = std::max(ticker.recovery_seen_end_, static_cast<size_t>(request->ticker_seq_num_) + 1);
+      if (ticker.incremental_msgs_) {
+        ticker.incremental_msgs_->insert(request->ticker_seq_num_, request->me_market_update_);
+        checkIncrementalSync(ticker_id);
+      }
     }
-
-    logger_.log("%:% %() % size snapshot:% incremental:% % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                Common::getCurrentTimeStr(&time_str_), snapshot_queued_msgs_.size(), incremental_queued_msgs_.size(), request->seq_num_, request->toString());
-
-    checkSnapshotSync();
   }
-
-  /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
-  auto MarketDataConsumer::recvCallback(McastSocket *socket) noexcept -> void {
+  /// Process market data updates read from a socket, channel is the incremental channel the socket belongs to or nullptr for the snapshot stream.
+  auto MarketDataConsumer::recvCallback(McastSocket *socket, IncrementalChannel *channel, bool is_feed_b) noexcept -> void {
     TTT_MEASURE(T7_MarketDataConsumer_UDP_read, logger_);
 
     START_MEASURE(Trading_MarketDataConsumer_recvCallback);
-    const auto is_snapshot = (socket->socket_fd_ == snapshot_mcast_socket_.socket_fd_);
-    if (UNLIKELY(is_snapshot && !in_recovery_)) { // market update was read from the snapshot market data stream and we are not in recovery, so we dont need it and discard it.
-      socket->next_rcv_valid_index_ = 0;
-
-      logger_.log("%:% %() % WARN Not expecting snapshot messages.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-
-      return;
-    }
-
-    if (socket->next_rcv_valid_index_ >= sizeof(Exchange::MDPMarketUpdate)) {
+    const auto is_snapshot = (channel == nullptr);
+    if (!is_snapshot && channel->compact_) {
+      size_t i = 0;
+      for (auto packet_len = Exchange::mdpWirePacketLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); packet_len;
+           i += packet_len, packet_len = Exchange::mdpWirePacketLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+        const auto decoded = wire_decoder_.decode(socket->inbound_data_.data() + i, [this, channel, is_feed_b](const Exchange::MDPMarketUpdate &request) {
+          logger_.log("%:% %() % Received compact incremental %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                      request.toString());
+          onFeedUpdate(*channel, is_feed_b, &request);
+        });
+        if (UNLIKELY(!decoded)) { // the updates skipped leave a gap on the channel, recovered like a lost packet.
+          ++num_invalid_tickers_;
+          logger_.log("%:% %() % Skipped the rest of a compact packet at a ticker beyond max-tickers:%\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), ticker_sync_.size());
+        }
+      }
+      memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+      socket->next_rcv_valid_index_ -= i;
+    } else if (socket->next_rcv_valid_index_ >= sizeof(Exchange::MDPMarketUpdate)) {
       size_t i = 0;
       for (; i + sizeof(Exchange::MDPMarketUpdate) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::MDPMarketUpdate)) {
         auto request = reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->inbound_data_.data() + i);
@@ -185,32 +406,137 @@ namespace Trading {
                     Common::getCurrentTimeStr(&time_str_),
                     (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), request->toString());
 
-        const bool already_in_recovery = in_recovery_;
-        in_recovery_ = (already_in_recovery || request->seq_num_ != next_exp_inc_seq_num_);
-
-        if (UNLIKELY(in_recovery_)) {
-          if (UNLIKELY(!already_in_recovery)) { // if we just entered recovery, start the snapshot synchonization process by subscribing to the snapshot multicast stream.
-            logger_.log("%:% %() % Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), (is_snapshot ? "snapshot" : "incremental"), next_exp_inc_seq_num_, request->seq_num_);
-            startSnapshotSync();
-          }
+        const auto ticker_id = request->me_market_update_.ticker_id_;
+        if (UNLIKELY(ticker_id == Common::TickerId_INVALID))
+          continue;
 
-          queueMessage(is_snapshot, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
-        } else if (!is_snapshot) { // not in recovery and received a packet in the correct order and without gaps, process it.
-          logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), request->toString());
-
-          ++next_exp_inc_seq_num_;
-
-          auto next_write = incoming_md_updates_->getNextToWriteTo();
-          *next_write = std::move(request->me_market_update_);
-          incoming_md_updates_->updateWriteIndex();
-          TTT_MEASURE(T8_MarketDataConsumer_LFQueue_write, logger_);
+        if (is_snapshot) { // snapshots are only needed for tickers synchronizing from them, the others keep being updated from the incremental channels.
+          if (ticker_id < ticker_sync_.size() && ticker_sync_[ticker_id].snapshot_sync_)
+            queueMessage(is_snapshot, request);
+          continue;
         }
+
+        onFeedUpdate(*channel, is_feed_b, request);
       }
       memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
       socket->next_rcv_valid_index_ -= i;
     }
     END_MEASURE(Trading_MarketDataConsumer_recvCallback, logger_);
   }
+
+  /// Arbitrate between the feeds of an incremental channel - process updates in sequence number order, the first copy to arrive on either feed, and
+  /// request the gap from the gap fill server if an update does not arrive on either within the reorder window.
+  auto MarketDataConsumer::onFeedUpdate(IncrementalChannel &channel, bool is_feed_b, const Exchange::MDPMarketUpdate *request) noexcept -> void {
+    const auto seq_num = request->seq_num_;
+    channel.feed_next_seq_num_[is_feed_b] = std::max(channel.feed_next_seq_num_[is_feed_b], seq_num + 1);
+
+    if (seq_num < channel.next_exp_seq_num_ ||
+        (seq_num < channel.next_exp_seq_num_ + MD_ARBITRATION_WINDOW && channel.pending_present_[seq_num % MD_ARBITRATION_WINDOW])) {
+      ++num_duplicates_; // already received on the other feed.
+    } else if (LIKELY(seq_num == channel.next_exp_seq_num_)) {
+      ++channel.next_exp_seq_num_;
+      onIncrementalUpdate(request);
+      releasePendingIncrementals(channel);
+    } else {
+      // Ahead of the next expected update, make room for it if it is beyond the window and hold it back.
+      while (seq_num >= channel.next_exp_seq_num_ + MD_ARBITRATION_WINDOW) {
+        if (!channel.num_pending_) { // nothing held back, e.g. joined after the start of the session.
+          ++num_inc_gaps_;
+          requestGapFill(channel.channel_id_, channel.next_exp_seq_num_, seq_num - 1);
+          channel.next_exp_seq_num_ = seq_num;
+          break;
+        }
+        skipIncrementalGap(channel);
+      }
+
+      if (!channel.num_pending_)
+        channel.pending_since_ = Common::getCurrentNanos();
+      channel.pending_updates_[seq_num % MD_ARBITRATION_WINDOW] = *request;
+      channel.pending_present_[seq_num % MD_ARBITRATION_WINDOW] = true;
+      ++channel.num_pending_;
+      releasePendingIncrementals(channel);
+    }
+
+    if (UNLIKELY(channel.num_pending_))
+      checkReorderWindow(channel, false);
+  }
+
+  /// Declare the gap in front of the held back updates once the reorder window is exceeded. The time limit is only checked once the feeds have
+  /// nothing more to read, so that the consumer thread being descheduled does not count against updates waiting in the other feed's socket.
+  auto MarketDataConsumer::checkReorderWindow(IncrementalChannel &channel, bool feeds_idle) noexcept -> void {
+    while (channel.num_pending_) {
+      const auto feeds_next_seq_num = (channel.num_feeds_ > 1 ? std::min(channel.feed_next_seq_num_[0], channel.feed_next_seq_num_[1]) :
+                                       channel.feed_next_seq_num_[0]);
+      const auto feeds_passed = (feeds_next_seq_num > channel.next_exp_seq_num_ + 1);
+      if (!(feeds_passed && channel.num_pending_ > reorder_cfg_.max_msgs_) &&
+          !(feeds_idle && Common::getCurrentNanos() - channel.pending_since_ >= reorder_cfg_.max_time_))
+        return;
+
+      skipIncrementalGap(channel);
+      channel.pending_since_ = Common::getCurrentNanos(); // the next gap, if any, gets a reorder window of its own.
+    }
+  }
+
+  /// Process the held back updates of this channel following on from its next_exp_seq_num_.
+  auto MarketDataConsumer::releasePendingIncrementals(IncrementalChannel &channel) noexcept -> void {
+    while (channel.num_pending_ && channel.pending_present_[channel.next_exp_seq_num_ % MD_ARBITRATION_WINDOW]) {
+      channel.pending_present_[channel.next_exp_seq_num_ % MD_ARBITRATION_WINDOW] = false;
+      --channel.num_pending_;
+      onIncrementalUpdate(&channel.pending_updates_[channel.next_exp_seq_num_ % MD_ARBITRATION_WINDOW]);
+      ++channel.next_exp_seq_num_;
+    }
+  }
+
+  /// Give up on the updates missing before the next held back one, request them from the gap fill server and process the held back ones.
+  auto MarketDataConsumer::skipIncrementalGap(IncrementalChannel &channel) noexcept -> void {
+    auto seq_num = channel.next_exp_seq_num_;
+    while (!channel.pending_present_[seq_num % MD_ARBITRATION_WINDOW])
+      ++seq_num;
+
+    logger_.log("%:% %() % Packet drops on incremental channel:%. SeqNum expected:% next received:% held back:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), channel.channel_id_, channel.next_exp_seq_num_, seq_num, channel.num_pending_);
+    ++num_inc_gaps_;
+    requestGapFill(channel.channel_id_, channel.next_exp_seq_num_, seq_num - 1);
+    channel.next_exp_seq_num_ = seq_num;
+    releasePendingIncrementals(channel);
+  }
+
+  /// Process an incremental update read from an incremental channel or retransmitted by the gap fill server, checking for gaps in its ticker's updates.
+  auto MarketDataConsumer::onIncrementalUpdate(const Exchange::MDPMarketUpdate *request) noexcept -> void {
+    const auto ticker_id = request->me_market_update_.ticker_id_;
+    if (!isSubscribed(ticker_id)) // only needed to sequence its channel.
+      return;
+
+    if (UNLIKELY(ticker_id >= ticker_sync_.size())) {
+      ++num_invalid_tickers_;
+      logger_.log("%:% %() % Dropping update of ticker:% beyond max-tickers:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), ticker_id, ticker_sync_.size(), request->toString());
+      return;
+    }
+    auto &ticker = ticker_sync_[ticker_id];
+
+    if (UNLIKELY(!ticker.in_recovery_ && request->ticker_seq_num_ != ticker.next_exp_seq_num_)) {
+      if (request->ticker_seq_num_ < ticker.next_exp_seq_num_) // already processed, e.g. retransmitted as part of a larger gap.
+        return;
+
+      // A gap in this ticker's updates, start recovering this ticker only.
+      logger_.log("%:% %() % Packet drops for ticker:%. TickerSeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), ticker_id, ticker.next_exp_seq_num_, request->ticker_seq_num_);
+      startRecovery(ticker_id);
+    }
+
+    if (UNLIKELY(ticker.in_recovery_)) {
+      queueMessage(false, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
+    } else { // not in recovery and received a packet in the correct order and without gaps, process it.
+      logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), request->toString());
+
+      ++ticker.next_exp_seq_num_;
+
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = request->me_market_update_;
+      incoming_md_updates_->updateWriteIndex();
+      TTT_MEASURE(T8_MarketDataConsumer_LFQueue_write, logger_);
+    }
+  }
 }
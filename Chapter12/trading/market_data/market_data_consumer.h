@@ -1,21 +1,84 @@
 #pragma once
 
 #include <functional>
-#include <map>
+#include <sstream>
 
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
 #include "common/mcast_socket.h"
+#include "common/tcp_socket.h"
 
 #include "exchange/market_data/market_update.h"
+#include "exchange/market_data/market_data_wire.h"
+
+#include "market_data/recovery_buffers.h"
 
 namespace Trading {
+  /// Largest gap on an incremental channel requested from the gap fill server, larger gaps are recovered from snapshots straight away.
+  constexpr size_t MD_MAX_GAP_FILL = 16 * 1024;
+
+  /// Longest the gap fill server may go without answering while gap fills are pending, after that the connection is dropped and the gaps are
+  /// recovered from snapshots.
+  constexpr Common::Nanos MD_GAP_FILL_TIMEOUT = Common::NANOS_TO_SECS;
+
+  /// Most incremental updates held back while waiting for a missing one, the gap is requested from the gap fill server when this is exceeded
+  /// regardless of ReorderCfg.
+  constexpr size_t MD_ARBITRATION_WINDOW = 1024;
+
+  /// The recovery counters, the backlog of the lock free queue to the trade engine and the faults injected are logged this often while they change.
+  constexpr Common::Nanos MD_STATS_INTERVAL = Common::NANOS_TO_SECS;
+
+  /// How long incremental updates arriving ahead of a missing one are held back, waiting for it to arrive late on either feed, before the gap
+  /// is requested from the gap fill server and the affected tickers go into recovery.
+  struct ReorderCfg {
+    /// Once every feed has delivered an update past the missing one, the gap is declared as soon as more than max_msgs_ updates are held back.
+    size_t max_msgs_ = 8;
+
+    /// The gap is declared once the first update held back has waited for max_time_ and there is nothing more to read on the feeds, even if a feed
+    /// has not gone past the missing update.
+    Common::Nanos max_time_ = 200 * Common::NANOS_TO_MICROS;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "ReorderCfg{"
+         << "max-msgs:" << max_msgs_ << " "
+         << "max-time:" << max_time_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// How the incremental updates of the tickers in recovery are queued up, see IncrementalRecoveryPool.
+  struct RecoveryCfg {
+    /// Most incremental updates queued up per ticker in recovery.
+    size_t window_ = MD_RECOVERY_WINDOW;
+
+    /// Number of recovery buffers allocated up front, a ticker going into recovery while all of them are in use recovers from snapshots only.
+    size_t num_buffers_ = MD_RECOVERY_BUFFERS;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "RecoveryCfg{"
+         << "window:" << window_ << " "
+         << "buffers:" << num_buffers_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
   class MarketDataConsumer {
   public:
+    /// Only the updates of the tickers listed are pushed to the trade engine and only the incremental channels they are published on are joined,
+    /// an empty list subscribes to every ticker. Updates of TickerIds beyond limits.max_tickers_ are dropped.
     MarketDataConsumer(Common::ClientId client_id, Exchange::MEMarketUpdateLFQueue *market_updates, const std::string &iface,
                        const std::string &snapshot_ip, int snapshot_port,
-                       const std::string &incremental_ip, int incremental_port);
+                       const std::vector<Exchange::IncrementalChannelCfg> &incremental_channels, const std::vector<Common::TickerId> &tickers,
+                       const std::string &gap_fill_ip, int gap_fill_port, const ReorderCfg &reorder_cfg = ReorderCfg(),
+                       const Common::FaultCfg &fault_cfg = Common::FaultCfg(), const Common::EngineLimits &limits = Common::EngineLimits(),
+                       const RecoveryCfg &recovery_cfg = RecoveryCfg());
 
     ~MarketDataConsumer() {
       stop();
@@ -34,6 +97,40 @@ namespace Trading {
       run_ = false;
     }
 
+    /// Number of gaps on the incremental channels, i.e. updates missed on every feed of a channel, and of duplicate updates discarded.
+    auto numIncrementalGaps() const noexcept {
+      return num_inc_gaps_.load();
+    }
+
+    auto numDuplicates() const noexcept {
+      return num_duplicates_.load();
+    }
+
+    /// Number of times a ticker went into recovery.
+    auto numRecoveries() const noexcept {
+      return num_recoveries_.load();
+    }
+
+    /// Total time tickers spent in recovery, counting the recoveries finished so far.
+    auto recoveryTime() const noexcept {
+      return recovery_time_.load();
+    }
+
+    /// Most incremental updates of a ticker queued up while it was in recovery.
+    auto maxRecoveryBacklog() const noexcept {
+      return max_recovery_backlog_.load();
+    }
+
+    /// Number of recoveries started without an incremental recovery buffer, because more tickers than RecoveryCfg::num_buffers_ were in recovery.
+    auto numSnapshotOnlyRecoveries() const noexcept {
+      return num_snapshot_only_recoveries_.load();
+    }
+
+    /// Number of incremental updates dropped because their TickerId is beyond EngineLimits::max_tickers_.
+    auto numInvalidTickers() const noexcept {
+      return num_invalid_tickers_.load();
+    }
+
     /// Deleted default, copy & move constructors and assignment-operators.
     MarketDataConsumer() = delete;
 
@@ -46,8 +143,21 @@ namespace Trading {
     MarketDataConsumer &operator=(const MarketDataConsumer &&) = delete;
 
   private:
-    /// Track the next expected sequence number on the incremental market data stream, used to detect gaps / drops.
-    size_t next_exp_inc_seq_num_ = 1;
+    const ReorderCfg reorder_cfg_;
+
+    /// Tickers whose updates are pushed to the trade engine indexed by TickerId, empty if subscribed to every ticker. The updates of the other tickers
+    /// published on the joined channels are dropped as soon as they have been sequenced.
+    std::vector<bool> subscribed_tickers_;
+
+    std::atomic<size_t> num_inc_gaps_ = {0}, num_duplicates_ = {0}, num_recoveries_ = {0};
+    std::atomic<Common::Nanos> recovery_time_ = {0};
+    std::atomic<size_t> max_recovery_backlog_ = {0};
+    std::atomic<size_t> num_snapshot_only_recoveries_ = {0}, num_invalid_tickers_ = {0};
+
+    /// Most updates seen queued up to the trade engine and the stats last logged, see logStats().
+    Common::Nanos last_stats_time_ = 0;
+    size_t max_queue_backlog_ = 0;
+    std::string last_stats_;
 
     /// Lock free queue on which decoded market data updates are pushed to, to be consumed by the trade engine.
     Exchange::MEMarketUpdateLFQueue *incoming_md_updates_ = nullptr;
@@ -57,34 +167,136 @@ namespace Trading {
     std::string time_str_;
     Logger logger_;
 
-    /// Multicast subscriber sockets for the incremental and market data streams.
-    Common::McastSocket incremental_mcast_socket_, snapshot_mcast_socket_;
+    /// An incremental channel joined by this consumer, with its own seq_num_ sequence and arbitration state.
+    struct IncrementalChannel {
+      IncrementalChannel(size_t channel_id, bool compact, Logger &logger)
+          : channel_id_(channel_id), compact_(compact), pending_updates_(MD_ARBITRATION_WINDOW), pending_present_(MD_ARBITRATION_WINDOW, false),
+            socket_(logger), b_socket_(logger) {
+      }
+
+      size_t channel_id_ = 0;
+
+      /// Updates arrive in the compact encoding of market_data_wire.h instead of as raw MDPMarketUpdate structs.
+      bool compact_ = false;
+
+      /// Track the next expected sequence number on this channel, used to request gap fills for the updates dropped.
+      size_t next_exp_seq_num_ = 1;
+
+      /// Updates ahead of next_exp_seq_num_ are held back here, indexed by seq_num_ % MD_ARBITRATION_WINDOW, until the missing ones arrive late
+      /// or the reorder window is exceeded. num_pending_ of them have been held back since pending_since_.
+      std::vector<Exchange::MDPMarketUpdate> pending_updates_;
+      std::vector<bool> pending_present_;
+      size_t num_pending_ = 0;
+      Common::Nanos pending_since_ = 0;
+
+      /// One past the highest sequence number received on each of the A and B feeds.
+      size_t num_feeds_ = 1;
+      size_t feed_next_seq_num_[2] = {1, 1};
+
+      /// Multicast subscriber sockets for the A and B feeds, the B feed socket is only used if a B feed is configured.
+      Common::McastSocket socket_, b_socket_;
+    };
+
+    std::vector<IncrementalChannel> incremental_channels_;
 
-    /// Tracks if we are currently in the process of recovering / synchronizing with the snapshot market data stream either because we just started up or we dropped a packet.
-    bool in_recovery_ = false;
+    /// Decodes the packets read off the compact incremental channels.
+    Exchange::MDPWireDecoder wire_decoder_;
+
+    /// Multicast subscriber socket for the snapshot stream.
+    Common::McastSocket snapshot_mcast_socket_;
+
+    /// Connection to the exchange's gap fill server, dropped incremental updates are requested from it before falling back to snapshots.
+    Common::TCPSocket gap_fill_socket_;
+    size_t num_gap_fills_pending_ = 0;
+
+    /// When the last gap fill was requested or data was last read from the gap fill server, to time out pending gap fills.
+    Common::Nanos gap_fill_time_ = 0;
+
+    /// Number of retransmitted updates still to be read for the gap fill response currently being read.
+    size_t gap_fill_updates_remaining_ = 0;
 
     /// Information for the snapshot multicast stream.
     const std::string iface_, snapshot_ip_;
     const int snapshot_port_;
 
-    /// Containers to queue up market data updates from the snapshot and incremental channels, queued up in order of increasing sequence numbers.
-    typedef std::map<size_t, Exchange::MEMarketUpdate> QueuedMarketUpdates;
-    QueuedMarketUpdates snapshot_queued_msgs_, incremental_queued_msgs_;
+    /// Gap detection and recovery state of one ticker, each ticker recovers from its own snapshots while the others keep being updated.
+    struct TickerSync {
+      /// Next expected ticker_seq_num_ for this ticker on the incremental market data stream.
+      size_t next_exp_seq_num_ = 1;
+
+      /// Tracks if we are currently in the process of recovering this ticker, either because its first update was not the first one published
+      /// or we dropped one of its updates. It is recovered from gap fills if possible, else snapshot_sync_ is set to synchronize it from snapshots.
+      bool in_recovery_ = false;
+      bool snapshot_sync_ = false;
+      Common::Nanos recovery_start_ = 0;
+
+      /// Snapshot messages and incremental updates queued up while in recovery, the latter indexed by their ticker_seq_num_ in a buffer taken from
+      /// incremental_pool_ for the duration of the recovery. Without a free buffer incremental_msgs_ stays nullptr until another ticker releases one.
+      SnapshotRecoveryBuffer snapshot_msgs_;
+      IncrementalRecoveryBuffer *incremental_msgs_ = nullptr;
+
+      /// One past the highest ticker_seq_num_ seen while in recovery, without incremental_msgs_ only a snapshot at least that recent is consistent.
+      size_t recovery_seen_end_ = 0;
+    };
+
+    /// Hash map from TickerId -> TickerSync, sized for EngineLimits::max_tickers_ up front.
+    std::vector<TickerSync> ticker_sync_;
+
+    IncrementalRecoveryPool incremental_pool_;
+
+    /// The snapshot multicast stream is subscribed to while at least one ticker is synchronizing from snapshots.
+    size_t num_snapshot_syncs_ = 0;
 
   private:
     /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the recvCallback() and checkSnapshotSync() methods.
     auto run() noexcept -> void;
 
-    /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
-    auto recvCallback(McastSocket *socket) noexcept -> void;
+    auto isSubscribed(Common::TickerId ticker_id) const noexcept {
+      return subscribed_tickers_.empty() || (ticker_id < subscribed_tickers_.size() && subscribed_tickers_[ticker_id]);
+    }
+
+    /// Process market data updates read from a socket, channel is the incremental channel the socket belongs to or nullptr for the snapshot stream.
+    auto recvCallback(McastSocket *socket, IncrementalChannel *channel, bool is_feed_b) noexcept -> void;
 
-    /// Queue up a message in the *_queued_msgs_ containers, first parameter specifies if this update came from the snapshot or the incremental streams.
+    /// Queue up a message in the ticker's recovery buffers, first parameter specifies if this update came from the snapshot or the incremental streams.
     auto queueMessage(bool is_snapshot, const Exchange::MDPMarketUpdate *request);
 
-    /// Start the process of snapshot synchronization by subscribing to the snapshot multicast stream.
-    auto startSnapshotSync() -> void;
+    /// Arbitrate between the feeds of an incremental channel - process updates in sequence number order, the first copy to arrive on either feed, and
+    /// request the gap from the gap fill server if an update was missed on both.
+    auto onFeedUpdate(IncrementalChannel &channel, bool is_feed_b, const Exchange::MDPMarketUpdate *request) noexcept -> void;
+
+    auto releasePendingIncrementals(IncrementalChannel &channel) noexcept -> void;
+
+    auto skipIncrementalGap(IncrementalChannel &channel) noexcept -> void;
+
+    /// Declare the gap in front of the held back updates once the reorder window is exceeded.
+    auto checkReorderWindow(IncrementalChannel &channel, bool feeds_idle) noexcept -> void;
+
+    /// Process an incremental update read from an incremental channel or retransmitted by the gap fill server.
+    auto onIncrementalUpdate(const Exchange::MDPMarketUpdate *request) noexcept -> void;
+
+    /// Gap fill requests and responses.
+    auto requestGapFill(size_t channel_id, size_t from_seq_num, size_t to_seq_num) -> void;
+
+    auto gapFillCallback(TCPSocket *socket) noexcept -> void;
+
+    auto gapFillDone() -> void;
+
+    /// Start recovering this ticker, from the pending gap fills if there are any else from the snapshot multicast stream.
+    auto startRecovery(Common::TickerId ticker_id) -> void;
+
+    /// Start the process of snapshot synchronization for this ticker, subscribing to the snapshot multicast stream if no other ticker is synchronizing.
+    auto startSnapshotSync(Common::TickerId ticker_id) -> void;
+
+    auto finishRecovery(Common::TickerId ticker_id, size_t next_exp_seq_num) -> void;
+
+    /// Check if a recovery of this ticker is possible from its queued up incremental updates alone, i.e. the gap fills closed its gap.
+    auto checkIncrementalSync(Common::TickerId ticker_id) -> void;
+
+    /// Check if a recovery / synchronization of this ticker is possible from its queued up market data updates from the snapshot and incremental market data streams.
+    auto checkSnapshotSync(Common::TickerId ticker_id) -> void;
 
-    /// Check if a recovery / synchronization is possible from the queued up market data updates from the snapshot and incremental market data streams.
-    auto checkSnapshotSync() -> void;
+    /// Log the recovery counters, the backlog of the lock free queue to the trade engine and the faults injected if they changed since last time.
+    auto logStats() noexcept -> void;
   };
 }
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+
+#include "exchange/market_data/market_update.h"
+
+namespace Trading {
+  /// Default number of incremental updates of a ticker which can be queued up while it is in recovery, older ones are dropped once it is exceeded.
+  constexpr size_t MD_RECOVERY_WINDOW = 64 * 1024;
+
+  /// Default number of IncrementalRecoveryBuffers, i.e. of tickers which can queue up their incremental updates while in recovery at the same time.
+  constexpr size_t MD_RECOVERY_BUFFERS = 4;
+
+  /// Incremental updates of a ticker queued up while it is in recovery, indexed by ticker_seq_num_ % capacity with a bitmap of the ones present.
+  /// Holds ticker_seq_nums in [begin(), end()) and tracks the watermark next(), all updates in [begin(), next()) are present, which is advanced as
+  /// updates arrive so finding out whether the gaps are closed is O(1). Storage is allocated once up front.
+  class IncrementalRecoveryBuffer final {
+  public:
+    explicit IncrementalRecoveryBuffer(size_t capacity = MD_RECOVERY_WINDOW)
+        : updates_(capacity), present_((capacity + 63) / 64, 0) {
+    }
+
+    auto begin() const noexcept {
+      return begin_;
+    }
+
+    auto next() const noexcept {
+      return next_;
+    }
+
+    auto end() const noexcept {
+      return end_;
+    }
+
+    auto empty() const noexcept {
+      return (begin_ == end_);
+    }
+
+    auto at(size_t seq_num) const noexcept -> const Exchange::MEMarketUpdate & {
+      return updates_[seq_num % updates_.size()];
+    }
+
+    /// Drop everything queued, updates older than begin are ignored from now on.
+    auto reset(size_t begin) noexcept -> void {
+      for (auto seq_num = begin_; seq_num < end_; ++seq_num)
+        clear(seq_num);
+      begin_ = next_ = end_ = begin;
+    }
+
+    /// Queue up an update, dropping the oldest ones if it does not fit in the window.
+    auto insert(size_t seq_num, const Exchange::MEMarketUpdate &market_update) noexcept -> void {
+      if (UNLIKELY(seq_num < begin_))
+        return;
+      if (UNLIKELY(seq_num >= begin_ + updates_.size()))
+        advanceTo(seq_num + 1 - updates_.size());
+
+      updates_[seq_num % updates_.size()] = market_update;
+      set(seq_num);
+      end_ = std::max(end_, seq_num + 1);
+      advanceWatermark();
+    }
+
+    /// Drop the updates older than begin.
+    auto advanceTo(size_t begin) noexcept -> void {
+      if (begin <= begin_)
+        return;
+
+      for (auto seq_num = begin_; seq_num < std::min(begin, end_); ++seq_num)
+        clear(seq_num);
+      begin_ = begin;
+      end_ = std::max(end_, begin_);
+      next_ = std::max(next_, begin_);
+      advanceWatermark();
+    }
+
+    /// Returns true if the updates queued from seq_num onwards have no gaps, only needs to look at them if seq_num is past the watermark.
+    auto contiguousFrom(size_t seq_num) const noexcept {
+      if (seq_num <= next_)
+        return (next_ == end_);
+
+      for (; seq_num < end_; ++seq_num) {
+        if (!isSet(seq_num))
+          return false;
+      }
+      return true;
+    }
+
+  private:
+    std::vector<Exchange::MEMarketUpdate> updates_;
+    std::vector<uint64_t> present_;
+
+    size_t begin_ = 1, next_ = 1, end_ = 1;
+
+  private:
+    auto isSet(size_t seq_num) const noexcept -> bool {
+      const auto index = seq_num % updates_.size();
+      return (present_[index / 64] >> (index % 64)) & 1;
+    }
+
+    auto set(size_t seq_num) noexcept -> void {
+      const auto index = seq_num % updates_.size();
+      present_[index / 64] |= (uint64_t{1} << (index % 64));
+    }
+
+    auto clear(size_t seq_num) noexcept -> void {
+      const auto index = seq_num % updates_.size();
+      present_[index / 64] &= ~(uint64_t{1} << (index % 64));
+    }
+
+    auto advanceWatermark() noexcept -> void {
+      while (next_ < end_ && isSet(next_))
+        ++next_;
+    }
+  };
+
+  /// IncrementalRecoveryBuffers shared by the tickers, a ticker only holds one while it is in recovery. All of them are allocated up front, so taking
+  /// one never allocates on the recovery path, a ticker finding none free recovers without one.
+  class IncrementalRecoveryPool final {
+  public:
+    IncrementalRecoveryPool(size_t num_buffers, size_t window) {
+      buffers_.reserve(num_buffers);
+      free_.reserve(num_buffers);
+      for (size_t i = 0; i < num_buffers; ++i)
+        free_.push_back(buffers_.emplace_back(std::make_unique<IncrementalRecoveryBuffer>(window)).get());
+    }
+
+    /// Number of buffers allocated up front.
+    auto size() const noexcept {
+      return buffers_.size();
+    }
+
+    auto numFree() const noexcept {
+      return free_.size();
+    }
+
+    /// Take a buffer queueing updates from begin onwards, nullptr if all of them are in use.
+    auto acquire(size_t begin) noexcept -> IncrementalRecoveryBuffer * {
+      if (UNLIKELY(free_.empty()))
+        return nullptr;
+
+      auto buffer = free_.back();
+      free_.pop_back();
+      buffer->reset(begin);
+      return buffer;
+    }
+
+    auto release(IncrementalRecoveryBuffer *buffer) noexcept -> void {
+      buffer->reset(buffer->end());
+      free_.push_back(buffer);
+    }
+
+  private:
+    std::vector<std::unique_ptr<IncrementalRecoveryBuffer>> buffers_;
+    std::vector<IncrementalRecoveryBuffer *> free_;
+  };
+
+  /// Snapshot run of a ticker being received from the snapshot stream - SNAPSHOT_START, CLEAR, orders, SNAPSHOT_END numbered from 0 - buffered in order.
+  /// Snapshot messages have to arrive without gaps, a partial snapshot is discarded as soon as one is detected and buffering restarts at the next
+  /// SNAPSHOT_START. The buffer keeps its capacity across snapshots, so it only allocates while growing to the largest snapshot seen.
+  class SnapshotRecoveryBuffer final {
+  public:
+    /// The CLEAR and order messages of the snapshot, excluding SNAPSHOT_START and SNAPSHOT_END.
+    auto updates() const noexcept -> const std::vector<Exchange::MEMarketUpdate> & {
+      return updates_;
+    }
+
+    /// ticker_seq_num_ of the last incremental update of the ticker the snapshot is consistent with.
+    auto tickerSeqNum() const noexcept {
+      return ticker_seq_num_;
+    }
+
+    auto complete() const noexcept {
+      return complete_;
+    }
+
+    auto reset() noexcept -> void {
+      updates_.clear();
+      started_ = complete_ = false;
+    }
+
+    /// Buffer the next snapshot message, returns false if it did not follow on from the ones buffered so far and the partial snapshot was discarded.
+    auto add(const Exchange::MDPMarketUpdate &market_update) noexcept -> bool {
+      const auto type = market_update.me_market_update_.type_;
+      if (type == Exchange::MarketUpdateType::SNAPSHOT_START && market_update.seq_num_ == 0) {
+        const auto was_started = started_;
+        reset();
+        started_ = true;
+        ticker_seq_num_ = market_update.ticker_seq_num_;
+        return !was_started;
+      }
+
+      if (!started_ || complete_ || market_update.seq_num_ != updates_.size() + 1) {
+        const auto was_started = started_;
+        reset();
+        return !was_started;
+      }
+
+      if (type == Exchange::MarketUpdateType::SNAPSHOT_END)
+        complete_ = true;
+      else
+        updates_.push_back(market_update.me_market_update_);
+      return true;
+    }
+
+  private:
+    std::vector<Exchange::MEMarketUpdate> updates_;
+    size_t ticker_seq_num_ = 0;
+    bool started_ = false, complete_ = false;
+  };
+}
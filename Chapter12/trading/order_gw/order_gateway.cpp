@@ -4,69 +4,145 @@ namespace Trading {
   OrderGateway::OrderGateway(ClientId client_id,
                              Exchange::ClientRequestLFQueue *client_requests,
                              Exchange::ClientResponseLFQueue *client_responses,
-                             std::string ip, const std::string &iface, int port)
+                             std::string ip, const std::string &iface, int port, const Common::FaultCfg &fault_cfg)
       : client_id_(client_id), ip_(ip), iface_(iface), port_(port), outgoing_requests_(client_requests), incoming_responses_(client_responses),
       logger_("trading_order_gateway_" + std::to_string(client_id) + ".log"), tcp_socket_(logger_) {
+    sent_requests_.resize(OG_MAX_SENT_REQUESTS);
     tcp_socket_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
+
+    if (fault_cfg.enabled()) {
+      logger_.log("%:% %() % Injecting %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), fault_cfg.toString());
+      tcp_socket_.injectFaults(fault_cfg, 0);
+    }
+  }
+
+  /// Connect to the order server, dropping the previous connection if any, and send a LOGON to start or resume the session.
+  auto OrderGateway::connect() -> void {
+    tcp_socket_.disconnect();
+    ASSERT(tcp_socket_.connect(ip_, iface_, port_, false) >= 0,
+           "Unable to connect to ip:" + ip_ + " port:" + std::to_string(port_) + " on iface:" + iface_ + " error:" + std::string(std::strerror(errno)));
+
+    logged_on_ = false;
+    logger_.log("%:% %() % Sending LOGON cid:% next-request:% last-response:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), client_id_, next_outgoing_seq_num_, next_exp_seq_num_ - 1);
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    tcp_socket_.send(encoded, Exchange::encodeLogon(client_id_, next_outgoing_seq_num_, next_exp_seq_num_ - 1, encoded));
+    logon_time_ = getCurrentNanos();
+  }
+
+  /// Agree the sequence numbers with the order server, the client responses missed since the last connection follow the LOGON_ACK.
+  auto OrderGateway::onLogonAck(const Exchange::WireLogonAck &logon_ack) noexcept -> void {
+    logger_.log("%:% %() % Received LOGON_ACK cid:% next-request:% replay-from:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), client_id_, logon_ack.next_request_seq_, logon_ack.replay_from_seq_);
+    if (logon_ack.replay_from_seq_ != next_exp_seq_num_) { // older than the order server keeps, the trade engine never sees them.
+      logger_.log("%:% %() % ERROR Client responses lost. ClientId:% SeqNum expected:% replay from:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, logon_ack.replay_from_seq_);
+    }
+
+    next_exp_seq_num_ = logon_ack.replay_from_seq_;
+    logged_on_ = true;
+
+    // Client requests the order server has not received by now are resent, the ring holds those in [next_outgoing_seq_num_ - OG_MAX_SENT_REQUESTS,
+    // next_outgoing_seq_num_), anything older is lost and the resent ones are numbered on from the one the order server expects.
+    const uint32_t oldest_seq_num = (next_outgoing_seq_num_ > OG_MAX_SENT_REQUESTS ? next_outgoing_seq_num_ - OG_MAX_SENT_REQUESTS : 1);
+    const auto resend_from_seq_num = std::clamp(logon_ack.next_request_seq_, oldest_seq_num, next_outgoing_seq_num_);
+    if (UNLIKELY(logon_ack.next_request_seq_ < oldest_seq_num)) {
+      logger_.log("%:% %() % ERROR Client requests lost. ClientId:% SeqNum expected:% oldest kept:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), client_id_, logon_ack.next_request_seq_, oldest_seq_num);
+    }
+
+    std::vector<Exchange::MEClientRequest> unacked_requests;
+    for (auto seq_num = resend_from_seq_num; seq_num < next_outgoing_seq_num_; ++seq_num)
+      unacked_requests.push_back(sent_requests_[seq_num % OG_MAX_SENT_REQUESTS]);
+
+    next_outgoing_seq_num_ = logon_ack.next_request_seq_;
+    for (const auto &client_request : unacked_requests) {
+      logger_.log("%:% %() % Resending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), client_id_, next_outgoing_seq_num_, client_request.toString());
+      sendRequest(client_request);
+    }
+  }
+
+  auto OrderGateway::sendRequest(const Exchange::MEClientRequest &client_request) noexcept -> void {
+    char encoded[Exchange::WIRE_MAX_REQUEST_SIZE];
+    tcp_socket_.send(encoded, Exchange::encodeClientRequest(next_outgoing_seq_num_, client_request, encoded));
+    sent_requests_[next_outgoing_seq_num_ % OG_MAX_SENT_REQUESTS] = client_request;
+    ++next_outgoing_seq_num_;
   }
 
   /// Main thread loop - sends out client requests to the exchange and reads and dispatches incoming client responses.
   auto OrderGateway::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
+      // Resume the session on a new connection once the order server is reachable again, or if the LOGON on this one went unanswered.
+      if (UNLIKELY(tcp_socket_.disconnected_ || (!logged_on_ && getCurrentNanos() - logon_time_ > OG_LOGON_TIMEOUT))) {
+        logger_.log("%:% %() % % from the order server, reconnecting.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    (tcp_socket_.disconnected_ ? "Disconnected" : "No LOGON_ACK"));
+
+        using namespace std::literals::chrono_literals;
+        std::this_thread::sleep_for(1s);
+        connect();
+      }
+
       tcp_socket_.sendAndRecv();
 
+      if (UNLIKELY(!logged_on_))
+        continue;
+
       for(auto client_request = outgoing_requests_->getNextToRead(); client_request; client_request = outgoing_requests_->getNextToRead()) {
         TTT_MEASURE(T11_OrderGateway_LFQueue_read, logger_);
 
         logger_.log("%:% %() % Sending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__,
                     Common::getCurrentTimeStr(&time_str_), client_id_, next_outgoing_seq_num_, client_request->toString());
         START_MEASURE(Trading_TCPSocket_send);
-        tcp_socket_.send(&next_outgoing_seq_num_, sizeof(next_outgoing_seq_num_));
-        tcp_socket_.send(client_request, sizeof(Exchange::MEClientRequest));
+        sendRequest(*client_request);
         END_MEASURE(Trading_TCPSocket_send, logger_);
         outgoing_requests_->updateReadIndex();
         TTT_MEASURE(T12_OrderGateway_TCP_write, logger_);
-
-        next_outgoing_seq_num_++;
       }
     }
   }
 
-  /// Callback when an incoming client response is read, we perform some checks and forward it to the lock free queue connected to the trade engine.
+  /// Callback when incoming client responses are read, we decode them in place, perform some checks and forward them to the lock free queue connected to the trade engine.
   auto OrderGateway::recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
     TTT_MEASURE(T7t_OrderGateway_TCP_read, logger_);
 
     START_MEASURE(Trading_OrderGateway_recvCallback);
     logger_.log("%:% %() % Received socket:% len:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
 
-    if (socket->next_rcv_valid_index_ >= sizeof(Exchange::OMClientResponse)) {
-      size_t i = 0;
-      for (; i + sizeof(Exchange::OMClientResponse) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::OMClientResponse)) {
-        auto response = reinterpret_cast<const Exchange::OMClientResponse *>(socket->inbound_data_.data() + i);
-        logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), response->toString());
-
-        if(response->me_client_response_.client_id_ != client_id_) { // this should never happen unless there is a bug at the exchange.
-          logger_.log("%:% %() % ERROR Incorrect client id. ClientId expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), client_id_, response->me_client_response_.client_id_);
-          continue;
-        }
-        if(response->seq_num_ != next_exp_seq_num_) { // this should never happen since we use a reliable TCP protocol, unless there is a bug at the exchange.
-          logger_.log("%:% %() % ERROR Incorrect sequence number. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, response->seq_num_);
-          continue;
-        }
-
-        ++next_exp_seq_num_;
-
-        auto next_write = incoming_responses_->getNextToWriteTo();
-        *next_write = std::move(response->me_client_response_);
-        incoming_responses_->updateWriteIndex();
-        TTT_MEASURE(T8t_OrderGateway_LFQueue_write, logger_);
+    size_t i = 0;
+    for (auto msg_len = Exchange::wireMessageLength(socket->inbound_data_.data(), socket->next_rcv_valid_index_); msg_len;
+         i += msg_len, msg_len = Exchange::wireMessageLength(socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i)) {
+      if (UNLIKELY(Exchange::wireMessageType(socket->inbound_data_.data() + i) == Exchange::WireMsgType::LOGON_ACK)) {
+        const auto logon_ack = Exchange::decodeSessionMessage<Exchange::WireLogonAck>(socket->inbound_data_.data() + i);
+        if (logon_ack)
+          onLogonAck(*logon_ack);
+        continue;
       }
-      memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
-      socket->next_rcv_valid_index_ -= i;
+
+      auto next_write = incoming_responses_->getNextToWriteTo();
+      const auto seq_num = Exchange::decodeClientResponse(socket->inbound_data_.data() + i, client_id_, *next_write);
+      logger_.log("%:% %() % Received seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), seq_num, next_write->toString());
+
+      if(seq_num != next_exp_seq_num_) { // this should never happen since we use a reliable TCP protocol, unless there is a bug at the exchange.
+        logger_.log("%:% %() % ERROR Incorrect sequence number. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, seq_num);
+        continue;
+      }
+
+      ++next_exp_seq_num_;
+
+      if(UNLIKELY(next_write->type_ == Exchange::ClientResponseType::INVALID)) { // a message type or version this gateway does not understand.
+        logger_.log("%:% %() % ERROR Undecodable client response. ClientId:% seq:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), client_id_, seq_num);
+        continue;
+      }
+
+      incoming_responses_->updateWriteIndex();
+      TTT_MEASURE(T8t_OrderGateway_LFQueue_write, logger_);
     }
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
+    socket->next_rcv_valid_index_ -= i;
     END_MEASURE(Trading_OrderGateway_recvCallback, logger_);
   }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include "common/thread_utils.h"
 #include "common/macros.h"
@@ -8,14 +10,22 @@
 
 #include "exchange/order_server/client_request.h"
 #include "exchange/order_server/client_response.h"
+#include "exchange/order_server/client_wire.h"
 
 namespace Trading {
+  /// Number of client requests kept for resending to a resumed session, those the order server had not received before the connection dropped.
+  constexpr size_t OG_MAX_SENT_REQUESTS = Common::ME_MAX_CLIENT_UPDATES;
+
+  /// Time to wait for the LOGON_ACK before reconnecting, the LOGON is lost if e.g. the connection failed while it was being established.
+  constexpr Nanos OG_LOGON_TIMEOUT = 1 * NANOS_TO_SECS;
+
   class OrderGateway {
   public:
+    /// The faults drawn from fault_cfg are injected into the client responses read, a drop breaks the connection and the session is resumed on a new one.
     OrderGateway(ClientId client_id,
                  Exchange::ClientRequestLFQueue *client_requests,
                  Exchange::ClientResponseLFQueue *client_responses,
-                 std::string ip, const std::string &iface, int port);
+                 std::string ip, const std::string &iface, int port, const Common::FaultCfg &fault_cfg = Common::FaultCfg());
 
     ~OrderGateway() {
       stop();
@@ -27,8 +37,7 @@ namespace Trading {
     /// Start and stop the order gateway main thread.
     auto start() {
       run_ = true;
-      ASSERT(tcp_socket_.connect(ip_, iface_, port_, false) >= 0,
-             "Unable to connect to ip:" + ip_ + " port:" + std::to_string(port_) + " on iface:" + iface_ + " error:" + std::string(std::strerror(errno)));
+      connect();
       ASSERT(Common::createAndStartThread(-1, "Trading/OrderGateway", [this]() { run(); }) != nullptr, "Failed to start OrderGateway thread.");
     }
 
@@ -67,17 +76,34 @@ namespace Trading {
     Logger logger_;
 
     /// Sequence numbers to track the sequence number to set on outgoing client requests and expected on incoming client responses.
-    size_t next_outgoing_seq_num_ = 1;
-    size_t next_exp_seq_num_ = 1;
+    /// They survive reconnects, the LOGON on a new connection resumes the session with them.
+    uint32_t next_outgoing_seq_num_ = 1;
+    uint32_t next_exp_seq_num_ = 1;
+
+    /// Set once the order server acknowledged the LOGON on the current connection, client requests are held back until then.
+    bool logged_on_ = false;
+    Nanos logon_time_ = 0;
+
+    /// Ring of the last OG_MAX_SENT_REQUESTS client requests sent, indexed by sequence number, resent from the one the LOGON_ACK expects next.
+    std::vector<Exchange::MEClientRequest> sent_requests_;
 
     /// TCP connection to the exchange's order server.
     Common::TCPSocket tcp_socket_;
 
   private:
+    /// Connect to the order server, dropping the previous connection if any, and send a LOGON to start or resume the session.
+    auto connect() -> void;
+
+    /// Agree the sequence numbers with the order server, the client responses missed since the last connection follow the LOGON_ACK.
+    auto onLogonAck(const Exchange::WireLogonAck &logon_ack) noexcept -> void;
+
+    /// Send the client request with the next sequence number and keep it in case it has to be resent.
+    auto sendRequest(const Exchange::MEClientRequest &client_request) noexcept -> void;
+
     /// Main thread loop - sends out client requests to the exchange and reads and dispatches incoming client responses.
     auto run() noexcept -> void;
 
-    /// Callback when an incoming client response is read, we perform some checks and forward it to the lock free queue connected to the trade engine.
+    /// Callback when incoming client responses are read, we decode them in place, perform some checks and forward them to the lock free queue connected to the trade engine.
     auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
   };
 }
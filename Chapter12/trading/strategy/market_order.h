@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <vector>
 #include <sstream>
 #include "common/types.h"
 
@@ -29,7 +31,38 @@ namespace Trading {
   };
 
   /// Hash map from OrderId -> MarketOrder.
-  typedef std::array<MarketOrder *, ME_MAX_ORDER_IDS> OrderHashMap;
+  typedef std::vector<MarketOrder *> OrderHashMap;
+
+  /// Order id index of a MarketOrderBook, a hash map from OrderId -> MarketOrder which grows with the market order ids seen within the capacity of
+  /// max_order_ids reserved upfront, so inserting never reallocates. Market order ids are generated per ticker by the exchange, so every book owns one.
+  class MarketOrderIndex final {
+  public:
+    explicit MarketOrderIndex(size_t max_order_ids)
+        : max_order_ids_(max_order_ids) {
+      oid_to_order_.reserve(max_order_ids_);
+    }
+
+    /// Return the live order with the provided market order id, the order id has to have been seen.
+    auto at(OrderId order_id) const -> MarketOrder * {
+      return oid_to_order_.at(order_id);
+    }
+
+    auto insert(MarketOrder *order) noexcept -> void {
+      if (UNLIKELY(order->order_id_ >= oid_to_order_.size())) {
+        ASSERT(order->order_id_ < max_order_ids_, "Order id beyond limits:" + order->toString());
+        oid_to_order_.resize(std::min(max_order_ids_, std::max<size_t>(order->order_id_ + 1, 2 * oid_to_order_.size())), nullptr);
+      }
+      oid_to_order_[order->order_id_] = order;
+    }
+
+    auto erase(const MarketOrder *order) noexcept -> void {
+      oid_to_order_.at(order->order_id_) = nullptr;
+    }
+
+  private:
+    size_t max_order_ids_ = 0;
+    OrderHashMap oid_to_order_;
+  };
 
   /// Used by the trade engine to represent a price level in the limit order book.
   /// Internally maintains a list of MarketOrder objects arranged in FIFO order.
@@ -37,7 +70,7 @@ namespace Trading {
     Side side_ = Side::INVALID;
     Price price_ = Price_INVALID;
 
-    MarketOrder *first_mkt_order_ = nullptr;
+    MarketOrder *first_order_ = nullptr;
 
     /// MarketOrdersAtPrice also serves as a node in a doubly linked list of price levels arranged in order from most aggressive to least aggressive price.
     MarketOrdersAtPrice *prev_entry_ = nullptr;
@@ -46,15 +79,15 @@ namespace Trading {
     /// Only needed for use with MemPool.
     MarketOrdersAtPrice() = default;
 
-    MarketOrdersAtPrice(Side side, Price price, MarketOrder *first_mkt_order, MarketOrdersAtPrice *prev_entry, MarketOrdersAtPrice *next_entry)
-        : side_(side), price_(price), first_mkt_order_(first_mkt_order), prev_entry_(prev_entry), next_entry_(next_entry) {}
+    MarketOrdersAtPrice(Side side, Price price, MarketOrder *first_order, MarketOrdersAtPrice *prev_entry, MarketOrdersAtPrice *next_entry)
+        : side_(side), price_(price), first_order_(first_order), prev_entry_(prev_entry), next_entry_(next_entry) {}
 
     auto toString() const {
       std::stringstream ss;
       ss << "MarketOrdersAtPrice["
          << "side:" << sideToString(side_) << " "
          << "price:" << priceToString(price_) << " "
-         << "first_mkt_order:" << (first_mkt_order_ ? first_mkt_order_->toString() : "null") << " "
+         << "first_order:" << (first_order_ ? first_order_->toString() : "null") << " "
          << "prev:" << priceToString(prev_entry_ ? prev_entry_->price_ : Price_INVALID) << " "
          << "next:" << priceToString(next_entry_ ? next_entry_->price_ : Price_INVALID) << "]";
 
@@ -62,9 +95,6 @@ namespace Trading {
     }
   };
 
-  /// Hash map from Price -> MarketOrdersAtPrice.
-  typedef std::array<MarketOrdersAtPrice *, ME_MAX_PRICE_LEVELS> OrdersAtPriceHashMap;
-
   /// Represents a Best Bid Offer (BBO) abstraction for components which only need a small summary of top of book price and liquidity instead of the full order book.
   struct BBO {
     Price bid_price_ = Price_INVALID, ask_price_ = Price_INVALID;
@@ -3,8 +3,16 @@
 #include "trade_engine.h"
 
 namespace Trading {
-  MarketOrderBook::MarketOrderBook(TickerId ticker_id, Logger *logger)
-      : ticker_id_(ticker_id), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(ME_MAX_ORDER_IDS), logger_(logger) {
+  /// Every live price level holds at least one live order, so there cannot be more live price levels than live orders.
+  MarketOrderBookPools::MarketOrderBookPools(const EngineLimits &limits)
+      : max_order_ids_(limits.max_order_ids_), max_price_levels_(limits.max_price_levels_), order_pool_(limits.max_order_ids_),
+        orders_at_price_pool_(std::min(limits.max_order_ids_, limits.max_tickers_ * limits.max_price_levels_)) {
+    ASSERT(limits.isValid(), "Invalid " + limits.toString());
+  }
+
+  MarketOrderBook::MarketOrderBook(TickerId ticker_id, Logger *logger, MarketOrderBookPools *pools)
+      : ticker_id_(ticker_id), pools_(pools),
+        book_(&pools->order_pool_, &pools->orders_at_price_pool_, MarketOrderIndex(pools->max_order_ids_), pools->max_price_levels_), logger_(logger) {
   }
 
   MarketOrderBook::~MarketOrderBook() {
@@ -12,33 +20,34 @@ namespace Trading {
                  Common::getCurrentTimeStr(&time_str_), toString(false, true));
 
     trade_engine_ = nullptr;
-    bids_by_price_ = asks_by_price_ = nullptr;
-    oid_to_order_.fill(nullptr);
+    pools_ = nullptr;
   }
 
   /// Process market data update and update the limit order book.
   auto MarketOrderBook::onMarketUpdate(const Exchange::MEMarketUpdate *market_update) noexcept -> void {
-    const auto bid_updated = (bids_by_price_ && market_update->side_ == Side::BUY && market_update->price_ >= bids_by_price_->price_);
-    const auto ask_updated = (asks_by_price_ && market_update->side_ == Side::SELL && market_update->price_ <= asks_by_price_->price_);
+    const auto bids_by_price = book_.bestOrdersByPrice(Side::BUY);
+    const auto asks_by_price = book_.bestOrdersByPrice(Side::SELL);
+    const auto bid_updated = (bids_by_price && market_update->side_ == Side::BUY && market_update->price_ >= bids_by_price->price_);
+    const auto ask_updated = (asks_by_price && market_update->side_ == Side::SELL && market_update->price_ <= asks_by_price->price_);
 
     switch (market_update->type_) {
       case Exchange::MarketUpdateType::ADD: {
-        auto order = order_pool_.allocate(market_update->order_id_, market_update->side_, market_update->price_,
+        auto order = pools_->order_pool_.allocate(market_update->order_id_, market_update->side_, market_update->price_,
                                           market_update->qty_, market_update->priority_, nullptr, nullptr);
         START_MEASURE(Trading_MarketOrderBook_addOrder);
-        addOrder(order);
+        book_.addOrder(order);
         END_MEASURE(Trading_MarketOrderBook_addOrder, (*logger_));
       }
         break;
       case Exchange::MarketUpdateType::MODIFY: {
-        auto order = oid_to_order_.at(market_update->order_id_);
+        auto order = book_.orderIndex().at(market_update->order_id_);
         order->qty_ = market_update->qty_;
       }
         break;
       case Exchange::MarketUpdateType::CANCEL: {
-        auto order = oid_to_order_.at(market_update->order_id_);
+        auto order = book_.orderIndex().at(market_update->order_id_);
         START_MEASURE(Trading_MarketOrderBook_removeOrder);
-        removeOrder(order);
+        book_.removeOrder(order);
         END_MEASURE(Trading_MarketOrderBook_removeOrder, (*logger_));
       }
         break;
@@ -48,25 +57,7 @@ namespace Trading {
       }
         break;
       case Exchange::MarketUpdateType::CLEAR: { // Clear the full limit order book and deallocate MarketOrdersAtPrice and MarketOrder objects.
-        for (auto &order: oid_to_order_) {
-          if (order)
-            order_pool_.deallocate(order);
-        }
-        oid_to_order_.fill(nullptr);
-
-        if(bids_by_price_) {
-          for(auto bid = bids_by_price_->next_entry_; bid != bids_by_price_; bid = bid->next_entry_)
-            orders_at_price_pool_.deallocate(bid);
-          orders_at_price_pool_.deallocate(bids_by_price_);
-        }
-
-        if(asks_by_price_) {
-          for(auto ask = asks_by_price_->next_entry_; ask != asks_by_price_; ask = ask->next_entry_)
-            orders_at_price_pool_.deallocate(ask);
-          orders_at_price_pool_.deallocate(asks_by_price_);
-        }
-
-        bids_by_price_ = asks_by_price_ = nullptr;
+        book_.clear();
       }
         break;
       case Exchange::MarketUpdateType::INVALID:
@@ -95,10 +86,10 @@ namespace Trading {
       Qty qty = 0;
       size_t num_orders = 0;
 
-      for (auto o_itr = itr->first_mkt_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         qty += o_itr->qty_;
         ++num_orders;
-        if (o_itr->next_order_ == itr->first_mkt_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
       sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
@@ -106,7 +97,7 @@ namespace Trading {
               priceToString(itr->next_entry_->price_).c_str(),
               priceToString(itr->price_).c_str(), qtyToString(qty).c_str(), std::to_string(num_orders).c_str());
       ss << buf;
-      for (auto o_itr = itr->first_mkt_order_;; o_itr = o_itr->next_order_) {
+      for (auto o_itr = itr->first_order_;; o_itr = o_itr->next_order_) {
         if (detailed) {
           sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
                   orderIdToString(o_itr->order_id_).c_str(), qtyToString(o_itr->qty_).c_str(),
@@ -114,7 +105,7 @@ namespace Trading {
                   orderIdToString(o_itr->next_order_ ? o_itr->next_order_->order_id_ : OrderId_INVALID).c_str());
           ss << buf;
         }
-        if (o_itr->next_order_ == itr->first_mkt_order_)
+        if (o_itr->next_order_ == itr->first_order_)
           break;
       }
 
@@ -131,11 +122,12 @@ namespace Trading {
 
     ss << "Ticker:" << tickerIdToString(ticker_id_) << std::endl;
     {
-      auto ask_itr = asks_by_price_;
+      const auto asks_by_price = book_.bestOrdersByPrice(Side::SELL);
+      auto ask_itr = asks_by_price;
       auto last_ask_price = std::numeric_limits<Price>::min();
       for (size_t count = 0; ask_itr; ++count) {
         ss << "ASKS L:" << count << " => ";
-        auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price_ ? nullptr : ask_itr->next_entry_);
+        auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price ? nullptr : ask_itr->next_entry_);
         printer(ss, ask_itr, Side::SELL, last_ask_price, validity_check);
         ask_itr = next_ask_itr;
       }
@@ -144,11 +136,12 @@ namespace Trading {
     ss << std::endl << "                          X" << std::endl << std::endl;
 
     {
-      auto bid_itr = bids_by_price_;
+      const auto bids_by_price = book_.bestOrdersByPrice(Side::BUY);
+      auto bid_itr = bids_by_price;
       auto last_bid_price = std::numeric_limits<Price>::max();
       for (size_t count = 0; bid_itr; ++count) {
         ss << "BIDS L:" << count << " => ";
-        auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price_ ? nullptr : bid_itr->next_entry_);
+        auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price ? nullptr : bid_itr->next_entry_);
         printer(ss, bid_itr, Side::BUY, last_bid_price, validity_check);
         bid_itr = next_bid_itr;
       }
@@ -43,7 +43,20 @@ namespace Trading {
             order->order_state_ = OMOrderState::DEAD;
         }
           break;
+        case Exchange::ClientResponseType::THROTTLED: { // the request never reached the matching engine, so the order is back in the state before it.
+          if (order->order_state_ == OMOrderState::PENDING_NEW)
+            order->order_state_ = OMOrderState::DEAD;
+          else if (order->order_state_ == OMOrderState::PENDING_CANCEL)
+            order->order_state_ = OMOrderState::LIVE;
+        }
+          break;
+        case Exchange::ClientResponseType::REJECTED: {
+          order->order_state_ = OMOrderState::DEAD;
+        }
+          break;
         case Exchange::ClientResponseType::CANCEL_REJECTED:
+        case Exchange::ClientResponseType::SESSION_MOVED:
+        case Exchange::ClientResponseType::SESSION_TAKEOVER:
         case Exchange::ClientResponseType::INVALID: {
         }
           break;
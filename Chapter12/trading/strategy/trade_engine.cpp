@@ -6,17 +6,16 @@ namespace Trading {
                            const TradeEngineCfgHashMap &ticker_cfg,
                            Exchange::ClientRequestLFQueue *client_requests,
                            Exchange::ClientResponseLFQueue *client_responses,
-                           Exchange::MEMarketUpdateLFQueue *market_updates)
-      : client_id_(client_id), outgoing_ogw_requests_(client_requests), incoming_ogw_responses_(client_responses),
-        incoming_md_updates_(market_updates), logger_("trading_engine_" + std::to_string(client_id) + ".log"),
+                           Exchange::MEMarketUpdateLFQueue *market_updates,
+                           const EngineLimits &limits)
+      : client_id_(client_id), order_book_pools_(limits), ticker_order_book_(limits.max_tickers_, nullptr), outgoing_ogw_requests_(client_requests),
+        incoming_ogw_responses_(client_responses), incoming_md_updates_(market_updates), logger_("trading_engine_" + std::to_string(client_id) + ".log"),
         feature_engine_(&logger_),
         position_keeper_(&logger_),
         order_manager_(&logger_, this, risk_manager_),
         risk_manager_(&logger_, &position_keeper_, ticker_cfg) {
-    for (size_t i = 0; i < ticker_order_book_.size(); ++i) {
-      ticker_order_book_[i] = new MarketOrderBook(i, &logger_);
-      ticker_order_book_[i]->setTradeEngine(this);
-    }
+    // Positions, risk and strategy state are small fixed size arrays indexed by TickerId, ME_MAX_TICKERS remains their upper bound.
+    ASSERT(limits.max_tickers_ <= ME_MAX_TICKERS, "Invalid " + limits.toString() + " max tickers supported:" + std::to_string(ME_MAX_TICKERS));
 
     // Initialize the function wrappers for the callbacks for order book changes, trade events and client responses.
     algoOnOrderBookUpdate_ = [this](auto ticker_id, auto price, auto side, auto book) {
@@ -91,7 +90,13 @@ namespace Trading {
                     market_update->toString().c_str());
         ASSERT(market_update->ticker_id_ < ticker_order_book_.size(),
                "Unknown ticker-id on update:" + market_update->toString());
-        ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
+        auto order_book = ticker_order_book_[market_update->ticker_id_];
+        if (UNLIKELY(!order_book)) { // first market update for this ticker.
+          order_book = new MarketOrderBook(market_update->ticker_id_, &logger_, &order_book_pools_);
+          order_book->setTradeEngine(this);
+          ticker_order_book_[market_update->ticker_id_] = order_book;
+        }
+        order_book->onMarketUpdate(market_update);
         incoming_md_updates_->updateReadIndex();
         last_event_time_ = Common::getCurrentNanos();
       }
@@ -30,7 +30,8 @@ namespace Trading {
                 const TradeEngineCfgHashMap &ticker_cfg,
                 Exchange::ClientRequestLFQueue *client_requests,
                 Exchange::ClientResponseLFQueue *client_responses,
-                Exchange::MEMarketUpdateLFQueue *market_updates);
+                Exchange::MEMarketUpdateLFQueue *market_updates,
+                const EngineLimits &limits = EngineLimits());
 
     ~TradeEngine();
 
@@ -102,7 +103,10 @@ namespace Trading {
     /// This trade engine's ClientId.
     const ClientId client_id_;
 
-    /// Hash map container from TickerId -> MarketOrderBook.
+    /// Order and price level memory pools shared by all the order books.
+    MarketOrderBookPools order_book_pools_;
+
+    /// Hash map container from TickerId -> MarketOrderBook, nullptr for tickers which have not had a market update yet.
     MarketOrderBookHashMap ticker_order_book_;
 
     /// Lock free queues.
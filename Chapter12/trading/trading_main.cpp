@@ -27,10 +27,13 @@ int main(int argc, char **argv) {
 
   const int sleep_time = 20 * 1000;
 
+  // Capacities of the lock free queues and order books, these have to cover every ticker the exchange publishes.
+  const Common::EngineLimits limits;
+
   // The lock free queues to facilitate communication between order gateway <-> trade engine and market data consumer -> trade engine.
-  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
-  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
-  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  Exchange::ClientRequestLFQueue client_requests(limits.max_client_updates_);
+  Exchange::ClientResponseLFQueue client_responses(limits.max_client_updates_);
+  Exchange::MEMarketUpdateLFQueue market_updates(limits.max_market_updates_);
 
   std::string time_str;
 
@@ -51,25 +54,41 @@ int main(int argc, char **argv) {
                                           ticker_cfg,
                                           &client_requests,
                                           &client_responses,
-                                          &market_updates);
+                                          &market_updates,
+                                          limits);
   trade_engine->start();
 
   const std::string order_gw_ip = "127.0.0.1";
   const std::string order_gw_iface = "lo";
   const int order_gw_port = 12345;
 
+  // Network faults to inject into the market data and the client responses read, off unless configured in the environment, see scripts/run_fault_injection.sh.
+  // Every client draws its own faults from the same seed.
+  auto md_fault_cfg = Common::FaultCfg::fromEnv("MD_FAULT_");
+  auto ogw_fault_cfg = Common::FaultCfg::fromEnv("OGW_FAULT_");
+  md_fault_cfg.seed_ += client_id;
+  ogw_fault_cfg.seed_ += client_id;
+
   logger->log("%:% %() % Starting Order Gateway...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  order_gateway = new Trading::OrderGateway(client_id, &client_requests, &client_responses, order_gw_ip, order_gw_iface, order_gw_port);
+  order_gateway = new Trading::OrderGateway(client_id, &client_requests, &client_responses, order_gw_ip, order_gw_iface, order_gw_port, ogw_fault_cfg);
   order_gateway->start();
 
   const std::string mkt_data_iface = "lo";
   const std::string snapshot_ip = "233.252.14.1";
   const int snapshot_port = 20000;
-  const std::string incremental_ip = "233.252.14.3";
-  const int incremental_port = 20001;
+  const std::vector<Exchange::IncrementalChannelCfg> incremental_channels = {{"233.252.14.3", 20001, "233.252.14.4", 20003, true},
+                                                                             {"233.252.14.5", 20004, "233.252.14.6", 20005, true}};
+  const std::string gap_fill_ip = "127.0.0.1";
+  const int gap_fill_port = 20002;
+
+  // Only subscribe to the tickers configured on the command line, the RANDOM algorithm configures none and trades every ticker.
+  std::vector<Common::TickerId> tickers;
+  for (Common::TickerId ticker_id = 0; ticker_id < next_ticker_id; ++ticker_id)
+    tickers.push_back(ticker_id);
 
   logger->log("%:% %() % Starting Market Data Consumer...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  market_data_consumer = new Trading::MarketDataConsumer(client_id, &market_updates, mkt_data_iface, snapshot_ip, snapshot_port, incremental_ip, incremental_port);
+  market_data_consumer = new Trading::MarketDataConsumer(client_id, &market_updates, mkt_data_iface, snapshot_ip, snapshot_port, incremental_channels, tickers,
+                                                         gap_fill_ip, gap_fill_port, Trading::ReorderCfg(), md_fault_cfg, limits);
   market_data_consumer->start();
 
   usleep(10 * 1000 * 1000);